@@ -0,0 +1,493 @@
+/*
+ *  bench.c -- Load generator which drives the authentication hooks of the
+ *             MySQL or PostgreSQL Plugin from concurrent processes.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* configuration includes. */
+#include "config.h"
+
+/* autoconf declares VERSION which is declared in pppd.h too. */
+#ifdef VERSION
+#undef VERSION
+#endif
+
+/* generic includes. */
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ppp generic includes. */
+#include <pppd/chap-new.h>
+#include <pppd/pppd.h>
+
+/* ppp ipcp includes. */
+#include <pppd/fsm.h>
+#include <pppd/ipcp.h>
+
+/* bench includes. */
+#include "bench.h"
+#include "shim.h"
+
+/* this function show the usage of the load generator. */
+int32_t pppd__bench_usage(uint8_t *program) {
+
+	/* show usage. */
+	fprintf(stderr, "Usage: %s [-a auth] [-c processes] [-n logins] [-U users] [-u prefix] [-w prefix]\n", program);
+	fprintf(stderr, "       [-S] [-v] plugin [option[=value] ...]\n");
+	fprintf(stderr, "       %s -g users [-t type] [-u prefix] [-w prefix]\n", program);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Load the plugin like the ppp daemon, set its options and call its authentication\n");
+	fprintf(stderr, "hook from concurrent processes, each login with a random user. Options are given\n");
+	fprintf(stderr, "like in the ppp options file, but as name=value, a bool option only by name.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -a auth             pap, chap-md5 or mschapv2 (default: chap-md5)\n");
+	fprintf(stderr, "  -c processes        the number of concurrent processes (default: 4)\n");
+	fprintf(stderr, "  -n logins           the number of logins of each process (default: 1000)\n");
+	fprintf(stderr, "  -U users            the number of users to pick from (default: 10000)\n");
+	fprintf(stderr, "  -u prefix           the username before the number of the user (default: user)\n");
+	fprintf(stderr, "  -w prefix           the password before the number of the user (default: pass)\n");
+	fprintf(stderr, "  -S                  call the ip up and ip down notifiers after an accepted login\n");
+	fprintf(stderr, "  -v                  show the log messages of the plugin\n");
+	fprintf(stderr, "  -g users            print the users as csv for pppd-sql-import and exit\n");
+	fprintf(stderr, "  -t type             the address format of the csv, mysql or pgsql (default: mysql)\n");
+
+	/* return with error. */
+	return 1;
+}
+
+/* this function print the generated users as csv for the import tool. */
+int32_t pppd__bench_generate(uint32_t users, uint8_t *type, uint8_t *user_prefix, uint8_t *pass_prefix) {
+
+	/* some common variables. */
+	uint32_t count   = 0;
+	uint32_t address = 0;
+
+	/* loop through all users. */
+	for (count = 0; count < users; count++) {
+
+		/* every user has its own client address. */
+		address = BENCH_ADDRESS + count + 1;
+
+		/* check if addresses are numbers like INET_ATON() of the mysql schema or dotted quads of the postgresql schema. */
+		if (strcmp((char *)type, "mysql") == 0) {
+			fprintf(stdout, "%s%u,%s%u,%u,%u\n", user_prefix, count, pass_prefix, count, address, BENCH_SERVER);
+		} else {
+			fprintf(stdout, "%s%u,%s%u,%u.%u.%u.%u,%u.%u.%u.%u\n", user_prefix, count, pass_prefix, count,
+				address >> 24, (address >> 16) & 0xff, (address >> 8) & 0xff, address & 0xff,
+				BENCH_SERVER >> 24, (BENCH_SERVER >> 16) & 0xff, (BENCH_SERVER >> 8) & 0xff, BENCH_SERVER & 0xff);
+		}
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function load the plugin like the plugin option of the ppp daemon. */
+int32_t pppd__bench_load(struct pppd_bench *bench) {
+
+	/* some common variables. */
+	void *handle       = NULL;
+	uint8_t *version   = NULL;
+	void (*init)(void) = NULL;
+
+	/* check if plugin was loaded, its references to the ppp daemon are resolved against the shim. */
+	if ((handle = dlopen((char *)bench->plugin, RTLD_GLOBAL | RTLD_NOW)) == NULL) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-bench: %s\n", dlerror());
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* check if plugin was compiled for the ppp daemon of the shim, the daemon refuses others too. */
+	if ((version = dlsym(handle, "pppd_version")) == NULL ||
+	    strcmp((char *)version, VERSION) != 0) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-bench: %s is compiled for pppd version %s, not %s\n", bench->plugin, version != NULL ? (char *)version : "unknown", VERSION);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* check if plugin has an init function. */
+	if ((init = (void (*)(void))dlsym(handle, "plugin_init")) == NULL) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-bench: %s has no plugin_init\n", bench->plugin);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* initialize the plugin, it adds its options, hooks and notifiers. */
+	init();
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function make one login of the given user and measure the time of the hook. */
+int32_t pppd__bench_login(struct pppd_bench *bench, uint32_t user, uint32_t *seed, struct pppd_bench_login *login) {
+
+	/* some common variables. */
+	uint8_t name[MAXNAMELEN];
+	uint8_t password[MAXSECRETLEN];
+	uint8_t challenge[SHIM_CHALLENGE + 1];
+	uint8_t peer_challenge[SHIM_CHALLENGE];
+	uint8_t response[SHIM_MSCHAPV2_RESPONSE + 1];
+	uint8_t message[256];
+	uint32_t count                   = 0;
+	int32_t id                       = 0;
+	int32_t result                   = 0;
+	char *msg                        = NULL;
+	struct wordlist *addresses       = NULL;
+	struct wordlist *options         = NULL;
+	struct chap_digest_type *digest  = NULL;
+	struct timespec start;
+	struct timespec stop;
+
+	/* the credentials of the user, like the generated users. */
+	snprintf((char *)name, sizeof(name), "%s%u", bench->user_prefix, user);
+	snprintf((char *)password, sizeof(password), "%s%u", bench->pass_prefix, user);
+
+	/* a random challenge and identifier, like the ppp daemon sends to the peer. */
+	challenge[0] = SHIM_CHALLENGE;
+	for (count = 0; count < SHIM_CHALLENGE; count++) {
+		challenge[count + 1] = rand_r(seed);
+		peer_challenge[count] = rand_r(seed);
+	}
+	id = rand_r(seed) & 0xff;
+
+	/* the response of the peer is computed before the measurement. */
+	if (bench->auth == BENCH_AUTH_MD5) {
+		digest = &pppd_shim_md5;
+		result = pppd__shim_md5_response(response, id, password, strlen((char *)password), challenge);
+	}
+	if (bench->auth == BENCH_AUTH_MSCHAPV2) {
+		digest = &pppd_shim_mschapv2;
+		result = pppd__shim_mschapv2_response(response, name, password, strlen((char *)password), challenge, peer_challenge);
+	}
+
+	/* check if response was computed. */
+	if (result < 0) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-bench: cannot compute the chap response\n");
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* call the hook like the ppp daemon on a received response or pap request. */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (bench->auth == BENCH_AUTH_PAP) {
+		result = pap_auth_hook((char *)name, (char *)password, &msg, &addresses, &options);
+	} else {
+		result = chap_verify_hook((char *)name, hostname, id, digest, challenge, response, (char *)message, sizeof(message));
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	/* store the result of the login. */
+	login->latency  = (uint64_t)(stop.tv_sec - start.tv_sec) * 1000000000 + stop.tv_nsec - start.tv_nsec;
+	login->accepted = result == 1 ? 1 : 0;
+	login->done     = 1;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function is the worker process which makes the logins of one ppp daemon after another. */
+int32_t pppd__bench_worker(struct pppd_bench *bench, uint32_t number) {
+
+	/* some common variables. */
+	struct pppd_bench_login *login = NULL;
+	uint32_t seed                  = getpid() ^ time(NULL);
+	uint32_t count                 = 0;
+
+	/* the phase change runs the startup of the plugin once per process, like the ppp daemon entering authentication. */
+	pppd__shim_notify(phasechange, PHASE_AUTHENTICATE);
+
+	/* loop through the logins of this process. */
+	for (count = 0; count < bench->logins; count++) {
+
+		/* check if login was made. */
+		login = &bench->results[number * bench->logins + count];
+		if (pppd__bench_login(bench, rand_r(&seed) % bench->users, &seed, login) < 0) {
+			return -1;
+		}
+
+		/* check if a session should follow the accepted login. */
+		if (bench->session == 1 && login->accepted == 1) {
+
+			/* the ppp daemon asks the plugin for the address of the peer before ipcp is up. */
+			if (ip_choose_hook != NULL) {
+				ip_choose_hook(&ipcp_hisoptions[0].hisaddr);
+			}
+
+			/* the link goes up and down at once. */
+			pppd__shim_notify(ip_up_notifier, 0);
+			pppd__shim_notify(ip_down_notifier, 0);
+		}
+	}
+
+	/* the ppp daemon exits. */
+	pppd__shim_notify(exitnotify, 0);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function compare two latencies for sorting. */
+int pppd__bench_compare(const void *first, const void *second) {
+
+	/* some common variables. */
+	uint64_t a = *(const uint64_t *)first;
+	uint64_t b = *(const uint64_t *)second;
+
+	/* return the order. */
+	return a < b ? -1 : a > b ? 1 : 0;
+}
+
+/* this function show the logins per second and the latency percentiles. */
+int32_t pppd__bench_report(struct pppd_bench *bench, double seconds) {
+
+	/* some common variables. */
+	uint64_t *latencies = NULL;
+	uint64_t sum        = 0;
+	uint32_t total      = bench->processes * bench->logins;
+	uint32_t count      = 0;
+	uint32_t done       = 0;
+	uint32_t accepted   = 0;
+	uint32_t index      = 0;
+	double quantiles[4] = { 0.5, 0.9, 0.99, 0.999 };
+	double values[4];
+
+	/* check if memory was allocated. */
+	if ((latencies = malloc(sizeof(uint64_t) * (total > 0 ? total : 1))) == NULL) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-bench: out of memory\n");
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* collect the latencies of all made logins, a crashed process leaves the rest of its logins undone. */
+	for (count = 0; count < total; count++) {
+		if (bench->results[count].done == 1) {
+			latencies[done++] = bench->results[count].latency;
+			sum              += bench->results[count].latency;
+			accepted         += bench->results[count].accepted;
+		}
+	}
+
+	/* the percentiles are exact, by the nearest rank of the sorted latencies. */
+	qsort(latencies, done, sizeof(uint64_t), pppd__bench_compare);
+	for (count = 0; count < 4; count++) {
+		index         = quantiles[count] * done;
+		values[count] = done > 0 ? latencies[index < done ? index : done - 1] / 1000000.0 : 0.0;
+	}
+
+	/* show the throughput. */
+	fprintf(stdout, "%-20s %12u\n", "processes", bench->processes);
+	fprintf(stdout, "%-20s %12u\n", "logins", done);
+	fprintf(stdout, "%-20s %12u\n", "accepted", accepted);
+	fprintf(stdout, "%-20s %12u\n", "rejected", done - accepted);
+	fprintf(stdout, "%-20s %12.3f\n", "seconds", seconds);
+	fprintf(stdout, "%-20s %12.1f\n", "logins/sec", seconds > 0 ? done / seconds : 0.0);
+
+	/* show the latencies of the hook in milliseconds. */
+	fprintf(stdout, "\n");
+	fprintf(stdout, "%-10s %12s %12s %12s %12s %12s %12s\n", "latency", "mean", "p50", "p90", "p99", "p999", "max");
+	fprintf(stdout, "%-10s %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f\n", "ms",
+		done > 0 ? sum / 1000000.0 / done : 0.0,
+		values[0], values[1], values[2], values[3],
+		done > 0 ? latencies[done - 1] / 1000000.0 : 0.0);
+
+	/* check if logins were rejected or not made. */
+	if (done - accepted > 0) {
+		fprintf(stderr, "pppd-sql-bench: %u logins rejected%s\n", done - accepted, pppd_shim_verbose == 0 ? ", show the reason with -v" : "");
+	}
+	if (done < total) {
+		fprintf(stderr, "pppd-sql-bench: %u logins not made\n", total - done);
+	}
+
+	/* free the latencies. */
+	free(latencies);
+
+	/* return with error if not every login was made and accepted. */
+	return accepted == total ? 0 : 1;
+}
+
+/* the load generator. */
+int main(int argc, char **argv) {
+
+	/* some common variables. */
+	uint8_t *type    = (uint8_t *)"mysql";
+	uint32_t users   = 0;
+	uint32_t count   = 0;
+	int32_t option   = 0;
+	int32_t status   = 0;
+	pid_t pid        = 0;
+	struct pppd_bench bench;
+	struct timespec start;
+	struct timespec stop;
+
+	/* initialize the bench with the defaults. */
+	memset(&bench, 0, sizeof(bench));
+	bench.auth        = BENCH_AUTH_MD5;
+	bench.processes   = 4;
+	bench.logins      = 1000;
+	bench.users       = 10000;
+	bench.user_prefix = (uint8_t *)"user";
+	bench.pass_prefix = (uint8_t *)"pass";
+
+	/* parse the command line, options of the plugin follow the plugin. */
+	while ((option = getopt(argc, argv, "+a:c:n:U:u:w:Svg:t:")) != -1) {
+		switch (option) {
+			case 'a':
+				if (strcmp(optarg, "pap") == 0) {
+					bench.auth = BENCH_AUTH_PAP;
+				} else if (strcmp(optarg, "chap-md5") == 0) {
+					bench.auth = BENCH_AUTH_MD5;
+				} else if (strcmp(optarg, "mschapv2") == 0) {
+					bench.auth = BENCH_AUTH_MSCHAPV2;
+				} else {
+					return pppd__bench_usage((uint8_t *)argv[0]);
+				}
+				break;
+			case 'c':
+				bench.processes = strtoul(optarg, NULL, 10);
+				break;
+			case 'n':
+				bench.logins = strtoul(optarg, NULL, 10);
+				break;
+			case 'U':
+				bench.users = strtoul(optarg, NULL, 10);
+				break;
+			case 'u':
+				bench.user_prefix = (uint8_t *)optarg;
+				break;
+			case 'w':
+				bench.pass_prefix = (uint8_t *)optarg;
+				break;
+			case 'S':
+				bench.session = 1;
+				break;
+			case 'v':
+				pppd_shim_verbose = 1;
+				break;
+			case 'g':
+				users = strtoul(optarg, NULL, 10);
+				break;
+			case 't':
+				type = (uint8_t *)optarg;
+				break;
+			default:
+				return pppd__bench_usage((uint8_t *)argv[0]);
+		}
+	}
+
+	/* check if users should be generated instead of logins. */
+	if (users > 0) {
+		return pppd__bench_generate(users, type, bench.user_prefix, bench.pass_prefix);
+	}
+
+	/* check if plugin is given and the numbers are valid. */
+	if (optind >= argc || bench.users == 0 || bench.logins == 0 ||
+	    bench.processes == 0 || bench.processes > BENCH_PROCESSES) {
+		return pppd__bench_usage((uint8_t *)argv[0]);
+	}
+
+	/* check if plugin was loaded. */
+	bench.plugin = (uint8_t *)argv[optind];
+	if (pppd__bench_load(&bench) < 0) {
+		return 1;
+	}
+
+	/* set the options of the plugin. */
+	for (count = optind + 1; count < argc; count++) {
+		if (pppd__shim_option((uint8_t *)argv[count]) < 0) {
+			return 1;
+		}
+	}
+
+	/* check if plugin authenticates with the given protocol, like the ppp daemon asks the check hooks. */
+	if ((bench.auth == BENCH_AUTH_PAP && (pap_auth_hook == NULL || (pap_check_hook != NULL && pap_check_hook() == 0))) ||
+	    (bench.auth != BENCH_AUTH_PAP && (chap_verify_hook == NULL || (chap_check_hook != NULL && chap_check_hook() == 0)))) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-bench: %s does not authenticate with %s\n", bench.plugin, bench.auth == BENCH_AUTH_PAP ? "pap" : "chap");
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* check if results were mapped, the worker processes write into the same pages. */
+	if ((bench.results = mmap(NULL, sizeof(struct pppd_bench_login) * bench.processes * bench.logins, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-bench: cannot map the results\n");
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* the log of the plugin must not be written twice by the buffer inherited by the workers. */
+	fflush(stdout);
+	fflush(stderr);
+
+	/* start one process per concurrent ppp daemon. */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (count = 0; count < bench.processes; count++) {
+
+		/* check if process was created. */
+		if ((pid = fork()) < 0) {
+
+			/* show the error, the started processes are finished and reported. */
+			fprintf(stderr, "pppd-sql-bench: cannot create process %u\n", count);
+			break;
+		}
+
+		/* run the logins in the child. */
+		if (pid == 0) {
+			_exit(pppd__bench_worker(&bench, count) == 0 ? 0 : 1);
+		}
+	}
+
+	/* wait until all processes have finished. */
+	while ((pid = wait(&status)) > 0) {
+
+		/* check if process failed. */
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "pppd-sql-bench: process %u failed\n", (uint32_t)pid);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	/* show the results. */
+	return pppd__bench_report(&bench, (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1000000000.0);
+}
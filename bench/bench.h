@@ -0,0 +1,101 @@
+/*
+ *  bench.h -- Load generator which drives the authentication hooks of the
+ *             MySQL or PostgreSQL Plugin from concurrent processes.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+/* generic includes. */
+#include <stdint.h>
+
+/* define bench constants. */
+#define BENCH_PROCESSES			1024		/* the maximum number of concurrent processes. */
+#define BENCH_ADDRESS			0x0a000000	/* the first address of the generated users, 10.0.0.0. */
+#define BENCH_SERVER			0x0afffffe	/* the server address of the generated users, 10.255.255.254. */
+
+/* define authentication protocols. */
+#define BENCH_AUTH_PAP			0		/* password authentication protocol. */
+#define BENCH_AUTH_MD5			1		/* chap with md5. */
+#define BENCH_AUTH_MSCHAPV2		2		/* chap with ms-chapv2. */
+
+/* the result of one login, written by the worker process. */
+struct pppd_bench_login {
+	uint64_t	latency;		/* the time spent in the hook in nanoseconds. */
+	uint32_t	done;			/* one if the login was made. */
+	uint32_t	accepted;		/* one if the login was accepted. */
+};
+
+/* the options of the load generator and the results shared with the worker processes. */
+struct pppd_bench {
+	uint8_t		*plugin;		/* the path of the plugin. */
+	uint32_t	auth;			/* the authentication protocol. */
+	uint32_t	processes;		/* the number of concurrent processes. */
+	uint32_t	logins;			/* the number of logins of each process. */
+	uint32_t	users;			/* the number of users, each login picks one at random. */
+	uint8_t		*user_prefix;		/* the username is the prefix and the number of the user. */
+	uint8_t		*pass_prefix;		/* the password is the prefix and the number of the user. */
+	uint32_t	session;		/* one if the ip up and ip down notifiers are called after an accepted login. */
+	struct pppd_bench_login	*results;	/* the results of all logins, mapped shared before the fork. */
+};
+
+/* this function show the usage of the load generator. */
+int32_t pppd__bench_usage(
+	uint8_t		*program
+);
+
+/* this function print the generated users as csv for the import tool. */
+int32_t pppd__bench_generate(
+	uint32_t	users,
+	uint8_t		*type,
+	uint8_t		*user_prefix,
+	uint8_t		*pass_prefix
+);
+
+/* this function load the plugin like the plugin option of the ppp daemon. */
+int32_t pppd__bench_load(
+	struct pppd_bench	*bench
+);
+
+/* this function make one login of the given user and measure the time of the hook. */
+int32_t pppd__bench_login(
+	struct pppd_bench	*bench,
+	uint32_t	user,
+	uint32_t	*seed,
+	struct pppd_bench_login	*login
+);
+
+/* this function is the worker process which makes the logins of one ppp daemon after another. */
+int32_t pppd__bench_worker(
+	struct pppd_bench	*bench,
+	uint32_t	number
+);
+
+/* this function compare two latencies for sorting. */
+int pppd__bench_compare(
+	const void	*first,
+	const void	*second
+);
+
+/* this function show the logins per second and the latency percentiles. */
+int32_t pppd__bench_report(
+	struct pppd_bench	*bench,
+	double		seconds
+);
+
+#endif					/* _BENCH_H */
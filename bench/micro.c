@@ -0,0 +1,445 @@
+/*
+ *  micro.c -- Microbenchmark of the password and string functions which are
+ *             called on every login of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* openssl includes. */
+#include <openssl/opensslv.h>
+
+/* plugin includes. */
+#include "micro.h"
+#include "password.h"
+#include "pppd-sql.h"
+#include "str.h"
+
+/* the names of the measured functions, in the order of the constants. */
+const char *pppd_micro_functions[] = { "verify", "decrypt", "htoi", "strsep" };
+
+/* the names of the encryption algorithms, in the order of the constants. */
+const char *pppd_micro_encryptions[] = { "NONE", "CRYPT", "MD5", "AES" };
+
+/* the sum of all results, so the compiler cannot drop a call. */
+volatile int32_t pppd_micro_sink = 0;
+
+/* this function show the usage of the microbenchmark. */
+int32_t pppd__micro_usage(uint8_t *program) {
+
+	/* show usage. */
+	fprintf(stderr, "Usage: %s [-l lengths] [-t milliseconds] [-r runs] [-b baseline] [-x percent]\n", program);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Measure the nanoseconds per call of the password verification and decryption\n");
+	fprintf(stderr, "of every encryption, and of the hex and token parsing, with matching and not\n");
+	fprintf(stderr, "matching input. The results are comma separated, one line per case.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -l lengths          the comma separated password lengths, 1 to %u (default: 8,16,32,64,96)\n", SIZE_SECRET / 2 - SIZE_AES - 1);
+	fprintf(stderr, "  -t milliseconds     the measured time of each case (default: 500)\n");
+	fprintf(stderr, "  -r runs             the number of runs of each case, the median is compared (default: 5)\n");
+	fprintf(stderr, "  -b baseline         the results of a previous run, the change is shown for each case\n");
+	fprintf(stderr, "  -x percent          the change which is a regression, the exit code is one then (default: 10)\n");
+
+	/* return with error. */
+	return 1;
+}
+
+/* this function prepare the inputs of the given case. */
+int32_t pppd__micro_prepare(struct pppd_micro_case *micro, uint32_t function, uint32_t encryption, uint32_t length, uint32_t hit) {
+
+	/* some common variables. */
+	static const uint8_t hex[]     = "0123456789abcdefABCDEF";
+	static const uint8_t invalid[] = "ghijklmnopqrstuvwxyzGHIJKLMNOPQRSTUVWXYZ";
+	uint32_t count = 0;
+
+	/* initialize the case. */
+	memset(micro, 0, sizeof(struct pppd_micro_case));
+	micro->function   = function;
+	micro->encryption = encryption;
+	micro->length     = length;
+	micro->hit        = hit;
+	micro->calls      = 1;
+	micro->key        = (uint8_t *)(encryption == PPPD_SQL_ENCRYPTION_CRYPT ? MICRO_SALT : MICRO_KEY);
+
+	/* a printable password of the given length. */
+	for (count = 0; count < length; count++) {
+		micro->passwd[count] = 'a' + (count * 7) % 26;
+	}
+
+	/* check if password is verified or decrypted, the secret is stored like the import tools do. */
+	if (function == MICRO_VERIFY || function == MICRO_DECRYPT) {
+
+		/* check if secret was encoded. */
+		if (pppd__encode_password(micro->passwd, encryption, micro->key, micro->secret, sizeof(micro->secret)) < 0) {
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+		micro->secret_length = strlen((char *)micro->secret);
+
+		/* a wrong password differs in the first character, crypt() only uses the first eight. */
+		if (function == MICRO_VERIFY && hit == 0) {
+			micro->passwd[0] ^= 1;
+		}
+
+		/* a wrong key fails the aes padding check, the other algorithms ignore the key. */
+		if (function == MICRO_DECRYPT && hit == 0 && encryption == PPPD_SQL_ENCRYPTION_AES) {
+			micro->key = (uint8_t *)MICRO_KEY_MISS;
+		}
+	}
+
+	/* check if hex characters are converted, one call per character. */
+	if (function == MICRO_HTOI) {
+		for (count = 0; count < length; count++) {
+			micro->secret[count] = hit == 1 ? hex[count % (sizeof(hex) - 1)] : invalid[count % (sizeof(invalid) - 1)];
+		}
+		micro->calls = length;
+	}
+
+	/* check if string is split, one call per token of eight characters or one call without delimiter. */
+	if (function == MICRO_STRSEP) {
+		for (count = 0; count < length; count++) {
+			if (hit == 1 && count % 8 == 7) {
+				micro->secret[count] = ',';
+				micro->calls++;
+			} else {
+				micro->secret[count] = micro->passwd[count];
+			}
+		}
+		micro->secret_length = length;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function call the function of the given case and return the elapsed nanoseconds. */
+uint64_t pppd__micro_run(struct pppd_micro_case *micro, uint64_t iterations) {
+
+	/* some common variables. */
+	uint64_t count     = 0;
+	uint32_t character = 0;
+	int32_t length     = 0;
+	uint8_t *string    = NULL;
+	struct timespec start;
+	struct timespec stop;
+
+	/* call the function the given number of times. */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	switch (micro->function) {
+		case MICRO_VERIFY:
+			for (count = 0; count < iterations; count++) {
+				pppd_micro_sink += pppd__verify_password(micro->passwd, micro->secret, micro->encryption, micro->key);
+			}
+			break;
+		case MICRO_DECRYPT:
+
+			/* the secret is decrypted in place, like the row buffer of the database. */
+			for (count = 0; count < iterations; count++) {
+				memcpy(micro->work, micro->secret, micro->secret_length + 1);
+				length = micro->secret_length;
+				pppd_micro_sink += pppd__decrypt_password(micro->work, &length, micro->encryption, micro->key);
+			}
+			break;
+		case MICRO_HTOI:
+			for (count = 0; count < iterations; count++) {
+				for (character = 0; character < micro->length; character++) {
+					pppd_micro_sink += pppd__htoi(micro->secret[character]);
+				}
+			}
+			break;
+		case MICRO_STRSEP:
+
+			/* the string is split in place, like the server lists of the options. */
+			for (count = 0; count < iterations; count++) {
+				memcpy(micro->work, micro->secret, micro->secret_length + 1);
+				string = micro->work;
+				while (pppd__strsep(&string, (uint8_t *)",") != NULL) {
+					pppd_micro_sink++;
+				}
+			}
+			break;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	/* return the elapsed time. */
+	return (uint64_t)(stop.tv_sec - start.tv_sec) * 1000000000 + stop.tv_nsec - start.tv_nsec;
+}
+
+/* this function measure the given case and return the minimum and median nanoseconds per call. */
+int32_t pppd__micro_measure(struct pppd_micro_case *micro, uint64_t target, uint32_t runs, uint64_t *iterations, double *minimum, double *median) {
+
+	/* some common variables. */
+	double values[MICRO_RUNS];
+	uint64_t elapsed = 0;
+	uint32_t count   = 0;
+
+	/* double the iterations until the run is long enough to be timed, this warms the caches too. */
+	*iterations = 1;
+	while ((elapsed = pppd__micro_run(micro, *iterations)) < MICRO_CALIBRATE) {
+		*iterations *= 2;
+	}
+
+	/* scale the iterations, so all runs take the target time. */
+	*iterations = (double)*iterations * (target / runs) / elapsed;
+	if (*iterations == 0) {
+		*iterations = 1;
+	}
+
+	/* loop through all runs. */
+	for (count = 0; count < runs; count++) {
+		values[count] = (double)pppd__micro_run(micro, *iterations) / (*iterations * micro->calls);
+	}
+
+	/* the minimum is the best case, the median is robust against a noisy run. */
+	qsort(values, runs, sizeof(double), pppd__micro_compare);
+	*minimum = values[0];
+	*median  = values[runs / 2];
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function compare two measurements for sorting. */
+int pppd__micro_compare(const void *first, const void *second) {
+
+	/* some common variables. */
+	double a = *(const double *)first;
+	double b = *(const double *)second;
+
+	/* return the order. */
+	return a < b ? -1 : a > b ? 1 : 0;
+}
+
+/* this function read the results of a previous run. */
+int32_t pppd__micro_baseline(uint8_t *path, struct pppd_micro_baseline *baseline, uint32_t *count) {
+
+	/* some common variables. */
+	uint8_t line[1024];
+	FILE *file = NULL;
+
+	/* check if file was opened. */
+	if ((file = fopen((char *)path, "r")) == NULL) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-micro: cannot open baseline %s\n", path);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* loop through all lines, the header and lines of other formats are skipped. */
+	while (*count < MICRO_CASES && fgets((char *)line, sizeof(line), file) != NULL) {
+		if (sscanf((char *)line, "%*[^,],%15[^,],%15[^,],%u,%7[^,],%*[^,],%*[^,],%lf",
+			   baseline[*count].function, baseline[*count].encryption, &baseline[*count].length,
+			   baseline[*count].result, &baseline[*count].median) == 5) {
+			(*count)++;
+		}
+	}
+
+	/* close the file. */
+	fclose(file);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function measure the given case and show its result, a regression is returned as one. */
+int32_t pppd__micro_report(struct pppd_micro_case *micro, uint64_t target, uint32_t runs, struct pppd_micro_baseline *baseline, uint32_t baseline_count, double threshold) {
+
+	/* some common variables. */
+	const char *function   = pppd_micro_functions[micro->function];
+	const char *encryption = micro->function == MICRO_VERIFY || micro->function == MICRO_DECRYPT ? pppd_micro_encryptions[micro->encryption] : "-";
+	const char *result     = micro->hit == 1 ? "hit" : "miss";
+	uint64_t iterations    = 0;
+	uint32_t count         = 0;
+	double minimum         = 0;
+	double median          = 0;
+	double change          = 0;
+
+	/* measure the case. */
+	pppd__micro_measure(micro, target, runs, &iterations, &minimum, &median);
+
+	/* show the result, the openssl version allows comparing results of different builds. */
+	fprintf(stdout, "%s,%s,%s,%u,%s,%llu,%.1f,%.1f", OPENSSL_VERSION_TEXT, function, encryption, micro->length, result, (unsigned long long)iterations, minimum, median);
+
+	/* check if no baseline is given. */
+	if (baseline_count == 0) {
+		fprintf(stdout, "\n");
+		fflush(stdout);
+		return 0;
+	}
+
+	/* loop through the baseline until the same case is found. */
+	for (count = 0; count < baseline_count; count++) {
+		if (strcmp((char *)baseline[count].function, function) == 0 &&
+		    strcmp((char *)baseline[count].encryption, encryption) == 0 &&
+		    strcmp((char *)baseline[count].result, result) == 0 &&
+		    baseline[count].length == micro->length &&
+		    baseline[count].median > 0) {
+			break;
+		}
+	}
+
+	/* check if case is new. */
+	if (count == baseline_count) {
+		fprintf(stdout, ",,\n");
+		fflush(stdout);
+		return 0;
+	}
+
+	/* show the change of the median. */
+	change = (median - baseline[count].median) * 100 / baseline[count].median;
+	fprintf(stdout, ",%.1f,%+.1f\n", baseline[count].median, change);
+	fflush(stdout);
+
+	/* check if case is slower than allowed. */
+	if (change > threshold) {
+
+		/* show the regression. */
+		fprintf(stderr, "pppd-sql-micro: %s %s length %u %s is %.1f%% slower than the baseline\n", function, encryption, micro->length, result, change);
+
+		/* return the regression. */
+		return 1;
+	}
+
+	/* return without regression. */
+	return 0;
+}
+
+/* the microbenchmark. */
+int main(int argc, char **argv) {
+
+	/* some common variables. */
+	struct pppd_micro_case micro;
+	struct pppd_micro_baseline *baseline = NULL;
+	uint32_t lengths[MICRO_LENGTHS];
+	uint8_t list[256];
+	uint8_t *string          = NULL;
+	uint8_t *token           = NULL;
+	uint8_t *path            = NULL;
+	uint64_t target          = 500;
+	uint32_t runs            = 5;
+	uint32_t length_count    = 0;
+	uint32_t baseline_count  = 0;
+	uint32_t regressions     = 0;
+	uint32_t function        = 0;
+	uint32_t encryption      = 0;
+	uint32_t length          = 0;
+	int32_t hit              = 0;
+	int32_t option           = 0;
+	double threshold         = 10;
+
+	/* the default password lengths. */
+	snprintf((char *)list, sizeof(list), "8,16,32,64,96");
+
+	/* parse the command line. */
+	while ((option = getopt(argc, argv, "l:t:r:b:x:")) != -1) {
+		switch (option) {
+			case 'l':
+				snprintf((char *)list, sizeof(list), "%s", optarg);
+				break;
+			case 't':
+				target = strtoull(optarg, NULL, 10);
+				break;
+			case 'r':
+				runs = strtoul(optarg, NULL, 10);
+				break;
+			case 'b':
+				path = (uint8_t *)optarg;
+				break;
+			case 'x':
+				threshold = strtod(optarg, NULL);
+				break;
+			default:
+				return pppd__micro_usage((uint8_t *)argv[0]);
+		}
+	}
+
+	/* loop through the given lengths. */
+	string = list;
+	while ((token = pppd__strsep(&string, (uint8_t *)",")) != NULL) {
+
+		/* check if length is valid, the padded aes result must fit into the secret. */
+		length = strtoul((char *)token, NULL, 10);
+		if (length == 0 || length >= SIZE_SECRET / 2 - SIZE_AES || length_count == MICRO_LENGTHS) {
+			return pppd__micro_usage((uint8_t *)argv[0]);
+		}
+		lengths[length_count++] = length;
+	}
+
+	/* check if the numbers are valid. */
+	if (optind != argc || target == 0 || runs == 0 || runs > MICRO_RUNS) {
+		return pppd__micro_usage((uint8_t *)argv[0]);
+	}
+
+	/* the target time of each case in nanoseconds. */
+	target *= 1000000;
+
+	/* check if a baseline is given. */
+	if (path != NULL) {
+
+		/* check if memory was allocated and baseline was read. */
+		if ((baseline = calloc(MICRO_CASES, sizeof(struct pppd_micro_baseline))) == NULL ||
+		    pppd__micro_baseline(path, baseline, &baseline_count) < 0) {
+			return 1;
+		}
+	}
+
+	/* show the columns. */
+	fprintf(stdout, "openssl,function,encryption,length,result,iterations,ns_min,ns_median%s\n", path != NULL ? ",baseline_ns_median,change_percent" : "");
+
+	/* loop through all functions, encryptions, lengths and the matching and not matching input. */
+	for (function = MICRO_VERIFY; function <= MICRO_STRSEP; function++) {
+		for (encryption = PPPD_SQL_ENCRYPTION_NONE; encryption <= PPPD_SQL_ENCRYPTION_AES; encryption++) {
+
+			/* the string functions do not depend on the encryption. */
+			if (function != MICRO_VERIFY && function != MICRO_DECRYPT && encryption != PPPD_SQL_ENCRYPTION_NONE) {
+				break;
+			}
+
+			/* loop through all lengths. */
+			for (length = 0; length < length_count; length++) {
+				for (hit = 1; hit >= 0; hit--) {
+
+					/* check if case was prepared. */
+					if (pppd__micro_prepare(&micro, function, encryption, lengths[length], hit) < 0) {
+
+						/* show the error. */
+						fprintf(stderr, "pppd-sql-micro: cannot encode a %s password of length %u\n", pppd_micro_encryptions[encryption], lengths[length]);
+
+						/* return with error. */
+						return 1;
+					}
+
+					/* measure and show the case. */
+					regressions += pppd__micro_report(&micro, target, runs, baseline, baseline_count, threshold);
+				}
+			}
+		}
+	}
+
+	/* free the baseline. */
+	free(baseline);
+
+	/* return with error if a case is slower than the baseline. */
+	return regressions > 0 ? 1 : 0;
+}
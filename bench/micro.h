@@ -0,0 +1,122 @@
+/*
+ *  micro.h -- Microbenchmark of the password and string functions which are
+ *             called on every login of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MICRO_H
+#define _MICRO_H
+
+/* generic includes. */
+#include <stdint.h>
+#include <stdio.h>
+
+/* plugin includes. */
+#include "pppd-sql.h"
+
+/* define micro constants. */
+#define MICRO_LENGTHS			16		/* the maximum number of secret lengths. */
+#define MICRO_RUNS			64		/* the maximum number of runs of one case. */
+#define MICRO_CASES			512		/* the maximum number of cases of a baseline. */
+#define MICRO_CALIBRATE			10000000	/* the minimum time of the calibration run in nanoseconds. */
+#define MICRO_KEY			"0123456789abcdef"	/* the aes key of the secrets. */
+#define MICRO_KEY_MISS			"fedcba9876543210"	/* the wrong aes key of a failed decryption. */
+#define MICRO_SALT			"ab"		/* the salt of the crypt secrets. */
+
+/* define measured functions. */
+#define MICRO_VERIFY			0		/* pppd__verify_password(). */
+#define MICRO_DECRYPT			1		/* pppd__decrypt_password(). */
+#define MICRO_HTOI			2		/* pppd__htoi(), one call per character. */
+#define MICRO_STRSEP			3		/* pppd__strsep(), one call per token. */
+
+/* one measured case, the inputs are prepared before the measurement. */
+struct pppd_micro_case {
+	uint32_t	function;		/* the measured function. */
+	uint32_t	encryption;		/* the password encryption algorithm. */
+	uint32_t	length;			/* the length of the password or string. */
+	uint32_t	hit;			/* one if the password matches, the key is right or the delimiter is found. */
+	uint32_t	calls;			/* the number of calls of the function per iteration. */
+	uint8_t		*key;			/* the key or salt of the encryption. */
+	uint8_t		passwd[SIZE_SECRET];	/* the password given by the peer. */
+	uint8_t		secret[SIZE_SECRET];	/* the secret as stored in the database, or the input string. */
+	uint8_t		work[SIZE_SECRET];	/* the copy of the secret which is changed by the function. */
+	int32_t		secret_length;		/* the length of the secret. */
+};
+
+/* one result of a baseline. */
+struct pppd_micro_baseline {
+	uint8_t		function[16];		/* the name of the function. */
+	uint8_t		encryption[16];		/* the name of the encryption. */
+	uint32_t	length;			/* the length of the password or string. */
+	uint8_t		result[8];		/* hit or miss. */
+	double		median;			/* the median nanoseconds per call. */
+};
+
+/* this function show the usage of the microbenchmark. */
+int32_t pppd__micro_usage(
+	uint8_t		*program
+);
+
+/* this function prepare the inputs of the given case. */
+int32_t pppd__micro_prepare(
+	struct pppd_micro_case	*micro,
+	uint32_t	function,
+	uint32_t	encryption,
+	uint32_t	length,
+	uint32_t	hit
+);
+
+/* this function call the function of the given case and return the elapsed nanoseconds. */
+uint64_t pppd__micro_run(
+	struct pppd_micro_case	*micro,
+	uint64_t	iterations
+);
+
+/* this function measure the given case and return the minimum and median nanoseconds per call. */
+int32_t pppd__micro_measure(
+	struct pppd_micro_case	*micro,
+	uint64_t	target,
+	uint32_t	runs,
+	uint64_t	*iterations,
+	double		*minimum,
+	double		*median
+);
+
+/* this function compare two measurements for sorting. */
+int pppd__micro_compare(
+	const void	*first,
+	const void	*second
+);
+
+/* this function read the results of a previous run. */
+int32_t pppd__micro_baseline(
+	uint8_t		*path,
+	struct pppd_micro_baseline	*baseline,
+	uint32_t	*count
+);
+
+/* this function measure the given case and show its result, a regression is returned as one. */
+int32_t pppd__micro_report(
+	struct pppd_micro_case	*micro,
+	uint64_t	target,
+	uint32_t	runs,
+	struct pppd_micro_baseline	*baseline,
+	uint32_t	baseline_count,
+	double		threshold
+);
+
+#endif					/* _MICRO_H */
@@ -0,0 +1,680 @@
+/*
+ *  proxy.c -- Local TCP proxy between the Plugin and the MySQL or PostgreSQL
+ *             database which injects latency, stalls, resets and refused
+ *             connects.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* bench includes. */
+#include "proxy.h"
+
+/* this function show the usage of the proxy. */
+int32_t pppd__proxy_usage(uint8_t *program) {
+
+	/* show usage. */
+	fprintf(stderr, "Usage: %s -l [host:]port -u host:port [-d latency] [-s probability:ms]\n", program);
+	fprintf(stderr, "       [-x probability] [-c probability] [-b probability] [-o connections] [-S seed] [-v]\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Forward the connections of the plugin to the database and inject faults. The faults\n");
+	fprintf(stderr, "of a connection only depend on the seed and the number of the connection, so a run\n");
+	fprintf(stderr, "with the same seed and the same logins hits the same statements.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -l [host:]port      the address the plugin connects to (default host: 127.0.0.1)\n");
+	fprintf(stderr, "  -u host:port        the address of the database\n");
+	fprintf(stderr, "  -d latency          the delay of every chunk from the database in milliseconds:\n");
+	fprintf(stderr, "                      fixed:ms, uniform:min:max, exp:mean or normal:mean:stddev\n");
+	fprintf(stderr, "  -s probability:ms   stall a chunk of either side for the given milliseconds\n");
+	fprintf(stderr, "  -x probability      reset the connection at a chunk of either side\n");
+	fprintf(stderr, "  -c probability      reset a new connection before it reaches the database\n");
+	fprintf(stderr, "  -b probability      accept a new connection but never answer it\n");
+	fprintf(stderr, "  -o connections      reset the given number of first connections, like a restarting database\n");
+	fprintf(stderr, "  -S seed             the seed of the random faults (default: 1)\n");
+	fprintf(stderr, "  -v                  log every connection and fault\n");
+
+	/* return with error. */
+	return 1;
+}
+
+/* this function split the given host:port, the host is optional if a default is given. */
+int32_t pppd__proxy_address(uint8_t *address, uint8_t *host, uint8_t **port, const uint8_t *default_host) {
+
+	/* some common variables. */
+	uint8_t *separator = NULL;
+	uint32_t length    = 0;
+
+	/* check if address has a host, the last colon separates the port of an ipv6 address. */
+	if ((separator = (uint8_t *)strrchr((char *)address, ':')) == NULL) {
+
+		/* check if a default host is given. */
+		if (default_host == NULL) {
+			return -1;
+		}
+
+		/* the address is the port. */
+		snprintf((char *)host, PROXY_ADDRESS, "%s", default_host);
+		*port = address;
+
+		/* if no error was found, return zero. */
+		return 0;
+	}
+
+	/* check if host fits, brackets around an ipv6 address are removed. */
+	length = separator - address;
+	if (length > 1 && address[0] == '[' && address[length - 1] == ']') {
+		address++;
+		length -= 2;
+	}
+	if (length == 0 || length >= PROXY_ADDRESS || separator[1] == '\0') {
+		return -1;
+	}
+
+	/* copy the host and point to the port. */
+	memcpy(host, address, length);
+	host[length] = '\0';
+	*port        = separator + 1;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function parse the latency distribution like exp:5 or uniform:1:20. */
+int32_t pppd__proxy_distribution(uint8_t *spec, struct pppd_proxy_latency *latency) {
+
+	/* initialize the distribution. */
+	memset(latency, 0, sizeof(struct pppd_proxy_latency));
+
+	/* check which distribution is given. */
+	if (sscanf((char *)spec, "fixed:%lf", &latency->first) == 1) {
+		latency->kind = PROXY_LATENCY_FIXED;
+	} else if (sscanf((char *)spec, "uniform:%lf:%lf", &latency->first, &latency->second) == 2 && latency->first <= latency->second) {
+		latency->kind = PROXY_LATENCY_UNIFORM;
+	} else if (sscanf((char *)spec, "exp:%lf", &latency->first) == 1) {
+		latency->kind = PROXY_LATENCY_EXP;
+	} else if (sscanf((char *)spec, "normal:%lf:%lf", &latency->first, &latency->second) == 2 && latency->second >= 0) {
+		latency->kind = PROXY_LATENCY_NORMAL;
+	} else {
+		return -1;
+	}
+
+	/* check if times are valid. */
+	if (latency->first < 0) {
+		return -1;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function parse a probability with an optional time like 0.01:500. */
+int32_t pppd__proxy_probability(uint8_t *spec, double *probability, uint32_t *time) {
+
+	/* some common variables. */
+	int32_t fields = 0;
+
+	/* check if probability and the time, if one is wanted, were given. */
+	if (time != NULL) {
+		fields = sscanf((char *)spec, "%lf:%u", probability, time) == 2 ? 0 : -1;
+	} else {
+		fields = sscanf((char *)spec, "%lf", probability) == 1 ? 0 : -1;
+	}
+
+	/* check if probability is valid. */
+	if (fields < 0 || *probability < 0 || *probability > 1) {
+		return -1;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function return the next random number of the connection, the sequence only depends on the seed. */
+uint64_t pppd__proxy_random(uint64_t *state) {
+
+	/* some common variables. */
+	uint64_t value = 0;
+
+	/* the splitmix64 generator, every state gives a well mixed value. */
+	*state += 0x9e3779b97f4a7c15ULL;
+	value   = *state;
+	value   = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	value   = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+
+	/* return the random number. */
+	return value ^ (value >> 31);
+}
+
+/* this function return a random number between zero and one. */
+double pppd__proxy_uniform(uint64_t *state) {
+
+	/* the upper 53 bits fill the mantissa, one is never returned. */
+	return (pppd__proxy_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* this function return a random latency of the distribution in milliseconds. */
+double pppd__proxy_sample(struct pppd_proxy_latency *latency, uint64_t *state) {
+
+	/* some common variables. */
+	double value = 0;
+
+	/* sample the distribution. */
+	switch (latency->kind) {
+		case PROXY_LATENCY_FIXED:
+			value = latency->first;
+			break;
+		case PROXY_LATENCY_UNIFORM:
+			value = latency->first + (latency->second - latency->first) * pppd__proxy_uniform(state);
+			break;
+		case PROXY_LATENCY_EXP:
+			value = -latency->first * log(1.0 - pppd__proxy_uniform(state));
+			break;
+		case PROXY_LATENCY_NORMAL:
+
+			/* the box-muller transform of two uniform numbers. */
+			value = latency->first + latency->second * sqrt(-2.0 * log(1.0 - pppd__proxy_uniform(state))) * cos(2.0 * M_PI * pppd__proxy_uniform(state));
+			break;
+	}
+
+	/* the delay cannot be negative. */
+	return value > 0 ? value : 0;
+}
+
+/* this function sleep the given milliseconds. */
+int32_t pppd__proxy_sleep(double milliseconds) {
+
+	/* some common variables. */
+	struct timespec remaining;
+
+	/* check if sleep is needed. */
+	if (milliseconds <= 0) {
+		return 0;
+	}
+
+	/* sleep the whole time, a signal does not shorten it. */
+	remaining.tv_sec  = milliseconds / 1000;
+	remaining.tv_nsec = (milliseconds - remaining.tv_sec * 1000.0) * 1000000;
+	while (nanosleep(&remaining, &remaining) < 0 && errno == EINTR);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function close the socket with a reset instead of a regular shutdown. */
+int32_t pppd__proxy_reset(int32_t socket) {
+
+	/* some common variables. */
+	struct linger linger;
+
+	/* a zero linger time sends a reset on close. */
+	linger.l_onoff  = 1;
+	linger.l_linger = 0;
+	setsockopt(socket, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+
+	/* close the socket. */
+	close(socket);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function log a fault of the given connection. */
+int32_t pppd__proxy_log(struct pppd_proxy *proxy, struct pppd_proxy_connection *connection, const char *format, ...) {
+
+	/* some common variables. */
+	va_list arguments;
+
+	/* check if faults are logged. */
+	if (proxy->verbose == 0) {
+		return 0;
+	}
+
+	/* show the message with the connection and its chunks, the chunks locate the fault in the protocol. */
+	fprintf(stderr, "pppd-sql-proxy: connection %u chunk %u: ", connection->number, connection->chunks);
+	va_start(arguments, format);
+	vfprintf(stderr, format, arguments);
+	va_end(arguments);
+	fprintf(stderr, "\n");
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function open the listening socket. */
+int32_t pppd__proxy_listen(struct pppd_proxy *proxy) {
+
+	/* some common variables. */
+	struct addrinfo hints;
+	struct addrinfo *addresses = NULL;
+	int32_t result             = 0;
+	int32_t server             = -1;
+	int32_t reuse              = 1;
+
+	/* check if listen address was resolved. */
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags    = AI_PASSIVE;
+	if ((result = getaddrinfo((char *)proxy->listen_host, (char *)proxy->listen_port, &hints, &addresses)) != 0) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-proxy: %s:%s: %s\n", proxy->listen_host, proxy->listen_port, gai_strerror(result));
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* check if socket was created, bound and is listening, a restarted proxy reuses the port at once. */
+	if ((server = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol)) < 0 ||
+	    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+	    bind(server, addresses->ai_addr, addresses->ai_addrlen) < 0 ||
+	    listen(server, SOMAXCONN) < 0) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-proxy: %s:%s: %s\n", proxy->listen_host, proxy->listen_port, strerror(errno));
+
+		/* close the socket. */
+		if (server >= 0) {
+			close(server);
+		}
+
+		/* free the addresses. */
+		freeaddrinfo(addresses);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* free the addresses. */
+	freeaddrinfo(addresses);
+
+	/* return the socket. */
+	return server;
+}
+
+/* this function connect to the database. */
+int32_t pppd__proxy_connect(struct pppd_proxy *proxy) {
+
+	/* some common variables. */
+	struct addrinfo hints;
+	struct addrinfo *addresses = NULL;
+	struct addrinfo *address   = NULL;
+	int32_t server             = -1;
+	int32_t nodelay            = 1;
+
+	/* check if database address was resolved. */
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo((char *)proxy->upstream_host, (char *)proxy->upstream_port, &hints, &addresses) != 0) {
+		return -1;
+	}
+
+	/* loop through all addresses until one is connected. */
+	for (address = addresses; address != NULL; address = address->ai_next) {
+
+		/* check if socket was created and connected. */
+		if ((server = socket(address->ai_family, address->ai_socktype, address->ai_protocol)) >= 0 &&
+		    connect(server, address->ai_addr, address->ai_addrlen) == 0) {
+			break;
+		}
+
+		/* close the socket. */
+		if (server >= 0) {
+			close(server);
+			server = -1;
+		}
+	}
+
+	/* free the addresses. */
+	freeaddrinfo(addresses);
+
+	/* the chunks are forwarded at once, the delays are only the injected ones. */
+	if (server >= 0) {
+		setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+	}
+
+	/* return the socket. */
+	return server;
+}
+
+/* this function forward one chunk, one is returned if the connection was closed. */
+int32_t pppd__proxy_forward(struct pppd_proxy *proxy, struct pppd_proxy_connection *connection, int32_t from, int32_t to) {
+
+	/* some common variables. */
+	uint8_t buffer[PROXY_BUFFER];
+	ssize_t size    = 0;
+	ssize_t written = 0;
+	ssize_t result  = 0;
+	double delay    = 0;
+
+	/* check if chunk was read, zero is the regular close of the side. */
+	if ((size = read(from, buffer, sizeof(buffer))) < 0 && errno == EINTR) {
+		return 0;
+	}
+	if (size <= 0) {
+		pppd__proxy_log(proxy, connection, "closed by the %s", from == connection->client ? "plugin" : "database");
+		return 1;
+	}
+	connection->chunks++;
+
+	/* check if connection should be reset, both sides see the reset. */
+	if (pppd__proxy_uniform(&connection->state) < proxy->reset_probability) {
+
+		/* log the fault. */
+		pppd__proxy_log(proxy, connection, "reset at a chunk of %zd bytes from the %s", size, from == connection->client ? "plugin" : "database");
+
+		/* reset both sides. */
+		pppd__proxy_reset(connection->client);
+		pppd__proxy_reset(connection->server);
+
+		/* return the closed connection. */
+		return 1;
+	}
+
+	/* check if chunk should stall, like a lost packet which is retransmitted. */
+	if (pppd__proxy_uniform(&connection->state) < proxy->stall_probability) {
+
+		/* log the fault. */
+		pppd__proxy_log(proxy, connection, "stall for %u ms", proxy->stall);
+
+		/* stall the chunk. */
+		pppd__proxy_sleep(proxy->stall);
+	}
+
+	/* check if chunk comes from the database, every response is delayed by the distribution. */
+	if (from == connection->server && proxy->latency.kind != PROXY_LATENCY_NONE) {
+		delay = pppd__proxy_sample(&proxy->latency, &connection->state);
+		pppd__proxy_sleep(delay);
+	}
+
+	/* loop until the whole chunk is written. */
+	while (written < size) {
+
+		/* check if write failed, the other side is gone. */
+		if ((result = write(to, buffer + written, size - written)) < 0) {
+
+			/* check if write was interrupted. */
+			if (errno == EINTR) {
+				continue;
+			}
+
+			/* return the closed connection. */
+			return 1;
+		}
+		written += result;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function handle one connection of the plugin until it is closed. */
+int32_t pppd__proxy_session(struct pppd_proxy *proxy, struct pppd_proxy_connection *connection) {
+
+	/* some common variables. */
+	struct pollfd sockets[2];
+	uint8_t buffer[PROXY_BUFFER];
+	uint32_t fate = PROXY_CONNECTION_FORWARD;
+	ssize_t size  = 0;
+	double random = 0;
+
+	/* the fate of the connection, an outage refuses the first connections regardless of the seed. */
+	random = pppd__proxy_uniform(&connection->state);
+	if (connection->number <= proxy->outage || random < proxy->refuse_probability) {
+		fate = PROXY_CONNECTION_REFUSE;
+	} else if (random < proxy->refuse_probability + proxy->blackhole_probability) {
+		fate = PROXY_CONNECTION_BLACKHOLE;
+	}
+
+	/* check if connection should be refused, the plugin sees a reset during the handshake. */
+	if (fate == PROXY_CONNECTION_REFUSE) {
+
+		/* log the fault. */
+		pppd__proxy_log(proxy, connection, "refused");
+
+		/* reset the connection. */
+		pppd__proxy_reset(connection->client);
+
+		/* return the handled connection. */
+		return 0;
+	}
+
+	/* check if connection should not be answered, the plugin waits for its connect or read timeout. */
+	if (fate == PROXY_CONNECTION_BLACKHOLE) {
+
+		/* log the fault. */
+		pppd__proxy_log(proxy, connection, "blackholed");
+
+		/* discard everything until the plugin gives up. */
+		while ((size = read(connection->client, buffer, sizeof(buffer))) != 0) {
+			if (size < 0 && errno != EINTR) {
+				break;
+			}
+		}
+		close(connection->client);
+
+		/* return the handled connection. */
+		return 0;
+	}
+
+	/* check if database was connected, the plugin sees the same reset as a refused connect. */
+	if ((connection->server = pppd__proxy_connect(proxy)) < 0) {
+
+		/* show the error, this is no injected fault. */
+		fprintf(stderr, "pppd-sql-proxy: connection %u: cannot connect to %s:%s\n", connection->number, proxy->upstream_host, proxy->upstream_port);
+
+		/* reset the connection. */
+		pppd__proxy_reset(connection->client);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* log the forwarded connection. */
+	pppd__proxy_log(proxy, connection, "forwarded");
+
+	/* wait for chunks of both sides. */
+	sockets[0].fd     = connection->client;
+	sockets[0].events = POLLIN;
+	sockets[1].fd     = connection->server;
+	sockets[1].events = POLLIN;
+
+	/* loop until one side is closed or reset. */
+	while (1) {
+
+		/* check if waiting failed. */
+		if (poll(sockets, 2, -1) < 0) {
+
+			/* check if waiting was interrupted. */
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		/* check if plugin sent a chunk, errors and hangups are read as close. */
+		if (sockets[0].revents != 0 &&
+		    pppd__proxy_forward(proxy, connection, connection->client, connection->server) == 1) {
+			return 0;
+		}
+
+		/* check if database sent a chunk. */
+		if (sockets[1].revents != 0 &&
+		    pppd__proxy_forward(proxy, connection, connection->server, connection->client) == 1) {
+			return 0;
+		}
+	}
+
+	/* close both sides. */
+	close(connection->client);
+	close(connection->server);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* the fault-injecting proxy. */
+int main(int argc, char **argv) {
+
+	/* some common variables. */
+	struct pppd_proxy proxy;
+	struct pppd_proxy_connection connection;
+	uint8_t *listen_address   = NULL;
+	uint8_t *upstream_address = NULL;
+	uint32_t number           = 0;
+	int32_t option            = 0;
+	int32_t server            = -1;
+	int32_t client            = -1;
+	int32_t nodelay           = 1;
+	pid_t pid                 = 0;
+
+	/* initialize the proxy with the defaults. */
+	memset(&proxy, 0, sizeof(proxy));
+	proxy.seed = 1;
+
+	/* parse the command line. */
+	while ((option = getopt(argc, argv, "l:u:d:s:x:c:b:o:S:v")) != -1) {
+		switch (option) {
+			case 'l':
+				listen_address = (uint8_t *)optarg;
+				break;
+			case 'u':
+				upstream_address = (uint8_t *)optarg;
+				break;
+			case 'd':
+				if (pppd__proxy_distribution((uint8_t *)optarg, &proxy.latency) < 0) {
+					return pppd__proxy_usage((uint8_t *)argv[0]);
+				}
+				break;
+			case 's':
+				if (pppd__proxy_probability((uint8_t *)optarg, &proxy.stall_probability, &proxy.stall) < 0) {
+					return pppd__proxy_usage((uint8_t *)argv[0]);
+				}
+				break;
+			case 'x':
+				if (pppd__proxy_probability((uint8_t *)optarg, &proxy.reset_probability, NULL) < 0) {
+					return pppd__proxy_usage((uint8_t *)argv[0]);
+				}
+				break;
+			case 'c':
+				if (pppd__proxy_probability((uint8_t *)optarg, &proxy.refuse_probability, NULL) < 0) {
+					return pppd__proxy_usage((uint8_t *)argv[0]);
+				}
+				break;
+			case 'b':
+				if (pppd__proxy_probability((uint8_t *)optarg, &proxy.blackhole_probability, NULL) < 0) {
+					return pppd__proxy_usage((uint8_t *)argv[0]);
+				}
+				break;
+			case 'o':
+				proxy.outage = strtoul(optarg, NULL, 10);
+				break;
+			case 'S':
+				proxy.seed = strtoull(optarg, NULL, 10);
+				break;
+			case 'v':
+				proxy.verbose = 1;
+				break;
+			default:
+				return pppd__proxy_usage((uint8_t *)argv[0]);
+		}
+	}
+
+	/* check if both addresses are given and valid. */
+	if (listen_address == NULL || upstream_address == NULL || optind != argc ||
+	    pppd__proxy_address(listen_address, proxy.listen_host, &proxy.listen_port, (uint8_t *)"127.0.0.1") < 0 ||
+	    pppd__proxy_address(upstream_address, proxy.upstream_host, &proxy.upstream_port, NULL) < 0) {
+		return pppd__proxy_usage((uint8_t *)argv[0]);
+	}
+
+	/* check if refused and blackholed connections are not more than all. */
+	if (proxy.refuse_probability + proxy.blackhole_probability > 1) {
+		return pppd__proxy_usage((uint8_t *)argv[0]);
+	}
+
+	/* check if listening socket was opened. */
+	if ((server = pppd__proxy_listen(&proxy)) < 0) {
+		return 1;
+	}
+
+	/* the finished connection processes are reaped by the kernel, a reset side must not kill the proxy. */
+	signal(SIGCHLD, SIG_IGN);
+	signal(SIGPIPE, SIG_IGN);
+
+	/* loop until the proxy is terminated. */
+	while (1) {
+
+		/* check if connection was accepted. */
+		if ((client = accept(server, NULL, NULL)) < 0) {
+
+			/* check if accept was interrupted. */
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+
+			/* show the error. */
+			fprintf(stderr, "pppd-sql-proxy: cannot accept: %s\n", strerror(errno));
+
+			/* return with error. */
+			return 1;
+		}
+		setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+		/* every connection has its own random sequence, independent of the timing of the others. */
+		memset(&connection, 0, sizeof(connection));
+		connection.number = ++number;
+		connection.state  = proxy.seed * 0x100000001b3ULL + number;
+		connection.client = client;
+		connection.server = -1;
+
+		/* check if process was created. */
+		if ((pid = fork()) < 0) {
+
+			/* show the error. */
+			fprintf(stderr, "pppd-sql-proxy: connection %u: cannot create process: %s\n", number, strerror(errno));
+
+			/* reset the connection. */
+			pppd__proxy_reset(client);
+			continue;
+		}
+
+		/* handle the connection in the child. */
+		if (pid == 0) {
+			close(server);
+			_exit(pppd__proxy_session(&proxy, &connection) == 0 ? 0 : 1);
+		}
+
+		/* the child owns the connection. */
+		close(client);
+	}
+}
@@ -0,0 +1,161 @@
+/*
+ *  proxy.h -- Local TCP proxy between the Plugin and the MySQL or PostgreSQL
+ *             database which injects latency, stalls, resets and refused
+ *             connects.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PROXY_H
+#define _PROXY_H
+
+/* generic includes. */
+#include <stdint.h>
+
+/* define proxy constants. */
+#define PROXY_BUFFER			16384		/* the maximum size of a forwarded chunk. */
+#define PROXY_ADDRESS			256		/* the maximum length of a host:port address. */
+
+/* define latency distributions. */
+#define PROXY_LATENCY_NONE		0		/* the responses are not delayed. */
+#define PROXY_LATENCY_FIXED		1		/* every response is delayed by the same time. */
+#define PROXY_LATENCY_UNIFORM		2		/* uniform between minimum and maximum. */
+#define PROXY_LATENCY_EXP		3		/* exponential with the given mean, a long tail. */
+#define PROXY_LATENCY_NORMAL		4		/* normal with mean and standard deviation, cut at zero. */
+
+/* define what happens to a new connection. */
+#define PROXY_CONNECTION_FORWARD	0		/* the connection is forwarded to the database. */
+#define PROXY_CONNECTION_REFUSE		1		/* the connection is reset before it reaches the database. */
+#define PROXY_CONNECTION_BLACKHOLE	2		/* the connection is accepted but never answered. */
+
+/* the latency distribution of the responses in milliseconds. */
+struct pppd_proxy_latency {
+	uint32_t	kind;			/* the distribution. */
+	double		first;			/* the fixed time, the minimum or the mean. */
+	double		second;			/* the maximum or the standard deviation. */
+};
+
+/* the options of the proxy. */
+struct pppd_proxy {
+	uint8_t		listen_host[PROXY_ADDRESS];	/* the address the plugin connects to. */
+	uint8_t		*listen_port;		/* the port the plugin connects to. */
+	uint8_t		upstream_host[PROXY_ADDRESS];	/* the address of the database. */
+	uint8_t		*upstream_port;		/* the port of the database. */
+	struct pppd_proxy_latency	latency;	/* the delay of every chunk from the database. */
+	double		stall_probability;	/* the probability that a chunk of either side stalls. */
+	uint32_t	stall;			/* the time of a stall in milliseconds. */
+	double		reset_probability;	/* the probability that a chunk resets the connection. */
+	double		refuse_probability;	/* the probability that a new connection is refused. */
+	double		blackhole_probability;	/* the probability that a new connection is never answered. */
+	uint32_t	outage;			/* the number of first connections which are refused. */
+	uint64_t	seed;			/* the seed of the random faults. */
+	uint32_t	verbose;		/* one if every fault is logged. */
+};
+
+/* one forwarded connection, it is handled by its own process. */
+struct pppd_proxy_connection {
+	uint32_t	number;			/* the number of the connection, counted from one. */
+	uint64_t	state;			/* the random state, derived from the seed and the number. */
+	uint32_t	chunks;			/* the number of forwarded chunks. */
+	int32_t		client;			/* the socket of the plugin. */
+	int32_t		server;			/* the socket of the database. */
+};
+
+/* this function show the usage of the proxy. */
+int32_t pppd__proxy_usage(
+	uint8_t		*program
+);
+
+/* this function split the given host:port, the host is optional if a default is given. */
+int32_t pppd__proxy_address(
+	uint8_t		*address,
+	uint8_t		*host,
+	uint8_t		**port,
+	const uint8_t	*default_host
+);
+
+/* this function parse the latency distribution like exp:5 or uniform:1:20. */
+int32_t pppd__proxy_distribution(
+	uint8_t		*spec,
+	struct pppd_proxy_latency	*latency
+);
+
+/* this function parse a probability with an optional time like 0.01:500. */
+int32_t pppd__proxy_probability(
+	uint8_t		*spec,
+	double		*probability,
+	uint32_t	*time
+);
+
+/* this function return the next random number of the connection, the sequence only depends on the seed. */
+uint64_t pppd__proxy_random(
+	uint64_t	*state
+);
+
+/* this function return a random number between zero and one. */
+double pppd__proxy_uniform(
+	uint64_t	*state
+);
+
+/* this function return a random latency of the distribution in milliseconds. */
+double pppd__proxy_sample(
+	struct pppd_proxy_latency	*latency,
+	uint64_t	*state
+);
+
+/* this function sleep the given milliseconds. */
+int32_t pppd__proxy_sleep(
+	double		milliseconds
+);
+
+/* this function close the socket with a reset instead of a regular shutdown. */
+int32_t pppd__proxy_reset(
+	int32_t		socket
+);
+
+/* this function log a fault of the given connection. */
+int32_t pppd__proxy_log(
+	struct pppd_proxy	*proxy,
+	struct pppd_proxy_connection	*connection,
+	const char	*format,
+	...
+);
+
+/* this function open the listening socket. */
+int32_t pppd__proxy_listen(
+	struct pppd_proxy	*proxy
+);
+
+/* this function connect to the database. */
+int32_t pppd__proxy_connect(
+	struct pppd_proxy	*proxy
+);
+
+/* this function forward one chunk, one is returned if the connection was closed. */
+int32_t pppd__proxy_forward(
+	struct pppd_proxy	*proxy,
+	struct pppd_proxy_connection	*connection,
+	int32_t		from,
+	int32_t		to
+);
+
+/* this function handle one connection of the plugin until it is closed. */
+int32_t pppd__proxy_session(
+	struct pppd_proxy	*proxy,
+	struct pppd_proxy_connection	*connection
+);
+
+#endif					/* _PROXY_H */
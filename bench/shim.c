@@ -0,0 +1,779 @@
+/*
+ *  shim.c -- The part of the Point-to-Point Protocol daemon which is used by
+ *            the Plugin, so the load generator can drive its hooks.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* configuration includes. */
+#include "config.h"
+
+/* autoconf declares VERSION which is declared in pppd.h too. */
+#ifdef VERSION
+#undef VERSION
+#endif
+
+/* generic includes. */
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* openssl includes. */
+#include <openssl/des.h>
+#include <openssl/evp.h>
+#include <openssl/md4.h>
+
+/* ppp generic includes. */
+#include <pppd/chap-new.h>
+#include <pppd/pppd.h>
+
+/* ppp ipcp includes. */
+#include <pppd/fsm.h>
+#include <pppd/ipcp.h>
+
+/* shim includes. */
+#include "shim.h"
+
+/* the authentication hooks, set by the plugin. */
+int (*pap_check_hook)(void)                                                                                = NULL;
+int (*pap_auth_hook)(char *, char *, char **, struct wordlist **, struct wordlist **)                       = NULL;
+int (*chap_check_hook)(void)                                                                               = NULL;
+int (*chap_verify_hook)(char *, char *, int, struct chap_digest_type *, unsigned char *, unsigned char *, char *, int) = NULL;
+void (*ip_choose_hook)(u_int32_t *)                                                                        = NULL;
+int (*allowed_address_hook)(u_int32_t)                                                                     = NULL;
+
+/* the notifier lists, extended by the plugin. */
+struct notifier *ip_up_notifier   = NULL;
+struct notifier *ip_down_notifier = NULL;
+struct notifier *phasechange      = NULL;
+struct notifier *exitnotify       = NULL;
+
+/* the link which is given to the scripts and the accounting, the load generator has no interface. */
+char ifname[MAXIFNAMELEN]       = "ppp0";
+char devnam[MAXPATHLEN]         = "/dev/null";
+char hostname[MAXNAMELEN]       = "pppd-sql-bench";
+char *ipparam                   = NULL;
+int baud_rate                   = 0;
+int ifunit                      = 0;
+int link_stats_valid            = 0;
+unsigned link_connect_time      = 0;
+struct pppd_stats link_stats;
+ipcp_options ipcp_gotoptions[NUM_PPP];
+ipcp_options ipcp_hisoptions[NUM_PPP];
+
+/* the option tables added by the plugin. */
+option_t *pppd_shim_options[SHIM_OPTIONS];
+
+/* one if the log messages of the plugin are shown. */
+uint32_t pppd_shim_verbose = 0;
+
+/* the chap md5 digest, the plugin calls the verify function with the secret from the database. */
+struct chap_digest_type pppd_shim_md5 = {
+	.code            = CHAP_MD5,
+	.verify_response = pppd__shim_md5_verify,
+};
+
+/* the ms-chapv2 digest, the plugin calls the verify function with the secret from the database. */
+struct chap_digest_type pppd_shim_mschapv2 = {
+	.code            = CHAP_MICROSOFT_V2,
+	.verify_response = pppd__shim_mschapv2_verify,
+};
+
+/* this function format like the ppp daemon, %q is shown as string and %I as dotted quad. */
+int32_t pppd__shim_format(char *buffer, int32_t size, char *format, va_list args) {
+
+	/* some common variables. */
+	char spec[32];
+	char address[16];
+	uint8_t *octets       = NULL;
+	uint8_t *string       = NULL;
+	uint32_t spec_length  = 0;
+	uint32_t longs        = 0;
+	int32_t length        = 0;
+	int32_t written       = 0;
+	int32_t saved_errno   = errno;
+	u_int32_t ip          = 0;
+	char conversion       = 0;
+
+	/* check if buffer has space for the terminator. */
+	if (size <= 0) {
+		return 0;
+	}
+
+	/* loop through the format until the buffer is full. */
+	while (*format != '\0' && length < size - 1) {
+
+		/* copy the characters which are no conversion. */
+		if (*format != '%') {
+			buffer[length++] = *format++;
+			continue;
+		}
+
+		/* collect the flags, width, precision and length of the conversion. */
+		spec_length         = 0;
+		longs               = 0;
+		spec[spec_length++] = *format++;
+		while (*format != '\0' && strchr("-+ #0123456789.hlzjt", *format) != NULL && spec_length < sizeof(spec) - 2) {
+
+			/* count the length modifiers which are wider than int. */
+			if (*format == 'l' || *format == 'z' || *format == 'j' || *format == 't') {
+				longs++;
+			}
+			spec[spec_length++] = *format++;
+		}
+
+		/* check if format ends within the conversion. */
+		if (*format == '\0') {
+			break;
+		}
+
+		/* the ppp daemon conversions are shown as string, %m is the error of the caller. */
+		conversion          = *format++;
+		spec[spec_length++] = (conversion == 'q' || conversion == 'I' || conversion == 'm') ? 's' : conversion;
+		spec[spec_length]   = '\0';
+
+		/* format the argument of the conversion. */
+		switch (conversion) {
+			case 'd':
+			case 'i':
+				if (longs > 1) {
+					written = snprintf(buffer + length, size - length, spec, va_arg(args, long long));
+				} else if (longs == 1) {
+					written = snprintf(buffer + length, size - length, spec, va_arg(args, long));
+				} else {
+					written = snprintf(buffer + length, size - length, spec, va_arg(args, int));
+				}
+				break;
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+				if (longs > 1) {
+					written = snprintf(buffer + length, size - length, spec, va_arg(args, unsigned long long));
+				} else if (longs == 1) {
+					written = snprintf(buffer + length, size - length, spec, va_arg(args, unsigned long));
+				} else {
+					written = snprintf(buffer + length, size - length, spec, va_arg(args, unsigned int));
+				}
+				break;
+			case 'c':
+				written = snprintf(buffer + length, size - length, spec, va_arg(args, int));
+				break;
+			case 'e':
+			case 'f':
+			case 'g':
+				written = snprintf(buffer + length, size - length, spec, va_arg(args, double));
+				break;
+			case 'p':
+				written = snprintf(buffer + length, size - length, spec, va_arg(args, void *));
+				break;
+			case 's':
+			case 'q':
+				string  = va_arg(args, uint8_t *);
+				written = snprintf(buffer + length, size - length, spec, string != NULL ? (char *)string : "(null)");
+				break;
+			case 'I':
+				ip      = va_arg(args, u_int32_t);
+				octets  = (uint8_t *)&ip;
+				snprintf(address, sizeof(address), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+				written = snprintf(buffer + length, size - length, spec, address);
+				break;
+			case 'm':
+				written = snprintf(buffer + length, size - length, spec, strerror(saved_errno));
+				break;
+			case '%':
+				written = snprintf(buffer + length, size - length, "%%");
+				break;
+			default:
+				written = snprintf(buffer + length, size - length, "%s", spec);
+				break;
+		}
+
+		/* check if formatting failed. */
+		if (written < 0) {
+			break;
+		}
+
+		/* the output is truncated at the end of the buffer. */
+		length += written;
+		if (length > size - 1) {
+			length = size - 1;
+		}
+	}
+
+	/* terminate the output. */
+	buffer[length] = '\0';
+
+	/* return the length of the output. */
+	return length;
+}
+
+/* this function show a log message of the plugin if verbose. */
+int32_t pppd__shim_log(uint8_t *level, char *format, va_list args) {
+
+	/* some common variables. */
+	char message[SHIM_FORMAT];
+	int32_t length = 0;
+
+	/* check if log messages are shown. */
+	if (pppd_shim_verbose == 0) {
+		return 0;
+	}
+
+	/* format the message and remove the newline, most messages of the plugin end with one. */
+	length = pppd__shim_format(message, sizeof(message), format, args);
+	if (length > 0 && message[length - 1] == '\n') {
+		message[length - 1] = '\0';
+	}
+
+	/* show the message with the process, the workers log concurrently. */
+	fprintf(stderr, "[%u] %s: %s\n", (uint32_t)getpid(), level, message);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function log a debug message. */
+void dbglog(char *format, ...) {
+
+	/* some common variables. */
+	va_list args;
+
+	/* log the message. */
+	va_start(args, format);
+	pppd__shim_log((uint8_t *)"debug", format, args);
+	va_end(args);
+}
+
+/* this function log an informational message. */
+void info(char *format, ...) {
+
+	/* some common variables. */
+	va_list args;
+
+	/* log the message. */
+	va_start(args, format);
+	pppd__shim_log((uint8_t *)"info", format, args);
+	va_end(args);
+}
+
+/* this function log a notice. */
+void notice(char *format, ...) {
+
+	/* some common variables. */
+	va_list args;
+
+	/* log the message. */
+	va_start(args, format);
+	pppd__shim_log((uint8_t *)"notice", format, args);
+	va_end(args);
+}
+
+/* this function log a warning. */
+void warn(char *format, ...) {
+
+	/* some common variables. */
+	va_list args;
+
+	/* log the message. */
+	va_start(args, format);
+	pppd__shim_log((uint8_t *)"warn", format, args);
+	va_end(args);
+}
+
+/* this function log an error. */
+void error(char *format, ...) {
+
+	/* some common variables. */
+	va_list args;
+
+	/* log the message. */
+	va_start(args, format);
+	pppd__shim_log((uint8_t *)"error", format, args);
+	va_end(args);
+}
+
+/* this function log a fatal error and terminate the process like the ppp daemon. */
+void fatal(char *format, ...) {
+
+	/* some common variables. */
+	va_list args;
+
+	/* a fatal error is always shown. */
+	pppd_shim_verbose = 1;
+
+	/* log the message. */
+	va_start(args, format);
+	pppd__shim_log((uint8_t *)"fatal", format, args);
+	va_end(args);
+
+	/* terminate the process. */
+	exit(1);
+}
+
+/* this function format into the given buffer like the ppp daemon. */
+int slprintf(char *buffer, int size, char *format, ...) {
+
+	/* some common variables. */
+	va_list args;
+	int32_t length = 0;
+
+	/* format the arguments. */
+	va_start(args, format);
+	length = pppd__shim_format(buffer, size, format, args);
+	va_end(args);
+
+	/* return the length of the output. */
+	return length;
+}
+
+/* this function terminate the link, which is the process of the load generator. */
+void die(int status) {
+
+	/* terminate the process. */
+	exit(status);
+}
+
+/* this function add an option table of the plugin. */
+void add_options(option_t *options) {
+
+	/* some common variables. */
+	uint32_t count = 0;
+
+	/* find the first free table. */
+	for (count = 0; count < SHIM_OPTIONS && pppd_shim_options[count] != NULL; count++);
+
+	/* check if table fits, the plugin adds only one. */
+	if (count == SHIM_OPTIONS) {
+		fatal("too many option tables");
+	}
+
+	/* store the table. */
+	pppd_shim_options[count] = options;
+}
+
+/* this function return the option of the plugin with the given name. */
+option_t *pppd__shim_find(uint8_t *name) {
+
+	/* some common variables. */
+	option_t *option = NULL;
+	uint32_t count   = 0;
+
+	/* loop through all tables. */
+	for (count = 0; count < SHIM_OPTIONS && pppd_shim_options[count] != NULL; count++) {
+
+		/* loop through all options of the table. */
+		for (option = pppd_shim_options[count]; option->name != NULL; option++) {
+
+			/* check if option has the given name. */
+			if (strcmp(option->name, (char *)name) == 0) {
+				return option;
+			}
+		}
+	}
+
+	/* the option is unknown. */
+	return NULL;
+}
+
+/* this function set an option of the plugin given as name=value, a bool option is given by name. */
+int32_t pppd__shim_option(uint8_t *argument) {
+
+	/* some common variables. */
+	uint8_t name[MAXNAMELEN];
+	uint8_t *value   = NULL;
+	option_t *option = NULL;
+
+	/* split the argument into name and value. */
+	snprintf((char *)name, sizeof(name), "%s", argument);
+	if ((value = (uint8_t *)strchr((char *)name, '=')) != NULL) {
+		*value++ = '\0';
+	}
+
+	/* check if option is known. */
+	if ((option = pppd__shim_find(name)) == NULL) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-bench: unknown option %s\n", name);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* check if option needs a value, only a bool option is given without one. */
+	if ((option->type == o_bool) != (value == NULL)) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-bench: option %s %s\n", name, value == NULL ? "needs a value" : "takes no value");
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* set the option like the ppp daemon. */
+	switch (option->type) {
+		case o_bool:
+			*(int *)option->addr = option->flags & OPT_VALUE;
+			break;
+		case o_int:
+			*(int *)option->addr = strtol((char *)value, NULL, 0);
+			break;
+		case o_uint32:
+			*(u_int32_t *)option->addr = strtoul((char *)value, NULL, 0);
+			break;
+		case o_string:
+			*(char **)option->addr = strdup((char *)value);
+			break;
+		default:
+
+			/* show the error. */
+			fprintf(stderr, "pppd-sql-bench: option %s has an unsupported type\n", name);
+
+			/* return with error. */
+			return -1;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function add a function to the given notifier list. */
+void add_notifier(struct notifier **notifier, notify_func func, void *arg) {
+
+	/* some common variables. */
+	struct notifier *entry = NULL;
+
+	/* check if memory was allocated. */
+	if ((entry = malloc(sizeof(struct notifier))) == NULL) {
+		fatal("out of memory in add_notifier");
+	}
+
+	/* append the function, the ppp daemon calls the notifiers in the order of adding. */
+	entry->next = NULL;
+	entry->func = func;
+	entry->arg  = arg;
+	while (*notifier != NULL) {
+		notifier = &(*notifier)->next;
+	}
+	*notifier = entry;
+}
+
+/* this function remove a function from the given notifier list. */
+void remove_notifier(struct notifier **notifier, notify_func func, void *arg) {
+
+	/* some common variables. */
+	struct notifier *entry = NULL;
+
+	/* loop through the list. */
+	while ((entry = *notifier) != NULL) {
+
+		/* check if entry is the given function. */
+		if (entry->func == func && entry->arg == arg) {
+			*notifier = entry->next;
+			free(entry);
+			return;
+		}
+		notifier = &entry->next;
+	}
+}
+
+/* this function call all functions of the given notifier list. */
+int32_t pppd__shim_notify(struct notifier *notifier, int32_t arg) {
+
+	/* some common variables. */
+	struct notifier *next = NULL;
+
+	/* loop through the list, a function may remove itself. */
+	for (; notifier != NULL; notifier = next) {
+		next = notifier->next;
+		notifier->func(notifier->arg, arg);
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function schedule a function, timers are not run, a login of the load generator has no session time. */
+void timeout(void (*func)(void *), void *arg, int seconds, int useconds) {
+}
+
+/* this function cancel a scheduled function. */
+void untimeout(void (*func)(void *), void *arg) {
+}
+
+/* this function return a secret from the secrets files, the load generator has none. */
+int get_secret(int unit, char *client, char *server, char *secret, int *secret_length, int am_server) {
+
+	/* no secret was found. */
+	return 0;
+}
+
+/* this function set a variable for the scripts. */
+void script_setenv(char *name, char *value, int internal) {
+
+	/* the scripts are started by this process and inherit the environment. */
+	setenv(name, value, 1);
+}
+
+/* this function remove a variable for the scripts. */
+void script_unsetenv(char *name) {
+
+	/* the scripts are started by this process and inherit the environment. */
+	unsetenv(name);
+}
+
+/* this function return the statistics of the link, the load generator has no traffic. */
+int get_ppp_stats(int unit, struct pppd_stats *stats) {
+
+	/* no byte or packet was transferred. */
+	memset(stats, 0, sizeof(struct pppd_stats));
+
+	/* return success. */
+	return 1;
+}
+
+/* this function update the link statistics. */
+void update_link_stats(int unit) {
+
+	/* no byte or packet was transferred. */
+	memset(&link_stats, 0, sizeof(link_stats));
+	link_stats_valid = 1;
+}
+
+/* this function start a script like the ppp daemon, zero is returned if it does not exist. */
+pid_t run_program(char *program, char **args, int must_exist, void (*done)(void *), void *arg, int wait) {
+
+	/* some common variables. */
+	int32_t status = 0;
+	pid_t pid      = 0;
+
+	/* check if script is executable. */
+	if (access(program, X_OK) != 0) {
+
+		/* check if script must exist. */
+		if (must_exist != 0 || errno != ENOENT) {
+			error("Can't execute %s: %m", program);
+		}
+
+		/* return without process. */
+		return 0;
+	}
+
+	/* check if process was created. */
+	if ((pid = fork()) < 0) {
+
+		/* something on fork failed. */
+		error("Failed to create child process for %s: %m", program);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* execute the script in the child. */
+	if (pid == 0) {
+		execv(program, args);
+		_exit(99);
+	}
+
+	/* check if the ppp daemon would wait for the script. */
+	if (wait != 0) {
+		while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+
+		/* call the function of the finished script. */
+		if (done != NULL) {
+			done(arg);
+		}
+	}
+
+	/* return the process of the script. */
+	return pid;
+}
+
+/* this function verify a chap md5 response like the chap-md5 module of the ppp daemon. */
+int pppd__shim_md5_verify(int id, char *name, unsigned char *secret, int secret_length, unsigned char *challenge, unsigned char *response, char *message, int message_space) {
+
+	/* some common variables. */
+	uint8_t expected[SHIM_MD5_RESPONSE + 1];
+
+	/* check if response has the length of a md5 digest and matches the secret. */
+	if (response[0] == SHIM_MD5_RESPONSE &&
+	    pppd__shim_md5_response(expected, id, secret, secret_length, challenge) == 0 &&
+	    memcmp(expected + 1, response + 1, SHIM_MD5_RESPONSE) == 0) {
+
+		/* the peer knows the secret. */
+		slprintf(message, message_space, "Access granted");
+
+		/* return success. */
+		return 1;
+	}
+
+	/* the peer does not know the secret. */
+	slprintf(message, message_space, "Access denied");
+
+	/* return failure. */
+	return 0;
+}
+
+/* this function compute the chap md5 response of the peer, the first byte of challenge and response is the length. */
+int32_t pppd__shim_md5_response(uint8_t *response, int32_t id, uint8_t *secret, int32_t secret_length, uint8_t *challenge) {
+
+	/* some common variables. */
+	EVP_MD_CTX *context = NULL;
+	uint8_t identifier  = id;
+	int32_t result      = 0;
+
+	/* check if context was allocated. */
+	if ((context = EVP_MD_CTX_new()) == NULL) {
+		return -1;
+	}
+
+	/* the digest of the identifier, the secret and the challenge, the challenge starts with its length. */
+	if (EVP_DigestInit_ex(context, EVP_md5(), NULL) != 1 ||
+	    EVP_DigestUpdate(context, &identifier, 1) != 1 ||
+	    EVP_DigestUpdate(context, secret, secret_length) != 1 ||
+	    EVP_DigestUpdate(context, challenge + 1, challenge[0]) != 1 ||
+	    EVP_DigestFinal_ex(context, response + 1, NULL) != 1) {
+		result = -1;
+	}
+
+	/* the response starts with its length. */
+	response[0] = SHIM_MD5_RESPONSE;
+
+	/* free the context. */
+	EVP_MD_CTX_free(context);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function compute the ms-chapv2 nt response of rfc 2759 from the challenges, the name and the secret. */
+int32_t pppd__shim_mschapv2_nt(uint8_t *nt, uint8_t *name, uint8_t *secret, int32_t secret_length, uint8_t *challenge, uint8_t *peer_challenge) {
+
+	/* some common variables. */
+	uint8_t unicode[MAXSECRETLEN * 2];
+	uint8_t digest[EVP_MAX_MD_SIZE];
+	uint8_t hash[21];
+	uint8_t *user       = NULL;
+	uint32_t count      = 0;
+	EVP_MD_CTX *context = NULL;
+	DES_cblock key;
+	DES_key_schedule schedule;
+
+	/* the challenge hash uses the name without the domain, like the ppp daemon. */
+	if ((user = (uint8_t *)strrchr((char *)name, '\\')) != NULL) {
+		user++;
+	} else {
+		user = name;
+	}
+
+	/* check if context was allocated. */
+	if ((context = EVP_MD_CTX_new()) == NULL) {
+		return -1;
+	}
+
+	/* the challenge hash is the sha1 of both challenges and the name. */
+	if (EVP_DigestInit_ex(context, EVP_sha1(), NULL) != 1 ||
+	    EVP_DigestUpdate(context, peer_challenge, SHIM_CHALLENGE) != 1 ||
+	    EVP_DigestUpdate(context, challenge, SHIM_CHALLENGE) != 1 ||
+	    EVP_DigestUpdate(context, user, strlen((char *)user)) != 1 ||
+	    EVP_DigestFinal_ex(context, digest, NULL) != 1) {
+
+		/* free the context. */
+		EVP_MD_CTX_free(context);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* free the context. */
+	EVP_MD_CTX_free(context);
+
+	/* the secret as little endian unicode. */
+	if (secret_length > MAXSECRETLEN) {
+		secret_length = MAXSECRETLEN;
+	}
+	memset(unicode, 0, sizeof(unicode));
+	for (count = 0; count < secret_length; count++) {
+		unicode[count * 2] = secret[count];
+	}
+
+	/* the password hash is the md4 of the unicode secret, padded with zeros to three des keys. */
+	memset(hash, 0, sizeof(hash));
+	MD4(unicode, secret_length * 2, hash);
+
+	/* the nt response is the first 8 bytes of the challenge hash encrypted with all three keys. */
+	for (count = 0; count < 3; count++) {
+
+		/* spread 56 bits of the password hash over the 8 bytes of the des key. */
+		key[0] = hash[count * 7];
+		key[1] = (hash[count * 7] << 7) | (hash[count * 7 + 1] >> 1);
+		key[2] = (hash[count * 7 + 1] << 6) | (hash[count * 7 + 2] >> 2);
+		key[3] = (hash[count * 7 + 2] << 5) | (hash[count * 7 + 3] >> 3);
+		key[4] = (hash[count * 7 + 3] << 4) | (hash[count * 7 + 4] >> 4);
+		key[5] = (hash[count * 7 + 4] << 3) | (hash[count * 7 + 5] >> 5);
+		key[6] = (hash[count * 7 + 5] << 2) | (hash[count * 7 + 6] >> 6);
+		key[7] = hash[count * 7 + 6] << 1;
+		DES_set_odd_parity(&key);
+		DES_set_key_unchecked(&key, &schedule);
+		DES_ecb_encrypt((const_DES_cblock *)digest, (DES_cblock *)(nt + count * 8), &schedule, DES_ENCRYPT);
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function verify a ms-chapv2 response like the chap_ms module of the ppp daemon. */
+int pppd__shim_mschapv2_verify(int id, char *name, unsigned char *secret, int secret_length, unsigned char *challenge, unsigned char *response, char *message, int message_space) {
+
+	/* some common variables. */
+	uint8_t nt[SHIM_MSCHAPV2_NT_LENGTH];
+
+	/* check if response has the length of a ms-chapv2 response and matches the secret. */
+	if (response[0] == SHIM_MSCHAPV2_RESPONSE &&
+	    challenge[0] == SHIM_CHALLENGE &&
+	    pppd__shim_mschapv2_nt(nt, (uint8_t *)name, secret, secret_length, challenge + 1, response + 1 + SHIM_MSCHAPV2_PEER) == 0 &&
+	    memcmp(nt, response + 1 + SHIM_MSCHAPV2_NT, SHIM_MSCHAPV2_NT_LENGTH) == 0) {
+
+		/* the peer knows the secret, the authenticator response is not checked by the load generator. */
+		slprintf(message, message_space, "S=0000000000000000000000000000000000000000 M=Access granted");
+
+		/* return success. */
+		return 1;
+	}
+
+	/* the peer does not know the secret. */
+	slprintf(message, message_space, "E=691 R=1 C=00000000000000000000000000000000 V=0 M=Access denied");
+
+	/* return failure. */
+	return 0;
+}
+
+/* this function compute the ms-chapv2 response of the peer, the first byte of challenge and response is the length. */
+int32_t pppd__shim_mschapv2_response(uint8_t *response, uint8_t *name, uint8_t *secret, int32_t secret_length, uint8_t *challenge, uint8_t *peer_challenge) {
+
+	/* the response is the peer challenge, 8 reserved bytes, the nt response and the flags. */
+	memset(response, 0, SHIM_MSCHAPV2_RESPONSE + 1);
+	response[0] = SHIM_MSCHAPV2_RESPONSE;
+	memcpy(response + 1 + SHIM_MSCHAPV2_PEER, peer_challenge, SHIM_CHALLENGE);
+
+	/* return the result of the nt response. */
+	return pppd__shim_mschapv2_nt(response + 1 + SHIM_MSCHAPV2_NT, name, secret, secret_length, challenge + 1, peer_challenge);
+}
@@ -0,0 +1,132 @@
+/*
+ *  shim.h -- The part of the Point-to-Point Protocol daemon which is used by
+ *            the Plugin, so the load generator can drive its hooks.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SHIM_H
+#define _SHIM_H
+
+/* generic includes. */
+#include <stdarg.h>
+#include <stdint.h>
+
+/* define shim constants. */
+#define SHIM_OPTIONS			16		/* the maximum number of option tables added by the plugin. */
+#define SHIM_FORMAT			1024		/* the maximum length of a log message. */
+#define SHIM_CHALLENGE			16		/* the length of the chap challenge. */
+#define SHIM_MD5_RESPONSE		16		/* the length of the chap md5 response. */
+#define SHIM_MSCHAPV2_RESPONSE		49		/* the length of the ms-chapv2 response. */
+#define SHIM_MSCHAPV2_PEER		0		/* the offset of the peer challenge in the ms-chapv2 response. */
+#define SHIM_MSCHAPV2_NT		24		/* the offset of the nt response in the ms-chapv2 response. */
+#define SHIM_MSCHAPV2_NT_LENGTH		24		/* the length of the nt response. */
+
+/* the option tables added by the plugin. */
+extern option_t *pppd_shim_options[SHIM_OPTIONS];
+
+/* one if the log messages of the plugin are shown. */
+extern uint32_t pppd_shim_verbose;
+
+/* the chap digests of the load generator, like the chap-md5 and chap_ms modules of the ppp daemon. */
+extern struct chap_digest_type pppd_shim_md5;
+extern struct chap_digest_type pppd_shim_mschapv2;
+
+/* this function format like the ppp daemon, %q is shown as string and %I as dotted quad. */
+int32_t pppd__shim_format(
+	char		*buffer,
+	int32_t		size,
+	char		*format,
+	va_list		args
+);
+
+/* this function show a log message of the plugin if verbose. */
+int32_t pppd__shim_log(
+	uint8_t		*level,
+	char		*format,
+	va_list		args
+);
+
+/* this function return the option of the plugin with the given name. */
+option_t *pppd__shim_find(
+	uint8_t		*name
+);
+
+/* this function set an option of the plugin given as name=value, a bool option is given by name. */
+int32_t pppd__shim_option(
+	uint8_t		*argument
+);
+
+/* this function call all functions of the given notifier list. */
+int32_t pppd__shim_notify(
+	struct notifier	*notifier,
+	int32_t		arg
+);
+
+/* this function verify a chap md5 response like the chap-md5 module of the ppp daemon. */
+int pppd__shim_md5_verify(
+	int		id,
+	char		*name,
+	unsigned char	*secret,
+	int		secret_length,
+	unsigned char	*challenge,
+	unsigned char	*response,
+	char		*message,
+	int		message_space
+);
+
+/* this function compute the chap md5 response of the peer, the first byte of challenge and response is the length. */
+int32_t pppd__shim_md5_response(
+	uint8_t		*response,
+	int32_t		id,
+	uint8_t		*secret,
+	int32_t		secret_length,
+	uint8_t		*challenge
+);
+
+/* this function compute the ms-chapv2 nt response of rfc 2759 from the challenges, the name and the secret. */
+int32_t pppd__shim_mschapv2_nt(
+	uint8_t		*nt,
+	uint8_t		*name,
+	uint8_t		*secret,
+	int32_t		secret_length,
+	uint8_t		*challenge,
+	uint8_t		*peer_challenge
+);
+
+/* this function verify a ms-chapv2 response like the chap_ms module of the ppp daemon. */
+int pppd__shim_mschapv2_verify(
+	int		id,
+	char		*name,
+	unsigned char	*secret,
+	int		secret_length,
+	unsigned char	*challenge,
+	unsigned char	*response,
+	char		*message,
+	int		message_space
+);
+
+/* this function compute the ms-chapv2 response of the peer, the first byte of challenge and response is the length. */
+int32_t pppd__shim_mschapv2_response(
+	uint8_t		*response,
+	uint8_t		*name,
+	uint8_t		*secret,
+	int32_t		secret_length,
+	uint8_t		*challenge,
+	uint8_t		*peer_challenge
+);
+
+#endif					/* _SHIM_H */
@@ -26,6 +26,12 @@ USE `ppp`;
 --
 -- Table structure for table `login`
 --
+-- The username is the primary key, so the password query is one lookup in
+-- the clustered index which also holds all fetched columns, and the lock of
+-- an exclusive login covers only this row. The addresses are stored as
+-- INET_ATON() numbers, VARBINARY(16) filled by INET6_ATON() and dotted quad
+-- strings are accepted too.
+--
 
 DROP TABLE IF EXISTS `login`;
 CREATE TABLE `login` (
@@ -33,10 +39,12 @@ CREATE TABLE `login` (
   `username` varchar(16) NOT NULL,
   `password` varchar(32) NOT NULL,
   `status` int(11) NOT NULL default '0',
-  `clientip` varchar(15) NOT NULL,
-  `serverip` varchar(15) NOT NULL,
-  PRIMARY KEY  (`id`),
-  KEY `username` (`username`)
+  `clientip` int(10) unsigned NOT NULL,
+  `serverip` int(10) unsigned NOT NULL,
+  `serverid` varchar(64) default NULL,
+  PRIMARY KEY  (`username`),
+  UNIQUE KEY `id` (`id`),
+  KEY `serverid` (`serverid`,`status`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
 
 --
@@ -47,6 +55,49 @@ LOCK TABLES `login` WRITE;
 /*!40000 ALTER TABLE `login` DISABLE KEYS */;
 /*!40000 ALTER TABLE `login` ENABLE KEYS */;
 UNLOCK TABLES;
+
+--
+-- Table structure for table `accounting`
+--
+
+DROP TABLE IF EXISTS `accounting`;
+CREATE TABLE `accounting` (
+  `id` int(11) NOT NULL auto_increment,
+  `session` varchar(64) default NULL,
+  `username` varchar(16) NOT NULL,
+  `received` bigint(20) unsigned NOT NULL default '0',
+  `transmitted` bigint(20) unsigned NOT NULL default '0',
+  `duration` int(11) unsigned NOT NULL default '0',
+  `stop` timestamp NOT NULL default CURRENT_TIMESTAMP,
+  PRIMARY KEY  (`id`),
+  UNIQUE KEY `session` (`session`),
+  KEY `username` (`username`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+--
+-- Table structure for table `sessions`
+--
+
+DROP TABLE IF EXISTS `sessions`;
+CREATE TABLE `sessions` (
+  `username` varchar(16) NOT NULL,
+  `session` varchar(64) NOT NULL,
+  `expires` datetime NOT NULL,
+  PRIMARY KEY  (`username`),
+  KEY `session` (`session`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+--
+-- Table structure for table `pool`
+--
+
+DROP TABLE IF EXISTS `pool`;
+CREATE TABLE `pool` (
+  `ip` varchar(15) NOT NULL,
+  `session` varchar(64) default NULL,
+  PRIMARY KEY  (`ip`),
+  KEY `session` (`session`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
 /*!40103 SET TIME_ZONE=@OLD_TIME_ZONE */;
 
 /*!40101 SET SQL_MODE=@OLD_SQL_MODE */;
@@ -64,8 +64,9 @@ CREATE TABLE "login" (
     username character varying(16) NOT NULL,
     "password" character varying(32) NOT NULL,
     status integer DEFAULT 0 NOT NULL,
-    clientip character varying(15) NOT NULL,
-    serverip character varying(15) NOT NULL
+    clientip inet NOT NULL,
+    serverip inet NOT NULL,
+    serverid character varying(64)
 );
 
 
@@ -75,10 +76,95 @@ ALTER TABLE public."login" OWNER TO postgres;
 -- Data for Name: login; Type: TABLE DATA; Schema: public; Owner: postgres
 --
 
-COPY "login" (id, username, "password", status, clientip, serverip) FROM stdin;
+COPY "login" (id, username, "password", status, clientip, serverip, serverid) FROM stdin;
 \.
 
 
+--
+-- Name: login_username; Type: INDEX; Schema: public; Owner: postgres
+--
+-- The password query looks up one username and fetches the included
+-- columns from the index, so it never scans or locks other rows.
+--
+
+CREATE UNIQUE INDEX login_username ON "login" USING btree (username) INCLUDE ("password", clientip, serverip);
+
+CREATE INDEX login_serverid ON "login" USING btree (serverid, status);
+
+
+--
+-- Name: accounting_sq; Type: SEQUENCE; Schema: public; Owner: postgres
+--
+
+CREATE SEQUENCE accounting_sq
+    START WITH 1
+    INCREMENT BY 1
+    NO MAXVALUE
+    NO MINVALUE
+    CACHE 1;
+
+
+ALTER TABLE public.accounting_sq OWNER TO postgres;
+
+--
+-- Name: accounting; Type: TABLE; Schema: public; Owner: postgres; Tablespace: 
+--
+
+CREATE TABLE accounting (
+    id integer DEFAULT nextval('accounting_sq'::regclass) NOT NULL,
+    session character varying(64),
+    username character varying(16) NOT NULL,
+    received bigint DEFAULT 0 NOT NULL,
+    transmitted bigint DEFAULT 0 NOT NULL,
+    duration integer DEFAULT 0 NOT NULL,
+    stop timestamp without time zone DEFAULT now() NOT NULL
+);
+
+
+ALTER TABLE public.accounting OWNER TO postgres;
+
+CREATE UNIQUE INDEX accounting_session ON accounting USING btree (session);
+
+CREATE INDEX accounting_username ON accounting USING btree (username);
+
+
+--
+-- Name: sessions; Type: TABLE; Schema: public; Owner: postgres; Tablespace: 
+--
+
+CREATE TABLE sessions (
+    username character varying(16) NOT NULL,
+    session character varying(64) NOT NULL,
+    expires timestamp with time zone NOT NULL
+);
+
+
+ALTER TABLE public.sessions OWNER TO postgres;
+
+ALTER TABLE ONLY sessions
+    ADD CONSTRAINT sessions_pkey PRIMARY KEY (username);
+
+CREATE INDEX sessions_session ON sessions USING btree (session);
+
+
+--
+-- Name: pool; Type: TABLE; Schema: public; Owner: postgres; Tablespace: 
+--
+
+CREATE TABLE pool (
+    ip character varying(15) NOT NULL,
+    session character varying(64)
+);
+
+
+ALTER TABLE public.pool OWNER TO postgres;
+
+ALTER TABLE ONLY pool
+    ADD CONSTRAINT pool_pkey PRIMARY KEY (ip);
+
+CREATE INDEX pool_session ON pool USING btree (session);
+
+
 --
 -- Name: public; Type: ACL; Schema: -; Owner: postgres
 --
@@ -0,0 +1,21 @@
+--
+-- SQLite database schema
+--
+
+PRAGMA journal_mode = WAL;
+
+--
+-- Table structure for table `login`
+--
+-- The username is the primary key of a table without rowid, so the password
+-- query is one lookup in the table b-tree which also holds all fetched
+-- columns. The addresses are stored as numbers like INET_ATON() of MySQL.
+--
+
+CREATE TABLE login (
+  username TEXT NOT NULL PRIMARY KEY,
+  password TEXT NOT NULL,
+  status INTEGER NOT NULL DEFAULT 0,
+  clientip INTEGER NOT NULL,
+  serverip INTEGER NOT NULL
+) WITHOUT ROWID;
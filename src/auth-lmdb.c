@@ -0,0 +1,670 @@
+/*
+ *  auth-lmdb.c -- Challenge Handshake Authentication Protocol and Password
+ *                 Authentication Protocol for the Point-to-Point Protocol
+ *                 (PPP) via LMDB.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic plugin includes. */
+#include "plugin.h"
+#include "plugin-lmdb.h"
+#include "stats.h"
+
+/* auth plugin includes. */
+#include "auth-lmdb.h"
+
+/* store username in global variable, because ip down did not know it. */
+uint8_t username[MAXNAMELEN];
+
+/* indicate if the startup tasks were already executed. */
+uint32_t startup = 0;
+
+/* validated options and the environment, kept for the process lifetime. */
+struct pppd_lmdb_plan pppd_lmdb_plan;
+
+/* this function handles the lmdb error codes. */
+int32_t pppd__lmdb_error(int32_t code) {
+
+	/* show error header. */
+	error("Plugin %s: Fatal Error Message (LMDB):\n", PLUGIN_NAME_LMDB);
+
+	/* show the detailed error. */
+	error("Plugin %s: * %d: %s\n", PLUGIN_NAME_LMDB, code, mdb_strerror(code));
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function validate the parameter and build the plan. */
+int32_t pppd__lmdb_plan(void) {
+
+	/* some common variables. */
+	int32_t encryption = 0;
+
+	/* check if all information are supplied. */
+	if (pppd_lmdb_database		== NULL ||
+	    pppd_lmdb_pass_encryption	== NULL) {
+
+		/* something failed on lmdb initialization. */
+		error("Plugin %s: LMDB information are not complete\n", PLUGIN_NAME_LMDB);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_INCOMPLETE;
+	}
+
+	/* check if encryption algorithm is supported. */
+	if ((encryption = pppd__encryption(pppd_lmdb_pass_encryption)) < 0) {
+
+		/* unknown algorithm, otherwise every password would be accepted. */
+		error("Plugin: %s: LMDB encryption %s is not supported\n", PLUGIN_NAME_LMDB, pppd_lmdb_pass_encryption);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_OPTION;
+	}
+
+	/* check if passwords are encrypted. */
+	if (encryption == PPPD_SQL_ENCRYPTION_CRYPT ||
+	    encryption == PPPD_SQL_ENCRYPTION_AES) {
+
+		/* check if key or salt is given. */
+		if (pppd_lmdb_pass_key == NULL) {
+
+			/* some required encryption information are missing. */
+			error("Plugin: %s: LMDB encryption information are not complete\n", PLUGIN_NAME_LMDB);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if concurrent connection from one user should be denied. */
+	if (pppd_lmdb_exclusive == 1) {
+
+		/* check if login status is stored. */
+		if (pppd_lmdb_status        == 0 ||
+		    pppd_lmdb_authoritative == 0) {
+
+			/* some required exclusive information are missing. */
+			error("Plugin: %s: LMDB exclusive information are not complete\n", PLUGIN_NAME_LMDB);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* store the parsed options, so no login parses them again. */
+	pppd_lmdb_plan.encryption = encryption;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function check the parameter, the plan is built at the first call and reused by every login. */
+int32_t pppd__lmdb_parameter(void) {
+
+	/* check if plan was not built, options do not change after they are complete. */
+	if (pppd_lmdb_plan.built == 0) {
+
+		/* validate options and build plan. */
+		pppd_lmdb_plan.result = pppd__lmdb_plan();
+		pppd_lmdb_plan.built  = 1;
+	}
+
+	/* return the result of the validation. */
+	return pppd_lmdb_plan.result;
+}
+
+/* this function open the environment once. */
+int32_t pppd__lmdb_open(void) {
+
+	/* some common variables. */
+	int32_t result = 0;
+	int32_t dead   = 0;
+	MDB_txn *txn   = NULL;
+
+	/* check if environment is already open, it is kept open for the process lifetime. */
+	if (pppd_lmdb_plan.env != NULL) {
+		return 0;
+	}
+
+	/* check if environment was successfully created. */
+	if ((result = mdb_env_create(&pppd_lmdb_plan.env)) != MDB_SUCCESS) {
+
+		/* something on creating environment failed. */
+		pppd__lmdb_error(result);
+
+		/* forget the environment. */
+		pppd_lmdb_plan.env = NULL;
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_INIT;
+	}
+
+	/* set the size of the memory map, it limits the size of the database. */
+	mdb_env_set_mapsize(pppd_lmdb_plan.env, pppd_lmdb_map_size);
+
+	/* check if environment was successfully opened, it is only opened for writing if the login status is stored. */
+	if ((result = mdb_env_open(pppd_lmdb_plan.env, (char *)pppd_lmdb_database, MDB_NOSUBDIR | MDB_NORDAHEAD | (pppd_lmdb_status == 1 ? 0 : MDB_RDONLY), 0600)) != MDB_SUCCESS) {
+
+		/* something on opening environment failed. */
+		pppd__lmdb_error(result);
+
+		/* close the environment, it is opened again at the next login. */
+		pppd__lmdb_exit(NULL, 0);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_CONNECT;
+	}
+
+	/* release reader slots of crashed ppp daemons, they would pin old pages forever. (ignore return code, slots are only leaked) */
+	mdb_reader_check(pppd_lmdb_plan.env, &dead);
+
+	/* check if database was successfully opened and the read-only transaction is created. */
+	if ((result = mdb_txn_begin(pppd_lmdb_plan.env, NULL, MDB_RDONLY, &txn)) != MDB_SUCCESS ||
+	    (result = mdb_dbi_open(txn, NULL, 0, &pppd_lmdb_plan.dbi)) != MDB_SUCCESS) {
+
+		/* something on opening database failed. */
+		pppd__lmdb_error(result);
+
+		/* release transaction. (aborting NULL is not allowed) */
+		if (txn != NULL) {
+			mdb_txn_abort(txn);
+		}
+
+		/* close the environment, it is opened again at the next login. */
+		pppd__lmdb_exit(NULL, 0);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_CONNECT;
+	}
+
+	/* keep the transaction for lookups, a reset transaction only needs to be renewed. */
+	mdb_txn_reset(txn);
+	pppd_lmdb_plan.read = txn;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function read the record of the given user in a read-only transaction. */
+int32_t pppd__lmdb_get(uint8_t *name, struct pppd_record *record) {
+
+	/* some common variables. */
+	int32_t result = 0;
+	MDB_val key;
+	MDB_val value;
+
+	/* check if transaction was successfully renewed, this takes a snapshot without any lock. */
+	if ((result = mdb_txn_renew(pppd_lmdb_plan.read)) != MDB_SUCCESS) {
+
+		/* something on renewing transaction failed. */
+		pppd__lmdb_error(result);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* the username is the key, without terminator. */
+	key.mv_size = strlen((char *)name);
+	key.mv_data = name;
+
+	/* check if user was found, the value points into the memory map. */
+	if ((result = mdb_get(pppd_lmdb_plan.read, pppd_lmdb_plan.dbi, &key, &value)) != MDB_SUCCESS) {
+
+		/* check if lookup failed for another reason than a missing user. */
+		if (result != MDB_NOTFOUND) {
+
+			/* something on reading failed. */
+			pppd__lmdb_error(result);
+		}
+
+		/* release snapshot. */
+		mdb_txn_reset(pppd_lmdb_plan.read);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* check if record was successfully decoded, it must be copied before the snapshot is released. */
+	if (pppd__record_decode(record, value.mv_data, value.mv_size) < 0) {
+
+		/* invalid record found. */
+		error("Plugin %s: The record for %s is not valid in database\n", PLUGIN_NAME_LMDB, name);
+
+		/* release snapshot. */
+		mdb_txn_reset(pppd_lmdb_plan.read);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* release snapshot, so the writer is able to reuse old pages. */
+	mdb_txn_reset(pppd_lmdb_plan.read);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function return the password from database. */
+int32_t pppd__lmdb_password(uint8_t *name, uint8_t *secret_name, int32_t *secret_length) {
+
+	/* some common variables. */
+	struct pppd_record record;
+
+	/* check if record was found. */
+	if (pppd__lmdb_get(name, &record) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* cleanup memory. */
+	memset(secret_name, 0, MAXSECRETLEN);
+
+	/* copy password to secret, the record is never longer than a secret. */
+	memcpy(secret_name, record.secret, record.header.length);
+	*secret_length = record.header.length;
+
+	/* copy ip addresses, they are stored in network byte order. */
+	client_ip = record.header.client_ip;
+	server_ip = record.header.server_ip;
+
+	/* clear the memory with the password, so nobody is able to dump it. */
+	memset(&record, 0, sizeof(record));
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function set the login status of the given user. */
+int32_t pppd__lmdb_status(uint8_t *name, uint32_t status) {
+
+	/* some common variables. */
+	uint8_t buffer[sizeof(struct pppd_record)];
+	int32_t result = 0;
+	size_t size    = 0;
+	MDB_txn *txn   = NULL;
+	MDB_val key;
+	MDB_val value;
+	struct pppd_record record;
+
+	/* check if the login status is not stored. */
+	if (pppd_lmdb_status == 0) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* check if write transaction was successfully started, it serializes all ppp daemons. */
+	if ((result = mdb_txn_begin(pppd_lmdb_plan.env, NULL, 0, &txn)) != MDB_SUCCESS) {
+
+		/* something on starting transaction failed. */
+		pppd__lmdb_error(result);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* the username is the key, without terminator. */
+	key.mv_size = strlen((char *)name);
+	key.mv_data = name;
+
+	/* check if record was found and decoded, it is read again under the write lock. */
+	if ((result = mdb_get(txn, pppd_lmdb_plan.dbi, &key, &value)) != MDB_SUCCESS ||
+	    pppd__record_decode(&record, value.mv_data, value.mv_size) < 0) {
+
+		/* check if lookup failed for another reason than an invalid record. */
+		if (result != MDB_SUCCESS) {
+
+			/* something on reading failed. */
+			pppd__lmdb_error(result);
+		}
+
+		/* release transaction. */
+		mdb_txn_abort(txn);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* check if user is already online, the check and the update are one transaction. */
+	if (pppd_lmdb_exclusive == 1 &&
+	    status              == 1 &&
+	    record.header.status == 1) {
+
+		/* user is already logged in. */
+		error("Plugin %s: The user %s is already logged in\n", PLUGIN_NAME_LMDB, name);
+
+		/* release transaction. */
+		mdb_txn_abort(txn);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_LEASE;
+	}
+
+	/* store the new status. */
+	record.header.status = status;
+	pppd__record_encode(&record, buffer, &size);
+
+	/* the new value. */
+	value.mv_size = size;
+	value.mv_data = buffer;
+
+	/* check if record was successfully written. */
+	if ((result = mdb_put(txn, pppd_lmdb_plan.dbi, &key, &value, 0)) != MDB_SUCCESS) {
+
+		/* release transaction. */
+		mdb_txn_abort(txn);
+	} else {
+
+		/* commit transaction, a failed commit already released it. */
+		result = mdb_txn_commit(txn);
+	}
+
+	/* check if record was successfully written and committed. */
+	if (result != MDB_SUCCESS) {
+
+		/* something on writing failed. */
+		pppd__lmdb_error(result);
+
+		/* clear the memory with the password, so nobody is able to dump it. */
+		memset(&record, 0, sizeof(record));
+		memset(buffer, 0, sizeof(buffer));
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* clear the memory with the password, so nobody is able to dump it. */
+	memset(&record, 0, sizeof(record));
+	memset(buffer, 0, sizeof(buffer));
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function is the phase change notifier for the ppp daemon. */
+void pppd__lmdb_phase(void *opaque, int32_t arg) {
+
+	/* check if startup tasks were already executed, options are complete at first phase change. */
+	if (startup == 1) {
+		return;
+	}
+
+	/* indicate that startup tasks are executed. */
+	startup = 1;
+
+	/* check if login latencies and counters should be recorded, failed logins are counted too. */
+	if (pppd_lmdb_stats != NULL &&
+	    pppd__stats_open(pppd_lmdb_stats, 1, &pppd_stats_file) < 0) {
+
+		/* logins work without stats, they are only not recorded. */
+		error("Plugin %s: Stats file %s is not usable\n", PLUGIN_NAME_LMDB, pppd_lmdb_stats);
+	}
+
+	/* check if options are valid, the plan is built once here. (ignore return code, every login reports it again) */
+	pppd__lmdb_parameter();
+}
+
+/* this function is the ip up notifier for the ppp daemon. */
+void pppd__lmdb_up(void *opaque, int32_t arg) {
+
+	/* check if we should execute a script. */
+	if (pppd_lmdb_ip_up != NULL) {
+
+		/* execute script. */
+		if (pppd__ip_up(username, pppd_lmdb_ip_up) != 0) {
+
+			/* check if we should fail. */
+			if (pppd_lmdb_ip_up_fail == 1) {
+
+				/* show the error. */
+				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_LMDB, pppd_lmdb_ip_up);
+
+				/* check if status should be updated. */
+				if (pppd_lmdb_exclusive     == 1 &&
+				    pppd_lmdb_authoritative == 1) {
+
+					/* update database. (ignore return code, because what should I do, stop the disconnect?) */
+					pppd__lmdb_status(username, 0);
+				}
+
+				/* die bitch die. */
+				die(1);
+			}
+		}
+	}
+}
+
+/* this function is the ip down notifier for the ppp daemon. */
+void pppd__lmdb_down(void *opaque, int32_t arg) {
+
+	/* check if we should execute a script. */
+	if (pppd_lmdb_ip_down != NULL) {
+
+		/* execute script. */
+		if (pppd__ip_down(username, pppd_lmdb_ip_down) != 0) {
+
+			/* check if we should fail. */
+			if (pppd_lmdb_ip_down_fail == 1) {
+
+				/* show the error. */
+				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_LMDB, pppd_lmdb_ip_down);
+
+				/* die bitch die. */
+				die(1);
+			}
+		}
+	}
+
+	/* check if status should be updated. */
+	if (pppd_lmdb_exclusive     == 1 &&
+	    pppd_lmdb_authoritative == 1) {
+
+		/* update database. (ignore return code, because what should I do, stop the disconnect?) */
+		pppd__lmdb_status(username, 0);
+	}
+}
+
+/* this function is the exit notifier for the ppp daemon. */
+void pppd__lmdb_exit(void *opaque, int32_t arg) {
+
+	/* check if read-only transaction exists. */
+	if (pppd_lmdb_plan.read != NULL) {
+
+		/* release transaction and its reader slot. */
+		mdb_txn_abort(pppd_lmdb_plan.read);
+		pppd_lmdb_plan.read = NULL;
+	}
+
+	/* check if environment exists. */
+	if (pppd_lmdb_plan.env != NULL) {
+
+		/* close the environment. */
+		mdb_env_close(pppd_lmdb_plan.env);
+		pppd_lmdb_plan.env = NULL;
+	}
+}
+
+/* this function check the chap authentication information against a lmdb database. */
+int32_t pppd__chap_verify_lmdb(char *name, char *ourname, int id, struct chap_digest_type *digest, unsigned char *challenge, unsigned char *response, char *message, int message_space) {
+
+	/* some common variables. */
+	uint8_t secret_name[MAXSECRETLEN];
+	int32_t secret_length = 0;
+	int32_t result        = 0;
+	struct timespec login_start;
+	struct timespec phase_start;
+
+	/* start the timer of the whole login. */
+	pppd__stats_start(PPPD_STATS_LOGIN, (uint8_t *)name, &login_start);
+
+	/* check if parameters are complete. */
+	if ((result = pppd__lmdb_parameter()) == 0) {
+
+		/* check if lmdb open is working. */
+		pppd__stats_start(PPPD_STATS_CONNECT, (uint8_t *)name, &phase_start);
+		result = pppd__lmdb_open();
+		pppd__stats_stop(PPPD_STATS_CONNECT, (uint8_t *)name, result, &phase_start);
+		if (result == 0) {
+
+			/* check if lmdb fetching was successful. */
+			pppd__stats_start(PPPD_STATS_QUERY, (uint8_t *)name, &phase_start);
+			result = pppd__lmdb_password((uint8_t *)name, secret_name, &secret_length);
+			pppd__stats_stop(PPPD_STATS_QUERY, (uint8_t *)name, result, &phase_start);
+			if (result == 0) {
+
+				/* check if password decryption was correct. */
+				pppd__stats_start(PPPD_STATS_DECRYPT, (uint8_t *)name, &phase_start);
+				result = pppd__decrypt_password(secret_name, &secret_length, pppd_lmdb_plan.encryption, pppd_lmdb_pass_key);
+				pppd__stats_stop(PPPD_STATS_DECRYPT, (uint8_t *)name, result, &phase_start);
+				if (result == 0) {
+
+					/* verify discovered secret against the client's response. */
+					pppd__stats_start(PPPD_STATS_VERIFY, (uint8_t *)name, &phase_start);
+					result = digest->verify_response(id, name, secret_name, secret_length, challenge, response, message, message_space) == 1 ? 0 : PPPD_SQL_ERROR_PASSWORD;
+					pppd__stats_stop(PPPD_STATS_VERIFY, (uint8_t *)name, result, &phase_start);
+					if (result == 0) {
+
+						/* check if database update was successful. */
+						pppd__stats_start(PPPD_STATS_STATUS, (uint8_t *)name, &phase_start);
+						result = pppd__lmdb_status((uint8_t *)name, 1);
+						pppd__stats_stop(PPPD_STATS_STATUS, (uint8_t *)name, result, &phase_start);
+						if (result == 0) {
+
+							/* store username for ip down configuration. */
+							strncpy((char *)username, name, MAXNAMELEN);
+
+							/* record the accepted login. */
+							pppd__stats_login((uint8_t *)name, 0, &login_start);
+
+							/* clear the memory with the password, so nobody is able to dump it. */
+							memset(secret_name, 0, sizeof(secret_name));
+
+							/* if no error was found, establish link. */
+							return 1;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/* record the failed login, the fallback to the secrets file is not part of it. */
+	pppd__stats_login((uint8_t *)name, result, &login_start);
+
+	/* check if lmdb is not authoritative. */
+	if (pppd_lmdb_authoritative == 0) {
+
+		/* get the secret that the peer is supposed to know. */
+		if (get_secret(0, name, ourname, (char *)secret_name, &secret_length, 1) == 1) {
+
+			/* verify discovered secret against the client's response. */
+			if (digest->verify_response(id, name, secret_name, secret_length, challenge, response, message, message_space) == 1) {
+
+				/* clear the memory with the password, so nobody is able to dump it. */
+				memset(secret_name, 0, sizeof(secret_name));
+
+				/* if no error was found, establish link. */
+				return 1;
+			}
+		}
+
+		/* show user that fallback also fails. */
+		error("No CHAP secret found for authenticating %q", name);
+	}
+
+	/* clear the memory with the password, so nobody is able to dump it. */
+	memset(secret_name, 0, sizeof(secret_name));
+
+	/* return with error and terminate link. */
+	return 0;
+}
+
+/* this function check the pap authentication information against a lmdb database. */
+int32_t pppd__pap_auth_lmdb(char *user, char *passwd, char **msgp, struct wordlist **paddrs, struct wordlist **popts) {
+
+	/* some common variables. */
+	uint8_t secret_name[MAXSECRETLEN];
+	int32_t secret_length = 0;
+	int32_t result        = 0;
+	struct timespec login_start;
+	struct timespec phase_start;
+
+	/* start the timer of the whole login. */
+	pppd__stats_start(PPPD_STATS_LOGIN, (uint8_t *)user, &login_start);
+
+	/* check if parameters are complete. */
+	if ((result = pppd__lmdb_parameter()) == 0) {
+
+		/* check if lmdb open is working. */
+		pppd__stats_start(PPPD_STATS_CONNECT, (uint8_t *)user, &phase_start);
+		result = pppd__lmdb_open();
+		pppd__stats_stop(PPPD_STATS_CONNECT, (uint8_t *)user, result, &phase_start);
+		if (result == 0) {
+
+			/* check if lmdb fetching was successful. */
+			pppd__stats_start(PPPD_STATS_QUERY, (uint8_t *)user, &phase_start);
+			result = pppd__lmdb_password((uint8_t *)user, secret_name, &secret_length);
+			pppd__stats_stop(PPPD_STATS_QUERY, (uint8_t *)user, result, &phase_start);
+			if (result == 0) {
+
+				/* check if the password is correct. */
+				pppd__stats_start(PPPD_STATS_VERIFY, (uint8_t *)user, &phase_start);
+				result = pppd__verify_password((uint8_t *)passwd, secret_name, pppd_lmdb_plan.encryption, pppd_lmdb_pass_key);
+				pppd__stats_stop(PPPD_STATS_VERIFY, (uint8_t *)user, result, &phase_start);
+				if (result == 0) {
+
+					/* check if database update was successful. */
+					pppd__stats_start(PPPD_STATS_STATUS, (uint8_t *)user, &phase_start);
+					result = pppd__lmdb_status((uint8_t *)user, 1);
+					pppd__stats_stop(PPPD_STATS_STATUS, (uint8_t *)user, result, &phase_start);
+					if (result == 0) {
+
+						/* store username for ip down configuration. */
+						strncpy((char *)username, user, MAXNAMELEN);
+
+						/* record the accepted login. */
+						pppd__stats_login((uint8_t *)user, 0, &login_start);
+
+						/* clear the memory with the password, so nobody is able to dump it. */
+						memset(secret_name, 0, sizeof(secret_name));
+
+						/* if no error was found, establish link. */
+						return 1;
+					}
+				}
+			}
+		}
+	}
+
+	/* record the failed login, the fallback to the secrets file is not part of it. */
+	pppd__stats_login((uint8_t *)user, result, &login_start);
+
+	/* check if lmdb is not authoritative. */
+	if (pppd_lmdb_authoritative == 0) {
+
+		/* return with error and look in pap file. */
+		return -1;
+	}
+
+	/* clear the memory with the password, so nobody is able to dump it. */
+	memset(secret_name, 0, sizeof(secret_name));
+
+	/* return with error and terminate link. */
+	return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ *  auth-lmdb.h -- Challenge Handshake Authentication Protocol and Password
+ *                 Authentication Protocol for the Point-to-Point Protocol
+ *                 (PPP) via LMDB.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _AUTH_LMDB_H
+#define _AUTH_LMDB_H
+
+/* validated options and the environment, kept for the process lifetime. */
+struct pppd_lmdb_plan {
+	uint32_t	built;			/* one if the plan was built. */
+	int32_t		result;			/* the result of the validation, returned for every login. */
+	uint32_t	encryption;		/* the password encryption algorithm. */
+	MDB_env		*env;			/* the environment, opened at the first login. */
+	MDB_dbi		dbi;			/* the database with the credential records. */
+	MDB_txn		*read;			/* the reset read-only transaction, renewed by every lookup. */
+};
+
+/* validated options and the environment. */
+extern struct pppd_lmdb_plan pppd_lmdb_plan;
+
+/* this function handles the lmdb error codes. */
+int32_t pppd__lmdb_error(
+	int32_t		code
+);
+
+/* this function validate the parameter and build the plan. */
+int32_t pppd__lmdb_plan(
+	void
+);
+
+/* this function check the parameter. */
+int32_t pppd__lmdb_parameter(
+	void
+);
+
+/* this function open the environment once. */
+int32_t pppd__lmdb_open(
+	void
+);
+
+/* this function read the record of the given user in a read-only transaction. */
+int32_t pppd__lmdb_get(
+	uint8_t		*name,
+	struct pppd_record	*record
+);
+
+/* this function return the password from database. */
+int32_t pppd__lmdb_password(
+	uint8_t		*name,
+	uint8_t		*secret_name,
+	int32_t		*secret_length
+);
+
+/* this function set the login status of the given user. */
+int32_t pppd__lmdb_status(
+	uint8_t		*name,
+	uint32_t	status
+);
+
+/* this function is the phase change notifier for the ppp daemon. */
+void pppd__lmdb_phase(
+	void		*opaque,
+	int32_t		arg
+);
+
+/* this function is the ip up notifier for the ppp daemon. */
+void pppd__lmdb_up(
+	void		*opaque,
+	int32_t		arg
+);
+
+/* this function is the ip down notifier for the ppp daemon. */
+void pppd__lmdb_down(
+	void		*opaque,
+	int32_t		arg
+);
+
+/* this function is the exit notifier for the ppp daemon. */
+void pppd__lmdb_exit(
+	void		*opaque,
+	int32_t		arg
+);
+
+/* this function check the chap authentication information against a lmdb database. */
+int32_t pppd__chap_verify_lmdb(
+	char		*name,
+	char		*ourname,
+	int		id,
+	struct chap_digest_type		*digest,
+	unsigned char	*challenge,
+	unsigned char	*response,
+	char		*message,
+	int		message_space
+);
+
+/* this function check the pap authentication information against a lmdb database. */
+int32_t pppd__pap_auth_lmdb(
+	char		*user,
+	char		*passwd,
+	char		**msgp,
+	struct wordlist	**paddrs,
+	struct wordlist	**popts
+);
+
+#endif					/* _AUTH_LMDB_H */
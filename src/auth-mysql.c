@@ -21,7 +21,13 @@
 
 /* generic plugin includes. */
 #include "plugin.h"
+#include "journal.h"
+#include "netlink.h"
 #include "plugin-mysql.h"
+#include "pool.h"
+#include "radix.h"
+#include "registry.h"
+#include "stats.h"
 #include "str.h"
 
 /* auth plugin includes. */
@@ -30,6 +36,18 @@
 /* store username in global variable, because ip down did not know it. */
 uint8_t username[MAXNAMELEN];
 
+/* indicate if the startup tasks were already executed. */
+uint32_t startup = 0;
+
+/* indicate if the client address is allocated from the pool table, it is released at ip down or exit. */
+uint32_t allocated = 0;
+
+/* validated options and precompiled queries, built once after options are complete. */
+struct pppd_mysql_plan pppd_mysql_plan;
+
+/* the server side of the current login, kept for the slow log. */
+struct pppd_mysql_slow pppd_mysql_slow;
+
 /* this function handles the mysql_error() result. */
 int32_t pppd__mysql_error(uint32_t error_code, const uint8_t *error_state, const uint8_t *error_message) {
 
@@ -43,17 +61,25 @@ int32_t pppd__mysql_error(uint32_t error_code, const uint8_t *error_state, const
 	return 0;
 }
 
-/* this function check the parameter. */
-int32_t pppd__mysql_parameter(void) {
+/* this function validate the parameter and build the plan. */
+int32_t pppd__mysql_plan(void) {
 
-	/* check if all information are supplied. */
-	if (pppd_mysql_host		== NULL ||
-	    pppd_mysql_port		== NULL ||
+	/* some common variables. */
+	uint32_t count     = 0;
+	uint32_t line      = 0;
+	int32_t encryption = 0;
+	struct pppd_realm *realm        = NULL;
+	struct pppd_mysql_target *target = NULL;
+
+	/* check if all information are supplied, the host options are not required if shards are given. */
+	if (((pppd_mysql_host		== NULL ||
+	      pppd_mysql_port		== NULL ||
+	      pppd_mysql_database	== NULL ||
+	      pppd_mysql_table		== NULL) &&
+	     pppd_mysql_shards		== NULL) ||
 	    pppd_mysql_user		== NULL ||
 	    pppd_mysql_pass		== NULL ||
 	    pppd_mysql_pass_encryption	== NULL ||
-	    pppd_mysql_database		== NULL ||
-	    pppd_mysql_table		== NULL ||
 	    pppd_mysql_column_user	== NULL ||
 	    pppd_mysql_column_pass	== NULL ||
 	    pppd_mysql_column_client_ip	== NULL ||
@@ -66,9 +92,19 @@ int32_t pppd__mysql_parameter(void) {
 		return PPPD_SQL_ERROR_INCOMPLETE;
 	}
 
+	/* check if encryption algorithm is supported. */
+	if ((encryption = pppd__encryption((uint8_t *)pppd_mysql_pass_encryption)) < 0) {
+
+		/* unknown algorithm, otherwise every password would be accepted. */
+		error("Plugin: %s: MySQL encryption %s is not supported\n", PLUGIN_NAME_MYSQL, pppd_mysql_pass_encryption);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_OPTION;
+	}
+
 	/* check if passwords are encrypted. */
-	if (strcasecmp(pppd_mysql_pass_encryption, "CRYPT")	== 0 ||
-	    strcasecmp(pppd_mysql_pass_encryption, "AES")	== 0) {
+	if (encryption == PPPD_SQL_ENCRYPTION_CRYPT ||
+	    encryption == PPPD_SQL_ENCRYPTION_AES) {
 
 		/* check if key or salt is given. */
 		if (pppd_mysql_pass_key == NULL) {
@@ -84,8 +120,9 @@ int32_t pppd__mysql_parameter(void) {
 	/* check if concurrent connection from one user should be denied. */
 	if (pppd_mysql_exclusive == 1) {
 
-		/* check if update column is given. */
-		if (pppd_mysql_column_update == NULL ||
+		/* check if update column or sessions table is given. */
+		if ((pppd_mysql_column_update  == NULL &&
+		     pppd_mysql_session_table == NULL) ||
 		    pppd_mysql_authoritative == 0) {
 
 			/* some required exclusive information are missing. */
@@ -96,15 +133,291 @@ int32_t pppd__mysql_parameter(void) {
 		}
 	}
 
+	/* check if session accounting should be written. */
+	if (pppd_mysql_accounting_table != NULL) {
+
+		/* check if accounting columns are given. */
+		if (pppd_mysql_column_bytes_received	== NULL ||
+		    pppd_mysql_column_bytes_transmitted	== NULL ||
+		    pppd_mysql_column_duration		== NULL) {
+
+			/* some required accounting information are missing. */
+			error("Plugin: %s: MySQL accounting information are not complete\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if interim accounting updates should be written. */
+	if (pppd_mysql_interim_interval > 0) {
+
+		/* check if accounting table and session column are given. */
+		if (pppd_mysql_accounting_table == NULL ||
+		    pppd_mysql_column_session   == NULL) {
+
+			/* some required interim information are missing. */
+			error("Plugin: %s: MySQL interim information are not complete\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if online state should be kept as lease in a sessions table. */
+	if (pppd_mysql_session_table != NULL) {
+
+		/* check if lease columns are given and concurrent connection is denied. */
+		if (pppd_mysql_column_session == NULL ||
+		    pppd_mysql_column_expires == NULL ||
+		    pppd_mysql_lease_time     < 3 ||
+		    pppd_mysql_exclusive      == 0) {
+
+			/* some required lease information are missing. */
+			error("Plugin: %s: MySQL lease information are not complete\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if client ip addresses should be allocated from a pool. */
+	if (pppd_mysql_pool_table != NULL) {
+
+		/* check if pool columns are given. */
+		if (pppd_mysql_column_pool_ip      == NULL ||
+		    pppd_mysql_column_pool_session == NULL) {
+
+			/* some required pool information are missing. */
+			error("Plugin: %s: MySQL pool information are not complete\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if client ip addresses should be allocated from a host-local pool. */
+	if (pppd_mysql_pool_file != NULL) {
+
+		/* check if range is given and database pool is not used. */
+		if (pppd_mysql_pool_range == NULL ||
+		    pppd_mysql_pool_table != NULL) {
+
+			/* some required pool information are missing. */
+			error("Plugin: %s: MySQL local pool information are not complete\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if traffic should be shaped. */
+	if (pppd_mysql_column_rate_down != NULL ||
+	    pppd_mysql_column_rate_up   != NULL) {
+
+		/* check if rates are fetched as session attributes. */
+		if (pppd_mysql_column_attributes == NULL) {
+
+			/* some required shaping information are missing. */
+			error("Plugin: %s: MySQL shaping information are not complete\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if client address should be added to firewall sets. */
+	if (pppd_mysql_column_nft_set != NULL) {
+
+		/* check if table is given and sets are fetched as session attributes. */
+		if (pppd_mysql_nft_table         == NULL ||
+		    pppd_mysql_column_attributes == NULL) {
+
+			/* some required firewall information are missing. */
+			error("Plugin: %s: MySQL firewall information are not complete\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if framed routes are given. */
+	if (pppd_mysql_column_framed_routes != NULL) {
+
+		/* check if routes are fetched as session attributes. */
+		if (pppd_mysql_column_attributes == NULL) {
+
+			/* some required routing information are missing. */
+			error("Plugin: %s: MySQL framed routes information are not complete\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if ownership of the login status should be recorded. */
+	if (pppd_mysql_server_id != NULL) {
+
+		/* check if server identifier and update columns are given. */
+		if (pppd_mysql_column_server_id == NULL ||
+		    pppd_mysql_column_update    == NULL) {
+
+			/* some required reconciliation information are missing. */
+			error("Plugin: %s: MySQL reconciliation information are not complete\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if shards are given, the port and table options are their defaults. */
+	if (pppd_mysql_shards != NULL) {
+
+		/* check if shards were successfully parsed. */
+		if (pppd__shard_parse(pppd_mysql_shards, pppd_mysql_port, pppd_mysql_table, pppd_mysql_plan.shards, &pppd_mysql_plan.shards_count) < 0) {
+
+			/* some shard is not valid. */
+			error("Plugin: %s: MySQL shards %s are not valid\n", PLUGIN_NAME_MYSQL, pppd_mysql_shards);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_OPTION;
+		}
+	} else {
+
+		/* check if the host options fit into the only shard. */
+		if (pppd__shard_fill(&pppd_mysql_plan.shards[0], pppd_mysql_host, pppd_mysql_port, pppd_mysql_database, pppd_mysql_table) < 0) {
+
+			/* some option is too long. */
+			error("Plugin: %s: MySQL port is not a valid number or host, database or table is too long\n", PLUGIN_NAME_MYSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_OPTION;
+		}
+
+		/* the host options are the only shard. */
+		pppd_mysql_plan.shards_count = 1;
+	}
+
+	/* check if realms are given, the port and table options are their defaults. */
+	if (pppd_mysql_realms != NULL &&
+	    pppd__realm_load(pppd_mysql_realms, pppd_mysql_port, pppd_mysql_table, &pppd_mysql_plan.realms, &line) < 0) {
+
+		/* some realm is not valid. */
+		error("Plugin: %s: MySQL realm file %s is not valid at line %d\n", PLUGIN_NAME_MYSQL, pppd_mysql_realms, line);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_OPTION;
+	}
+
+	/* store the parsed options, so no login parses them again. */
+	pppd_mysql_plan.encryption    = encryption;
+	pppd_mysql_plan.targets_count = pppd_mysql_plan.shards_count + pppd_mysql_plan.realms.count;
+
+	/* loop through all shards and realms, each has its own password query and options. */
+	for (count = 0; count < pppd_mysql_plan.targets_count; count++) {
+
+		/* the shards use the options. */
+		target = &pppd_mysql_plan.targets[count];
+		if (count < pppd_mysql_plan.shards_count) {
+			target->shard            = &pppd_mysql_plan.shards[count];
+			target->user             = pppd_mysql_user;
+			target->pass             = pppd_mysql_pass;
+			target->column_user      = pppd_mysql_column_user;
+			target->column_pass      = pppd_mysql_column_pass;
+			target->column_client_ip = pppd_mysql_column_client_ip;
+			target->column_server_ip = pppd_mysql_column_server_ip;
+			target->condition        = pppd_mysql_condition;
+		} else {
+
+			/* the realms use their own settings and the options for the missing ones. */
+			realm                    = &pppd_mysql_plan.realms.realm[count - pppd_mysql_plan.shards_count];
+			target->shard            = &realm->shard;
+			target->user             = realm->user[0] != '\0' ? realm->user : pppd_mysql_user;
+			target->pass             = realm->pass[0] != '\0' ? realm->pass : pppd_mysql_pass;
+			target->column_user      = realm->column_user[0] != '\0' ? realm->column_user : pppd_mysql_column_user;
+			target->column_pass      = realm->column_pass[0] != '\0' ? realm->column_pass : pppd_mysql_column_pass;
+			target->column_client_ip = realm->column_client_ip[0] != '\0' ? realm->column_client_ip : pppd_mysql_column_client_ip;
+			target->column_server_ip = realm->column_server_ip[0] != '\0' ? realm->column_server_ip : pppd_mysql_column_server_ip;
+			target->condition        = realm->condition[0] != '\0' ? realm->condition : pppd_mysql_condition;
+		}
+
+		/* build the password query up to the username, attribute columns are fetched with the same query. */
+		target->query_head_length = snprintf((char *)target->query_head, SIZE_QUERY, "SELECT %s, %s, %s%s%s FROM %s WHERE %s='",
+			target->column_pass, target->column_client_ip, target->column_server_ip,
+			pppd_mysql_column_attributes != NULL ? ", " : "", pppd_mysql_column_attributes != NULL ? (char *)pppd_mysql_column_attributes : "",
+			target->shard->table, target->column_user);
+
+		/* build the password query behind the username, an exclusive read lock is set if a lease does not replace it. */
+		target->query_tail_length = snprintf((char *)target->query_tail, SIZE_QUERY, "'%s%s%s",
+			target->condition != NULL ? " AND " : "", target->condition != NULL ? (char *)target->condition : "",
+			pppd_mysql_exclusive == 1 && pppd_mysql_authoritative == 1 && pppd_mysql_column_update != NULL && pppd_mysql_session_table == NULL ? " FOR UPDATE" : "");
+
+		/* check if query was truncated, this is refused instead of running a different condition. */
+		if (target->query_head_length >= SIZE_QUERY ||
+		    target->query_tail_length >= SIZE_QUERY) {
+
+			/* query is too long. */
+			error("Plugin: %s: MySQL password query is longer than %d bytes\n", PLUGIN_NAME_MYSQL, SIZE_QUERY - 1);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function check the parameter, the plan is built at the first call and reused by every login. */
+int32_t pppd__mysql_parameter(void) {
+
+	/* check if plan was not built, options do not change after they are complete. */
+	if (pppd_mysql_plan.built == 0) {
+
+		/* validate options and build plan. */
+		pppd_mysql_plan.result = pppd__mysql_plan();
+		pppd_mysql_plan.built  = 1;
+	}
+
+	/* return the result of the validation. */
+	return pppd_mysql_plan.result;
+}
+
+/* this function return the target of the given user, the realm behind the at sign or else the shard of the username hash. */
+uint32_t pppd__mysql_select(uint8_t *name) {
+
+	/* some common variables. */
+	int32_t realm = 0;
+
+	/* check if a realm matches. */
+	if ((realm = pppd__realm_find(&pppd_mysql_plan.realms, name)) >= 0) {
+		return pppd_mysql_plan.shards_count + realm;
+	}
+
+	/* select the shard by a stable hash of the username. */
+	return pppd__shard_select(name, pppd_mysql_plan.shards_count);
+}
+
+/* this function route the session of this ppp daemon to the given target, the notifiers write there. */
+int32_t pppd__mysql_route(uint32_t target) {
+
+	/* store the target of the current user, the options are left untouched. */
+	pppd_mysql_plan.target = target;
+
 	/* if no error was found, return zero. */
 	return 0;
 }
 
-/* this function connect to a mysql database. */
-int32_t pppd__mysql_connect(MYSQL **mysql) {
+/* this function connect to the database of the given target, writers of journal records pass multi statements. */
+int32_t pppd__mysql_connect(MYSQL **mysql, struct pppd_mysql_target *target, uint32_t flags) {
 
 	/* some common variables. */
 	uint32_t count = 0;
+	struct pppd_shard *shard = target->shard;
+
+	/* forget the server side of a previous connection. */
+	pppd_mysql_slow.thread_id = 0;
+	pppd_mysql_slow.query[0]  = '\0';
 
 	/* check if mysql initialization was successful. */
 	if ((*mysql = mysql_init(NULL)) == NULL) {
@@ -128,8 +441,12 @@ int32_t pppd__mysql_connect(MYSQL **mysql) {
 	/* loop through number of connection retries. */
 	for (count = pppd_mysql_retry_connect; count > 0 ; count--) {
 
+		/* count the round trip, every try after the first one is a retry. */
+		pppd__stats_count(PPPD_STATS_ROUND_TRIPS, 1);
+		pppd__stats_count(PPPD_STATS_RETRIES, count < pppd_mysql_retry_connect ? 1 : 0);
+
 		/* check if mysql connection was successfully established. */
-		if (mysql_real_connect(*mysql, pppd_mysql_host, pppd_mysql_user, pppd_mysql_pass, pppd_mysql_database, (uint32_t)atoi(pppd_mysql_port), (uint8_t *)NULL, 0) == 0) {
+		if (mysql_real_connect(*mysql, shard->host, target->user, target->pass, shard->database, shard->port_number, (uint8_t *)NULL, flags) == 0) {
 
 			/* check if it was last connection try. */
 			if (count == 1) {
@@ -154,6 +471,9 @@ int32_t pppd__mysql_connect(MYSQL **mysql) {
 		}
 	}
 
+	/* remember the connection id, it identifies the login in the logs of the server. */
+	pppd_mysql_slow.thread_id = mysql_thread_id(*mysql);
+
 	/* if no error was found, return zero. */
 	return 0;
 }
@@ -172,46 +492,72 @@ int32_t pppd__mysql_disconnect(MYSQL **mysql) {
 	return 0;
 }
 
+/* this function convert an ip address column into an address in network byte order. */
+int32_t pppd__mysql_address(MYSQL_FIELD *field, uint8_t *value, unsigned long length, uint32_t *address) {
+
+	/* check if column is an integer, like INT UNSIGNED filled by INET_ATON(). */
+	if (field->type == MYSQL_TYPE_LONG ||
+	    field->type == MYSQL_TYPE_LONGLONG ||
+	    field->type == MYSQL_TYPE_INT24) {
+
+		/* the text protocol sends the decimal number. */
+		return pppd__address(value, length, PPPD_SQL_ADDRESS_NUMBER, address);
+	}
+
+	/* check if column is a binary string, like VARBINARY(16) filled by INET6_ATON(). */
+	if ((field->flags & BINARY_FLAG) != 0 &&
+	    field->charsetnr == MYSQL_CHARSET_BINARY &&
+	    (field->type == MYSQL_TYPE_STRING ||
+	     field->type == MYSQL_TYPE_VAR_STRING ||
+	     field->type == MYSQL_TYPE_BLOB)) {
+
+		/* the text protocol sends binary strings unchanged. */
+		return pppd__address(value, length, PPPD_SQL_ADDRESS_BYTES, address);
+	}
+
+	/* the column is a dotted quad string. */
+	return pppd__address(value, length, PPPD_SQL_ADDRESS_TEXT, address);
+}
+
 /* this function return the password from database. */
-int32_t pppd__mysql_password(MYSQL **mysql, uint8_t *name, uint8_t *secret_name, int32_t *secret_length) {
+int32_t pppd__mysql_password(MYSQL **mysql, struct pppd_mysql_target *target, uint8_t *name, uint8_t *secret_name, int32_t *secret_length) {
 
 	/* some common variables. */
-	uint8_t query[1024];
-	uint8_t query_extended[1024];
+	uint8_t query[SIZE_QUERY * 2 + MAXNAMELEN * 2];
+	uint32_t length    = 0;
 	uint32_t count     = 0;
 	uint32_t found     = 0;
+	uint32_t rate      = 0;
 	MYSQL_RES *result  = NULL;
 	MYSQL_ROW row      = NULL;
 	MYSQL_FIELD *field = NULL;
+	unsigned long *lengths = NULL;
 
-	/* build query for database. */
-	snprintf(query, 1024, "SELECT %s, %s, %s FROM %s WHERE %s='%s'", pppd_mysql_column_pass, pppd_mysql_column_client_ip, pppd_mysql_column_server_ip, pppd_mysql_table, pppd_mysql_column_user, name);
-
-	/* check if we have an additional mysql condition. */
-	if (pppd_mysql_condition != NULL) {
-
-		/* build extended query for database. */
-		snprintf(query_extended, 1024, " AND %s", pppd_mysql_condition);
+	/* forget attributes of a previous authentication. */
+	pppd__attribute_clear();
 
-		/* only write 1023 bytes, because strncat writes 1023 bytes plus the terminating null byte. */
-		strncat(query, query_extended, 1023);
+	/* copy the precompiled query up to the username. */
+	memcpy(query, target->query_head, target->query_head_length);
+	length = target->query_head_length;
 
-		/* clear the memory with the extended query, to build next one if required. */
-		memset(query_extended, 0, sizeof(query_extended));
-	}
+	/* bind the username, it is escaped, so it cannot change the query. */
+	length += mysql_real_escape_string(*mysql, (char *)query + length, (char *)name, strnlen((char *)name, MAXNAMELEN - 1));
 
-	/* check if we should set an exclusive read lock. */
-	if (pppd_mysql_exclusive     == 1 &&
-	    pppd_mysql_authoritative == 1 &&
-	    pppd_mysql_column_update != NULL) {
+	/* copy the precompiled query behind the username with the terminating null byte. */
+	memcpy(query + length, target->query_tail, target->query_tail_length + 1);
 
-		/* only write 1023 bytes, because strncat writes 1023 bytes plus the terminating null byte. */
-		strncat(query, " FOR UPDATE", 1023);
+	/* check if logins are timed for the slow log, then the rendered query is kept. */
+	if (pppd_stats_current.timed == 1) {
+		memcpy(pppd_mysql_slow.query, query, length + target->query_tail_length + 1);
 	}
 
 	/* loop through number of query retries. */
 	for (count = pppd_mysql_retry_query; count > 0 ; count--) {
 
+		/* count the round trip, every try after the first one is a retry. */
+		pppd__stats_count(PPPD_STATS_ROUND_TRIPS, 1);
+		pppd__stats_count(PPPD_STATS_RETRIES, count < pppd_mysql_retry_query ? 1 : 0);
+
 		/* check if query was successfully executed. */
 		if (mysql_query(*mysql, query) == 0) {
 
@@ -267,12 +613,20 @@ int32_t pppd__mysql_password(MYSQL **mysql, uint8_t *name, uint8_t *secret_name,
 	/* fetch mysql row, we only take care of first row. */
 	row = mysql_fetch_row(result);
 
+	/* fetch the column lengths, binary addresses may contain null bytes. */
+	lengths = mysql_fetch_lengths(result);
+
 	/* loop through all columns. */
 	for (count = 0; count < mysql_num_fields(result); count++) {
 
 		/* fetch mysql field name. */
 		field = mysql_fetch_field(result);
 
+		/* check if attribute column is NULL, then the attribute is not set. */
+		if (count >= 3 && row[count] == NULL) {
+			continue;
+		}
+
 		/* check if column is NULL. */
 		if ((row[count] == NULL) && (pppd_mysql_ignore_null == 0)) {
 
@@ -300,11 +654,11 @@ int32_t pppd__mysql_password(MYSQL **mysql, uint8_t *name, uint8_t *secret_name,
 		/* check if we found client ip. */
 		if (count == 1) {
 
-			/* check if ip address was successfully converted into binary data. */
-			if (inet_aton(row[count], (struct in_addr *) &client_ip) == 0) {
+			/* check if ip address was successfully converted, integer and binary columns need no text conversion. */
+			if (pppd__mysql_address(field, (uint8_t *)row[count], lengths[count], &client_ip) < 0) {
 
 				/* error on converting ip address. */
-				error("Plugin %s: Client IP address %s is not valid\n", PLUGIN_NAME_MYSQL, row[count]);
+				error("Plugin %s: Client IP address of %s is not valid\n", PLUGIN_NAME_MYSQL, name);
 
 				/* return with error and terminate link. */
 				return PPPD_SQL_ERROR_QUERY;
@@ -314,41 +668,121 @@ int32_t pppd__mysql_password(MYSQL **mysql, uint8_t *name, uint8_t *secret_name,
 		/* check if we found server ip. */
 		if (count == 2) {
 
-			/* check if ip address was successfully converted into binary data. */
-			if (inet_aton(row[count], (struct in_addr *) &server_ip) == 0) {
+			/* check if ip address was successfully converted, integer and binary columns need no text conversion. */
+			if (pppd__mysql_address(field, (uint8_t *)row[count], lengths[count], &server_ip) < 0) {
 
 				/* error on converting ip address. */
-				error("Plugin %s: Server IP address %s is not valid\n", PLUGIN_NAME_MYSQL, row[count]);
+				error("Plugin %s: Server IP address of %s is not valid\n", PLUGIN_NAME_MYSQL, name);
 
 				/* return with error and terminate link. */
 				return PPPD_SQL_ERROR_QUERY;
 			}
 		}
+
+		/* check if we found an attribute. */
+		if (count >= 3) {
+
+			/* store attribute for the scripts, framed routes which do not fit are never used. */
+			if (pppd__attribute_add((uint8_t *)field->name, (uint8_t *)row[count]) < 0 &&
+			    pppd_mysql_column_framed_routes != NULL &&
+			    strcasecmp((char *)(uint8_t *)field->name, (char *)pppd_mysql_column_framed_routes) == 0) {
+
+				/* return with error and terminate link. */
+				return PPPD_SQL_ERROR_ROUTE;
+			}
+		}
+	}
+
+	/* check if framed routes are given, they are parsed once, so every address check is a tree walk. */
+	if (pppd_mysql_column_framed_routes != NULL &&
+	    pppd__radix_parse(&framed_routes, pppd__attribute_get(pppd_mysql_column_framed_routes)) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_ROUTE;
+	}
+
+	/* check if rates are valid, a malformed rate would silently leave the session unlimited. */
+	if (pppd__rate(pppd_mysql_column_rate_down, &rate) < 0 ||
+	    pppd__rate(pppd_mysql_column_rate_up, &rate) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_RATE;
 	}
 
 	/* if no error was found, return zero. */
 	return 0;
 }
 
-/* this function update the login status in database. */
-int32_t pppd__mysql_status(MYSQL **mysql, uint8_t *name, uint32_t status) {
+/* this function append the given value quoted and escaped to the query, so it cannot change the statement. */
+int32_t pppd__mysql_quote(MYSQL **mysql, uint8_t *query, uint32_t size, uint32_t *length, uint8_t *value) {
 
 	/* some common variables. */
-	uint8_t query[1024];
-	uint32_t count = 0;
-	uint32_t found = 0;
+	uint32_t value_length = strlen((char *)value);
 
-	/* build query for database. */
-	snprintf(query, 1024, "UPDATE %s SET %s='%d' WHERE %s='%s'", pppd_mysql_table, pppd_mysql_column_update, status, pppd_mysql_column_user, name);
+	/* check if the value fits with its quotes and the null byte, every byte may be escaped. */
+	if (*length + value_length * 2 + 3 > size) {
+
+		/* mark buffer as full, like a truncated append. */
+		*length = size - 1;
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* append the escaped value between quotes. */
+	query[(*length)++] = '\'';
+	*length += mysql_real_escape_string(*mysql, (char *)query + *length, (char *)value, value_length);
+	query[(*length)++] = '\'';
+	query[*length]     = '\0';
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function execute the given write statements in one round trip and one transaction, the statements are stored back to back with their null bytes. */
+int32_t pppd__mysql_execute(MYSQL **mysql, uint8_t *query, uint32_t statements, uint32_t *rows) {
+
+	/* some common variables. */
+	uint8_t *statement = query;
+	uint32_t count     = 0;
+	uint32_t found     = 0;
+	int32_t next       = 0;
+	MYSQL_RES *result  = NULL;
+
+	/* join the statements with semicolons, more than one require a connection with multi statements. (escaped values contain no null byte) */
+	for (count = 1; count < statements; count++) {
+		statement += strlen((char *)statement);
+		*statement++ = ';';
+	}
 
 	/* loop through number of query retries. */
 	for (count = pppd_mysql_retry_query; count > 0 ; count--) {
 
+		/* count the round trip, every try after the first one is a retry. */
+		pppd__stats_count(PPPD_STATS_ROUND_TRIPS, 1);
+		pppd__stats_count(PPPD_STATS_RETRIES, count < pppd_mysql_retry_query ? 1 : 0);
+
 		/* check if query was successfully executed. */
 		if (mysql_query(*mysql, query) == 0) {
 
-			/* check if commit change to database was successfully executed. */
-			if (mysql_commit(*mysql) == 0) {
+			/* loop through the results of all statements in the query. */
+			do {
+
+				/* check if statement returned a result. */
+				if ((result = mysql_store_result(*mysql)) != NULL) {
+
+					/* clear memory to avoid leaks. */
+					mysql_free_result(result);
+				}
+
+				/* check if number of affected rows is requested, the last statement is reported. */
+				if (rows != NULL) {
+					*rows = (uint32_t)mysql_affected_rows(*mysql);
+				}
+			} while ((next = mysql_next_result(*mysql)) == 0);
+
+			/* check if all statements and the commit were successfully executed. */
+			if (next < 0 && mysql_commit(*mysql) == 0) {
 
 				/* indicate that we fetch a result. */
 				found = 1;
@@ -357,6 +791,9 @@ int32_t pppd__mysql_status(MYSQL **mysql, uint8_t *name, uint32_t status) {
 				break;
 			}
 		}
+
+		/* rollback execution, so a retry does not write twice. */
+		mysql_rollback(*mysql);
 	}
 
 	/* check if no query was executed successfully, very bad :) */
@@ -365,9 +802,6 @@ int32_t pppd__mysql_status(MYSQL **mysql, uint8_t *name, uint32_t status) {
 		/* something on executing query failed. */
 		pppd__mysql_error(mysql_errno(*mysql), mysql_sqlstate(*mysql), mysql_error(*mysql));
 
-		/* rollback execution. */
-		mysql_rollback(*mysql);
-
 		/* return with error and terminate link. */
 		return PPPD_SQL_ERROR_QUERY;
 	}
@@ -376,113 +810,1227 @@ int32_t pppd__mysql_status(MYSQL **mysql, uint8_t *name, uint32_t status) {
 	return 0;
 }
 
-/* this function is the ip up notifier for the ppp daemon. */
-void pppd__mysql_up(void *opaque, int32_t arg) {
+/* this function build the accounting statement for the given records. */
+int32_t pppd__mysql_accounting(MYSQL **mysql, struct pppd_mysql_target *target, uint8_t *query, uint32_t size, uint32_t *length, struct pppd_journal_record *records, uint32_t count) {
 
 	/* some common variables. */
-	MYSQL *mysql = NULL;
+	uint32_t rows  = 0;
+	uint32_t count_records = 0;
 
-	/* check if we should execute a script. */
-	if (pppd_mysql_ip_up != NULL) {
+	/* loop through all records. */
+	for (count_records = 0; count_records < count; count_records++) {
 
-		/* execute script. */
-		if (pppd__ip_up(username, pppd_mysql_ip_up) != 0) {
+		/* check if record carries accounting. */
+		if ((records[count_records].flags & JOURNAL_ACCOUNTING) == 0) {
+			continue;
+		}
 
-			/* check if we should fail. */
-			if (pppd_mysql_ip_up_fail == 1) {
+		/* check if it is the first row. */
+		if (rows == 0) {
 
-				/* show the error. */
-				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_MYSQL, pppd_mysql_ip_up);
+			/* check if we have a session column, so the row is updated by every interim update. */
+			if (pppd_mysql_column_session != NULL) {
 
-				/* check if status should be updated. */
-				if (pppd_mysql_exclusive     == 1 &&
-				    pppd_mysql_authoritative == 1 &&
-				    pppd_mysql_column_update != NULL) {
+				/* build insert with session identifier. */
+				pppd__strappend(query, size, length, "INSERT INTO %s (%s, %s, %s, %s, %s) VALUES ", pppd_mysql_accounting_table, pppd_mysql_column_session, target->column_user, pppd_mysql_column_bytes_received, pppd_mysql_column_bytes_transmitted, pppd_mysql_column_duration);
+			} else {
 
-					/* check if mysql connect is working. */
-					if (pppd__mysql_connect(&mysql) == 0) {
+				/* build insert with one row per session. */
+				pppd__strappend(query, size, length, "INSERT INTO %s (%s, %s, %s, %s) VALUES ", pppd_mysql_accounting_table, target->column_user, pppd_mysql_column_bytes_received, pppd_mysql_column_bytes_transmitted, pppd_mysql_column_duration);
+			}
+		}
 
-						/* update database. (ignore return code, because what should I do, stop the disconnect?) */
-						pppd__mysql_status(&mysql, username, 0);
+		/* check if we have a session column. */
+		if (pppd_mysql_column_session != NULL) {
 
-						/* disconnect from mysql. */
-						pppd__mysql_disconnect(&mysql);
-					}
-				}
+			/* add row with session identifier. */
+			pppd__strappend(query, size, length, rows > 0 ? ", (" : "(");
+			pppd__mysql_quote(mysql, query, size, length, records[count_records].session);
+			pppd__strappend(query, size, length, ", ");
+			pppd__mysql_quote(mysql, query, size, length, records[count_records].username);
+			pppd__strappend(query, size, length, ", '%u', '%u', '%u')", records[count_records].bytes_received, records[count_records].bytes_transmitted, records[count_records].duration);
+		} else {
 
-				/* die bitch die. */
-				die(1);
-			}
+			/* add row. */
+			pppd__strappend(query, size, length, rows > 0 ? ", (" : "(");
+			pppd__mysql_quote(mysql, query, size, length, records[count_records].username);
+			pppd__strappend(query, size, length, ", '%u', '%u', '%u')", records[count_records].bytes_received, records[count_records].bytes_transmitted, records[count_records].duration);
 		}
+
+		/* increase number of rows. */
+		rows++;
+	}
+
+	/* check if upsert must only add the deltas since the last write. */
+	if (rows > 0 && pppd_mysql_column_session != NULL) {
+
+		/* add the update part. */
+		pppd__strappend(query, size, length, " ON DUPLICATE KEY UPDATE %s=%s+VALUES(%s), %s=%s+VALUES(%s), %s=VALUES(%s)",
+			pppd_mysql_column_bytes_received, pppd_mysql_column_bytes_received, pppd_mysql_column_bytes_received,
+			pppd_mysql_column_bytes_transmitted, pppd_mysql_column_bytes_transmitted, pppd_mysql_column_bytes_transmitted,
+			pppd_mysql_column_duration, pppd_mysql_column_duration);
 	}
+
+	/* return number of rows. */
+	return rows;
 }
 
-/* this function is the ip down notifier for the ppp daemon. */
-void pppd__mysql_down(void *opaque, int32_t arg) {
+/* this function write the given records with multi-row statements in one round trip, the connection must have multi statements. */
+int32_t pppd__mysql_update(MYSQL **mysql, struct pppd_mysql_target *target, struct pppd_journal_record *records, uint32_t count) {
 
 	/* some common variables. */
-	MYSQL *mysql = NULL;
+	uint8_t *query = NULL;
+	uint32_t size  = (count + 1) * (1024 + MAXNAMELEN * 4 + SIZE_SESSION * 4);
+	uint32_t length = 0;
+	uint32_t rows  = 0;
+	uint32_t statements = 0;
+	uint32_t count_records = 0;
+	int32_t result = 0;
 
-	/* check if we should execute a script. */
-	if (pppd_mysql_ip_down != NULL) {
+	/* check if memory for query was successfully allocated. */
+	if ((query = malloc(size)) == NULL) {
 
-		/* execute script. */
-		if (pppd__ip_down(username, pppd_mysql_ip_down) != 0) {
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
 
-			/* check if we should fail. */
-			if (pppd_mysql_ip_down_fail == 1) {
+	/* clear the memory with the query, because parts of it are optional. */
+	memset(query, 0, size);
 
-				/* show the error. */
-				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_MYSQL, pppd_mysql_ip_up);
+	/* check if online state is kept as lease in the sessions table. */
+	if (pppd_mysql_session_table != NULL) {
 
-				/* die bitch die. */
-				die(1);
-			}
-		}
-	}
+		/* loop through all records. */
+		for (count_records = 0; count_records < count; count_records++) {
 
-	/* check if status should be updated. */
-	if (pppd_mysql_exclusive     == 1 &&
-	    pppd_mysql_authoritative == 1 &&
-	    pppd_mysql_column_update != NULL) {
+			/* check if record releases the lease. */
+			if ((records[count_records].flags & JOURNAL_RELEASE) == 0) {
+				continue;
+			}
 
-		/* check if mysql connect is working. */
-		if (pppd__mysql_connect(&mysql) == 0) {
+			/* release the leases of all sessions with one statement, only our own lease is removed. */
+			pppd__strappend(query, size, &length, rows == 0 ? "DELETE FROM %s WHERE %s IN (" : "", pppd_mysql_session_table, pppd_mysql_column_session);
+			pppd__strappend(query, size, &length, rows > 0 ? ", " : "");
+			pppd__mysql_quote(mysql, query, size, &length, records[count_records].session);
 
-			/* update database. (ignore return code, because what should I do, stop the disconnect?) */
-			pppd__mysql_status(&mysql, username, 0);
+			/* increase number of rows. */
+			rows++;
+		}
 
-			/* disconnect from mysql. */
-			pppd__mysql_disconnect(&mysql);
+		/* check if we have to close the list, the next statement starts behind the null byte. */
+		if (rows > 0) {
+			pppd__strappend(query, size, &length, ")");
+			length++;
+			statements++;
 		}
 	}
-}
 
-/* this function check the chap authentication information against a mysql database. */
-int32_t pppd__chap_verify_mysql(char *name, char *ourname, int id, struct chap_digest_type *digest, unsigned char *challenge, unsigned char *response, char *message, int message_space) {
+	/* check if we have a column to store the login status. */
+	if (pppd_mysql_column_update  != NULL &&
+	    pppd_mysql_session_table == NULL) {
+
+		/* loop through all records. */
+		for (count_records = 0; count_records < count; count_records++) {
+
+			/* check if record resets the login status. */
+			if ((records[count_records].flags & JOURNAL_STATUS) == 0) {
+				continue;
+			}
+
+			/* reset the status of all users with one statement. */
+			pppd__strappend(query, size, &length, rows == 0 ? "UPDATE %s SET %s='0' WHERE %s IN (" : "", target->shard->table, pppd_mysql_column_update, target->column_user);
+			pppd__strappend(query, size, &length, rows > 0 ? ", " : "");
+			pppd__mysql_quote(mysql, query, size, &length, records[count_records].username);
+
+			/* increase number of rows. */
+			rows++;
+		}
+
+		/* check if we have to close the list, the next statement starts behind the null byte. */
+		if (rows > 0) {
+			pppd__strappend(query, size, &length, ")");
+			length++;
+			statements++;
+		}
+	}
+
+	/* check if client ip addresses are allocated from a pool. */
+	if (pppd_mysql_pool_table != NULL) {
+
+		/* no address released so far. */
+		rows = 0;
+
+		/* loop through all records. */
+		for (count_records = 0; count_records < count; count_records++) {
+
+			/* check if record ends the session. */
+			if ((records[count_records].flags & JOURNAL_RELEASE) == 0) {
+				continue;
+			}
+
+			/* release the addresses of all sessions with one statement. */
+			pppd__strappend(query, size, &length, rows == 0 ? "UPDATE %s SET %s=NULL WHERE %s IN (" : "", pppd_mysql_pool_table, pppd_mysql_column_pool_session, pppd_mysql_column_pool_session);
+			pppd__strappend(query, size, &length, rows > 0 ? ", " : "");
+			pppd__mysql_quote(mysql, query, size, &length, records[count_records].session);
+
+			/* increase number of rows. */
+			rows++;
+		}
+
+		/* check if we have to close the list, the next statement starts behind the null byte. */
+		if (rows > 0) {
+			pppd__strappend(query, size, &length, ")");
+			length++;
+			statements++;
+		}
+	}
+
+	/* check if we should write session accounting. */
+	if (pppd_mysql_accounting_table != NULL) {
+
+		/* check if accounting was added, the statement ends with its null byte too. */
+		if (pppd__mysql_accounting(mysql, target, query, size, &length, records, count) > 0) {
+			length++;
+			statements++;
+		}
+	}
+
+	/* check if there is something to write. */
+	if (statements > 0) {
+
+		/* execute all statements in one transaction. */
+		result = pppd__mysql_execute(mysql, query, statements, NULL);
+	}
+
+	/* clear memory to avoid leaks. */
+	free(query);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function allocate the client ip address from the pool, if the account has none. */
+int32_t pppd__mysql_allocate(MYSQL **mysql) {
+
+	/* some common variables. */
+	uint8_t query[1024 + SIZE_SESSION * 2];
+	uint8_t address[16];
+	uint32_t length   = 0;
+	uint32_t count    = 0;
+	uint32_t found    = 0;
+	int32_t next      = 0;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row     = NULL;
+
+	/* check if pool is not used or the account has a static client ip address. */
+	if ((pppd_mysql_pool_table == NULL &&
+	     pppd_mysql_pool_file  == NULL) ||
+	    client_ip != 0) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* check if pool is host-local, then no database round trip is required. */
+	if (pppd_mysql_pool_file != NULL) {
+
+		/* allocate address from the shared bitmap. */
+		return pppd__pool_allocate(pppd_mysql_pool_file, pppd_mysql_pool_range, &client_ip);
+	}
+
+	/* check if session identifier was not already created for a lease. */
+	if (session_id[0] == '\0') {
+
+		/* create the session identifier, it owns the address. */
+		pppd__session_create();
+	}
+
+	/* build allocation, locked rows of concurrent allocations are skipped instead of waited for. */
+	pppd__strappend(query, sizeof(query), &length, "SET @ip=NULL; SELECT %s INTO @ip FROM %s WHERE %s IS NULL LIMIT 1 FOR UPDATE SKIP LOCKED; UPDATE %s SET %s=",
+		pppd_mysql_column_pool_ip, pppd_mysql_pool_table, pppd_mysql_column_pool_session,
+		pppd_mysql_pool_table, pppd_mysql_column_pool_session);
+	pppd__mysql_quote(mysql, query, sizeof(query), &length, session_id);
+	pppd__strappend(query, sizeof(query), &length, " WHERE %s=@ip; SELECT @ip", pppd_mysql_column_pool_ip);
+
+	/* check if multi statements were enabled, only this batch needs them on the connection. */
+	if (mysql_set_server_option(*mysql, MYSQL_OPTION_MULTI_STATEMENTS_ON) != 0) {
+
+		/* something on changing the option failed. */
+		pppd__mysql_error(mysql_errno(*mysql), mysql_sqlstate(*mysql), mysql_error(*mysql));
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through number of query retries. */
+	for (count = pppd_mysql_retry_query; count > 0 ; count--) {
+
+		/* count the round trip, every try after the first one is a retry. */
+		pppd__stats_count(PPPD_STATS_ROUND_TRIPS, 1);
+		pppd__stats_count(PPPD_STATS_RETRIES, count < pppd_mysql_retry_query ? 1 : 0);
+
+		/* clear the memory with the address, because it is optional. */
+		memset(address, 0, sizeof(address));
+
+		/* check if query was successfully executed. */
+		if (mysql_query(*mysql, query) == 0) {
+
+			/* loop through the results of all statements in the query. */
+			do {
+
+				/* check if statement returned a result. */
+				if ((result = mysql_store_result(*mysql)) != NULL) {
+
+					/* check if the allocated address was returned. */
+					if ((row = mysql_fetch_row(result)) != NULL &&
+					    row[0] != NULL) {
+
+						/* copy address. */
+						strncpy(address, row[0], sizeof(address) - 1);
+					}
+
+					/* clear memory to avoid leaks. */
+					mysql_free_result(result);
+				}
+			} while ((next = mysql_next_result(*mysql)) == 0);
+
+			/* check if all statements and the commit were successfully executed. */
+			if (next < 0 && mysql_commit(*mysql) == 0) {
+
+				/* indicate that we fetch a result. */
+				found = 1;
+
+				/* query result was ok, so break loop. */
+				break;
+			}
+		}
+
+		/* rollback execution, so a retry does not allocate twice. */
+		mysql_rollback(*mysql);
+	}
+
+	/* disable multi statements again, the following statements of the login are sent alone. (ignore return code, a broken connection failed above already) */
+	mysql_set_server_option(*mysql, MYSQL_OPTION_MULTI_STATEMENTS_OFF);
+
+	/* check if no query was executed successfully, very bad :) */
+	if (found == 0) {
+
+		/* something on executing query failed. */
+		pppd__mysql_error(mysql_errno(*mysql), mysql_sqlstate(*mysql), mysql_error(*mysql));
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* check if pool is exhausted. */
+	if (address[0] == '\0') {
+
+		/* no free address found. */
+		error("Plugin %s: Pool %s has no free address\n", PLUGIN_NAME_MYSQL, pppd_mysql_pool_table);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* the address row belongs to this session now, so it is released again even if it is not valid. */
+	allocated = 1;
+
+	/* check if ip address was successfully converted into binary data. */
+	if (inet_aton(address, (struct in_addr *) &client_ip) == 0) {
+
+		/* error on converting ip address. */
+		error("Plugin %s: Client IP address %s is not valid\n", PLUGIN_NAME_MYSQL, address);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function acquire or renew the lease of the current session. */
+int32_t pppd__mysql_lease(MYSQL **mysql, struct pppd_mysql_target *target, uint8_t *name) {
+
+	/* some common variables. */
+	uint8_t query[1024 + MAXNAMELEN * 2 + SIZE_SESSION * 2];
+	uint32_t length = 0;
+	uint32_t rows   = 0;
+
+	/* build compare-and-set, the lease is taken if it is free, expired or already ours. (the session is assigned first, so the expiry follows it) */
+	pppd__strappend(query, sizeof(query), &length, "INSERT INTO %s (%s, %s, %s) VALUES (", pppd_mysql_session_table, target->column_user, pppd_mysql_column_session, pppd_mysql_column_expires);
+	pppd__mysql_quote(mysql, query, sizeof(query), &length, name);
+	pppd__strappend(query, sizeof(query), &length, ", ");
+	pppd__mysql_quote(mysql, query, sizeof(query), &length, session_id);
+	pppd__strappend(query, sizeof(query), &length, ", NOW() + INTERVAL %u SECOND) ON DUPLICATE KEY UPDATE %s=IF(%s<NOW() OR %s=VALUES(%s), VALUES(%s), %s), %s=IF(%s=VALUES(%s), VALUES(%s), %s)",
+		pppd_mysql_lease_time,
+		pppd_mysql_column_session, pppd_mysql_column_expires, pppd_mysql_column_session, pppd_mysql_column_session, pppd_mysql_column_session, pppd_mysql_column_session,
+		pppd_mysql_column_expires, pppd_mysql_column_session, pppd_mysql_column_session, pppd_mysql_column_expires, pppd_mysql_column_expires);
+
+	/* check if lease statement was successfully executed. */
+	if (pppd__mysql_execute(mysql, query, 1, &rows) != 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* check if no row was written, then another session holds a lease which is not expired. */
+	if (rows == 0) {
+
+		/* lease is held by another session. */
+		error("Plugin %s: Lease for %s is held by another session\n", PLUGIN_NAME_MYSQL, name);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_LEASE;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function update the login status in database. */
+int32_t pppd__mysql_status(MYSQL **mysql, struct pppd_mysql_target *target, uint8_t *name, uint32_t status) {
+
+	/* some common variables. */
+	uint8_t query[1024 + MAXNAMELEN * 2];
+	uint32_t length = 0;
+	struct pppd_accounting accounting;
+	struct pppd_journal_record record;
+
+	/* check if user logs out. */
+	if (status == 0) {
+
+		/* fetch the counters which are not yet written by interim updates. */
+		pppd__accounting_fetch(&accounting, 1);
+
+		/* build the logout record, the status column is only reset if this server owns it exclusively. */
+		pppd__journal_record(&record, name, JOURNAL_ACCOUNTING | JOURNAL_RELEASE | (pppd_mysql_exclusive == 1 && pppd_mysql_authoritative == 1 ? JOURNAL_STATUS : 0), &accounting);
+
+		/* write status reset and accounting in one round trip. */
+		return pppd__mysql_update(mysql, target, &record, 1);
+	}
+
+	/* check if online state is kept as lease in the sessions table. */
+	if (pppd_mysql_session_table != NULL) {
+
+		/* create the session identifier, it owns the lease. */
+		pppd__session_create();
+
+		/* acquire lease, the credential table is not written. */
+		return pppd__mysql_lease(mysql, target, name);
+	}
+
+	/* check if there is no column to store the login status. */
+	if (pppd_mysql_column_update == NULL) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* build query for database. */
+	pppd__strappend(query, sizeof(query), &length, "UPDATE %s SET %s='%d'", target->shard->table, pppd_mysql_column_update, status);
+
+	/* check if this server should be recorded as owner of the login status. */
+	if (pppd_mysql_server_id != NULL) {
+		pppd__strappend(query, sizeof(query), &length, ", %s=", pppd_mysql_column_server_id);
+		pppd__mysql_quote(mysql, query, sizeof(query), &length, pppd_mysql_server_id);
+	}
+
+	/* select the user, the name is escaped. */
+	pppd__strappend(query, sizeof(query), &length, " WHERE %s=", target->column_user);
+	pppd__mysql_quote(mysql, query, sizeof(query), &length, name);
+
+	/* execute query. */
+	return pppd__mysql_execute(mysql, query, 1, NULL);
+}
+
+/* this function reset the login status, lease and pool address of a session which never came up. */
+int32_t pppd__mysql_reset(MYSQL **mysql, struct pppd_mysql_target *target, uint8_t *name) {
+
+	/* some common variables. */
+	struct pppd_journal_record record;
+
+	/* check if multi statements were enabled, the login connection has them off. */
+	if (mysql_set_server_option(*mysql, MYSQL_OPTION_MULTI_STATEMENTS_ON) != 0) {
+
+		/* something on changing the option failed. */
+		pppd__mysql_error(mysql_errno(*mysql), mysql_sqlstate(*mysql), mysql_error(*mysql));
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* build the logout record without accounting, the status column is only reset if this server owns it exclusively. */
+	pppd__journal_record(&record, name, JOURNAL_RELEASE | (pppd_mysql_exclusive == 1 && pppd_mysql_authoritative == 1 ? JOURNAL_STATUS : 0), NULL);
+
+	/* indicate that the address is released. */
+	allocated = 0;
+
+	/* write status reset and address release in one round trip. */
+	return pppd__mysql_update(mysql, target, &record, 1);
+}
+
+/* this function write the given journal records to database, the records of a user are written to its shard or realm. */
+int32_t pppd__mysql_journal(struct pppd_journal_record *records, uint32_t count) {
+
+	/* some common variables. */
+	struct pppd_journal_record *target_records = NULL;
+	uint32_t target        = 0;
+	uint32_t target_count  = 0;
+	uint32_t count_records = 0;
+	int32_t result         = 0;
+	MYSQL *mysql           = NULL;
+
+	/* check if memory for the records of one shard or realm was successfully allocated. */
+	if ((target_records = malloc((count + 1) * sizeof(struct pppd_journal_record))) == NULL) {
+
+		/* return with error, records are flushed later. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all shards and realms until one is not working. */
+	for (target = 0; target < pppd_mysql_plan.targets_count && result == 0; target++) {
+
+		/* loop through all records and collect the ones of this shard or realm. */
+		for (target_count = 0, count_records = 0; count_records < count; count_records++) {
+
+			/* check if record belongs to this shard or realm and was not written by a previous flush. */
+			if (records[count_records].flags != 0 &&
+			    pppd__mysql_select(records[count_records].username) == target) {
+				target_records[target_count++] = records[count_records];
+			}
+		}
+
+		/* check if shard or realm has no records. */
+		if (target_count == 0) {
+			continue;
+		}
+
+		/* check if mysql connect to this shard or realm is working. */
+		if ((result = pppd__mysql_connect(&mysql, &pppd_mysql_plan.targets[target], CLIENT_MULTI_STATEMENTS)) == 0) {
+
+			/* write all records of this shard or realm with one group commit. */
+			result = pppd__mysql_update(&mysql, &pppd_mysql_plan.targets[target], target_records, target_count);
+
+			/* disconnect from mysql. */
+			pppd__mysql_disconnect(&mysql);
+		}
+
+		/* check if records were written. */
+		if (result == 0) {
+
+			/* loop through all records and clear the flags of this shard or realm in the journal, so a retry after a failing one does not write them twice. */
+			for (count_records = 0; count_records < count; count_records++) {
+				if (pppd__mysql_select(records[count_records].username) == target) {
+					records[count_records].flags = 0;
+				}
+			}
+		}
+	}
+
+	/* clear memory to avoid leaks. */
+	free(target_records);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function reset the login status of all sessions owned by this server which are not running. */
+int32_t pppd__mysql_stale(MYSQL **mysql, struct pppd_mysql_target *target, uint8_t *names, uint32_t count) {
+
+	/* some common variables. */
+	uint8_t *query = NULL;
+	uint32_t size  = (count + 1) * (MAXNAMELEN * 2 + 4) + 1024;
+	uint32_t length = 0;
+	uint32_t count_names = 0;
+	int32_t result = 0;
+
+	/* check if memory for query was successfully allocated. */
+	if ((query = malloc(size)) == NULL) {
+
+		/* return with error, reconciliation is retried later. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* clear the memory with the query, because parts of it are optional. */
+	memset(query, 0, size);
+
+	/* reset all online users of this server with one statement. */
+	pppd__strappend(query, size, &length, "UPDATE %s SET %s='0' WHERE %s='1' AND %s=", target->shard->table, pppd_mysql_column_update, pppd_mysql_column_update, pppd_mysql_column_server_id);
+	pppd__mysql_quote(mysql, query, size, &length, pppd_mysql_server_id);
+
+	/* loop through all users which have a running ppp daemon on this host. */
+	for (count_names = 0; count_names < count; count_names++) {
+
+		/* keep the status of running sessions. */
+		pppd__strappend(query, size, &length, count_names == 0 ? " AND %s NOT IN (" : "", target->column_user);
+		pppd__strappend(query, size, &length, count_names > 0 ? ", " : "");
+		pppd__mysql_quote(mysql, query, size, &length, names + count_names * MAXNAMELEN);
+	}
+
+	/* check if we have to close the list. */
+	if (count > 0) {
+		pppd__strappend(query, size, &length, ")");
+	}
+
+	/* execute query. */
+	result = pppd__mysql_execute(mysql, query, 1, NULL);
+
+	/* clear memory to avoid leaks. */
+	free(query);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function is the stale login status reconciliation timer for the ppp daemon. */
+void pppd__mysql_reconcile(void *opaque) {
+
+	/* some common variables. */
+	uint8_t *names = NULL;
+	uint32_t count = 0;
+	uint32_t target  = 0;
+	int32_t lock   = 0;
+	MYSQL *mysql = NULL;
+
+	/* check if reconciliation is due, only one ppp daemon on this host does it per interval. */
+	if ((lock = pppd__registry_lock(pppd_mysql_registry, pppd_mysql_reconcile_interval)) >= 0) {
+
+		/* check if running sessions were found. */
+		if (pppd__registry_users(pppd_mysql_registry, &names, &count) == 0) {
+
+			/* loop through all shards and realms, this server may own users on each of them. */
+			for (target = 0; target < pppd_mysql_plan.targets_count; target++) {
+
+				/* check if mysql connect to this shard or realm is working. */
+				if (pppd__mysql_connect(&mysql, &pppd_mysql_plan.targets[target], 0) == 0) {
+
+					/* reset stale login status. (ignore return code, it is retried with next interval) */
+					pppd__mysql_stale(&mysql, &pppd_mysql_plan.targets[target], names, count);
+
+					/* disconnect from mysql. */
+					pppd__mysql_disconnect(&mysql);
+				}
+			}
+		}
+
+		/* clear memory to avoid leaks. */
+		free(names);
+
+		/* unlock registry, logins may write their status again. */
+		pppd__registry_unlock(lock);
+	}
+
+	/* check if we should reconcile periodically. */
+	if (pppd_mysql_reconcile_interval > 0) {
+
+		/* schedule next reconciliation. */
+		timeout(pppd__mysql_reconcile, NULL, pppd__accounting_interval(pppd_mysql_reconcile_interval, 0), 0);
+	}
+}
+
+/* this function register the session on this host, so reconciliation does not reset its login status. */
+int32_t pppd__mysql_register(uint8_t *name, int32_t *registry) {
+
+	/* nothing is registered so far. */
+	*registry = PPPD_SQL_ERROR_REGISTRY;
+
+	/* check if ownership of the login status is recorded. */
+	if (pppd_mysql_server_id == NULL) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* check if session was successfully registered, the lock is held until the login status is written. */
+	if ((*registry = pppd__registry_add(pppd_mysql_registry, name)) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_REGISTRY;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function is the lease renewal timer for the ppp daemon. */
+void pppd__mysql_renew(void *opaque) {
+
+	/* some common variables. */
+	int32_t result = 0;
+	MYSQL *mysql = NULL;
+	struct pppd_mysql_target *target = &pppd_mysql_plan.targets[pppd_mysql_plan.target];
+
+	/* check if mysql connect is working, otherwise lease is renewed with next interval. */
+	if (pppd__mysql_connect(&mysql, target, 0) == 0) {
+
+		/* renew lease with the same compare-and-set which acquired it. */
+		result = pppd__mysql_lease(&mysql, target, username);
+
+		/* disconnect from mysql. */
+		pppd__mysql_disconnect(&mysql);
+
+		/* check if lease expired and was taken over by another session. */
+		if (result == PPPD_SQL_ERROR_LEASE) {
+
+			/* die bitch die. */
+			die(1);
+		}
+	}
+
+	/* schedule next lease renewal. */
+	timeout(pppd__mysql_renew, NULL, pppd_mysql_lease_time / 3, 0);
+}
+
+/* this function is the interim accounting timer for the ppp daemon. */
+void pppd__mysql_interim(void *opaque) {
+
+	/* some common variables. */
+	MYSQL *mysql = NULL;
+	struct pppd_mysql_target *target = &pppd_mysql_plan.targets[pppd_mysql_plan.target];
+	struct pppd_accounting accounting;
+	struct pppd_journal_record record;
+
+	/* check if statistics are available and traffic was seen since last update. (coalesce idle intervals) */
+	if (pppd__accounting_fetch(&accounting, 0) == 0 &&
+	    (accounting.bytes_received != 0 || accounting.bytes_transmitted != 0)) {
+
+		/* build the upsert record for the deltas. */
+		pppd__journal_record(&record, username, JOURNAL_ACCOUNTING, &accounting);
+
+		/* check if we use a write-behind journal, so the flusher batches the upserts of all sessions on one connection. */
+		if (pppd_mysql_journal != NULL &&
+		    pppd__journal_append(pppd_mysql_journal, &record) == 0) {
+
+			/* mark counters as written, the journal owns them now. */
+			pppd__accounting_commit(&accounting);
+
+			/* flush journal in background, a running flusher picks the record up. */
+			pppd__journal_spawn(pppd_mysql_journal, pppd__mysql_journal);
+
+			/* schedule next interim update. */
+			timeout(pppd__mysql_interim, NULL, pppd__accounting_interval(pppd_mysql_interim_interval, 0), 0);
+
+			/* database is updated asynchronously. */
+			return;
+		}
+
+		/* check if mysql connect is working. */
+		if (pppd__mysql_connect(&mysql, target, CLIENT_MULTI_STATEMENTS) == 0) {
+
+			/* check if update was successful, otherwise deltas are sent with next update. */
+			if (pppd__mysql_update(&mysql, target, &record, 1) == 0) {
+
+				/* mark counters as written. */
+				pppd__accounting_commit(&accounting);
+			}
+
+			/* disconnect from mysql. */
+			pppd__mysql_disconnect(&mysql);
+		}
+	}
+
+	/* schedule next interim update. */
+	timeout(pppd__mysql_interim, NULL, pppd__accounting_interval(pppd_mysql_interim_interval, 0), 0);
+}
+
+/* this function log the current login if one of its phases exceeded the threshold. */
+int32_t pppd__mysql_slow(uint8_t *name, int32_t result) {
+
+	/* some common variables. */
+	struct pppd_shard *shard = pppd_mysql_plan.targets[pppd_mysql_plan.target].shard;
+	uint64_t *elapsed        = pppd_stats_current.elapsed;
+
+	/* check if no phase exceeded its threshold, a threshold of zero is disabled. */
+	if ((pppd_mysql_slow_connect == 0 || elapsed[PPPD_STATS_CONNECT] < pppd_mysql_slow_connect * 1000000ULL) &&
+	    (pppd_mysql_slow_query   == 0 || elapsed[PPPD_STATS_QUERY]   < pppd_mysql_slow_query * 1000000ULL) &&
+	    (pppd_mysql_slow_status  == 0 || elapsed[PPPD_STATS_STATUS]  < pppd_mysql_slow_status * 1000000ULL)) {
+		return 0;
+	}
+
+	/* log the phases in one line, the thread id matches the process list and the slow query log of the server. */
+	warn("Plugin %s: Slow login user=%q result=%d host=%s port=%s database=%s thread=%lu retries=%u connect=%ums query=%ums decrypt=%ums verify=%ums status=%ums login=%ums sql=%q\n",
+		PLUGIN_NAME_MYSQL, name, result, shard->host, shard->port, shard->database, pppd_mysql_slow.thread_id, pppd_stats_current.retries,
+		(uint32_t)(elapsed[PPPD_STATS_CONNECT] / 1000000), (uint32_t)(elapsed[PPPD_STATS_QUERY] / 1000000), (uint32_t)(elapsed[PPPD_STATS_DECRYPT] / 1000000),
+		(uint32_t)(elapsed[PPPD_STATS_VERIFY] / 1000000), (uint32_t)(elapsed[PPPD_STATS_STATUS] / 1000000), (uint32_t)(elapsed[PPPD_STATS_LOGIN] / 1000000),
+		pppd_mysql_slow.query);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function log the script if it exceeded the threshold. */
+int32_t pppd__mysql_slow_script(uint8_t *program, int32_t result) {
+
+	/* check if script did not exceed its threshold, a threshold of zero is disabled. */
+	if (pppd_mysql_slow_script == 0 ||
+	    pppd_stats_current.elapsed[PPPD_STATS_SCRIPT] < pppd_mysql_slow_script * 1000000ULL) {
+		return 0;
+	}
+
+	/* log the script in one line. */
+	warn("Plugin %s: Slow script user=%q result=%d script=%q elapsed=%ums\n",
+		PLUGIN_NAME_MYSQL, username, result, program, (uint32_t)(pppd_stats_current.elapsed[PPPD_STATS_SCRIPT] / 1000000));
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function warn if the password query does not look up the user by an index. */
+int32_t pppd__mysql_explain(MYSQL **mysql, struct pppd_mysql_target *target) {
+
+	/* some common variables. */
+	uint8_t query[SIZE_QUERY * 2 + 8];
+	uint32_t count     = 0;
+	int32_t table      = -1;
+	int32_t type       = -1;
+	int32_t key        = -1;
+	int32_t extra      = -1;
+	MYSQL_RES *result  = NULL;
+	MYSQL_ROW row      = NULL;
+	MYSQL_FIELD *field = NULL;
+
+	/* the precompiled query with an empty username, the plan does not depend on it. */
+	snprintf((char *)query, sizeof(query), "EXPLAIN %s%s", target->query_head, target->query_tail);
+
+	/* check if query was successfully executed and returned the plan. */
+	if (mysql_query(*mysql, (char *)query) != 0 ||
+	    (result = mysql_store_result(*mysql)) == NULL) {
+
+		/* something on executing query failed. */
+		pppd__mysql_error(mysql_errno(*mysql), mysql_sqlstate(*mysql), mysql_error(*mysql));
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all columns, their order differs between server versions. */
+	for (count = 0; count < mysql_num_fields(result); count++) {
+
+		/* fetch mysql field name. */
+		field = mysql_fetch_field_direct(result, count);
+
+		/* remember the columns we need. */
+		table = strcmp(field->name, "table") == 0 ? count : table;
+		type  = strcmp(field->name, "type")  == 0 ? count : type;
+		key   = strcmp(field->name, "key")   == 0 ? count : key;
+		extra = strcmp(field->name, "Extra") == 0 ? count : extra;
+	}
+
+	/* check if plan has the expected columns. */
+	if (table < 0 || type < 0 || key < 0 || extra < 0) {
+
+		/* clear memory to avoid leaks. */
+		mysql_free_result(result);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all tables of the plan, the condition may join more of them. */
+	while ((row = mysql_fetch_row(result)) != NULL) {
+
+		/* check if table was resolved by a unique index before execution, then there is no access type. */
+		if (row[type] == NULL) {
+			continue;
+		}
+
+		/* check if table is read completely, by rows or by a full index scan. */
+		if (strcmp(row[type], "ALL")   == 0 ||
+		    strcmp(row[type], "index") == 0 ||
+		    row[key] == NULL) {
+
+			/* every login reads or locks the whole table. */
+			warn("Plugin %s: The password query scans table %s (access type %s), add a unique index on %s\n", PLUGIN_NAME_MYSQL, row[table] ? row[table] : "NULL", row[type], target->column_user);
+			continue;
+		}
+
+		/* check if index does not cover all columns, then every lookup reads the row too. (the primary key of InnoDB holds the row) */
+		if (strcmp(row[key], "PRIMARY") != 0 &&
+		    (row[extra] == NULL ||
+		     strstr(row[extra], "Using index") == NULL)) {
+
+			/* lookup works, only show information. */
+			info("Plugin %s: The password query uses index %s of table %s without covering it\n", PLUGIN_NAME_MYSQL, row[key], row[table] ? row[table] : "NULL");
+		}
+	}
+
+	/* clear memory to avoid leaks. */
+	mysql_free_result(result);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function is the phase change notifier for the ppp daemon. */
+void pppd__mysql_phase(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	uint32_t target = 0;
+	MYSQL *mysql = NULL;
+
+	/* check if startup tasks were already executed, options are complete at first phase change. */
+	if (startup == 1) {
+		return;
+	}
+
+	/* indicate that startup tasks are executed. */
+	startup = 1;
+
+	/* check if options are valid, the plan is built once here. */
+	if (pppd__mysql_parameter() < 0) {
+		return;
+	}
+
+	/* loop through all shards and realms if the plan of their password query should be checked. */
+	for (target = 0; pppd_mysql_check_plan == 1 && target < pppd_mysql_plan.targets_count; target++) {
+
+		/* check if mysql connect to this shard or realm is working. */
+		if (pppd__mysql_connect(&mysql, &pppd_mysql_plan.targets[target], 0) == 0) {
+
+			/* warn about table scans. (ignore return code, the query works without index) */
+			pppd__mysql_explain(&mysql, &pppd_mysql_plan.targets[target]);
+
+			/* disconnect from mysql. */
+			pppd__mysql_disconnect(&mysql);
+		}
+	}
+
+	/* check if login latencies and counters should be recorded. */
+	if (pppd_mysql_stats != NULL &&
+	    pppd__stats_open(pppd_mysql_stats, 1, &pppd_stats_file) < 0) {
+
+		/* logins work without stats, they are only not recorded. */
+		error("Plugin %s: Stats file %s is not usable\n", PLUGIN_NAME_MYSQL, pppd_mysql_stats);
+	}
+
+	/* time the phases of each login if one of them should be logged when slow. */
+	pppd_stats_current.timed = (pppd_mysql_slow_connect > 0 ||
+				    pppd_mysql_slow_query   > 0 ||
+				    pppd_mysql_slow_status  > 0 ||
+				    pppd_mysql_slow_script  > 0);
+
+	/* check if we use a write-behind journal. */
+	if (pppd_mysql_journal != NULL) {
+
+		/* replay records left by a crashed or disconnected ppp daemon. */
+		pppd__journal_spawn(pppd_mysql_journal, pppd__mysql_journal);
+	}
+
+	/* check if ownership of the login status is recorded. */
+	if (pppd_mysql_server_id != NULL) {
+
+		/* reset login status left by crashed ppp daemons and schedule periodic reconciliation. */
+		pppd__mysql_reconcile(NULL);
+	}
+}
+
+/* this function is the ip up notifier for the ppp daemon. */
+void pppd__mysql_up(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	MYSQL *mysql = NULL;
+	int32_t result = 0;
+	struct pppd_mysql_target *target = &pppd_mysql_plan.targets[pppd_mysql_plan.target];
+
+	/* start accounting of the new session. */
+	pppd__accounting_start();
+
+	/* check if we should write interim accounting updates. */
+	if (pppd_mysql_interim_interval > 0) {
+
+		/* schedule first interim update at a random point of the interval. */
+		timeout(pppd__mysql_interim, NULL, pppd__accounting_interval(pppd_mysql_interim_interval, 1), 0);
+	}
+
+	/* check if online state is kept as lease. */
+	if (pppd_mysql_session_table != NULL) {
+
+		/* schedule lease renewal, so it is renewed several times before it expires. */
+		timeout(pppd__mysql_renew, NULL, pppd_mysql_lease_time / 3, 0);
+	}
+
+	/* check if traffic should be shaped, this is done before the script, so it may change it. */
+	if (pppd_mysql_column_rate_down != NULL ||
+	    pppd_mysql_column_rate_up   != NULL) {
+
+		/* install shaping. (ignore return code, the session works without limit) */
+		pppd__shape(pppd_mysql_column_rate_down, pppd_mysql_column_rate_up, 1);
+	}
+
+	/* check if client address should be added to firewall sets. */
+	if (pppd_mysql_column_nft_set != NULL) {
+
+		/* add address. (ignore return code, the session works without firewall membership) */
+		pppd__firewall(pppd_mysql_nft_table, pppd_mysql_column_nft_set, 1);
+	}
+
+	/* check if framed routes are given. */
+	if (pppd_mysql_column_framed_routes != NULL) {
+
+		/* add routes. (ignore return code, the session works without the routed networks) */
+		pppd__netlink_route((uint8_t *)ifname, &framed_routes, 1);
+	}
+
+	/* check if we should execute a script. */
+	if (pppd_mysql_ip_up != NULL) {
+
+		/* execute script. */
+		result = pppd__ip_up(username, pppd_mysql_ip_up);
+
+		/* log the script if it was slow. */
+		pppd__mysql_slow_script(pppd_mysql_ip_up, result);
+
+		/* check if script failed. */
+		if (result != 0) {
+
+			/* check if we should fail. */
+			if (pppd_mysql_ip_up_fail == 1) {
+
+				/* show the error. */
+				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_MYSQL, pppd_mysql_ip_up);
+
+				/* check if status should be updated or address released. */
+				if ((pppd_mysql_exclusive     == 1 &&
+				     pppd_mysql_authoritative == 1 &&
+				     (pppd_mysql_column_update  != NULL ||
+				      pppd_mysql_session_table != NULL)) ||
+				    pppd_mysql_pool_table != NULL) {
+
+					/* check if mysql connect is working. */
+					if (pppd__mysql_connect(&mysql, target, CLIENT_MULTI_STATEMENTS) == 0) {
+
+						/* update database. (ignore return code, because what should I do, stop the disconnect?) */
+						pppd__mysql_status(&mysql, target, username, 0);
+
+						/* disconnect from mysql. */
+						pppd__mysql_disconnect(&mysql);
+					}
+				}
+
+				/* die bitch die. */
+				die(1);
+			}
+		}
+	}
+}
+
+/* this function is the ip down notifier for the ppp daemon. */
+void pppd__mysql_down(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	MYSQL *mysql = NULL;
+	int32_t result = 0;
+	struct pppd_mysql_target *target = &pppd_mysql_plan.targets[pppd_mysql_plan.target];
+	struct pppd_accounting accounting;
+	struct pppd_journal_record record;
+
+	/* stop interim accounting updates, the final one is written below. */
+	untimeout(pppd__mysql_interim, NULL);
+
+	/* stop lease renewal, the lease is released below. */
+	untimeout(pppd__mysql_renew, NULL);
+
+	/* check if address was allocated from the host-local pool. */
+	if (pppd_mysql_pool_file != NULL) {
+
+		/* release address. */
+		pppd__pool_release(pppd_mysql_pool_file, pppd_mysql_pool_range, client_ip);
+	}
+
+	/* check if session is registered, the login status is reset below. */
+	if (pppd_mysql_server_id != NULL) {
+
+		/* remove session from registry. */
+		pppd__registry_remove(pppd_mysql_registry);
+	}
+
+	/* check if traffic was shaped. */
+	if (pppd_mysql_column_rate_down != NULL ||
+	    pppd_mysql_column_rate_up   != NULL) {
+
+		/* remove shaping. (ignore return code, the kernel removes it with the interface) */
+		pppd__shape(pppd_mysql_column_rate_down, pppd_mysql_column_rate_up, 0);
+	}
+
+	/* check if client address was added to firewall sets. */
+	if (pppd_mysql_column_nft_set != NULL) {
+
+		/* remove address. (ignore return code, because what should I do, stop the disconnect?) */
+		pppd__firewall(pppd_mysql_nft_table, pppd_mysql_column_nft_set, 0);
+	}
+
+	/* check if framed routes are given. */
+	if (pppd_mysql_column_framed_routes != NULL) {
+
+		/* remove routes. (ignore return code, because what should I do, stop the disconnect?) */
+		pppd__netlink_route((uint8_t *)ifname, &framed_routes, 0);
+	}
+
+	/* check if we should execute a script. */
+	if (pppd_mysql_ip_down != NULL) {
+
+		/* execute script. */
+		result = pppd__ip_down(username, pppd_mysql_ip_down);
+
+		/* log the script if it was slow. */
+		pppd__mysql_slow_script(pppd_mysql_ip_down, result);
+
+		/* check if script failed. */
+		if (result != 0) {
+
+			/* check if we should fail. */
+			if (pppd_mysql_ip_down_fail == 1) {
+
+				/* show the error. */
+				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_MYSQL, pppd_mysql_ip_up);
+
+				/* die bitch die. */
+				die(1);
+			}
+		}
+	}
+
+	/* check if status should be updated, session accounting written or address released. */
+	if ((pppd_mysql_exclusive     == 1 &&
+	     pppd_mysql_authoritative == 1 &&
+	     (pppd_mysql_column_update  != NULL ||
+	      pppd_mysql_session_table != NULL)) ||
+	    pppd_mysql_accounting_table != NULL ||
+	    pppd_mysql_pool_table != NULL) {
+
+		/* check if we use a write-behind journal. */
+		if (pppd_mysql_journal != NULL) {
+
+			/* fetch the counters which are not yet written by interim updates. */
+			pppd__accounting_fetch(&accounting, 1);
+
+			/* build the logout record, the status column is only reset if this server owns it exclusively. */
+			pppd__journal_record(&record, username, JOURNAL_ACCOUNTING | JOURNAL_RELEASE | (pppd_mysql_exclusive == 1 && pppd_mysql_authoritative == 1 ? JOURNAL_STATUS : 0), &accounting);
+
+			/* check if record was stored in journal, otherwise fallback to synchronous update. */
+			if (pppd__journal_append(pppd_mysql_journal, &record) == 0) {
+
+				/* the address is released by the journal, which keeps its own copy of the session identifier. */
+				allocated = 0;
+				pppd__session_end();
+
+				/* flush journal in background, so link teardown never blocks on database. */
+				pppd__journal_spawn(pppd_mysql_journal, pppd__mysql_journal);
+
+				/* database is updated asynchronously. */
+				return;
+			}
+		}
+
+		/* check if mysql connect is working. */
+		if (pppd__mysql_connect(&mysql, target, CLIENT_MULTI_STATEMENTS) == 0) {
+
+			/* update database, if it failed the address is released at exit. (ignore return code, because what should I do, stop the disconnect?) */
+			if (pppd__mysql_status(&mysql, target, username, 0) == 0) {
+				allocated = 0;
+			}
+
+			/* disconnect from mysql. */
+			pppd__mysql_disconnect(&mysql);
+		}
+	}
+
+	/* check if the session is finished in database, otherwise the exit notifier needs its identifier to release the address. */
+	if (allocated == 0) {
+
+		/* forget session identifier, the accounting row of the next session must not be added to this one. */
+		pppd__session_end();
+	}
+}
+
+/* this function is the exit notifier for the ppp daemon. */
+void pppd__mysql_exit(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	MYSQL *mysql = NULL;
+	struct pppd_mysql_target *target = &pppd_mysql_plan.targets[pppd_mysql_plan.target];
+
+	/* check if address was allocated from the host-local pool. */
+	if (pppd_mysql_pool_file != NULL) {
+
+		/* release address, if IPCP never came up it was not released at ip down. */
+		pppd__pool_release(pppd_mysql_pool_file, pppd_mysql_pool_range, client_ip);
+	}
+
+	/* check if address is still allocated from the pool table, because IPCP never came up or ip down failed to release it. */
+	if (allocated == 1) {
+
+		/* check if mysql connect is working. */
+		if (pppd__mysql_connect(&mysql, target, 0) == 0) {
+
+			/* release address, login status and lease. (ignore return code, the ppp daemon exits anyway) */
+			pppd__mysql_reset(&mysql, target, username);
+
+			/* disconnect from mysql. */
+			pppd__mysql_disconnect(&mysql);
+		}
+	}
+}
+
+/* this function check the chap authentication information against a mysql database. */
+int32_t pppd__chap_verify_mysql(char *name, char *ourname, int id, struct chap_digest_type *digest, unsigned char *challenge, unsigned char *response, char *message, int message_space) {
 
 	/* some common variables. */
 	uint8_t secret_name[MAXSECRETLEN];
 	int32_t secret_length = 0;
+	int32_t registry      = PPPD_SQL_ERROR_REGISTRY;
+	int32_t result        = 0;
 	MYSQL *mysql          = NULL;
+	struct pppd_mysql_target *target = NULL;
+	struct timespec login_start;
+	struct timespec phase_start;
 
-	/* check if parameters are complete. */
-	if (pppd__mysql_parameter() == 0) {
+	/* start the timer of the whole login. */
+	pppd__stats_start(PPPD_STATS_LOGIN, name, &login_start);
 
-		/* check if mysql connect is working. */
-		if (pppd__mysql_connect(&mysql) == 0) {
+	/* check if parameters are complete and session is registered. */
+	if ((result = pppd__mysql_parameter()) == 0 &&
+	    (result = pppd__mysql_route(pppd__mysql_select(name))) == 0 &&
+	    (result = pppd__mysql_register(name, &registry)) == 0) {
+
+		/* all queries of the login go to the shard or realm of the user. */
+		target = &pppd_mysql_plan.targets[pppd_mysql_plan.target];
+
+		/* check if mysql connect is working, failed connects are timed too. */
+		pppd__stats_start(PPPD_STATS_CONNECT, name, &phase_start);
+		result = pppd__mysql_connect(&mysql, target, 0);
+		pppd__stats_stop(PPPD_STATS_CONNECT, name, result, &phase_start);
+		if (result == 0) {
 
 			/* check if mysql fetching was successful. */
-			if (pppd__mysql_password(&mysql, name, secret_name, &secret_length) == 0) {
+			pppd__stats_start(PPPD_STATS_QUERY, name, &phase_start);
+			result = pppd__mysql_password(&mysql, target, name, secret_name, &secret_length);
+			pppd__stats_stop(PPPD_STATS_QUERY, name, result, &phase_start);
+			if (result == 0) {
 
 				/* check if password decryption was correct. */
-				if (pppd__decrypt_password(secret_name, &secret_length, pppd_mysql_pass_encryption, pppd_mysql_pass_key) == 0) {
+				pppd__stats_start(PPPD_STATS_DECRYPT, name, &phase_start);
+				result = pppd__decrypt_password(secret_name, &secret_length, pppd_mysql_plan.encryption, pppd_mysql_pass_key);
+				pppd__stats_stop(PPPD_STATS_DECRYPT, name, result, &phase_start);
+				if (result == 0) {
 
 					/* verify discovered secret against the client's response. */
-					if (digest->verify_response(id, name, secret_name, secret_length, challenge, response, message, message_space) == 1) {
-
-						/* check if database update was successful. */
-						if (pppd__mysql_status(&mysql, name, 1) == 0) {
+					pppd__stats_start(PPPD_STATS_VERIFY, name, &phase_start);
+					result = digest->verify_response(id, name, secret_name, secret_length, challenge, response, message, message_space) == 1 ? 0 : PPPD_SQL_ERROR_PASSWORD;
+					pppd__stats_stop(PPPD_STATS_VERIFY, name, result, &phase_start);
+					if (result == 0) {
+
+						/* check if database update and address allocation were successful. */
+						pppd__stats_start(PPPD_STATS_STATUS, name, &phase_start);
+						if ((result = pppd__mysql_status(&mysql, target, name, 1)) == 0 &&
+						    (result = pppd__mysql_allocate(&mysql)) != 0) {
+
+							/* reset the login status and lease again, the link is not established. (ignore return code, reconciliation or the lease expiry clean up) */
+							pppd__mysql_reset(&mysql, target, name);
+						}
+						pppd__stats_stop(PPPD_STATS_STATUS, name, result, &phase_start);
+						if (result == 0) {
 
 							/* store username for ip down configuration. */
 							strncpy(username, name, MAXNAMELEN);
@@ -490,6 +2038,15 @@ int32_t pppd__chap_verify_mysql(char *name, char *ourname, int id, struct chap_d
 							/* disconnect from mysql. */
 							pppd__mysql_disconnect(&mysql);
 
+							/* unlock registry, the login status is written. */
+							pppd__registry_unlock(registry);
+
+							/* record the accepted login. */
+							pppd__stats_login(name, 0, &login_start);
+
+							/* log the login if it was slow. */
+							pppd__mysql_slow(name, 0);
+
 							/* clear the memory with the password, so nobody is able to dump it. */
 							memset(secret_name, 0, sizeof(secret_name));
 
@@ -505,6 +2062,20 @@ int32_t pppd__chap_verify_mysql(char *name, char *ourname, int id, struct chap_d
 		}
 	}
 
+	/* check if session was registered, but login failed. */
+	if (registry >= 0) {
+
+		/* unlock registry and remove session. */
+		pppd__registry_unlock(registry);
+		pppd__registry_remove(pppd_mysql_registry);
+	}
+
+	/* record the failed login, the fallback to the secrets file is not part of it. */
+	pppd__stats_login(name, result, &login_start);
+
+	/* log the login if it was slow. */
+	pppd__mysql_slow(name, result);
+
 	/* check if mysql is not authoritative. */
 	if (pppd_mysql_authoritative == 0) {
 
@@ -539,22 +2110,52 @@ int32_t pppd__pap_auth_mysql(char *user, char *passwd, char **msgp, struct wordl
 	/* some common variables. */
 	uint8_t secret_name[MAXSECRETLEN];
 	int32_t secret_length = 0;
+	int32_t registry      = PPPD_SQL_ERROR_REGISTRY;
+	int32_t result        = 0;
 	MYSQL *mysql          = NULL;
+	struct pppd_mysql_target *target = NULL;
+	struct timespec login_start;
+	struct timespec phase_start;
 
-	/* check if parameters are complete. */
-	if (pppd__mysql_parameter() == 0) {
+	/* start the timer of the whole login. */
+	pppd__stats_start(PPPD_STATS_LOGIN, user, &login_start);
 
-		/* check if mysql connect is working. */
-		if (pppd__mysql_connect(&mysql) == 0) {
+	/* check if parameters are complete and session is registered. */
+	if ((result = pppd__mysql_parameter()) == 0 &&
+	    (result = pppd__mysql_route(pppd__mysql_select(user))) == 0 &&
+	    (result = pppd__mysql_register(user, &registry)) == 0) {
+
+		/* all queries of the login go to the shard or realm of the user. */
+		target = &pppd_mysql_plan.targets[pppd_mysql_plan.target];
+
+		/* check if mysql connect is working, failed connects are timed too. */
+		pppd__stats_start(PPPD_STATS_CONNECT, user, &phase_start);
+		result = pppd__mysql_connect(&mysql, target, 0);
+		pppd__stats_stop(PPPD_STATS_CONNECT, user, result, &phase_start);
+		if (result == 0) {
 
 			/* check if mysql fetching was successful. */
-			if (pppd__mysql_password(&mysql, user, secret_name, &secret_length) == 0) {
+			pppd__stats_start(PPPD_STATS_QUERY, user, &phase_start);
+			result = pppd__mysql_password(&mysql, target, user, secret_name, &secret_length);
+			pppd__stats_stop(PPPD_STATS_QUERY, user, result, &phase_start);
+			if (result == 0) {
 
 				/* check if the password is correct. */
-				if (pppd__verify_password(passwd, secret_name, pppd_mysql_pass_encryption, pppd_mysql_pass_key) == 0) {
-
-					/* check if database update was successful. */
-					if (pppd__mysql_status(&mysql, user, 1) == 0) {
+				pppd__stats_start(PPPD_STATS_VERIFY, user, &phase_start);
+				result = pppd__verify_password(passwd, secret_name, pppd_mysql_plan.encryption, pppd_mysql_pass_key);
+				pppd__stats_stop(PPPD_STATS_VERIFY, user, result, &phase_start);
+				if (result == 0) {
+
+					/* check if database update and address allocation were successful. */
+					pppd__stats_start(PPPD_STATS_STATUS, user, &phase_start);
+					if ((result = pppd__mysql_status(&mysql, target, user, 1)) == 0 &&
+					    (result = pppd__mysql_allocate(&mysql)) != 0) {
+
+						/* reset the login status and lease again, the link is not established. (ignore return code, reconciliation or the lease expiry clean up) */
+						pppd__mysql_reset(&mysql, target, user);
+					}
+					pppd__stats_stop(PPPD_STATS_STATUS, user, result, &phase_start);
+					if (result == 0) {
 
 						/* store username for ip down configuration. */
 						strncpy(username, user, MAXNAMELEN);
@@ -562,6 +2163,15 @@ int32_t pppd__pap_auth_mysql(char *user, char *passwd, char **msgp, struct wordl
 						/* disconnect from mysql. */
 						pppd__mysql_disconnect(&mysql);
 
+						/* unlock registry, the login status is written. */
+						pppd__registry_unlock(registry);
+
+						/* record the accepted login. */
+						pppd__stats_login(user, 0, &login_start);
+
+						/* log the login if it was slow. */
+						pppd__mysql_slow(user, 0);
+
 						/* clear the memory with the password, so nobody is able to dump it. */
 						memset(secret_name, 0, sizeof(secret_name));
 
@@ -576,6 +2186,20 @@ int32_t pppd__pap_auth_mysql(char *user, char *passwd, char **msgp, struct wordl
 		}
 	}
 
+	/* check if session was registered, but login failed. */
+	if (registry >= 0) {
+
+		/* unlock registry and remove session. */
+		pppd__registry_unlock(registry);
+		pppd__registry_remove(pppd_mysql_registry);
+	}
+
+	/* record the failed login, the fallback to the secrets file is not part of it. */
+	pppd__stats_login(user, result, &login_start);
+
+	/* log the login if it was slow. */
+	pppd__mysql_slow(user, result);
+
 	/* check if mysql is not authoritative. */
 	if (pppd_mysql_authoritative == 0) {
 
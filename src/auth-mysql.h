@@ -22,6 +22,50 @@
 #ifndef _AUTH_MYSQL_H
 #define _AUTH_MYSQL_H
 
+/* define the character set number of binary strings. */
+#define MYSQL_CHARSET_BINARY		63		/* the character set of BINARY, VARBINARY and BLOB columns. */
+
+/* one target of the logins, a shard or a realm, with its own options and password query. */
+struct pppd_mysql_target {
+	struct pppd_shard	*shard;		/* the database host, port, database and table. */
+	uint8_t		*user;			/* the database user. */
+	uint8_t		*pass;			/* the database password. */
+	uint8_t		*column_user;		/* the username column. */
+	uint8_t		*column_pass;		/* the password column. */
+	uint8_t		*column_client_ip;	/* the client ip address column. */
+	uint8_t		*column_server_ip;	/* the server ip address column. */
+	uint8_t		*condition;		/* the additional condition of the password query. */
+	uint32_t	query_head_length;	/* the length of the password query up to the username. */
+	uint32_t	query_tail_length;	/* the length of the password query behind the username. */
+	uint8_t		query_head[SIZE_QUERY];	/* the password query up to the username. */
+	uint8_t		query_tail[SIZE_QUERY];	/* the password query behind the username. */
+};
+
+/* validated options and precompiled queries, built once after options are complete. */
+struct pppd_mysql_plan {
+	uint32_t	built;			/* one if the plan was built. */
+	int32_t		result;			/* the result of the validation, returned for every login. */
+	uint32_t	encryption;		/* the password encryption algorithm. */
+	uint32_t	shards_count;		/* the number of shards. */
+	uint32_t	targets_count;		/* the number of shards and realms. */
+	uint32_t	target;			/* the shard or realm of the current user, all connections go there. */
+	struct pppd_shard	shards[SIZE_SHARDS];	/* the shards, one built from the host options if none are given. */
+	struct pppd_realms	realms;		/* the realms of the realm file. */
+	struct pppd_mysql_target	targets[SIZE_TARGETS];	/* the shards followed by the realms. */
+};
+
+/* validated options and precompiled queries. */
+extern struct pppd_mysql_plan pppd_mysql_plan;
+
+/* the server side of the current login, kept for the slow log. */
+struct pppd_mysql_slow {
+	unsigned long	thread_id;		/* the connection id of the server, like in the process list and its slow query log. */
+	uint8_t		query[SIZE_QUERY * 2 + MAXNAMELEN * 2];	/* the password query with the escaped username. */
+};
+
+/* the server side of the current login. */
+extern struct pppd_mysql_slow pppd_mysql_slow;
+
 /* this function handles the mysql_error() result. */
 int32_t pppd__mysql_error(
 	uint32_t	error_code,
@@ -29,14 +73,31 @@ int32_t pppd__mysql_error(
 	const uint8_t	*error_state
 );
 
+/* this function validate the parameter and build the plan. */
+int32_t pppd__mysql_plan(
+	void
+);
+
 /* this function check the parameter. */
 int32_t pppd__mysql_parameter(
 	void
 );
 
-/* this function connect to a mysql database. */
+/* this function return the target of the given user. */
+uint32_t pppd__mysql_select(
+	uint8_t		*name
+);
+
+/* this function route the session of this ppp daemon to the given target. */
+int32_t pppd__mysql_route(
+	uint32_t	target
+);
+
+/* this function connect to the database of the given target, writers of journal records pass multi statements. */
 int32_t pppd__mysql_connect(
-	MYSQL		**mysql
+	MYSQL		**mysql,
+	struct pppd_mysql_target	*target,
+	uint32_t	flags
 );
 
 /* this function disconnect from a mysql database. */
@@ -44,21 +105,145 @@ int32_t pppd__mysql_disconnect(
 	MYSQL		**mysql
 );
 
+/* this function convert an ip address column into an address in network byte order. */
+int32_t pppd__mysql_address(
+	MYSQL_FIELD	*field,
+	uint8_t		*value,
+	unsigned long	length,
+	uint32_t	*address
+);
+
 /* this function return the password from database. */
 int32_t pppd__mysql_password(
 	MYSQL		**mysql,
+	struct pppd_mysql_target	*target,
 	uint8_t		*name,
 	uint8_t		*secret_name,
 	int32_t		*secret_length
 );
 
+/* this function append the given value quoted and escaped to the query. */
+int32_t pppd__mysql_quote(
+	MYSQL		**mysql,
+	uint8_t		*query,
+	uint32_t	size,
+	uint32_t	*length,
+	uint8_t		*value
+);
+
+/* this function execute the given write statements in one round trip and commit them. */
+int32_t pppd__mysql_execute(
+	MYSQL		**mysql,
+	uint8_t		*query,
+	uint32_t	statements,
+	uint32_t	*rows
+);
+
+/* this function build the accounting statement for the given records. */
+int32_t pppd__mysql_accounting(
+	MYSQL		**mysql,
+	struct pppd_mysql_target	*target,
+	uint8_t		*query,
+	uint32_t	size,
+	uint32_t	*length,
+	struct pppd_journal_record	*records,
+	uint32_t	count
+);
+
+/* this function write the given records with multi-row statements in one round trip. */
+int32_t pppd__mysql_update(
+	MYSQL		**mysql,
+	struct pppd_mysql_target	*target,
+	struct pppd_journal_record	*records,
+	uint32_t	count
+);
+
+/* this function allocate the client ip address from the pool, if the account has none. */
+int32_t pppd__mysql_allocate(
+	MYSQL		**mysql
+);
+
+/* this function acquire or renew the lease of the current session. */
+int32_t pppd__mysql_lease(
+	MYSQL		**mysql,
+	struct pppd_mysql_target	*target,
+	uint8_t		*name
+);
+
 /* this function update the login status in database. */
 int32_t pppd__mysql_status(
 	MYSQL		**mysql,
+	struct pppd_mysql_target	*target,
 	uint8_t		*name,
 	uint32_t	status
 );
 
+/* this function reset the login status, lease and pool address of a session which never came up. */
+int32_t pppd__mysql_reset(
+	MYSQL		**mysql,
+	struct pppd_mysql_target	*target,
+	uint8_t		*name
+);
+
+/* this function write the given journal records to database. */
+int32_t pppd__mysql_journal(
+	struct pppd_journal_record	*records,
+	uint32_t	count
+);
+
+/* this function reset the login status of all sessions owned by this server which are not running. */
+int32_t pppd__mysql_stale(
+	MYSQL		**mysql,
+	struct pppd_mysql_target	*target,
+	uint8_t		*names,
+	uint32_t	count
+);
+
+/* this function is the stale login status reconciliation timer for the ppp daemon. */
+void pppd__mysql_reconcile(
+	void		*opaque
+);
+
+/* this function register the session on this host, so reconciliation does not reset its login status. */
+int32_t pppd__mysql_register(
+	uint8_t		*name,
+	int32_t		*registry
+);
+
+/* this function is the lease renewal timer for the ppp daemon. */
+void pppd__mysql_renew(
+	void		*opaque
+);
+
+/* this function is the interim accounting timer for the ppp daemon. */
+void pppd__mysql_interim(
+	void		*opaque
+);
+
+/* this function log the current login if one of its phases exceeded the threshold. */
+int32_t pppd__mysql_slow(
+	uint8_t		*name,
+	int32_t		result
+);
+
+/* this function log the script if it exceeded the threshold. */
+int32_t pppd__mysql_slow_script(
+	uint8_t		*program,
+	int32_t		result
+);
+
+/* this function warn if the password query does not look up the user by an index. */
+int32_t pppd__mysql_explain(
+	MYSQL		**mysql,
+	struct pppd_mysql_target	*target
+);
+
+/* this function is the phase change notifier for the ppp daemon. */
+void pppd__mysql_phase(
+	void		*opaque,
+	int32_t		arg
+);
+
 /* this function is the ip up notifier for the ppp daemon. */
 void pppd__mysql_up(
 	void		*opaque,
@@ -71,6 +256,12 @@ void pppd__mysql_down(
 	int32_t		arg
 );
 
+/* this function is the exit notifier for the ppp daemon. */
+void pppd__mysql_exit(
+	void		*opaque,
+	int32_t		arg
+);
+
 /* this function check the chap authentication information against a mysql database. */
 int32_t pppd__chap_verify_mysql(
 	char		*name,
@@ -21,7 +21,13 @@
 
 /* generic plugin includes. */
 #include "plugin.h"
+#include "journal.h"
+#include "netlink.h"
 #include "plugin-pgsql.h"
+#include "pool.h"
+#include "radix.h"
+#include "registry.h"
+#include "stats.h"
 #include "str.h"
 
 /* auth plugin includes. */
@@ -30,6 +36,18 @@
 /* store username in global variable, because ip down did not know it. */
 uint8_t username[MAXNAMELEN];
 
+/* indicate if the startup tasks were already executed. */
+uint32_t startup = 0;
+
+/* indicate if the client address is allocated from the pool table, it is released at ip down or exit. */
+uint32_t allocated = 0;
+
+/* validated options and precompiled queries, built once after options are complete. */
+struct pppd_pgsql_plan pppd_pgsql_plan;
+
+/* the server side of the current login, kept for the slow log. */
+struct pppd_pgsql_slow pppd_pgsql_slow;
+
 /* this function handles the PQerrorMessage() result. */
 int32_t pppd__pgsql_error(uint8_t *error_message) {
 
@@ -62,17 +80,33 @@ int32_t pppd__pgsql_error(uint8_t *error_message) {
 	return 0;
 }
 
-/* this function check the parameter. */
-int32_t pppd__pgsql_parameter(void) {
+/* this function validate the parameter and build the plan. */
+int32_t pppd__pgsql_plan(void) {
 
-	/* check if all information are supplied. */
-	if (pppd_pgsql_host		== NULL ||
-	    pppd_pgsql_port		== NULL ||
+	/* some common variables. */
+	uint8_t columns[SIZE_QUERY] = { 0 };
+	uint8_t attributes[SIZE_QUERY] = { 0 };
+	uint8_t *string          = NULL;
+	uint8_t *column          = NULL;
+	uint32_t length          = 0;
+	uint32_t count           = 0;
+	uint32_t line            = 0;
+	uint32_t target_length   = 0;
+	int32_t truncated        = 0;
+	int32_t target_truncated = 0;
+	int32_t encryption       = 0;
+	struct pppd_realm *realm         = NULL;
+	struct pppd_pgsql_target *target = NULL;
+
+	/* check if all information are supplied, the host options are not required if shards are given. */
+	if (((pppd_pgsql_host		== NULL ||
+	      pppd_pgsql_port		== NULL ||
+	      pppd_pgsql_database	== NULL ||
+	      pppd_pgsql_table		== NULL) &&
+	     pppd_pgsql_shards		== NULL) ||
 	    pppd_pgsql_user		== NULL ||
 	    pppd_pgsql_pass		== NULL ||
 	    pppd_pgsql_pass_encryption	== NULL ||
-	    pppd_pgsql_database		== NULL ||
-	    pppd_pgsql_table		== NULL ||
 	    pppd_pgsql_column_user	== NULL ||
 	    pppd_pgsql_column_pass	== NULL ||
 	    pppd_pgsql_column_client_ip	== NULL ||
@@ -85,9 +119,19 @@ int32_t pppd__pgsql_parameter(void) {
 		return PPPD_SQL_ERROR_INCOMPLETE;
 	}
 
+	/* check if encryption algorithm is supported. */
+	if ((encryption = pppd__encryption((uint8_t *)pppd_pgsql_pass_encryption)) < 0) {
+
+		/* unknown algorithm, otherwise every password would be accepted. */
+		error("Plugin: %s: PostgreSQL encryption %s is not supported\n", PLUGIN_NAME_PGSQL, pppd_pgsql_pass_encryption);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_OPTION;
+	}
+
 	/* check if passwords are encrypted. */
-	if (strcasecmp((char *)pppd_pgsql_pass_encryption, "CRYPT")	== 0 ||
-	    strcasecmp((char *)pppd_pgsql_pass_encryption, "AES")	== 0) {
+	if (encryption == PPPD_SQL_ENCRYPTION_CRYPT ||
+	    encryption == PPPD_SQL_ENCRYPTION_AES) {
 
 		/* check if key or salt is given. */
 		if (pppd_pgsql_pass_key == NULL) {
@@ -103,8 +147,9 @@ int32_t pppd__pgsql_parameter(void) {
 	/* check if concurrent connection from one user should be denied. */
 	if (pppd_pgsql_exclusive == 1) {
 
-		/* check if update column is given. */
-		if (pppd_pgsql_column_update == NULL ||
+		/* check if update column or sessions table is given. */
+		if ((pppd_pgsql_column_update  == NULL &&
+		     pppd_pgsql_session_table == NULL) ||
 		    pppd_pgsql_authoritative == 0) {
 
 			/* some required exclusive information are missing. */
@@ -115,6 +160,310 @@ int32_t pppd__pgsql_parameter(void) {
 		}
 	}
 
+	/* check if session accounting should be written. */
+	if (pppd_pgsql_accounting_table != NULL) {
+
+		/* check if accounting columns are given. */
+		if (pppd_pgsql_column_bytes_received	== NULL ||
+		    pppd_pgsql_column_bytes_transmitted	== NULL ||
+		    pppd_pgsql_column_duration		== NULL) {
+
+			/* some required accounting information are missing. */
+			error("Plugin: %s: PostgreSQL accounting information are not complete\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if interim accounting updates should be written. */
+	if (pppd_pgsql_interim_interval > 0) {
+
+		/* check if accounting table and session column are given. */
+		if (pppd_pgsql_accounting_table == NULL ||
+		    pppd_pgsql_column_session   == NULL) {
+
+			/* some required interim information are missing. */
+			error("Plugin: %s: PostgreSQL interim information are not complete\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if online state should be kept as lease in a sessions table. */
+	if (pppd_pgsql_session_table != NULL) {
+
+		/* check if lease columns are given and concurrent connection is denied. */
+		if (pppd_pgsql_column_session == NULL ||
+		    pppd_pgsql_column_expires == NULL ||
+		    pppd_pgsql_lease_time     < 3 ||
+		    pppd_pgsql_exclusive      == 0) {
+
+			/* some required lease information are missing. */
+			error("Plugin: %s: PostgreSQL lease information are not complete\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if client ip addresses should be allocated from a pool. */
+	if (pppd_pgsql_pool_table != NULL) {
+
+		/* check if pool columns are given. */
+		if (pppd_pgsql_column_pool_ip      == NULL ||
+		    pppd_pgsql_column_pool_session == NULL) {
+
+			/* some required pool information are missing. */
+			error("Plugin: %s: PostgreSQL pool information are not complete\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if client ip addresses should be allocated from a host-local pool. */
+	if (pppd_pgsql_pool_file != NULL) {
+
+		/* check if range is given and database pool is not used. */
+		if (pppd_pgsql_pool_range == NULL ||
+		    pppd_pgsql_pool_table != NULL) {
+
+			/* some required pool information are missing. */
+			error("Plugin: %s: PostgreSQL local pool information are not complete\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if traffic should be shaped. */
+	if (pppd_pgsql_column_rate_down != NULL ||
+	    pppd_pgsql_column_rate_up   != NULL) {
+
+		/* check if rates are fetched as session attributes. */
+		if (pppd_pgsql_column_attributes == NULL) {
+
+			/* some required shaping information are missing. */
+			error("Plugin: %s: PostgreSQL shaping information are not complete\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if client address should be added to firewall sets. */
+	if (pppd_pgsql_column_nft_set != NULL) {
+
+		/* check if table is given and sets are fetched as session attributes. */
+		if (pppd_pgsql_nft_table         == NULL ||
+		    pppd_pgsql_column_attributes == NULL) {
+
+			/* some required firewall information are missing. */
+			error("Plugin: %s: PostgreSQL firewall information are not complete\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if framed routes are given. */
+	if (pppd_pgsql_column_framed_routes != NULL) {
+
+		/* check if routes are fetched as session attributes. */
+		if (pppd_pgsql_column_attributes == NULL) {
+
+			/* some required routing information are missing. */
+			error("Plugin: %s: PostgreSQL framed routes information are not complete\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if ownership of the login status should be recorded. */
+	if (pppd_pgsql_server_id != NULL) {
+
+		/* check if server identifier and update columns are given. */
+		if (pppd_pgsql_column_server_id == NULL ||
+		    pppd_pgsql_column_update    == NULL) {
+
+			/* some required reconciliation information are missing. */
+			error("Plugin: %s: PostgreSQL reconciliation information are not complete\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if shards are given, the port and table options are their defaults. */
+	if (pppd_pgsql_shards != NULL) {
+
+		/* check if shards were successfully parsed. */
+		if (pppd__shard_parse(pppd_pgsql_shards, pppd_pgsql_port, pppd_pgsql_table, pppd_pgsql_plan.shards, &pppd_pgsql_plan.shards_count) < 0) {
+
+			/* some shard is not valid. */
+			error("Plugin: %s: PostgreSQL shards %s are not valid\n", PLUGIN_NAME_PGSQL, pppd_pgsql_shards);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_OPTION;
+		}
+	} else {
+
+		/* check if the host options fit into the only shard. */
+		if (pppd__shard_fill(&pppd_pgsql_plan.shards[0], pppd_pgsql_host, pppd_pgsql_port, pppd_pgsql_database, pppd_pgsql_table) < 0) {
+
+			/* some option is too long. */
+			error("Plugin: %s: PostgreSQL port is not a valid number or host, database or table is too long\n", PLUGIN_NAME_PGSQL);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_OPTION;
+		}
+
+		/* the host options are the only shard. */
+		pppd_pgsql_plan.shards_count = 1;
+	}
+
+	/* check if realms are given, the port and table options are their defaults. */
+	if (pppd_pgsql_realms != NULL &&
+	    pppd__realm_load(pppd_pgsql_realms, pppd_pgsql_port, pppd_pgsql_table, &pppd_pgsql_plan.realms, &line) < 0) {
+
+		/* some realm is not valid. */
+		error("Plugin: %s: PostgreSQL realm file %s is not valid at line %d\n", PLUGIN_NAME_PGSQL, pppd_pgsql_realms, line);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_OPTION;
+	}
+
+	/* store the parsed options, so no login parses them again. */
+	pppd_pgsql_plan.encryption    = encryption;
+	pppd_pgsql_plan.targets_count = pppd_pgsql_plan.shards_count + pppd_pgsql_plan.realms.count;
+
+	/* build the connection keywords, the values are passed as they are, so no quoting is required. (host, port, user, password and dbname are set from the shard or realm on connect) */
+	slprintf((char *)pppd_pgsql_plan.connect_timeout, sizeof(pppd_pgsql_plan.connect_timeout), "%d", pppd_pgsql_connect_timeout);
+	pppd_pgsql_plan.keywords[0] = "host";
+	pppd_pgsql_plan.keywords[1] = "port";
+	pppd_pgsql_plan.keywords[2] = "user";
+	pppd_pgsql_plan.keywords[3] = "password";
+	pppd_pgsql_plan.keywords[4] = "dbname";
+	pppd_pgsql_plan.keywords[5] = "connect_timeout";
+	pppd_pgsql_plan.values[5]   = (char *)pppd_pgsql_plan.connect_timeout;
+	pppd_pgsql_plan.keywords[6] = NULL;
+	pppd_pgsql_plan.values[6]   = NULL;
+
+	/* check if attributes are fetched with the same query, all shards and realms use them. */
+	if (pppd_pgsql_column_attributes != NULL) {
+
+		/* copy the list, it is split in place. */
+		strncpy((char *)columns, (char *)pppd_pgsql_column_attributes, sizeof(columns) - 1);
+		string = columns;
+
+		/* loop through all attribute columns, they are cast to text, so scripts get the same values as in text format. */
+		while ((column = pppd__strsep(&string, (uint8_t *)",")) != NULL) {
+
+			/* skip whitespace around the column name. */
+			column += strspn((char *)column, " \t");
+			column[strcspn((char *)column, " \t")] = '\0';
+
+			/* check if column name is empty. */
+			if (*column == '\0') {
+				continue;
+			}
+
+			/* append the column, a cast keeps the column name. */
+			truncated |= pppd__strappend(attributes, SIZE_QUERY, &length, ", CAST(%s AS text)", column);
+		}
+	}
+
+	/* loop through all shards and realms, each has its own password query and options. */
+	for (count = 0; count < pppd_pgsql_plan.targets_count; count++) {
+
+		/* the shards use the options. */
+		target = &pppd_pgsql_plan.targets[count];
+		if (count < pppd_pgsql_plan.shards_count) {
+			target->shard            = &pppd_pgsql_plan.shards[count];
+			target->user             = pppd_pgsql_user;
+			target->pass             = pppd_pgsql_pass;
+			target->column_user      = pppd_pgsql_column_user;
+			target->column_pass      = pppd_pgsql_column_pass;
+			target->column_client_ip = pppd_pgsql_column_client_ip;
+			target->column_server_ip = pppd_pgsql_column_server_ip;
+			target->condition        = pppd_pgsql_condition;
+		} else {
+
+			/* the realms use their own settings and the options for the missing ones. */
+			realm                    = &pppd_pgsql_plan.realms.realm[count - pppd_pgsql_plan.shards_count];
+			target->shard            = &realm->shard;
+			target->user             = realm->user[0] != '\0' ? realm->user : pppd_pgsql_user;
+			target->pass             = realm->pass[0] != '\0' ? realm->pass : pppd_pgsql_pass;
+			target->column_user      = realm->column_user[0] != '\0' ? realm->column_user : pppd_pgsql_column_user;
+			target->column_pass      = realm->column_pass[0] != '\0' ? realm->column_pass : pppd_pgsql_column_pass;
+			target->column_client_ip = realm->column_client_ip[0] != '\0' ? realm->column_client_ip : pppd_pgsql_column_client_ip;
+			target->column_server_ip = realm->column_server_ip[0] != '\0' ? realm->column_server_ip : pppd_pgsql_column_server_ip;
+			target->condition        = realm->condition[0] != '\0' ? realm->condition : pppd_pgsql_condition;
+		}
+
+		/* build the password query, the result is fetched in binary format, the username is bound to the placeholder and an exclusive read lock is set if a lease does not replace it. */
+		target_length = 0;
+		target_truncated = truncated | pppd__strappend(target->query, SIZE_QUERY, &target_length, "SELECT %s, %s, %s%s FROM %s WHERE %s=$1%s%s%s",
+			target->column_pass, target->column_client_ip, target->column_server_ip, attributes,
+			target->shard->table, target->column_user,
+			target->condition != NULL ? " AND " : "", target->condition != NULL ? (char *)target->condition : "",
+			pppd_pgsql_exclusive == 1 && pppd_pgsql_authoritative == 1 && pppd_pgsql_column_update != NULL && pppd_pgsql_session_table == NULL ? " FOR UPDATE" : "");
+		target->query_length = target_truncated < 0 ? SIZE_QUERY : target_length;
+
+		/* check if query was truncated, this is refused instead of running a different condition. */
+		if (target->query_length >= SIZE_QUERY) {
+
+			/* query is too long. */
+			error("Plugin: %s: PostgreSQL password query is longer than %d bytes\n", PLUGIN_NAME_PGSQL, SIZE_QUERY - 1);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function check the parameter, the plan is built at the first call and reused by every login. */
+int32_t pppd__pgsql_parameter(void) {
+
+	/* check if plan was not built, options do not change after they are complete. */
+	if (pppd_pgsql_plan.built == 0) {
+
+		/* validate options and build plan. */
+		pppd_pgsql_plan.result = pppd__pgsql_plan();
+		pppd_pgsql_plan.built  = 1;
+	}
+
+	/* return the result of the validation. */
+	return pppd_pgsql_plan.result;
+}
+
+/* this function return the target of the given user, the realm behind the at sign or else the shard of the username hash. */
+uint32_t pppd__pgsql_select(uint8_t *name) {
+
+	/* some common variables. */
+	int32_t realm = 0;
+
+	/* check if a realm matches. */
+	if ((realm = pppd__realm_find(&pppd_pgsql_plan.realms, name)) >= 0) {
+		return pppd_pgsql_plan.shards_count + realm;
+	}
+
+	/* select the shard by a stable hash of the username. */
+	return pppd__shard_select(name, pppd_pgsql_plan.shards_count);
+}
+
+/* this function route the session of this ppp daemon to the given target, the notifiers write there. */
+int32_t pppd__pgsql_route(uint32_t target) {
+
+	/* store the target of the current user, the options are left untouched. */
+	pppd_pgsql_plan.target = target;
+
 	/* if no error was found, return zero. */
 	return 0;
 }
@@ -130,6 +479,10 @@ int32_t pppd__pgsql_transaction(PGconn *pgsql, uint8_t *transaction) {
 	/* loop through number of query retries. */
 	for (count = pppd_pgsql_retry_query; count > 0 ; count--) {
 
+		/* count the round trip, every try after the first one is a retry. */
+		pppd__stats_count(PPPD_STATS_ROUND_TRIPS, 1);
+		pppd__stats_count(PPPD_STATS_RETRIES, count < pppd_pgsql_retry_query ? 1 : 0);
+
 		/* check if query was successfully executed. */
 		if ((result = PQexec(pgsql, (char *)transaction)) != NULL) {
 
@@ -161,24 +514,31 @@ int32_t pppd__pgsql_transaction(PGconn *pgsql, uint8_t *transaction) {
 	return 0;
 }
 
-/* this function connect to a postgresql database. */
-int32_t pppd__pgsql_connect(PGconn **pgsql) {
+/* this function connect to the database of the given target. */
+int32_t pppd__pgsql_connect(PGconn **pgsql, struct pppd_pgsql_target *target) {
 
 	/* some common variables. */
-	uint8_t connection_info[1024];
 	uint32_t count = 0;
 
-	/* clear connection info from previous connection. */
-	memset(connection_info, 0, sizeof(connection_info));
+	/* connect to the shard or realm, an empty port is the default of libpq. */
+	pppd_pgsql_plan.values[0] = (char *)target->shard->host;
+	pppd_pgsql_plan.values[1] = target->shard->port[0] != '\0' ? (char *)target->shard->port : NULL;
+	pppd_pgsql_plan.values[2] = (char *)target->user;
+	pppd_pgsql_plan.values[3] = (char *)target->pass;
+	pppd_pgsql_plan.values[4] = (char *)target->shard->database;
 
-	/* create the connection information for postgresql. */
-	snprintf((char *)connection_info, 1024, "host='%s' port='%s' user='%s' password='%s' dbname='%s' connect_timeout='%i'", pppd_pgsql_host, pppd_pgsql_port, pppd_pgsql_user, pppd_pgsql_pass, pppd_pgsql_database, pppd_pgsql_connect_timeout);
+	/* forget the server side of a previous connection. */
+	pppd_pgsql_slow.backend_pid = 0;
 
 	/* loop through number of connection retries. */
 	for (count = pppd_pgsql_retry_connect; count > 0 ; count--) {
 
+		/* count the round trip, every try after the first one is a retry. */
+		pppd__stats_count(PPPD_STATS_ROUND_TRIPS, 1);
+		pppd__stats_count(PPPD_STATS_RETRIES, count < pppd_pgsql_retry_connect ? 1 : 0);
+
 		/* connect to postgresql database. */
-		*pgsql = PQconnectdb((char *)connection_info);
+		*pgsql = PQconnectdbParams(pppd_pgsql_plan.keywords, pppd_pgsql_plan.values, 0);
 
 		/* check if postgresql connection was successfully established. */
 		if (PQstatus(*pgsql) != CONNECTION_OK) {
@@ -202,6 +562,9 @@ int32_t pppd__pgsql_connect(PGconn **pgsql) {
 		}
 	}
 
+	/* remember the backend process id, it identifies the login in the logs of the server. */
+	pppd_pgsql_slow.backend_pid = PQbackendPID(*pgsql);
+
 	/* check if transaction begin was successful. */
 	if (pppd__pgsql_transaction(*pgsql, (uint8_t *)"BEGIN") < 0) {
 
@@ -230,49 +593,72 @@ int32_t pppd__pgsql_disconnect(PGconn **pgsql) {
 	return 0;
 }
 
-/* this function return the password from database. */
-int32_t pppd__pgsql_password(PGconn **pgsql, uint8_t *name, uint8_t *secret_name, int32_t *secret_length) {
+/* this function convert a binary ip address column into an address in network byte order. */
+int32_t pppd__pgsql_address(PGresult *result, uint32_t column, uint32_t *address) {
 
 	/* some common variables. */
-	uint8_t query[1024];
-	uint8_t query_extended[1024];
-	int32_t is_null  = 0;
-	uint32_t count   = 0;
-	uint32_t found   = 0;
-	uint8_t *row     = 0;
-	uint8_t *field   = NULL;
-	PGresult *result = NULL;
+	uint8_t *value  = (uint8_t *)PQgetvalue(result, 0, column);
+	uint32_t length = PQgetlength(result, 0, column);
 
-	/* build query for database. */
-	snprintf((char *)query, 1024, "SELECT %s, %s, %s FROM %s WHERE %s='%s'", pppd_pgsql_column_pass, pppd_pgsql_column_client_ip, pppd_pgsql_column_server_ip, pppd_pgsql_table, pppd_pgsql_column_user, name);
+	/* check the type of the column, every type has its own binary format. */
+	switch (PQftype(result, column)) {
 
-	/* check if we have an additional postgresql condition. */
-	if (pppd_pgsql_condition != NULL) {
+		/* inet and cidr are family, bits, is_cidr, length and the address. */
+		case PGSQL_OID_INET:
+		case PGSQL_OID_CIDR:
 
-		/* build extended query for database. */
-		snprintf((char *)query_extended, 1024, " AND %s", pppd_pgsql_condition);
+			/* check if column is an IPv4 address. */
+			if (length != 8 ||
+			    value[0] != PGSQL_AF_INET ||
+			    value[3] != 4) {
 
-		/* only write 1023 bytes, because strncat writes 1023 bytes plus the terminating null byte. */
-		strncat((char *)query, (char *)query_extended, 1023);
+				/* return with error. */
+				return PPPD_SQL_ERROR_QUERY;
+			}
 
-		/* clear the memory with the extended query, to build next one if required. */
-		memset(query_extended, 0, sizeof(query_extended));
-	}
+			/* the address is already in network byte order. */
+			return pppd__address(value + 4, 4, PPPD_SQL_ADDRESS_BYTES, address);
 
-	/* check if we should set an exclusive read lock. */
-	if (pppd_pgsql_exclusive     == 1 &&
-	    pppd_pgsql_authoritative == 1 &&
-	    pppd_pgsql_column_update != NULL) {
+		/* integers are in network byte order, so the address is the last four bytes. */
+		case PGSQL_OID_INT4:
+		case PGSQL_OID_INT8:
+			return pppd__address(value + length - 4, 4, PPPD_SQL_ADDRESS_BYTES, address);
 
-		/* only write 1023 bytes, because strncat writes 1023 bytes plus the terminating null byte. */
-		strncat((char *)query, " FOR UPDATE", 1023);
+		/* bytea is the raw address. */
+		case PGSQL_OID_BYTEA:
+			return pppd__address(value, length, PPPD_SQL_ADDRESS_BYTES, address);
+
+		/* character types are the same in text and binary format. */
+		default:
+			return pppd__address(value, length, PPPD_SQL_ADDRESS_TEXT, address);
 	}
+}
+
+/* this function return the password from database. */
+int32_t pppd__pgsql_password(PGconn **pgsql, struct pppd_pgsql_target *target, uint8_t *name, uint8_t *secret_name, int32_t *secret_length) {
+
+	/* some common variables. */
+	const char *values[1] = { (char *)name };
+	int32_t is_null  = 0;
+	uint32_t count   = 0;
+	uint32_t found   = 0;
+	uint32_t rate    = 0;
+	uint8_t *row     = 0;
+	uint8_t *field   = NULL;
+	PGresult *result = NULL;
+
+	/* forget attributes of a previous authentication. */
+	pppd__attribute_clear();
 
 	/* loop through number of query retries. */
 	for (count = pppd_pgsql_retry_query; count > 0 ; count--) {
 
-		/* check if query was successfully executed. */
-		if ((result = PQexec(*pgsql, (char *)query)) != NULL) {
+		/* count the round trip, every try after the first one is a retry. */
+		pppd__stats_count(PPPD_STATS_ROUND_TRIPS, 1);
+		pppd__stats_count(PPPD_STATS_RETRIES, count < pppd_pgsql_retry_query ? 1 : 0);
+
+		/* check if query was successfully executed, the result is binary, so addresses need no text conversion. */
+		if ((result = PQexecParams(*pgsql, (char *)target->query, 1, NULL, values, NULL, NULL, 1)) != NULL) {
 
 			/* indicate that we fetch a result. */
 			found = 1;
@@ -330,6 +716,11 @@ int32_t pppd__pgsql_password(PGconn **pgsql, uint8_t *name, uint8_t *secret_name
 		/* fetch NULL information. */
 		is_null = PQgetisnull(result, 0, count);
 
+		/* check if attribute column is NULL, then the attribute is not set. */
+		if (count >= 3 && is_null == 1) {
+			continue;
+		}
+
 		/* first check what result we should get. */
 		if (is_null == 0) {
 
@@ -368,11 +759,12 @@ int32_t pppd__pgsql_password(PGconn **pgsql, uint8_t *name, uint8_t *secret_name
 		/* check if we found client ip. */
 		if (count == 1) {
 
-			/* check if ip address was successfully converted into binary data. */
-			if (inet_aton((char *)row, (struct in_addr *) &client_ip) == 0) {
+			/* check if ip address was successfully converted, a NULL is never a valid address. */
+			if (is_null == 1 ||
+			    pppd__pgsql_address(result, count, &client_ip) < 0) {
 
 				/* error on converting ip address. */
-				error("Plugin %s: Client IP address %s is not valid\n", PLUGIN_NAME_PGSQL, row);
+				error("Plugin %s: Client IP address of %s is not valid\n", PLUGIN_NAME_PGSQL, name);
 
 				/* clear memory to avoid leaks. */
 				PQclear(result);
@@ -385,11 +777,12 @@ int32_t pppd__pgsql_password(PGconn **pgsql, uint8_t *name, uint8_t *secret_name
 		/* check if we found server ip. */
 		if (count == 2) {
 
-			/* check if ip address was successfully converted into binary data. */
-			if (inet_aton((char *)row, (struct in_addr *) &server_ip) == 0) {
+			/* check if ip address was successfully converted, a NULL is never a valid address. */
+			if (is_null == 1 ||
+			    pppd__pgsql_address(result, count, &server_ip) < 0) {
 
 				/* error on converting ip address. */
-				error("Plugin %s: Server IP address %s is not valid\n", PLUGIN_NAME_PGSQL, row);
+				error("Plugin %s: Server IP address of %s is not valid\n", PLUGIN_NAME_PGSQL, name);
 
 				/* clear memory to avoid leaks. */
 				PQclear(result);
@@ -398,31 +791,100 @@ int32_t pppd__pgsql_password(PGconn **pgsql, uint8_t *name, uint8_t *secret_name
 				return PPPD_SQL_ERROR_QUERY;
 			}
 		}
+
+		/* check if we found an attribute. */
+		if (count >= 3) {
+
+			/* store attribute for the scripts, framed routes which do not fit are never used. */
+			if (pppd__attribute_add(field, row) < 0 &&
+			    pppd_pgsql_column_framed_routes != NULL &&
+			    strcasecmp((char *)field, (char *)pppd_pgsql_column_framed_routes) == 0) {
+
+				/* clear memory to avoid leaks. */
+				PQclear(result);
+
+				/* return with error and terminate link. */
+				return PPPD_SQL_ERROR_ROUTE;
+			}
+		}
 	}
 
 	/* clear memory to avoid leaks. */
 	PQclear(result);
 
+	/* check if framed routes are given, they are parsed once, so every address check is a tree walk. */
+	if (pppd_pgsql_column_framed_routes != NULL &&
+	    pppd__radix_parse(&framed_routes, pppd__attribute_get(pppd_pgsql_column_framed_routes)) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_ROUTE;
+	}
+
+	/* check if rates are valid, a malformed rate would silently leave the session unlimited. */
+	if (pppd__rate(pppd_pgsql_column_rate_down, &rate) < 0 ||
+	    pppd__rate(pppd_pgsql_column_rate_up, &rate) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_RATE;
+	}
+
 	/* if no error was found, return zero. */
 	return 0;
 }
 
-/* this function update the login status in database. */
-int32_t pppd__pgsql_status(PGconn **pgsql, uint8_t *name, uint32_t status) {
+/* this function append the given value quoted and escaped to the query, so it cannot change the statement. */
+int32_t pppd__pgsql_quote(PGconn **pgsql, uint8_t *query, uint32_t size, uint32_t *length, uint8_t *value) {
+
+	/* some common variables. */
+	uint32_t value_length = strlen((char *)value);
+	int32_t error_code    = 0;
+
+	/* check if the value fits with its quotes and the null byte, every byte may be escaped. */
+	if (*length + value_length * 2 + 3 > size) {
+
+		/* mark buffer as full, like a truncated append. */
+		*length = size - 1;
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* append the escaped value between quotes, the encoding of the connection is used. */
+	query[(*length)++] = '\'';
+	*length += PQescapeStringConn(*pgsql, (char *)query + *length, (char *)value, value_length, &error_code);
+	query[(*length)++] = '\'';
+	query[*length]     = '\0';
+
+	/* check if value was not valid in the encoding of the connection. */
+	if (error_code != 0) {
+
+		/* something on escaping failed. */
+		pppd__pgsql_error((uint8_t *)PQerrorMessage(*pgsql));
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function execute the given write statements in one round trip. */
+int32_t pppd__pgsql_execute(PGconn **pgsql, uint8_t *query, uint32_t *rows) {
 
 	/* some common variables. */
-	uint8_t query[1024];
 	uint32_t count = 0;
 	uint32_t found = 0;
 	PGresult *result = NULL;
 
-	/* build query for database. */
-	snprintf((char *)query, 1024, "UPDATE %s SET %s='%d' WHERE %s='%s'", pppd_pgsql_table, pppd_pgsql_column_update, status, pppd_pgsql_column_user, name);
-
 	/* loop through number of query retries. */
 	for (count = pppd_pgsql_retry_query; count > 0 ; count--) {
 
-		/* check if query was successfully executed. */
+		/* count the round trip, every try after the first one is a retry. */
+		pppd__stats_count(PPPD_STATS_ROUND_TRIPS, 1);
+		pppd__stats_count(PPPD_STATS_RETRIES, count < pppd_pgsql_retry_query ? 1 : 0);
+
+		/* check if query was successfully executed. (postgresql sends all statements in one round trip) */
 		if ((result = PQexec(*pgsql, (char *)query)) != NULL) {
 
 			/* check if the result is okay. */
@@ -434,6 +896,12 @@ int32_t pppd__pgsql_status(PGconn **pgsql, uint8_t *name, uint32_t status) {
 				/* query result was ok, so break loop. */
 				break;
 			}
+
+			/* clear memory to avoid leaks. */
+			PQclear(result);
+
+			/* result was freed, so do not clear it twice. */
+			result = NULL;
 		}
 	}
 
@@ -443,13 +911,15 @@ int32_t pppd__pgsql_status(PGconn **pgsql, uint8_t *name, uint32_t status) {
 		/* something on executing query failed. */
 		pppd__pgsql_error((uint8_t *)PQerrorMessage(*pgsql));
 
-		/* clear memory to avoid leaks. */
-		PQclear(result);
-
 		/* return with error and terminate link. */
 		return PPPD_SQL_ERROR_QUERY;
 	}
 
+	/* check if number of affected rows is requested, the last statement is reported. */
+	if (rows != NULL) {
+		*rows = (uint32_t)atoi(PQcmdTuples(result));
+	}
+
 	/* clear memory to avoid leaks. */
 	PQclear(result);
 
@@ -457,60 +927,1029 @@ int32_t pppd__pgsql_status(PGconn **pgsql, uint8_t *name, uint32_t status) {
 	return 0;
 }
 
-/* this function is the ip up notifier for the ppp daemon. */
-void pppd__pgsql_up(void *opaque, int32_t arg) {
+/* this function build the accounting statement for the given records. */
+int32_t pppd__pgsql_accounting(PGconn **pgsql, struct pppd_pgsql_target *target, uint8_t *query, uint32_t size, uint32_t *length, struct pppd_journal_record *records, uint32_t count) {
 
 	/* some common variables. */
-	PGconn *pgsql = NULL;
+	uint32_t rows  = 0;
+	uint32_t count_records = 0;
 
-	/* check if we should execute a script. */
-	if (pppd_pgsql_ip_up != NULL) {
+	/* loop through all records. */
+	for (count_records = 0; count_records < count; count_records++) {
 
-		/* execute script. */
-		if (pppd__ip_up(username, pppd_pgsql_ip_up) != 0) {
+		/* check if record carries accounting. */
+		if ((records[count_records].flags & JOURNAL_ACCOUNTING) == 0) {
+			continue;
+		}
 
-			/* check if we should fail. */
-			if (pppd_pgsql_ip_up_fail == 1) {
+		/* check if it is the first row. */
+		if (rows == 0) {
 
-				/* show the error. */
-				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_PGSQL, pppd_pgsql_ip_up);
+			/* check if we have a session column, so the row is updated by every interim update. */
+			if (pppd_pgsql_column_session != NULL) {
 
-				/* check if status should be updated. */
-				if (pppd_pgsql_exclusive     == 1 &&
-				    pppd_pgsql_authoritative == 1 &&
-				    pppd_pgsql_column_update != NULL) {
+				/* build insert with session identifier. */
+				pppd__strappend(query, size, length, "INSERT INTO %s AS accounting (%s, %s, %s, %s, %s) VALUES ", pppd_pgsql_accounting_table, pppd_pgsql_column_session, target->column_user, pppd_pgsql_column_bytes_received, pppd_pgsql_column_bytes_transmitted, pppd_pgsql_column_duration);
+			} else {
 
-					/* check if postgresql connect is working. */
-					if (pppd__pgsql_connect(&pgsql) == 0) {
+				/* build insert with one row per session. */
+				pppd__strappend(query, size, length, "INSERT INTO %s (%s, %s, %s, %s) VALUES ", pppd_pgsql_accounting_table, target->column_user, pppd_pgsql_column_bytes_received, pppd_pgsql_column_bytes_transmitted, pppd_pgsql_column_duration);
+			}
+		}
 
-						/* update database. (ignore return code, because what should I do, stop the disconnect?) */
-						pppd__pgsql_status(&pgsql, username, 0);
+		/* check if we have a session column. */
+		if (pppd_pgsql_column_session != NULL) {
 
-						/* disconnect from pgsql. */
-						pppd__pgsql_disconnect(&pgsql);
-					}
-				}
+			/* add row with session identifier. */
+			pppd__strappend(query, size, length, rows > 0 ? ", (" : "(");
+			pppd__pgsql_quote(pgsql, query, size, length, records[count_records].session);
+			pppd__strappend(query, size, length, ", ");
+			pppd__pgsql_quote(pgsql, query, size, length, records[count_records].username);
+			pppd__strappend(query, size, length, ", '%u', '%u', '%u')", records[count_records].bytes_received, records[count_records].bytes_transmitted, records[count_records].duration);
+		} else {
 
-				/* die bitch die. */
-				die(1);
-			}
+			/* add row. */
+			pppd__strappend(query, size, length, rows > 0 ? ", (" : "(");
+			pppd__pgsql_quote(pgsql, query, size, length, records[count_records].username);
+			pppd__strappend(query, size, length, ", '%u', '%u', '%u')", records[count_records].bytes_received, records[count_records].bytes_transmitted, records[count_records].duration);
 		}
+
+		/* increase number of rows. */
+		rows++;
 	}
+
+	/* check if upsert must only add the deltas since the last write. */
+	if (rows > 0 && pppd_pgsql_column_session != NULL) {
+
+		/* add the update part. */
+		pppd__strappend(query, size, length, " ON CONFLICT (%s) DO UPDATE SET %s=accounting.%s+EXCLUDED.%s, %s=accounting.%s+EXCLUDED.%s, %s=EXCLUDED.%s",
+			pppd_pgsql_column_session,
+			pppd_pgsql_column_bytes_received, pppd_pgsql_column_bytes_received, pppd_pgsql_column_bytes_received,
+			pppd_pgsql_column_bytes_transmitted, pppd_pgsql_column_bytes_transmitted, pppd_pgsql_column_bytes_transmitted,
+			pppd_pgsql_column_duration, pppd_pgsql_column_duration);
+	}
+
+	/* return number of rows. */
+	return rows;
 }
 
-/* this function is the ip down notifier for the ppp daemon. */
-void pppd__pgsql_down(void *opaque, int32_t arg) {
+/* this function write the given records with multi-row statements in one round trip. */
+int32_t pppd__pgsql_update(PGconn **pgsql, struct pppd_pgsql_target *target, struct pppd_journal_record *records, uint32_t count) {
 
 	/* some common variables. */
-	PGconn *pgsql = NULL;
-
-	/* check if we should execute a script. */
-	if (pppd_pgsql_ip_down != NULL) {
+	uint8_t *query = NULL;
+	uint32_t size  = (count + 1) * (1024 + MAXNAMELEN * 4 + SIZE_SESSION * 4);
+	uint32_t length = 0;
+	uint32_t start = 0;
+	uint32_t rows  = 0;
+	uint32_t count_records = 0;
+	int32_t result = 0;
 
-		/* execute script. */
-		if (pppd__ip_down(username, pppd_pgsql_ip_down) != 0) {
+	/* check if memory for query was successfully allocated. */
+	if ((query = malloc(size)) == NULL) {
 
-			/* check if we should fail. */
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* clear the memory with the query, because parts of it are optional. */
+	memset(query, 0, size);
+
+	/* check if online state is kept as lease in the sessions table. */
+	if (pppd_pgsql_session_table != NULL) {
+
+		/* loop through all records. */
+		for (count_records = 0; count_records < count; count_records++) {
+
+			/* check if record releases the lease. */
+			if ((records[count_records].flags & JOURNAL_RELEASE) == 0) {
+				continue;
+			}
+
+			/* release the leases of all sessions with one statement, only our own lease is removed. */
+			pppd__strappend(query, size, &length, rows == 0 ? "DELETE FROM %s WHERE %s IN (" : "", pppd_pgsql_session_table, pppd_pgsql_column_session);
+			pppd__strappend(query, size, &length, rows > 0 ? ", " : "");
+			pppd__pgsql_quote(pgsql, query, size, &length, records[count_records].session);
+
+			/* increase number of rows. */
+			rows++;
+		}
+
+		/* check if we have to close the list. */
+		if (rows > 0) {
+			pppd__strappend(query, size, &length, ")");
+		}
+	}
+
+	/* check if we have a column to store the login status. */
+	if (pppd_pgsql_column_update  != NULL &&
+	    pppd_pgsql_session_table == NULL) {
+
+		/* loop through all records. */
+		for (count_records = 0; count_records < count; count_records++) {
+
+			/* check if record resets the login status. */
+			if ((records[count_records].flags & JOURNAL_STATUS) == 0) {
+				continue;
+			}
+
+			/* reset the status of all users with one statement. */
+			pppd__strappend(query, size, &length, rows == 0 ? "UPDATE %s SET %s='0' WHERE %s IN (" : "", target->shard->table, pppd_pgsql_column_update, target->column_user);
+			pppd__strappend(query, size, &length, rows > 0 ? ", " : "");
+			pppd__pgsql_quote(pgsql, query, size, &length, records[count_records].username);
+
+			/* increase number of rows. */
+			rows++;
+		}
+
+		/* check if we have to close the list. */
+		if (rows > 0) {
+			pppd__strappend(query, size, &length, ")");
+		}
+	}
+
+	/* check if client ip addresses are allocated from a pool. */
+	if (pppd_pgsql_pool_table != NULL) {
+
+		/* remember end of the status statement. */
+		start = length;
+
+		/* add statement delimiter if required. */
+		pppd__strappend(query, size, &length, length > 0 ? "; " : "");
+
+		/* no address released so far. */
+		rows = 0;
+
+		/* loop through all records. */
+		for (count_records = 0; count_records < count; count_records++) {
+
+			/* check if record ends the session. */
+			if ((records[count_records].flags & JOURNAL_RELEASE) == 0) {
+				continue;
+			}
+
+			/* release the addresses of all sessions with one statement. */
+			pppd__strappend(query, size, &length, rows == 0 ? "UPDATE %s SET %s=NULL WHERE %s IN (" : "", pppd_pgsql_pool_table, pppd_pgsql_column_pool_session, pppd_pgsql_column_pool_session);
+			pppd__strappend(query, size, &length, rows > 0 ? ", " : "");
+			pppd__pgsql_quote(pgsql, query, size, &length, records[count_records].session);
+
+			/* increase number of rows. */
+			rows++;
+		}
+
+		/* check if we have to close the list. */
+		if (rows > 0) {
+			pppd__strappend(query, size, &length, ")");
+		} else {
+
+			/* remove the delimiter again. */
+			length = start;
+			query[length] = '\0';
+		}
+	}
+
+	/* check if we should write session accounting. */
+	if (pppd_pgsql_accounting_table != NULL) {
+
+		/* remember end of the status statement. */
+		start = length;
+
+		/* add statement delimiter if required. */
+		pppd__strappend(query, size, &length, length > 0 ? "; " : "");
+
+		/* check if no accounting was added. */
+		if (pppd__pgsql_accounting(pgsql, target, query, size, &length, records, count) == 0) {
+
+			/* remove the delimiter again. */
+			length = start;
+			query[length] = '\0';
+		}
+	}
+
+	/* check if there is something to write. */
+	if (length > 0) {
+
+		/* execute all statements in one round trip, they are committed on disconnect. */
+		result = pppd__pgsql_execute(pgsql, query, NULL);
+	}
+
+	/* clear memory to avoid leaks. */
+	free(query);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function allocate the client ip address from the pool, if the account has none. */
+int32_t pppd__pgsql_allocate(PGconn **pgsql) {
+
+	/* some common variables. */
+	uint8_t query[1024 + SIZE_SESSION * 2];
+	uint32_t length  = 0;
+	uint32_t count   = 0;
+	uint32_t found   = 0;
+	PGresult *result = NULL;
+
+	/* check if pool is not used or the account has a static client ip address. */
+	if ((pppd_pgsql_pool_table == NULL &&
+	     pppd_pgsql_pool_file  == NULL) ||
+	    client_ip != 0) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* check if pool is host-local, then no database round trip is required. */
+	if (pppd_pgsql_pool_file != NULL) {
+
+		/* allocate address from the shared bitmap. */
+		return pppd__pool_allocate(pppd_pgsql_pool_file, pppd_pgsql_pool_range, &client_ip);
+	}
+
+	/* check if session identifier was not already created for a lease. */
+	if (session_id[0] == '\0') {
+
+		/* create the session identifier, it owns the address. */
+		pppd__session_create();
+	}
+
+	/* build allocation, locked rows of concurrent allocations are skipped instead of waited for. */
+	pppd__strappend(query, sizeof(query), &length, "UPDATE %s SET %s=", pppd_pgsql_pool_table, pppd_pgsql_column_pool_session);
+	pppd__pgsql_quote(pgsql, query, sizeof(query), &length, session_id);
+	pppd__strappend(query, sizeof(query), &length, " WHERE %s=(SELECT %s FROM %s WHERE %s IS NULL LIMIT 1 FOR UPDATE SKIP LOCKED) RETURNING %s",
+		pppd_pgsql_column_pool_ip, pppd_pgsql_column_pool_ip, pppd_pgsql_pool_table, pppd_pgsql_column_pool_session, pppd_pgsql_column_pool_ip);
+
+	/* loop through number of query retries. */
+	for (count = pppd_pgsql_retry_query; count > 0 ; count--) {
+
+		/* count the round trip, every try after the first one is a retry. */
+		pppd__stats_count(PPPD_STATS_ROUND_TRIPS, 1);
+		pppd__stats_count(PPPD_STATS_RETRIES, count < pppd_pgsql_retry_query ? 1 : 0);
+
+		/* check if query was successfully executed. */
+		if ((result = PQexec(*pgsql, (char *)query)) != NULL) {
+
+			/* check if the result is okay. */
+			if (PQresultStatus(result) == PGRES_TUPLES_OK) {
+
+				/* indicate that we fetch a result. */
+				found = 1;
+
+				/* query result was ok, so break loop. */
+				break;
+			}
+
+			/* clear memory to avoid leaks. */
+			PQclear(result);
+
+			/* result was freed, so do not clear it twice. */
+			result = NULL;
+		}
+	}
+
+	/* check if no query was executed successfully, very bad :) */
+	if (found == 0) {
+
+		/* something on executing query failed. */
+		pppd__pgsql_error((uint8_t *)PQerrorMessage(*pgsql));
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* check if pool is exhausted. */
+	if (PQntuples(result) == 0) {
+
+		/* no free address found. */
+		error("Plugin %s: Pool %s has no free address\n", PLUGIN_NAME_PGSQL, pppd_pgsql_pool_table);
+
+		/* clear memory to avoid leaks. */
+		PQclear(result);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* the address row belongs to this session now, so it is released again even if it is not valid. */
+	allocated = 1;
+
+	/* check if ip address was successfully converted into binary data. */
+	if (inet_aton(PQgetvalue(result, 0, 0), (struct in_addr *) &client_ip) == 0) {
+
+		/* error on converting ip address. */
+		error("Plugin %s: Client IP address %s is not valid\n", PLUGIN_NAME_PGSQL, PQgetvalue(result, 0, 0));
+
+		/* clear memory to avoid leaks. */
+		PQclear(result);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* clear memory to avoid leaks. */
+	PQclear(result);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function acquire or renew the lease of the current session. */
+int32_t pppd__pgsql_lease(PGconn **pgsql, struct pppd_pgsql_target *target, uint8_t *name) {
+
+	/* some common variables. */
+	uint8_t query[1024 + MAXNAMELEN * 2 + SIZE_SESSION * 2];
+	uint32_t length = 0;
+	uint32_t rows   = 0;
+
+	/* build compare-and-set, the lease is taken if it is free, expired or already ours. */
+	pppd__strappend(query, sizeof(query), &length, "INSERT INTO %s AS lease (%s, %s, %s) VALUES (", pppd_pgsql_session_table, target->column_user, pppd_pgsql_column_session, pppd_pgsql_column_expires);
+	pppd__pgsql_quote(pgsql, query, sizeof(query), &length, name);
+	pppd__strappend(query, sizeof(query), &length, ", ");
+	pppd__pgsql_quote(pgsql, query, sizeof(query), &length, session_id);
+	pppd__strappend(query, sizeof(query), &length, ", now() + interval '%u seconds') ON CONFLICT (%s) DO UPDATE SET %s=EXCLUDED.%s, %s=EXCLUDED.%s WHERE lease.%s<now() OR lease.%s=EXCLUDED.%s",
+		pppd_pgsql_lease_time,
+		target->column_user, pppd_pgsql_column_session, pppd_pgsql_column_session, pppd_pgsql_column_expires, pppd_pgsql_column_expires,
+		pppd_pgsql_column_expires, pppd_pgsql_column_session, pppd_pgsql_column_session);
+
+	/* check if lease statement was successfully executed. */
+	if (pppd__pgsql_execute(pgsql, query, &rows) != 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* check if no row was written, then another session holds a lease which is not expired. */
+	if (rows == 0) {
+
+		/* lease is held by another session. */
+		error("Plugin %s: Lease for %s is held by another session\n", PLUGIN_NAME_PGSQL, name);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_LEASE;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function update the login status in database. */
+int32_t pppd__pgsql_status(PGconn **pgsql, struct pppd_pgsql_target *target, uint8_t *name, uint32_t status) {
+
+	/* some common variables. */
+	uint8_t query[1024 + MAXNAMELEN * 2];
+	uint32_t length = 0;
+	struct pppd_accounting accounting;
+	struct pppd_journal_record record;
+
+	/* check if user logs out. */
+	if (status == 0) {
+
+		/* fetch the counters which are not yet written by interim updates. */
+		pppd__accounting_fetch(&accounting, 1);
+
+		/* build the logout record, the status column is only reset if this server owns it exclusively. */
+		pppd__journal_record(&record, name, JOURNAL_ACCOUNTING | JOURNAL_RELEASE | (pppd_pgsql_exclusive == 1 && pppd_pgsql_authoritative == 1 ? JOURNAL_STATUS : 0), &accounting);
+
+		/* write status reset and accounting in one round trip. */
+		return pppd__pgsql_update(pgsql, target, &record, 1);
+	}
+
+	/* check if online state is kept as lease in the sessions table. */
+	if (pppd_pgsql_session_table != NULL) {
+
+		/* create the session identifier, it owns the lease. */
+		pppd__session_create();
+
+		/* acquire lease, the credential table is not written. */
+		return pppd__pgsql_lease(pgsql, target, name);
+	}
+
+	/* check if there is no column to store the login status. */
+	if (pppd_pgsql_column_update == NULL) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* build query for database. */
+	pppd__strappend(query, sizeof(query), &length, "UPDATE %s SET %s='%d'", target->shard->table, pppd_pgsql_column_update, status);
+
+	/* check if this server should be recorded as owner of the login status. */
+	if (pppd_pgsql_server_id != NULL) {
+		pppd__strappend(query, sizeof(query), &length, ", %s=", pppd_pgsql_column_server_id);
+		pppd__pgsql_quote(pgsql, query, sizeof(query), &length, pppd_pgsql_server_id);
+	}
+
+	/* select the user, the name is escaped. */
+	pppd__strappend(query, sizeof(query), &length, " WHERE %s=", target->column_user);
+	pppd__pgsql_quote(pgsql, query, sizeof(query), &length, name);
+
+	/* execute query. */
+	return pppd__pgsql_execute(pgsql, query, NULL);
+}
+
+/* this function reset the login status, lease and pool address of a session which never came up. */
+int32_t pppd__pgsql_reset(PGconn **pgsql, struct pppd_pgsql_target *target, uint8_t *name) {
+
+	/* some common variables. */
+	struct pppd_journal_record record;
+
+	/* build the logout record without accounting, the status column is only reset if this server owns it exclusively. */
+	pppd__journal_record(&record, name, JOURNAL_RELEASE | (pppd_pgsql_exclusive == 1 && pppd_pgsql_authoritative == 1 ? JOURNAL_STATUS : 0), NULL);
+
+	/* indicate that the address is released. */
+	allocated = 0;
+
+	/* write status reset and address release in one transaction. */
+	return pppd__pgsql_update(pgsql, target, &record, 1);
+}
+
+/* this function write the given journal records to database, the records of a user are written to its shard or realm. */
+int32_t pppd__pgsql_journal(struct pppd_journal_record *records, uint32_t count) {
+
+	/* some common variables. */
+	struct pppd_journal_record *target_records = NULL;
+	uint32_t target        = 0;
+	uint32_t target_count  = 0;
+	uint32_t count_records = 0;
+	int32_t result         = 0;
+	PGconn *pgsql           = NULL;
+
+	/* check if memory for the records of one shard or realm was successfully allocated. */
+	if ((target_records = malloc((count + 1) * sizeof(struct pppd_journal_record))) == NULL) {
+
+		/* return with error, records are flushed later. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all shards and realms until one is not working. */
+	for (target = 0; target < pppd_pgsql_plan.targets_count && result == 0; target++) {
+
+		/* loop through all records and collect the ones of this shard or realm. */
+		for (target_count = 0, count_records = 0; count_records < count; count_records++) {
+
+			/* check if record belongs to this shard or realm and was not written by a previous flush. */
+			if (records[count_records].flags != 0 &&
+			    pppd__pgsql_select(records[count_records].username) == target) {
+				target_records[target_count++] = records[count_records];
+			}
+		}
+
+		/* check if shard or realm has no records. */
+		if (target_count == 0) {
+			continue;
+		}
+
+		/* check if postgresql connect to this shard or realm is working. */
+		if ((result = pppd__pgsql_connect(&pgsql, &pppd_pgsql_plan.targets[target])) == 0) {
+
+			/* write all records of this shard or realm with one group commit. */
+			result = pppd__pgsql_update(&pgsql, &pppd_pgsql_plan.targets[target], target_records, target_count);
+
+			/* disconnect from postgresql. (commits the transaction or rolls back a failed one) */
+			pppd__pgsql_disconnect(&pgsql);
+		}
+
+		/* check if records were written. */
+		if (result == 0) {
+
+			/* loop through all records and clear the flags of this shard or realm in the journal, so a retry after a failing one does not write them twice. */
+			for (count_records = 0; count_records < count; count_records++) {
+				if (pppd__pgsql_select(records[count_records].username) == target) {
+					records[count_records].flags = 0;
+				}
+			}
+		}
+	}
+
+	/* clear memory to avoid leaks. */
+	free(target_records);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function reset the login status of all sessions owned by this server which are not running. */
+int32_t pppd__pgsql_stale(PGconn **pgsql, struct pppd_pgsql_target *target, uint8_t *names, uint32_t count) {
+
+	/* some common variables. */
+	uint8_t *query = NULL;
+	uint32_t size  = (count + 1) * (MAXNAMELEN * 2 + 4) + 1024;
+	uint32_t length = 0;
+	uint32_t count_names = 0;
+	int32_t result = 0;
+
+	/* check if memory for query was successfully allocated. */
+	if ((query = malloc(size)) == NULL) {
+
+		/* return with error, reconciliation is retried later. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* clear the memory with the query, because parts of it are optional. */
+	memset(query, 0, size);
+
+	/* reset all online users of this server with one statement. */
+	pppd__strappend(query, size, &length, "UPDATE %s SET %s='0' WHERE %s='1' AND %s=", target->shard->table, pppd_pgsql_column_update, pppd_pgsql_column_update, pppd_pgsql_column_server_id);
+	pppd__pgsql_quote(pgsql, query, size, &length, pppd_pgsql_server_id);
+
+	/* loop through all users which have a running ppp daemon on this host. */
+	for (count_names = 0; count_names < count; count_names++) {
+
+		/* keep the status of running sessions. */
+		pppd__strappend(query, size, &length, count_names == 0 ? " AND %s NOT IN (" : "", target->column_user);
+		pppd__strappend(query, size, &length, count_names > 0 ? ", " : "");
+		pppd__pgsql_quote(pgsql, query, size, &length, names + count_names * MAXNAMELEN);
+	}
+
+	/* check if we have to close the list. */
+	if (count > 0) {
+		pppd__strappend(query, size, &length, ")");
+	}
+
+	/* execute query. */
+	result = pppd__pgsql_execute(pgsql, query, NULL);
+
+	/* clear memory to avoid leaks. */
+	free(query);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function is the stale login status reconciliation timer for the ppp daemon. */
+void pppd__pgsql_reconcile(void *opaque) {
+
+	/* some common variables. */
+	uint8_t *names = NULL;
+	uint32_t count = 0;
+	uint32_t target  = 0;
+	int32_t lock   = 0;
+	PGconn *pgsql = NULL;
+
+	/* check if reconciliation is due, only one ppp daemon on this host does it per interval. */
+	if ((lock = pppd__registry_lock(pppd_pgsql_registry, pppd_pgsql_reconcile_interval)) >= 0) {
+
+		/* check if running sessions were found. */
+		if (pppd__registry_users(pppd_pgsql_registry, &names, &count) == 0) {
+
+			/* loop through all shards and realms, this server may own users on each of them. */
+			for (target = 0; target < pppd_pgsql_plan.targets_count; target++) {
+
+				/* check if pgsql connect to this shard or realm is working. */
+				if (pppd__pgsql_connect(&pgsql, &pppd_pgsql_plan.targets[target]) == 0) {
+
+					/* reset stale login status. (ignore return code, it is retried with next interval) */
+					pppd__pgsql_stale(&pgsql, &pppd_pgsql_plan.targets[target], names, count);
+
+					/* disconnect from pgsql. */
+					pppd__pgsql_disconnect(&pgsql);
+				}
+			}
+		}
+
+		/* clear memory to avoid leaks. */
+		free(names);
+
+		/* unlock registry, logins may write their status again. */
+		pppd__registry_unlock(lock);
+	}
+
+	/* check if we should reconcile periodically. */
+	if (pppd_pgsql_reconcile_interval > 0) {
+
+		/* schedule next reconciliation. */
+		timeout(pppd__pgsql_reconcile, NULL, pppd__accounting_interval(pppd_pgsql_reconcile_interval, 0), 0);
+	}
+}
+
+/* this function register the session on this host, so reconciliation does not reset its login status. */
+int32_t pppd__pgsql_register(uint8_t *name, int32_t *registry) {
+
+	/* nothing is registered so far. */
+	*registry = PPPD_SQL_ERROR_REGISTRY;
+
+	/* check if ownership of the login status is recorded. */
+	if (pppd_pgsql_server_id == NULL) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* check if session was successfully registered, the lock is held until the login status is written. */
+	if ((*registry = pppd__registry_add(pppd_pgsql_registry, name)) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_REGISTRY;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function is the lease renewal timer for the ppp daemon. */
+void pppd__pgsql_renew(void *opaque) {
+
+	/* some common variables. */
+	int32_t result = 0;
+	PGconn *pgsql = NULL;
+	struct pppd_pgsql_target *target = &pppd_pgsql_plan.targets[pppd_pgsql_plan.target];
+
+	/* check if pgsql connect is working, otherwise lease is renewed with next interval. */
+	if (pppd__pgsql_connect(&pgsql, target) == 0) {
+
+		/* renew lease with the same compare-and-set which acquired it. */
+		result = pppd__pgsql_lease(&pgsql, target, username);
+
+		/* disconnect from pgsql. */
+		pppd__pgsql_disconnect(&pgsql);
+
+		/* check if lease expired and was taken over by another session. */
+		if (result == PPPD_SQL_ERROR_LEASE) {
+
+			/* die bitch die. */
+			die(1);
+		}
+	}
+
+	/* schedule next lease renewal. */
+	timeout(pppd__pgsql_renew, NULL, pppd_pgsql_lease_time / 3, 0);
+}
+
+/* this function is the interim accounting timer for the ppp daemon. */
+void pppd__pgsql_interim(void *opaque) {
+
+	/* some common variables. */
+	PGconn *pgsql = NULL;
+	struct pppd_pgsql_target *target = &pppd_pgsql_plan.targets[pppd_pgsql_plan.target];
+	struct pppd_accounting accounting;
+	struct pppd_journal_record record;
+
+	/* check if statistics are available and traffic was seen since last update. (coalesce idle intervals) */
+	if (pppd__accounting_fetch(&accounting, 0) == 0 &&
+	    (accounting.bytes_received != 0 || accounting.bytes_transmitted != 0)) {
+
+		/* build the upsert record for the deltas. */
+		pppd__journal_record(&record, username, JOURNAL_ACCOUNTING, &accounting);
+
+		/* check if we use a write-behind journal, so the flusher batches the upserts of all sessions on one connection. */
+		if (pppd_pgsql_journal != NULL &&
+		    pppd__journal_append(pppd_pgsql_journal, &record) == 0) {
+
+			/* mark counters as written, the journal owns them now. */
+			pppd__accounting_commit(&accounting);
+
+			/* flush journal in background, a running flusher picks the record up. */
+			pppd__journal_spawn(pppd_pgsql_journal, pppd__pgsql_journal);
+
+			/* schedule next interim update. */
+			timeout(pppd__pgsql_interim, NULL, pppd__accounting_interval(pppd_pgsql_interim_interval, 0), 0);
+
+			/* database is updated asynchronously. */
+			return;
+		}
+
+		/* check if postgresql connect is working. */
+		if (pppd__pgsql_connect(&pgsql, target) == 0) {
+
+			/* check if update was successful, otherwise deltas are sent with next update. */
+			if (pppd__pgsql_update(&pgsql, target, &record, 1) == 0) {
+
+				/* mark counters as written. */
+				pppd__accounting_commit(&accounting);
+			}
+
+			/* disconnect from postgresql. */
+			pppd__pgsql_disconnect(&pgsql);
+		}
+	}
+
+	/* schedule next interim update. */
+	timeout(pppd__pgsql_interim, NULL, pppd__accounting_interval(pppd_pgsql_interim_interval, 0), 0);
+}
+
+/* this function log the current login if one of its phases exceeded the threshold. */
+int32_t pppd__pgsql_slow(uint8_t *name, int32_t result) {
+
+	/* some common variables. */
+	struct pppd_shard *shard = pppd_pgsql_plan.targets[pppd_pgsql_plan.target].shard;
+	uint64_t *elapsed        = pppd_stats_current.elapsed;
+
+	/* check if no phase exceeded its threshold, a threshold of zero is disabled. */
+	if ((pppd_pgsql_slow_connect == 0 || elapsed[PPPD_STATS_CONNECT] < pppd_pgsql_slow_connect * 1000000ULL) &&
+	    (pppd_pgsql_slow_query   == 0 || elapsed[PPPD_STATS_QUERY]   < pppd_pgsql_slow_query * 1000000ULL) &&
+	    (pppd_pgsql_slow_status  == 0 || elapsed[PPPD_STATS_STATUS]  < pppd_pgsql_slow_status * 1000000ULL)) {
+		return 0;
+	}
+
+	/* log the phases in one line, the backend pid matches pg_stat_activity and the log of the server, the username is the parameter of the query. */
+	warn("Plugin %s: Slow login user=%q result=%d host=%s port=%s database=%s backend=%d retries=%u connect=%ums query=%ums decrypt=%ums verify=%ums status=%ums login=%ums sql=%q\n",
+		PLUGIN_NAME_PGSQL, name, result, shard->host, shard->port, shard->database, pppd_pgsql_slow.backend_pid, pppd_stats_current.retries,
+		(uint32_t)(elapsed[PPPD_STATS_CONNECT] / 1000000), (uint32_t)(elapsed[PPPD_STATS_QUERY] / 1000000), (uint32_t)(elapsed[PPPD_STATS_DECRYPT] / 1000000),
+		(uint32_t)(elapsed[PPPD_STATS_VERIFY] / 1000000), (uint32_t)(elapsed[PPPD_STATS_STATUS] / 1000000), (uint32_t)(elapsed[PPPD_STATS_LOGIN] / 1000000),
+		pppd_pgsql_plan.targets[pppd_pgsql_plan.target].query);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function log the script if it exceeded the threshold. */
+int32_t pppd__pgsql_slow_script(uint8_t *program, int32_t result) {
+
+	/* check if script did not exceed its threshold, a threshold of zero is disabled. */
+	if (pppd_pgsql_slow_script == 0 ||
+	    pppd_stats_current.elapsed[PPPD_STATS_SCRIPT] < pppd_pgsql_slow_script * 1000000ULL) {
+		return 0;
+	}
+
+	/* log the script in one line. */
+	warn("Plugin %s: Slow script user=%q result=%d script=%q elapsed=%ums\n",
+		PLUGIN_NAME_PGSQL, username, result, program, (uint32_t)(pppd_stats_current.elapsed[PPPD_STATS_SCRIPT] / 1000000));
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function warn if the password query does not look up the user by an index. */
+int32_t pppd__pgsql_explain(PGconn **pgsql, struct pppd_pgsql_target *target) {
+
+	/* some common variables. */
+	uint8_t query[SIZE_QUERY + 8];
+	const char *values[1] = { "" };
+	uint32_t count   = 0;
+	uint8_t *row     = NULL;
+	PGresult *result = NULL;
+
+	/* check if sequential scans were disabled for this transaction, so a small table does not hide a missing index. */
+	if (pppd__pgsql_transaction(*pgsql, (uint8_t *)"SET LOCAL enable_seqscan = off") < 0) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* the precompiled query with an empty username, the plan does not depend on it. */
+	snprintf((char *)query, sizeof(query), "EXPLAIN %s", target->query);
+
+	/* check if query was successfully executed and returned the plan. */
+	if ((result = PQexecParams(*pgsql, (char *)query, 1, NULL, values, NULL, NULL, 0)) == NULL ||
+	    PQresultStatus(result) != PGRES_TUPLES_OK) {
+
+		/* something on executing query failed. */
+		pppd__pgsql_error((uint8_t *)PQerrorMessage(*pgsql));
+
+		/* clear memory to avoid leaks. */
+		PQclear(result);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all lines of the plan, the condition may join more tables. */
+	for (count = 0; count < PQntuples(result); count++) {
+
+		/* fetch the plan line. */
+		row = (uint8_t *)PQgetvalue(result, count, 0);
+
+		/* check if a table is read completely, it is still chosen if no index is usable. */
+		if (strstr((char *)row, "Seq Scan") != NULL) {
+
+			/* every login reads or locks the whole table. */
+			warn("Plugin %s: The password query scans a table (%s), add a unique index on %s\n", PLUGIN_NAME_PGSQL, row + strspn((char *)row, " ->"), target->column_user);
+		}
+
+		/* check if index does not cover all columns, then every lookup reads the heap too. */
+		if (strstr((char *)row, "Index Scan") != NULL) {
+
+			/* lookup works, only show information. */
+			info("Plugin %s: The password query uses an index without covering it (%s)\n", PLUGIN_NAME_PGSQL, row + strspn((char *)row, " ->"));
+		}
+	}
+
+	/* clear memory to avoid leaks. */
+	PQclear(result);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function is the phase change notifier for the ppp daemon. */
+void pppd__pgsql_phase(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	uint32_t target = 0;
+	PGconn *pgsql = NULL;
+
+	/* check if startup tasks were already executed, options are complete at first phase change. */
+	if (startup == 1) {
+		return;
+	}
+
+	/* indicate that startup tasks are executed. */
+	startup = 1;
+
+	/* check if options are valid, the plan is built once here. */
+	if (pppd__pgsql_parameter() < 0) {
+		return;
+	}
+
+	/* loop through all shards and realms if the plan of their password query should be checked. */
+	for (target = 0; pppd_pgsql_check_plan == 1 && target < pppd_pgsql_plan.targets_count; target++) {
+
+		/* check if pgsql connect to this shard or realm is working. */
+		if (pppd__pgsql_connect(&pgsql, &pppd_pgsql_plan.targets[target]) == 0) {
+
+			/* warn about table scans. (ignore return code, the query works without index) */
+			pppd__pgsql_explain(&pgsql, &pppd_pgsql_plan.targets[target]);
+
+			/* disconnect from pgsql, this also ends the transaction with the changed setting. */
+			pppd__pgsql_disconnect(&pgsql);
+		}
+	}
+
+	/* check if login latencies and counters should be recorded. */
+	if (pppd_pgsql_stats != NULL &&
+	    pppd__stats_open(pppd_pgsql_stats, 1, &pppd_stats_file) < 0) {
+
+		/* logins work without stats, they are only not recorded. */
+		error("Plugin %s: Stats file %s is not usable\n", PLUGIN_NAME_PGSQL, pppd_pgsql_stats);
+	}
+
+	/* time the phases of each login if one of them should be logged when slow. */
+	pppd_stats_current.timed = (pppd_pgsql_slow_connect > 0 ||
+				    pppd_pgsql_slow_query   > 0 ||
+				    pppd_pgsql_slow_status  > 0 ||
+				    pppd_pgsql_slow_script  > 0);
+
+	/* check if we use a write-behind journal. */
+	if (pppd_pgsql_journal != NULL) {
+
+		/* replay records left by a crashed or disconnected ppp daemon. */
+		pppd__journal_spawn(pppd_pgsql_journal, pppd__pgsql_journal);
+	}
+
+	/* check if ownership of the login status is recorded. */
+	if (pppd_pgsql_server_id != NULL) {
+
+		/* reset login status left by crashed ppp daemons and schedule periodic reconciliation. */
+		pppd__pgsql_reconcile(NULL);
+	}
+}
+
+/* this function is the ip up notifier for the ppp daemon. */
+void pppd__pgsql_up(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	PGconn *pgsql = NULL;
+	int32_t result = 0;
+	struct pppd_pgsql_target *target = &pppd_pgsql_plan.targets[pppd_pgsql_plan.target];
+
+	/* start accounting of the new session. */
+	pppd__accounting_start();
+
+	/* check if we should write interim accounting updates. */
+	if (pppd_pgsql_interim_interval > 0) {
+
+		/* schedule first interim update at a random point of the interval. */
+		timeout(pppd__pgsql_interim, NULL, pppd__accounting_interval(pppd_pgsql_interim_interval, 1), 0);
+	}
+
+	/* check if online state is kept as lease. */
+	if (pppd_pgsql_session_table != NULL) {
+
+		/* schedule lease renewal, so it is renewed several times before it expires. */
+		timeout(pppd__pgsql_renew, NULL, pppd_pgsql_lease_time / 3, 0);
+	}
+
+	/* check if traffic should be shaped, this is done before the script, so it may change it. */
+	if (pppd_pgsql_column_rate_down != NULL ||
+	    pppd_pgsql_column_rate_up   != NULL) {
+
+		/* install shaping. (ignore return code, the session works without limit) */
+		pppd__shape(pppd_pgsql_column_rate_down, pppd_pgsql_column_rate_up, 1);
+	}
+
+	/* check if client address should be added to firewall sets. */
+	if (pppd_pgsql_column_nft_set != NULL) {
+
+		/* add address. (ignore return code, the session works without firewall membership) */
+		pppd__firewall(pppd_pgsql_nft_table, pppd_pgsql_column_nft_set, 1);
+	}
+
+	/* check if framed routes are given. */
+	if (pppd_pgsql_column_framed_routes != NULL) {
+
+		/* add routes. (ignore return code, the session works without the routed networks) */
+		pppd__netlink_route((uint8_t *)ifname, &framed_routes, 1);
+	}
+
+	/* check if we should execute a script. */
+	if (pppd_pgsql_ip_up != NULL) {
+
+		/* execute script. */
+		result = pppd__ip_up(username, pppd_pgsql_ip_up);
+
+		/* log the script if it was slow. */
+		pppd__pgsql_slow_script(pppd_pgsql_ip_up, result);
+
+		/* check if script failed. */
+		if (result != 0) {
+
+			/* check if we should fail. */
+			if (pppd_pgsql_ip_up_fail == 1) {
+
+				/* show the error. */
+				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_PGSQL, pppd_pgsql_ip_up);
+
+				/* check if status should be updated or address released. */
+				if ((pppd_pgsql_exclusive     == 1 &&
+				     pppd_pgsql_authoritative == 1 &&
+				     (pppd_pgsql_column_update  != NULL ||
+				      pppd_pgsql_session_table != NULL)) ||
+				    pppd_pgsql_pool_table != NULL) {
+
+					/* check if postgresql connect is working. */
+					if (pppd__pgsql_connect(&pgsql, target) == 0) {
+
+						/* update database. (ignore return code, because what should I do, stop the disconnect?) */
+						pppd__pgsql_status(&pgsql, target, username, 0);
+
+						/* disconnect from pgsql. */
+						pppd__pgsql_disconnect(&pgsql);
+					}
+				}
+
+				/* die bitch die. */
+				die(1);
+			}
+		}
+	}
+}
+
+/* this function is the ip down notifier for the ppp daemon. */
+void pppd__pgsql_down(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	PGconn *pgsql = NULL;
+	int32_t result = 0;
+	struct pppd_pgsql_target *target = &pppd_pgsql_plan.targets[pppd_pgsql_plan.target];
+	struct pppd_accounting accounting;
+	struct pppd_journal_record record;
+
+	/* stop interim accounting updates, the final one is written below. */
+	untimeout(pppd__pgsql_interim, NULL);
+
+	/* stop lease renewal, the lease is released below. */
+	untimeout(pppd__pgsql_renew, NULL);
+
+	/* check if address was allocated from the host-local pool. */
+	if (pppd_pgsql_pool_file != NULL) {
+
+		/* release address. */
+		pppd__pool_release(pppd_pgsql_pool_file, pppd_pgsql_pool_range, client_ip);
+	}
+
+	/* check if session is registered, the login status is reset below. */
+	if (pppd_pgsql_server_id != NULL) {
+
+		/* remove session from registry. */
+		pppd__registry_remove(pppd_pgsql_registry);
+	}
+
+	/* check if traffic was shaped. */
+	if (pppd_pgsql_column_rate_down != NULL ||
+	    pppd_pgsql_column_rate_up   != NULL) {
+
+		/* remove shaping. (ignore return code, the kernel removes it with the interface) */
+		pppd__shape(pppd_pgsql_column_rate_down, pppd_pgsql_column_rate_up, 0);
+	}
+
+	/* check if client address was added to firewall sets. */
+	if (pppd_pgsql_column_nft_set != NULL) {
+
+		/* remove address. (ignore return code, because what should I do, stop the disconnect?) */
+		pppd__firewall(pppd_pgsql_nft_table, pppd_pgsql_column_nft_set, 0);
+	}
+
+	/* check if framed routes are given. */
+	if (pppd_pgsql_column_framed_routes != NULL) {
+
+		/* remove routes. (ignore return code, because what should I do, stop the disconnect?) */
+		pppd__netlink_route((uint8_t *)ifname, &framed_routes, 0);
+	}
+
+	/* check if we should execute a script. */
+	if (pppd_pgsql_ip_down != NULL) {
+
+		/* execute script. */
+		result = pppd__ip_down(username, pppd_pgsql_ip_down);
+
+		/* log the script if it was slow. */
+		pppd__pgsql_slow_script(pppd_pgsql_ip_down, result);
+
+		/* check if script failed. */
+		if (result != 0) {
+
+			/* check if we should fail. */
 			if (pppd_pgsql_ip_down_fail == 1) {
 
 				/* show the error. */
@@ -522,16 +1961,81 @@ void pppd__pgsql_down(void *opaque, int32_t arg) {
 		}
 	}
 
-	/* check if status should be updated. */
-	if (pppd_pgsql_exclusive     == 1 &&
-	    pppd_pgsql_authoritative == 1 &&
-	    pppd_pgsql_column_update != NULL) {
+	/* check if status should be updated, session accounting written or address released. */
+	if ((pppd_pgsql_exclusive     == 1 &&
+	     pppd_pgsql_authoritative == 1 &&
+	     (pppd_pgsql_column_update  != NULL ||
+	      pppd_pgsql_session_table != NULL)) ||
+	    pppd_pgsql_accounting_table != NULL ||
+	    pppd_pgsql_pool_table != NULL) {
+
+		/* check if we use a write-behind journal. */
+		if (pppd_pgsql_journal != NULL) {
+
+			/* fetch the counters which are not yet written by interim updates. */
+			pppd__accounting_fetch(&accounting, 1);
+
+			/* build the logout record, the status column is only reset if this server owns it exclusively. */
+			pppd__journal_record(&record, username, JOURNAL_ACCOUNTING | JOURNAL_RELEASE | (pppd_pgsql_exclusive == 1 && pppd_pgsql_authoritative == 1 ? JOURNAL_STATUS : 0), &accounting);
+
+			/* check if record was stored in journal, otherwise fallback to synchronous update. */
+			if (pppd__journal_append(pppd_pgsql_journal, &record) == 0) {
+
+				/* the address is released by the journal, which keeps its own copy of the session identifier. */
+				allocated = 0;
+				pppd__session_end();
+
+				/* flush journal in background, so link teardown never blocks on database. */
+				pppd__journal_spawn(pppd_pgsql_journal, pppd__pgsql_journal);
+
+				/* database is updated asynchronously. */
+				return;
+			}
+		}
+
+		/* check if postgresql connect is working. */
+		if (pppd__pgsql_connect(&pgsql, target) == 0) {
+
+			/* update database, if it failed the address is released at exit. (ignore return code, because what should I do, stop the disconnect?) */
+			if (pppd__pgsql_status(&pgsql, target, username, 0) == 0) {
+				allocated = 0;
+			}
+
+			/* disconnect from postgresql. */
+			pppd__pgsql_disconnect(&pgsql);
+		}
+	}
+
+	/* check if the session is finished in database, otherwise the exit notifier needs its identifier to release the address. */
+	if (allocated == 0) {
+
+		/* forget session identifier, the accounting row of the next session must not be added to this one. */
+		pppd__session_end();
+	}
+}
+
+/* this function is the exit notifier for the ppp daemon. */
+void pppd__pgsql_exit(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	PGconn *pgsql = NULL;
+	struct pppd_pgsql_target *target = &pppd_pgsql_plan.targets[pppd_pgsql_plan.target];
+
+	/* check if address was allocated from the host-local pool. */
+	if (pppd_pgsql_pool_file != NULL) {
+
+		/* release address, if IPCP never came up it was not released at ip down. */
+		pppd__pool_release(pppd_pgsql_pool_file, pppd_pgsql_pool_range, client_ip);
+	}
+
+	/* check if address is still allocated from the pool table, because IPCP never came up or ip down failed to release it. */
+	if (allocated == 1) {
 
 		/* check if postgresql connect is working. */
-		if (pppd__pgsql_connect(&pgsql) == 0) {
+		if (pppd__pgsql_connect(&pgsql, target) == 0) {
 
-			/* update database. (ignore return code, because what should I do, stop the disconnect?) */
-			pppd__pgsql_status(&pgsql, username, 0);
+			/* release address, login status and lease. (ignore return code, the ppp daemon exits anyway) */
+			pppd__pgsql_reset(&pgsql, target, username);
 
 			/* disconnect from postgresql. */
 			pppd__pgsql_disconnect(&pgsql);
@@ -545,25 +2049,58 @@ int32_t pppd__chap_verify_pgsql(char *name, char *ourname, int id, struct chap_d
 	/* some common variables. */
 	uint8_t secret_name[MAXSECRETLEN];
 	int32_t secret_length = 0;
+	int32_t registry      = PPPD_SQL_ERROR_REGISTRY;
+	int32_t result        = 0;
 	PGconn *pgsql         = NULL;
+	struct pppd_pgsql_target *target = NULL;
+	struct timespec login_start;
+	struct timespec phase_start;
 
-	/* check if parameters are complete. */
-	if (pppd__pgsql_parameter() == 0) {
+	/* start the timer of the whole login. */
+	pppd__stats_start(PPPD_STATS_LOGIN, (uint8_t *)name, &login_start);
 
-		/* check if postgresql connect is working. */
-		if (pppd__pgsql_connect(&pgsql) == 0) {
+	/* check if parameters are complete and session is registered. */
+	if ((result = pppd__pgsql_parameter()) == 0 &&
+	    (result = pppd__pgsql_route(pppd__pgsql_select((uint8_t *)name))) == 0 &&
+	    (result = pppd__pgsql_register((uint8_t *)name, &registry)) == 0) {
+
+		/* all queries of the login go to the shard or realm of the user. */
+		target = &pppd_pgsql_plan.targets[pppd_pgsql_plan.target];
+
+		/* check if postgresql connect is working, failed connects are timed too. */
+		pppd__stats_start(PPPD_STATS_CONNECT, (uint8_t *)name, &phase_start);
+		result = pppd__pgsql_connect(&pgsql, target);
+		pppd__stats_stop(PPPD_STATS_CONNECT, (uint8_t *)name, result, &phase_start);
+		if (result == 0) {
 
 			/* check if postgresql fetching was successful. */
-			if (pppd__pgsql_password(&pgsql, (uint8_t *)name, secret_name, &secret_length) == 0) {
+			pppd__stats_start(PPPD_STATS_QUERY, (uint8_t *)name, &phase_start);
+			result = pppd__pgsql_password(&pgsql, target, (uint8_t *)name, secret_name, &secret_length);
+			pppd__stats_stop(PPPD_STATS_QUERY, (uint8_t *)name, result, &phase_start);
+			if (result == 0) {
 
 				/* check if password decryption was correct. */
-				if (pppd__decrypt_password(secret_name, &secret_length, pppd_pgsql_pass_encryption, pppd_pgsql_pass_key) == 0) {
+				pppd__stats_start(PPPD_STATS_DECRYPT, (uint8_t *)name, &phase_start);
+				result = pppd__decrypt_password(secret_name, &secret_length, pppd_pgsql_plan.encryption, pppd_pgsql_pass_key);
+				pppd__stats_stop(PPPD_STATS_DECRYPT, (uint8_t *)name, result, &phase_start);
+				if (result == 0) {
 
 					/* verify discovered secret against the client's response. */
-					if (digest->verify_response(id, name, secret_name, secret_length, challenge, response, message, message_space) == 1) {
-
-						/* check if database update was successful. */
-						if (pppd__pgsql_status(&pgsql, (uint8_t *)name, 1) == 0) {
+					pppd__stats_start(PPPD_STATS_VERIFY, (uint8_t *)name, &phase_start);
+					result = digest->verify_response(id, name, secret_name, secret_length, challenge, response, message, message_space) == 1 ? 0 : PPPD_SQL_ERROR_PASSWORD;
+					pppd__stats_stop(PPPD_STATS_VERIFY, (uint8_t *)name, result, &phase_start);
+					if (result == 0) {
+
+						/* check if database update and address allocation were successful. */
+						pppd__stats_start(PPPD_STATS_STATUS, (uint8_t *)name, &phase_start);
+						if ((result = pppd__pgsql_status(&pgsql, target, (uint8_t *)name, 1)) == 0 &&
+						    (result = pppd__pgsql_allocate(&pgsql)) != 0) {
+
+							/* reset the login status and lease again, the link is not established. (ignore return code, reconciliation or the lease expiry clean up) */
+							pppd__pgsql_reset(&pgsql, target, (uint8_t *)name);
+						}
+						pppd__stats_stop(PPPD_STATS_STATUS, (uint8_t *)name, result, &phase_start);
+						if (result == 0) {
 
 							/* store username for ip down configuration. */
 							strncpy((char *)username, name, MAXNAMELEN);
@@ -571,6 +2108,15 @@ int32_t pppd__chap_verify_pgsql(char *name, char *ourname, int id, struct chap_d
 							/* disconnect from postgresql. */
 							pppd__pgsql_disconnect(&pgsql);
 
+							/* unlock registry, the login status is written. */
+							pppd__registry_unlock(registry);
+
+							/* record the accepted login. */
+							pppd__stats_login((uint8_t *)name, 0, &login_start);
+
+							/* log the login if it was slow. */
+							pppd__pgsql_slow((uint8_t *)name, 0);
+
 							/* clear the memory with the password, so nobody is able to dump it. */
 							memset(secret_name, 0, sizeof(secret_name));
 
@@ -586,6 +2132,20 @@ int32_t pppd__chap_verify_pgsql(char *name, char *ourname, int id, struct chap_d
 		}
 	}
 
+	/* check if session was registered, but login failed. */
+	if (registry >= 0) {
+
+		/* unlock registry and remove session. */
+		pppd__registry_unlock(registry);
+		pppd__registry_remove(pppd_pgsql_registry);
+	}
+
+	/* record the failed login, the fallback to the secrets file is not part of it. */
+	pppd__stats_login((uint8_t *)name, result, &login_start);
+
+	/* log the login if it was slow. */
+	pppd__pgsql_slow((uint8_t *)name, result);
+
 	/* check if postgresql is not authoritative. */
 	if (pppd_pgsql_authoritative == 0) {
 
@@ -620,22 +2180,52 @@ int32_t pppd__pap_auth_pgsql(char *user, char *passwd, char **msgp, struct wordl
 	/* some common variables. */
 	uint8_t secret_name[MAXSECRETLEN];
 	int32_t secret_length = 0;
+	int32_t registry      = PPPD_SQL_ERROR_REGISTRY;
+	int32_t result        = 0;
 	PGconn *pgsql         = NULL;
+	struct pppd_pgsql_target *target = NULL;
+	struct timespec login_start;
+	struct timespec phase_start;
 
-	/* check if parameters are complete. */
-	if (pppd__pgsql_parameter() == 0) {
+	/* start the timer of the whole login. */
+	pppd__stats_start(PPPD_STATS_LOGIN, (uint8_t *)user, &login_start);
 
-		/* check if postgresql connect is working. */
-		if (pppd__pgsql_connect(&pgsql) == 0) {
+	/* check if parameters are complete and session is registered. */
+	if ((result = pppd__pgsql_parameter()) == 0 &&
+	    (result = pppd__pgsql_route(pppd__pgsql_select((uint8_t *)user))) == 0 &&
+	    (result = pppd__pgsql_register((uint8_t *)user, &registry)) == 0) {
+
+		/* all queries of the login go to the shard or realm of the user. */
+		target = &pppd_pgsql_plan.targets[pppd_pgsql_plan.target];
+
+		/* check if postgresql connect is working, failed connects are timed too. */
+		pppd__stats_start(PPPD_STATS_CONNECT, (uint8_t *)user, &phase_start);
+		result = pppd__pgsql_connect(&pgsql, target);
+		pppd__stats_stop(PPPD_STATS_CONNECT, (uint8_t *)user, result, &phase_start);
+		if (result == 0) {
 
 			/* check if postgresql fetching was successful. */
-			if (pppd__pgsql_password(&pgsql, (uint8_t *)user, secret_name, &secret_length) == 0) {
+			pppd__stats_start(PPPD_STATS_QUERY, (uint8_t *)user, &phase_start);
+			result = pppd__pgsql_password(&pgsql, target, (uint8_t *)user, secret_name, &secret_length);
+			pppd__stats_stop(PPPD_STATS_QUERY, (uint8_t *)user, result, &phase_start);
+			if (result == 0) {
 
 				/* check if the password is correct. */
-				if (pppd__verify_password((uint8_t *)passwd, secret_name, pppd_pgsql_pass_encryption, pppd_pgsql_pass_key) == 0) {
-
-					/* check if database update was successful. */
-					if (pppd__pgsql_status(&pgsql, (uint8_t *)user, 1) == 0) {
+				pppd__stats_start(PPPD_STATS_VERIFY, (uint8_t *)user, &phase_start);
+				result = pppd__verify_password((uint8_t *)passwd, secret_name, pppd_pgsql_plan.encryption, pppd_pgsql_pass_key);
+				pppd__stats_stop(PPPD_STATS_VERIFY, (uint8_t *)user, result, &phase_start);
+				if (result == 0) {
+
+					/* check if database update and address allocation were successful. */
+					pppd__stats_start(PPPD_STATS_STATUS, (uint8_t *)user, &phase_start);
+					if ((result = pppd__pgsql_status(&pgsql, target, (uint8_t *)user, 1)) == 0 &&
+					    (result = pppd__pgsql_allocate(&pgsql)) != 0) {
+
+						/* reset the login status and lease again, the link is not established. (ignore return code, reconciliation or the lease expiry clean up) */
+						pppd__pgsql_reset(&pgsql, target, (uint8_t *)user);
+					}
+					pppd__stats_stop(PPPD_STATS_STATUS, (uint8_t *)user, result, &phase_start);
+					if (result == 0) {
 
 						/* store username for ip down configuration. */
 						strncpy((char *)username, user, MAXNAMELEN);
@@ -643,6 +2233,15 @@ int32_t pppd__pap_auth_pgsql(char *user, char *passwd, char **msgp, struct wordl
 						/* disconnect from postgresql. */
 						pppd__pgsql_disconnect(&pgsql);
 
+						/* unlock registry, the login status is written. */
+						pppd__registry_unlock(registry);
+
+						/* record the accepted login. */
+						pppd__stats_login((uint8_t *)user, 0, &login_start);
+
+						/* log the login if it was slow. */
+						pppd__pgsql_slow((uint8_t *)user, 0);
+
 						/* clear the memory with the password, so nobody is able to dump it. */
 						memset(secret_name, 0, sizeof(secret_name));
 
@@ -657,6 +2256,20 @@ int32_t pppd__pap_auth_pgsql(char *user, char *passwd, char **msgp, struct wordl
 		}
 	}
 
+	/* check if session was registered, but login failed. */
+	if (registry >= 0) {
+
+		/* unlock registry and remove session. */
+		pppd__registry_unlock(registry);
+		pppd__registry_remove(pppd_pgsql_registry);
+	}
+
+	/* record the failed login, the fallback to the secrets file is not part of it. */
+	pppd__stats_login((uint8_t *)user, result, &login_start);
+
+	/* log the login if it was slow. */
+	pppd__pgsql_slow((uint8_t *)user, result);
+
 	/* check if postgresql is not authoritative. */
 	if (pppd_pgsql_authoritative == 0) {
 
@@ -22,25 +22,90 @@
 #ifndef _AUTH_PGSQL_H
 #define _AUTH_PGSQL_H
 
+/* define the type oids and constants of the binary result format. */
+#define PGSQL_OID_BYTEA			17		/* the oid of bytea. */
+#define PGSQL_OID_INT8			20		/* the oid of bigint. */
+#define PGSQL_OID_INT4			23		/* the oid of integer. */
+#define PGSQL_OID_CIDR			650		/* the oid of cidr. */
+#define PGSQL_OID_INET			869		/* the oid of inet. */
+#define PGSQL_AF_INET			2		/* the address family of an IPv4 inet in binary format. */
+
+/* one target of the logins, a shard or a realm, with its own options and password query. */
+struct pppd_pgsql_target {
+	struct pppd_shard	*shard;		/* the database host, port, database and table. */
+	uint8_t		*user;			/* the database user. */
+	uint8_t		*pass;			/* the database password. */
+	uint8_t		*column_user;		/* the username column. */
+	uint8_t		*column_pass;		/* the password column. */
+	uint8_t		*column_client_ip;	/* the client ip address column. */
+	uint8_t		*column_server_ip;	/* the server ip address column. */
+	uint8_t		*condition;		/* the additional condition of the password query. */
+	uint32_t	query_length;		/* the length of the password query. */
+	uint8_t		query[SIZE_QUERY];	/* the password query, the username is bound as parameter. */
+};
+
+/* validated options and precompiled queries, built once after options are complete. */
+struct pppd_pgsql_plan {
+	uint32_t	built;			/* one if the plan was built. */
+	int32_t		result;			/* the result of the validation, returned for every login. */
+	uint32_t	encryption;		/* the password encryption algorithm. */
+	uint32_t	shards_count;		/* the number of shards. */
+	uint32_t	targets_count;		/* the number of shards and realms. */
+	uint32_t	target;			/* the shard or realm of the current user, all connections go there. */
+	struct pppd_shard	shards[SIZE_SHARDS];	/* the shards, one built from the host options if none are given. */
+	struct pppd_realms	realms;		/* the realms of the realm file. */
+	struct pppd_pgsql_target	targets[SIZE_TARGETS];	/* the shards followed by the realms. */
+	uint8_t		connect_timeout[16];	/* the connect timeout as connection value. */
+	const char	*keywords[7];		/* the connection keywords. */
+	const char	*values[7];		/* the connection values. */
+};
+
+/* validated options and precompiled queries. */
+extern struct pppd_pgsql_plan pppd_pgsql_plan;
+
+/* the server side of the current login, kept for the slow log. */
+struct pppd_pgsql_slow {
+	int32_t		backend_pid;		/* the process id of the server backend, like in pg_stat_activity and the server log. */
+};
+
+/* the server side of the current login. */
+extern struct pppd_pgsql_slow pppd_pgsql_slow;
+
 /* this function handles the PQerrorMessage() result. */
 int32_t pppd__pgsql_error(
 	uint8_t		*error_message
 );
 
+/* this function validate the parameter and build the plan. */
+int32_t pppd__pgsql_plan(
+	void
+);
+
 /* this function check the parameter. */
 int32_t pppd__pgsql_parameter(
 	void
 );
 
+/* this function return the target of the given user. */
+uint32_t pppd__pgsql_select(
+	uint8_t		*name
+);
+
+/* this function route the session of this ppp daemon to the given target. */
+int32_t pppd__pgsql_route(
+	uint32_t	target
+);
+
 /* this function begin or end a transaction. */
 int32_t pppd__pgsql_transaction(
 	PGconn		*pgsql,
 	uint8_t		*transaction
 );
 
-/* this function connect to a postgresql database. */
+/* this function connect to the database of the given target. */
 int32_t pppd__pgsql_connect(
-	PGconn		**pgsql
+	PGconn		**pgsql,
+	struct pppd_pgsql_target	*target
 );
 
 /* this function disconnect from a postgresql database. */
@@ -48,21 +113,143 @@ int32_t pppd__pgsql_disconnect(
 	PGconn		**pgsql
 );
 
+/* this function convert a binary ip address column into an address in network byte order. */
+int32_t pppd__pgsql_address(
+	PGresult	*result,
+	uint32_t	column,
+	uint32_t	*address
+);
+
 /* this function return the password from database. */
 int32_t pppd__pgsql_password(
 	PGconn		**pgsql,
+	struct pppd_pgsql_target	*target,
 	uint8_t		*name,
 	uint8_t		*secret_name,
 	int32_t		*secret_length
 );
 
+/* this function append the given value quoted and escaped to the query. */
+int32_t pppd__pgsql_quote(
+	PGconn		**pgsql,
+	uint8_t		*query,
+	uint32_t	size,
+	uint32_t	*length,
+	uint8_t		*value
+);
+
+/* this function execute the given write statements in one round trip. */
+int32_t pppd__pgsql_execute(
+	PGconn		**pgsql,
+	uint8_t		*query,
+	uint32_t	*rows
+);
+
+/* this function build the accounting statement for the given records. */
+int32_t pppd__pgsql_accounting(
+	PGconn		**pgsql,
+	struct pppd_pgsql_target	*target,
+	uint8_t		*query,
+	uint32_t	size,
+	uint32_t	*length,
+	struct pppd_journal_record	*records,
+	uint32_t	count
+);
+
+/* this function write the given records with multi-row statements in one round trip. */
+int32_t pppd__pgsql_update(
+	PGconn		**pgsql,
+	struct pppd_pgsql_target	*target,
+	struct pppd_journal_record	*records,
+	uint32_t	count
+);
+
+/* this function allocate the client ip address from the pool, if the account has none. */
+int32_t pppd__pgsql_allocate(
+	PGconn		**pgsql
+);
+
+/* this function acquire or renew the lease of the current session. */
+int32_t pppd__pgsql_lease(
+	PGconn		**pgsql,
+	struct pppd_pgsql_target	*target,
+	uint8_t		*name
+);
+
 /* this function update the login status in database. */
 int32_t pppd__pgsql_status(
 	PGconn		**pgsql,
+	struct pppd_pgsql_target	*target,
 	uint8_t		*name,
 	uint32_t	status
 );
 
+/* this function reset the login status, lease and pool address of a session which never came up. */
+int32_t pppd__pgsql_reset(
+	PGconn		**pgsql,
+	struct pppd_pgsql_target	*target,
+	uint8_t		*name
+);
+
+/* this function write the given journal records to database. */
+int32_t pppd__pgsql_journal(
+	struct pppd_journal_record	*records,
+	uint32_t	count
+);
+
+/* this function reset the login status of all sessions owned by this server which are not running. */
+int32_t pppd__pgsql_stale(
+	PGconn		**pgsql,
+	struct pppd_pgsql_target	*target,
+	uint8_t		*names,
+	uint32_t	count
+);
+
+/* this function is the stale login status reconciliation timer for the ppp daemon. */
+void pppd__pgsql_reconcile(
+	void		*opaque
+);
+
+/* this function register the session on this host, so reconciliation does not reset its login status. */
+int32_t pppd__pgsql_register(
+	uint8_t		*name,
+	int32_t		*registry
+);
+
+/* this function is the lease renewal timer for the ppp daemon. */
+void pppd__pgsql_renew(
+	void		*opaque
+);
+
+/* this function is the interim accounting timer for the ppp daemon. */
+void pppd__pgsql_interim(
+	void		*opaque
+);
+
+/* this function log the current login if one of its phases exceeded the threshold. */
+int32_t pppd__pgsql_slow(
+	uint8_t		*name,
+	int32_t		result
+);
+
+/* this function log the script if it exceeded the threshold. */
+int32_t pppd__pgsql_slow_script(
+	uint8_t		*program,
+	int32_t		result
+);
+
+/* this function warn if the password query does not look up the user by an index. */
+int32_t pppd__pgsql_explain(
+	PGconn		**pgsql,
+	struct pppd_pgsql_target	*target
+);
+
+/* this function is the phase change notifier for the ppp daemon. */
+void pppd__pgsql_phase(
+	void		*opaque,
+	int32_t		arg
+);
+
 /* this function is the ip up notifier for the ppp daemon. */
 void pppd__pgsql_up(
 	void		*opaque,
@@ -75,6 +262,12 @@ void pppd__pgsql_down(
 	int32_t		arg
 );
 
+/* this function is the exit notifier for the ppp daemon. */
+void pppd__pgsql_exit(
+	void		*opaque,
+	int32_t		arg
+);
+
 /* this function check the chap authentication information against a postgresql database. */
 int32_t pppd__chap_verify_pgsql(
 	char		*name,
@@ -0,0 +1,977 @@
+/*
+ *  auth-sqlite.c -- Challenge Handshake Authentication Protocol and Password
+ *                   Authentication Protocol for the Point-to-Point Protocol
+ *                   (PPP) via SQLite.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic plugin includes. */
+#include "plugin.h"
+#include "netlink.h"
+#include "plugin-sqlite.h"
+#include "radix.h"
+#include "stats.h"
+#include "str.h"
+
+/* auth plugin includes. */
+#include "auth-sqlite.h"
+
+/* store username in global variable, because ip down did not know it. */
+uint8_t username[MAXNAMELEN];
+
+/* indicate if the startup tasks were already executed. */
+uint32_t startup = 0;
+
+/* validated options, precompiled queries and the database, kept for the process lifetime. */
+struct pppd_sqlite_plan pppd_sqlite_plan;
+
+/* this function handles the sqlite3_errmsg() result. */
+int32_t pppd__sqlite_error(sqlite3 *sqlite) {
+
+	/* show error header. */
+	error("Plugin %s: Fatal Error Message (SQLite):\n", PLUGIN_NAME_SQLITE);
+
+	/* show the detailed error. */
+	error("Plugin %s: * %d: %s\n", PLUGIN_NAME_SQLITE, sqlite3_extended_errcode(sqlite), sqlite3_errmsg(sqlite));
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function validate the parameter and build the plan. */
+int32_t pppd__sqlite_plan(void) {
+
+	/* some common variables. */
+	int32_t encryption = 0;
+	int32_t length     = 0;
+
+	/* check if all information are supplied. */
+	if (pppd_sqlite_database		== NULL ||
+	    pppd_sqlite_pass_encryption	== NULL ||
+	    pppd_sqlite_table		== NULL ||
+	    pppd_sqlite_column_user	== NULL ||
+	    pppd_sqlite_column_pass	== NULL ||
+	    pppd_sqlite_column_client_ip	== NULL ||
+	    pppd_sqlite_column_server_ip	== NULL) {
+
+		/* something failed on sqlite initialization. */
+		error("Plugin %s: SQLite information are not complete\n", PLUGIN_NAME_SQLITE);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_INCOMPLETE;
+	}
+
+	/* check if encryption algorithm is supported. */
+	if ((encryption = pppd__encryption(pppd_sqlite_pass_encryption)) < 0) {
+
+		/* unknown algorithm, otherwise every password would be accepted. */
+		error("Plugin: %s: SQLite encryption %s is not supported\n", PLUGIN_NAME_SQLITE, pppd_sqlite_pass_encryption);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_OPTION;
+	}
+
+	/* check if passwords are encrypted. */
+	if (encryption == PPPD_SQL_ENCRYPTION_CRYPT ||
+	    encryption == PPPD_SQL_ENCRYPTION_AES) {
+
+		/* check if key or salt is given. */
+		if (pppd_sqlite_pass_key == NULL) {
+
+			/* some required encryption information are missing. */
+			error("Plugin: %s: SQLite encryption information are not complete\n", PLUGIN_NAME_SQLITE);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if concurrent connection from one user should be denied. */
+	if (pppd_sqlite_exclusive == 1) {
+
+		/* check if update column is given. */
+		if (pppd_sqlite_column_update  == NULL ||
+		    pppd_sqlite_authoritative == 0) {
+
+			/* some required exclusive information are missing. */
+			error("Plugin: %s: SQLite exclusive information are not complete\n", PLUGIN_NAME_SQLITE);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_INCOMPLETE;
+		}
+	}
+
+	/* check if session attributes are used by shaping, firewall sets or framed routes. */
+	if ((pppd_sqlite_column_rate_down      != NULL ||
+	     pppd_sqlite_column_rate_up        != NULL ||
+	     pppd_sqlite_column_nft_set        != NULL ||
+	     pppd_sqlite_column_framed_routes  != NULL) &&
+	    pppd_sqlite_column_attributes == NULL) {
+
+		/* some required attribute information are missing. */
+		error("Plugin: %s: SQLite attribute information are not complete\n", PLUGIN_NAME_SQLITE);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_INCOMPLETE;
+	}
+
+	/* check if firewall sets are given without table. */
+	if (pppd_sqlite_column_nft_set != NULL &&
+	    pppd_sqlite_nft_table      == NULL) {
+
+		/* some required firewall information are missing. */
+		error("Plugin: %s: SQLite firewall information are not complete\n", PLUGIN_NAME_SQLITE);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_INCOMPLETE;
+	}
+
+	/* store the parsed options, so no login parses them again. */
+	pppd_sqlite_plan.encryption = encryption;
+
+	/* build the password query, the username is bound to the placeholder. */
+	length = snprintf((char *)pppd_sqlite_plan.query_password, SIZE_QUERY, "SELECT %s, %s, %s%s%s FROM %s WHERE %s=?1%s%s",
+		pppd_sqlite_column_pass, pppd_sqlite_column_client_ip, pppd_sqlite_column_server_ip,
+		pppd_sqlite_column_attributes != NULL ? ", " : "", pppd_sqlite_column_attributes != NULL ? (char *)pppd_sqlite_column_attributes : "",
+		pppd_sqlite_table, pppd_sqlite_column_user,
+		pppd_sqlite_condition != NULL ? " AND " : "", pppd_sqlite_condition != NULL ? (char *)pppd_sqlite_condition : "");
+
+	/* check if query was truncated, this is refused instead of running a different condition. */
+	if (length >= SIZE_QUERY) {
+
+		/* query is too long. */
+		error("Plugin: %s: SQLite password query is longer than %d bytes\n", PLUGIN_NAME_SQLITE, SIZE_QUERY - 1);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_INCOMPLETE;
+	}
+
+	/* check if login status is stored. */
+	if (pppd_sqlite_column_update != NULL) {
+
+		/* build the login status update, status and username are bound to the placeholders. */
+		snprintf((char *)pppd_sqlite_plan.query_status, SIZE_QUERY, "UPDATE %s SET %s=?1 WHERE %s=?2", pppd_sqlite_table, pppd_sqlite_column_update, pppd_sqlite_column_user);
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function check the parameter, the plan is built at the first call and reused by every login. */
+int32_t pppd__sqlite_parameter(void) {
+
+	/* check if plan was not built, options do not change after they are complete. */
+	if (pppd_sqlite_plan.built == 0) {
+
+		/* validate options and build plan. */
+		pppd_sqlite_plan.result = pppd__sqlite_plan();
+		pppd_sqlite_plan.built  = 1;
+	}
+
+	/* return the result of the validation. */
+	return pppd_sqlite_plan.result;
+}
+
+/* this function open the database once and begin a transaction. */
+int32_t pppd__sqlite_connect(sqlite3 **sqlite) {
+
+	/* some common variables. */
+	uint8_t pragma[128];
+
+	/* check if database is not open yet, it is kept open for the process lifetime. */
+	if (pppd_sqlite_plan.sqlite == NULL) {
+
+		/* check if database was successfully opened, it is only opened for writing if the login status is stored. */
+		if (sqlite3_open_v2((char *)pppd_sqlite_database, &pppd_sqlite_plan.sqlite, (pppd_sqlite_column_update != NULL ? SQLITE_OPEN_READWRITE : SQLITE_OPEN_READONLY) | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK) {
+
+			/* something on opening database failed. */
+			pppd__sqlite_error(pppd_sqlite_plan.sqlite);
+
+			/* close the database. */
+			sqlite3_close(pppd_sqlite_plan.sqlite);
+			pppd_sqlite_plan.sqlite = NULL;
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_CONNECT;
+		}
+
+		/* wait for writers of other ppp daemons instead of failing immediately. */
+		sqlite3_busy_timeout(pppd_sqlite_plan.sqlite, pppd_sqlite_busy_timeout);
+
+		/* readers never block the writer with a write-ahead log and pages are read from the mapping. (ignore return code, a read-only replica keeps its journal mode) */
+		slprintf((char *)pragma, sizeof(pragma), "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA mmap_size=%u;", pppd_sqlite_mmap_size);
+		sqlite3_exec(pppd_sqlite_plan.sqlite, (char *)pragma, NULL, NULL, NULL);
+
+		/* check if statements were successfully prepared, they are reused by every login. */
+		if (sqlite3_prepare_v3(pppd_sqlite_plan.sqlite, (char *)pppd_sqlite_plan.query_password, -1, SQLITE_PREPARE_PERSISTENT, &pppd_sqlite_plan.password, NULL) != SQLITE_OK ||
+		    (pppd_sqlite_column_update != NULL &&
+		     sqlite3_prepare_v3(pppd_sqlite_plan.sqlite, (char *)pppd_sqlite_plan.query_status, -1, SQLITE_PREPARE_PERSISTENT, &pppd_sqlite_plan.status, NULL) != SQLITE_OK)) {
+
+			/* something on preparing statements failed. */
+			pppd__sqlite_error(pppd_sqlite_plan.sqlite);
+
+			/* close the database, it is opened again at the next login. */
+			pppd__sqlite_exit(NULL, 0);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_QUERY;
+		}
+	}
+
+	/* use the open database. */
+	*sqlite = pppd_sqlite_plan.sqlite;
+
+	/* check if transaction begin was successful, the write lock is taken at once if the login status is written. */
+	if (pppd__sqlite_transaction(*sqlite, (uint8_t *)(pppd_sqlite_exclusive == 1 ? "BEGIN IMMEDIATE" : "BEGIN")) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_CONNECT;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function commit the transaction, the database stays open. */
+int32_t pppd__sqlite_disconnect(sqlite3 **sqlite) {
+
+	/* finish transaction. (ignore return code, because what should I do, stop the disconnect?) */
+	pppd__sqlite_transaction(*sqlite, (uint8_t *)"END");
+
+	/* forget the database, it is closed by the exit notifier. */
+	*sqlite = NULL;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function execute the given transaction statement. */
+int32_t pppd__sqlite_transaction(sqlite3 *sqlite, uint8_t *transaction) {
+
+	/* some common variables. */
+	uint32_t count = 0;
+
+	/* loop through number of query retries. */
+	for (count = pppd_sqlite_retry_query; count > 0 ; count--) {
+
+		/* check if query was successfully executed. */
+		if (sqlite3_exec(sqlite, (char *)transaction, NULL, NULL, NULL) == SQLITE_OK) {
+
+			/* if no error was found, return zero. */
+			return 0;
+		}
+	}
+
+	/* something on executing query failed. */
+	pppd__sqlite_error(sqlite);
+
+	/* return with error and terminate link. */
+	return PPPD_SQL_ERROR_QUERY;
+}
+
+/* this function execute a prepared statement until it is done or returns a row. */
+int32_t pppd__sqlite_step(sqlite3 *sqlite, sqlite3_stmt *statement) {
+
+	/* some common variables. */
+	uint32_t count = 0;
+	int32_t result = SQLITE_BUSY;
+
+	/* loop through number of query retries, the busy timeout already waited for other writers. */
+	for (count = pppd_sqlite_retry_query; count > 0 ; count--) {
+
+		/* check if statement was not blocked. */
+		if ((result = sqlite3_step(statement)) != SQLITE_BUSY &&
+		    result != SQLITE_LOCKED) {
+			break;
+		}
+
+		/* reset statement, so it can be executed again. */
+		sqlite3_reset(statement);
+	}
+
+	/* check if statement failed. */
+	if (result != SQLITE_ROW &&
+	    result != SQLITE_DONE) {
+
+		/* something on executing query failed. */
+		pppd__sqlite_error(sqlite);
+	}
+
+	/* return the sqlite result. */
+	return result;
+}
+
+/* this function convert an ip address column into an address in network byte order. */
+int32_t pppd__sqlite_address(sqlite3_stmt *statement, uint32_t column, int32_t type, uint32_t *address) {
+
+	/* some common variables. */
+	sqlite3_int64 number = 0;
+	uint8_t *value       = NULL;
+
+	/* check if column is an integer, like INET_ATON() of MySQL. */
+	if (type == SQLITE_INTEGER) {
+
+		/* fetch number without text conversion. */
+		number = sqlite3_column_int64(statement, column);
+
+		/* check if number fits into an address. */
+		if (number < 0 || number > 0xffffffffLL) {
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_QUERY;
+		}
+
+		/* store address in network byte order. */
+		*address = htonl((uint32_t)number);
+
+		/* if no error was found, return zero. */
+		return 0;
+	}
+
+	/* check if column is a blob, like INET6_ATON() of MySQL. */
+	if (type == SQLITE_BLOB) {
+
+		/* fetch the blob before its size, so no conversion invalidates it. */
+		value = (uint8_t *)sqlite3_column_blob(statement, column);
+
+		/* the blob is already in network byte order. */
+		return pppd__address(value, sqlite3_column_bytes(statement, column), PPPD_SQL_ADDRESS_BYTES, address);
+	}
+
+	/* check if column is text. */
+	if (type == SQLITE_TEXT) {
+
+		/* the column is a dotted quad string. */
+		return pppd__address((uint8_t *)sqlite3_column_text(statement, column), 0, PPPD_SQL_ADDRESS_TEXT, address);
+	}
+
+	/* return with error, a NULL or float is never an address. */
+	return PPPD_SQL_ERROR_QUERY;
+}
+
+/* this function return the password from database. */
+int32_t pppd__sqlite_password(sqlite3 **sqlite, uint8_t *name, uint8_t *secret_name, int32_t *secret_length) {
+
+	/* some common variables. */
+	uint32_t count     = 0;
+	uint32_t rate      = 0;
+	int32_t result     = 0;
+	int32_t type       = 0;
+	uint8_t *column    = NULL;
+	sqlite3_stmt *statement = pppd_sqlite_plan.password;
+
+	/* forget attributes of a previous authentication. */
+	pppd__attribute_clear();
+
+	/* bind the username, it cannot change the query. */
+	sqlite3_reset(statement);
+	sqlite3_bind_text(statement, 1, (char *)name, -1, SQLITE_STATIC);
+
+	/* check if we have at least one row. */
+	if ((result = pppd__sqlite_step(*sqlite, statement)) != SQLITE_ROW) {
+
+		/* release statement. */
+		sqlite3_reset(statement);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all columns. */
+	for (count = 0; count < sqlite3_column_count(statement); count++) {
+
+		/* fetch column type first, it is undefined after a conversion. */
+		type = sqlite3_column_type(statement, count);
+
+		/* fetch column value. */
+		column = (uint8_t *)sqlite3_column_text(statement, count);
+
+		/* check if attribute column is NULL, then the attribute is not set. */
+		if (count >= 3 && column == NULL) {
+			continue;
+		}
+
+		/* check if column is NULL. */
+		if ((column == NULL) && (pppd_sqlite_ignore_null == 0)) {
+
+			/* NULL user account found. */
+			error("Plugin %s: The column %s for %s is NULL in database\n", PLUGIN_NAME_SQLITE, sqlite3_column_name(statement, count), name);
+
+			/* release statement. */
+			sqlite3_reset(statement);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_QUERY;
+		}
+
+		/* if we reach this point, check only if column is NULL and transform it. */
+		column = column ? column : (uint8_t *)"NULL";
+
+		/* check if we found password. */
+		if (count == 0) {
+
+			/* cleanup memory. */
+			memset(secret_name, 0, MAXSECRETLEN);
+
+			/* copy password to secret. */
+			strncpy((char *)secret_name, (char *)column, MAXSECRETLEN - 1);
+			*secret_length = strlen((char *)secret_name);
+		}
+
+		/* check if we found client ip. */
+		if (count == 1) {
+
+			/* check if ip address was successfully converted, integer and blob columns need no text conversion. */
+			if (pppd__sqlite_address(statement, count, type, &client_ip) < 0) {
+
+				/* error on converting ip address. */
+				error("Plugin %s: Client IP address of %s is not valid\n", PLUGIN_NAME_SQLITE, name);
+
+				/* release statement. */
+				sqlite3_reset(statement);
+
+				/* return with error and terminate link. */
+				return PPPD_SQL_ERROR_QUERY;
+			}
+		}
+
+		/* check if we found server ip. */
+		if (count == 2) {
+
+			/* check if ip address was successfully converted, integer and blob columns need no text conversion. */
+			if (pppd__sqlite_address(statement, count, type, &server_ip) < 0) {
+
+				/* error on converting ip address. */
+				error("Plugin %s: Server IP address of %s is not valid\n", PLUGIN_NAME_SQLITE, name);
+
+				/* release statement. */
+				sqlite3_reset(statement);
+
+				/* return with error and terminate link. */
+				return PPPD_SQL_ERROR_QUERY;
+			}
+		}
+
+		/* check if we found an attribute. */
+		if (count >= 3) {
+
+			/* store attribute for the scripts, framed routes which do not fit are never used. */
+			if (pppd__attribute_add((uint8_t *)sqlite3_column_name(statement, count), column) < 0 &&
+			    pppd_sqlite_column_framed_routes != NULL &&
+			    strcasecmp((char *)(uint8_t *)sqlite3_column_name(statement, count), (char *)pppd_sqlite_column_framed_routes) == 0) {
+
+				/* release statement. */
+				sqlite3_reset(statement);
+
+				/* return with error and terminate link. */
+				return PPPD_SQL_ERROR_ROUTE;
+			}
+		}
+	}
+
+	/* check if we have multiple user accounts, the values of the first row are already copied. */
+	if (pppd_sqlite_ignore_multiple == 0 &&
+	    pppd__sqlite_step(*sqlite, statement) == SQLITE_ROW) {
+
+		/* multiple user accounts found. */
+		error("Plugin %s: Multiple accounts for %s found in database\n", PLUGIN_NAME_SQLITE, name);
+
+		/* release statement. */
+		sqlite3_reset(statement);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* release statement, so the read transaction does not keep a snapshot. */
+	sqlite3_reset(statement);
+
+	/* check if framed routes are given, they are parsed once, so every address check is a tree walk. */
+	if (pppd_sqlite_column_framed_routes != NULL &&
+	    pppd__radix_parse(&framed_routes, pppd__attribute_get(pppd_sqlite_column_framed_routes)) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_ROUTE;
+	}
+
+	/* check if rates are valid, a malformed rate would silently leave the session unlimited. */
+	if (pppd__rate(pppd_sqlite_column_rate_down, &rate) < 0 ||
+	    pppd__rate(pppd_sqlite_column_rate_up, &rate) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_RATE;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function set the login status of the given user. */
+int32_t pppd__sqlite_status(sqlite3 **sqlite, uint8_t *name, uint32_t status) {
+
+	/* some common variables. */
+	int32_t result = 0;
+	sqlite3_stmt *statement = pppd_sqlite_plan.status;
+
+	/* check if there is no column to store the login status. */
+	if (statement == NULL) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* bind status and username. */
+	sqlite3_reset(statement);
+	sqlite3_bind_int(statement, 1, status);
+	sqlite3_bind_text(statement, 2, (char *)name, -1, SQLITE_STATIC);
+
+	/* execute statement. */
+	result = pppd__sqlite_step(*sqlite, statement);
+
+	/* release statement. */
+	sqlite3_reset(statement);
+
+	/* check if statement was successful. */
+	if (result != SQLITE_DONE) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function warn if the password query does not look up the user by an index. */
+int32_t pppd__sqlite_explain(sqlite3 *sqlite) {
+
+	/* some common variables. */
+	uint8_t query[SIZE_QUERY + 24];
+	uint8_t *row            = NULL;
+	sqlite3_stmt *statement = NULL;
+
+	/* the precompiled query, the plan does not depend on the unbound username. */
+	snprintf((char *)query, sizeof(query), "EXPLAIN QUERY PLAN %s", pppd_sqlite_plan.query_password);
+
+	/* check if plan was successfully prepared. */
+	if (sqlite3_prepare_v2(sqlite, (char *)query, -1, &statement, NULL) != SQLITE_OK) {
+
+		/* something on preparing statement failed. */
+		pppd__sqlite_error(sqlite);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all lines of the plan, the condition may join more tables. */
+	while (sqlite3_step(statement) == SQLITE_ROW) {
+
+		/* fetch the plan line, the detail is the last column. */
+		row = (uint8_t *)sqlite3_column_text(statement, sqlite3_column_count(statement) - 1);
+
+		/* check if line is missing. */
+		if (row == NULL) {
+			continue;
+		}
+
+		/* check if a table is read completely or an index is built for every login. */
+		if (strncmp((char *)row, "SCAN ", 5) == 0 ||
+		    strstr((char *)row, "AUTOMATIC") != NULL) {
+
+			/* every login reads the whole table. */
+			warn("Plugin %s: The password query scans a table (%s), add a unique index on %s\n", PLUGIN_NAME_SQLITE, row, pppd_sqlite_column_user);
+			continue;
+		}
+
+		/* check if index does not cover all columns, then every lookup reads the row too. */
+		if (strncmp((char *)row, "SEARCH ", 7) == 0 &&
+		    strstr((char *)row, "COVERING INDEX") == NULL &&
+		    strstr((char *)row, "PRIMARY KEY") == NULL) {
+
+			/* lookup works, only show information. */
+			info("Plugin %s: The password query uses an index without covering it (%s)\n", PLUGIN_NAME_SQLITE, row);
+		}
+	}
+
+	/* release statement. */
+	sqlite3_finalize(statement);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function is the phase change notifier for the ppp daemon. */
+void pppd__sqlite_phase(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	sqlite3 *sqlite = NULL;
+
+	/* check if startup tasks were already executed, options are complete at first phase change. */
+	if (startup == 1) {
+		return;
+	}
+
+	/* indicate that startup tasks are executed. */
+	startup = 1;
+
+	/* check if login latencies and counters should be recorded, failed logins are counted too. */
+	if (pppd_sqlite_stats != NULL &&
+	    pppd__stats_open(pppd_sqlite_stats, 1, &pppd_stats_file) < 0) {
+
+		/* logins work without stats, they are only not recorded. */
+		error("Plugin %s: Stats file %s is not usable\n", PLUGIN_NAME_SQLITE, pppd_sqlite_stats);
+	}
+
+	/* check if options are valid, the plan is built once here. */
+	if (pppd__sqlite_parameter() < 0) {
+		return;
+	}
+
+	/* check if the plan of the password query should be checked and sqlite connect is working. */
+	if (pppd_sqlite_check_plan == 1 &&
+	    pppd__sqlite_connect(&sqlite) == 0) {
+
+		/* warn about table scans. (ignore return code, the query works without index) */
+		pppd__sqlite_explain(sqlite);
+
+		/* disconnect from sqlite. */
+		pppd__sqlite_disconnect(&sqlite);
+	}
+}
+
+/* this function is the ip up notifier for the ppp daemon. */
+void pppd__sqlite_up(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	sqlite3 *sqlite = NULL;
+
+	/* check if traffic should be shaped, this is done before the script, so it may change it. */
+	if (pppd_sqlite_column_rate_down != NULL ||
+	    pppd_sqlite_column_rate_up   != NULL) {
+
+		/* install shaping. (ignore return code, the session works without limit) */
+		pppd__shape(pppd_sqlite_column_rate_down, pppd_sqlite_column_rate_up, 1);
+	}
+
+	/* check if client address should be added to firewall sets. */
+	if (pppd_sqlite_column_nft_set != NULL) {
+
+		/* add address. (ignore return code, the session works without firewall membership) */
+		pppd__firewall(pppd_sqlite_nft_table, pppd_sqlite_column_nft_set, 1);
+	}
+
+	/* check if framed routes are given. */
+	if (pppd_sqlite_column_framed_routes != NULL) {
+
+		/* add routes. (ignore return code, the session works without the routed networks) */
+		pppd__netlink_route((uint8_t *)ifname, &framed_routes, 1);
+	}
+
+	/* check if we should execute a script. */
+	if (pppd_sqlite_ip_up != NULL) {
+
+		/* execute script. */
+		if (pppd__ip_up(username, pppd_sqlite_ip_up) != 0) {
+
+			/* check if we should fail. */
+			if (pppd_sqlite_ip_up_fail == 1) {
+
+				/* show the error. */
+				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_SQLITE, pppd_sqlite_ip_up);
+
+				/* check if status should be updated. */
+				if (pppd_sqlite_exclusive     == 1 &&
+				    pppd_sqlite_authoritative == 1 &&
+				    pppd_sqlite_column_update != NULL) {
+
+					/* check if sqlite connect is working. */
+					if (pppd__sqlite_connect(&sqlite) == 0) {
+
+						/* update database. (ignore return code, because what should I do, stop the disconnect?) */
+						pppd__sqlite_status(&sqlite, username, 0);
+
+						/* disconnect from sqlite. */
+						pppd__sqlite_disconnect(&sqlite);
+					}
+				}
+
+				/* die bitch die. */
+				die(1);
+			}
+		}
+	}
+}
+
+/* this function is the ip down notifier for the ppp daemon. */
+void pppd__sqlite_down(void *opaque, int32_t arg) {
+
+	/* some common variables. */
+	sqlite3 *sqlite = NULL;
+
+	/* check if traffic was shaped. */
+	if (pppd_sqlite_column_rate_down != NULL ||
+	    pppd_sqlite_column_rate_up   != NULL) {
+
+		/* remove shaping. (ignore return code, the kernel removes it with the interface) */
+		pppd__shape(pppd_sqlite_column_rate_down, pppd_sqlite_column_rate_up, 0);
+	}
+
+	/* check if client address was added to firewall sets. */
+	if (pppd_sqlite_column_nft_set != NULL) {
+
+		/* remove address. (ignore return code, because what should I do, stop the disconnect?) */
+		pppd__firewall(pppd_sqlite_nft_table, pppd_sqlite_column_nft_set, 0);
+	}
+
+	/* check if framed routes are given. */
+	if (pppd_sqlite_column_framed_routes != NULL) {
+
+		/* remove routes. (ignore return code, because what should I do, stop the disconnect?) */
+		pppd__netlink_route((uint8_t *)ifname, &framed_routes, 0);
+	}
+
+	/* check if we should execute a script. */
+	if (pppd_sqlite_ip_down != NULL) {
+
+		/* execute script. */
+		if (pppd__ip_down(username, pppd_sqlite_ip_down) != 0) {
+
+			/* check if we should fail. */
+			if (pppd_sqlite_ip_down_fail == 1) {
+
+				/* show the error. */
+				error("Plugin %s: Script '%s' returned with non-zero status\n", PLUGIN_NAME_SQLITE, pppd_sqlite_ip_down);
+
+				/* die bitch die. */
+				die(1);
+			}
+		}
+	}
+
+	/* check if status should be updated. */
+	if (pppd_sqlite_exclusive     == 1 &&
+	    pppd_sqlite_authoritative == 1 &&
+	    pppd_sqlite_column_update != NULL) {
+
+		/* check if sqlite connect is working. */
+		if (pppd__sqlite_connect(&sqlite) == 0) {
+
+			/* update database. (ignore return code, because what should I do, stop the disconnect?) */
+			pppd__sqlite_status(&sqlite, username, 0);
+
+			/* disconnect from sqlite. */
+			pppd__sqlite_disconnect(&sqlite);
+		}
+	}
+}
+
+/* this function is the exit notifier for the ppp daemon. */
+void pppd__sqlite_exit(void *opaque, int32_t arg) {
+
+	/* release prepared statements. (finalizing NULL is a no-op) */
+	sqlite3_finalize(pppd_sqlite_plan.password);
+	sqlite3_finalize(pppd_sqlite_plan.status);
+	pppd_sqlite_plan.password = NULL;
+	pppd_sqlite_plan.status   = NULL;
+
+	/* close the database, the write-ahead log is checkpointed by the last connection. */
+	sqlite3_close(pppd_sqlite_plan.sqlite);
+	pppd_sqlite_plan.sqlite = NULL;
+}
+
+/* this function check the chap authentication information against a sqlite database. */
+int32_t pppd__chap_verify_sqlite(char *name, char *ourname, int id, struct chap_digest_type *digest, unsigned char *challenge, unsigned char *response, char *message, int message_space) {
+
+	/* some common variables. */
+	uint8_t secret_name[MAXSECRETLEN];
+	int32_t secret_length = 0;
+	int32_t result        = 0;
+	sqlite3 *sqlite       = NULL;
+	struct timespec login_start;
+	struct timespec phase_start;
+
+	/* start the timer of the whole login. */
+	pppd__stats_start(PPPD_STATS_LOGIN, (uint8_t *)name, &login_start);
+
+	/* check if parameters are complete. */
+	if ((result = pppd__sqlite_parameter()) == 0) {
+
+		/* check if sqlite connect is working. */
+		pppd__stats_start(PPPD_STATS_CONNECT, (uint8_t *)name, &phase_start);
+		result = pppd__sqlite_connect(&sqlite);
+		pppd__stats_stop(PPPD_STATS_CONNECT, (uint8_t *)name, result, &phase_start);
+		if (result == 0) {
+
+			/* check if sqlite fetching was successful. */
+			pppd__stats_start(PPPD_STATS_QUERY, (uint8_t *)name, &phase_start);
+			result = pppd__sqlite_password(&sqlite, (uint8_t *)name, secret_name, &secret_length);
+			pppd__stats_stop(PPPD_STATS_QUERY, (uint8_t *)name, result, &phase_start);
+			if (result == 0) {
+
+				/* check if password decryption was correct. */
+				pppd__stats_start(PPPD_STATS_DECRYPT, (uint8_t *)name, &phase_start);
+				result = pppd__decrypt_password(secret_name, &secret_length, pppd_sqlite_plan.encryption, pppd_sqlite_pass_key);
+				pppd__stats_stop(PPPD_STATS_DECRYPT, (uint8_t *)name, result, &phase_start);
+				if (result == 0) {
+
+					/* verify discovered secret against the client's response. */
+					pppd__stats_start(PPPD_STATS_VERIFY, (uint8_t *)name, &phase_start);
+					result = digest->verify_response(id, name, secret_name, secret_length, challenge, response, message, message_space) == 1 ? 0 : PPPD_SQL_ERROR_PASSWORD;
+					pppd__stats_stop(PPPD_STATS_VERIFY, (uint8_t *)name, result, &phase_start);
+					if (result == 0) {
+
+						/* check if database update was successful. */
+						pppd__stats_start(PPPD_STATS_STATUS, (uint8_t *)name, &phase_start);
+						result = pppd__sqlite_status(&sqlite, (uint8_t *)name, 1);
+						pppd__stats_stop(PPPD_STATS_STATUS, (uint8_t *)name, result, &phase_start);
+						if (result == 0) {
+
+							/* store username for ip down configuration. */
+							strncpy((char *)username, name, MAXNAMELEN);
+
+							/* disconnect from sqlite. */
+							pppd__sqlite_disconnect(&sqlite);
+
+							/* record the accepted login. */
+							pppd__stats_login((uint8_t *)name, 0, &login_start);
+
+							/* clear the memory with the password, so nobody is able to dump it. */
+							memset(secret_name, 0, sizeof(secret_name));
+
+							/* if no error was found, establish link. */
+							return 1;
+						}
+					}
+				}
+			}
+
+			/* disconnect from sqlite. */
+			pppd__sqlite_disconnect(&sqlite);
+		}
+	}
+
+	/* record the failed login, the fallback to the secrets file is not part of it. */
+	pppd__stats_login((uint8_t *)name, result, &login_start);
+
+	/* check if sqlite is not authoritative. */
+	if (pppd_sqlite_authoritative == 0) {
+
+		/* get the secret that the peer is supposed to know. */
+		if (get_secret(0, name, ourname, (char *)secret_name, &secret_length, 1) == 1) {
+
+			/* verify discovered secret against the client's response. */
+			if (digest->verify_response(id, name, secret_name, secret_length, challenge, response, message, message_space) == 1) {
+
+				/* clear the memory with the password, so nobody is able to dump it. */
+				memset(secret_name, 0, sizeof(secret_name));
+
+				/* if no error was found, establish link. */
+				return 1;
+			}
+		}
+
+		/* show user that fallback also fails. */
+		error("No CHAP secret found for authenticating %q", name);
+	}
+
+	/* clear the memory with the password, so nobody is able to dump it. */
+	memset(secret_name, 0, sizeof(secret_name));
+
+	/* return with error and terminate link. */
+	return 0;
+}
+
+/* this function check the pap authentication information against a sqlite database. */
+int32_t pppd__pap_auth_sqlite(char *user, char *passwd, char **msgp, struct wordlist **paddrs, struct wordlist **popts) {
+
+	/* some common variables. */
+	uint8_t secret_name[MAXSECRETLEN];
+	int32_t secret_length = 0;
+	int32_t result        = 0;
+	sqlite3 *sqlite       = NULL;
+	struct timespec login_start;
+	struct timespec phase_start;
+
+	/* start the timer of the whole login. */
+	pppd__stats_start(PPPD_STATS_LOGIN, (uint8_t *)user, &login_start);
+
+	/* check if parameters are complete. */
+	if ((result = pppd__sqlite_parameter()) == 0) {
+
+		/* check if sqlite connect is working. */
+		pppd__stats_start(PPPD_STATS_CONNECT, (uint8_t *)user, &phase_start);
+		result = pppd__sqlite_connect(&sqlite);
+		pppd__stats_stop(PPPD_STATS_CONNECT, (uint8_t *)user, result, &phase_start);
+		if (result == 0) {
+
+			/* check if sqlite fetching was successful. */
+			pppd__stats_start(PPPD_STATS_QUERY, (uint8_t *)user, &phase_start);
+			result = pppd__sqlite_password(&sqlite, (uint8_t *)user, secret_name, &secret_length);
+			pppd__stats_stop(PPPD_STATS_QUERY, (uint8_t *)user, result, &phase_start);
+			if (result == 0) {
+
+				/* check if the password is correct. */
+				pppd__stats_start(PPPD_STATS_VERIFY, (uint8_t *)user, &phase_start);
+				result = pppd__verify_password((uint8_t *)passwd, secret_name, pppd_sqlite_plan.encryption, pppd_sqlite_pass_key);
+				pppd__stats_stop(PPPD_STATS_VERIFY, (uint8_t *)user, result, &phase_start);
+				if (result == 0) {
+
+					/* check if database update was successful. */
+					pppd__stats_start(PPPD_STATS_STATUS, (uint8_t *)user, &phase_start);
+					result = pppd__sqlite_status(&sqlite, (uint8_t *)user, 1);
+					pppd__stats_stop(PPPD_STATS_STATUS, (uint8_t *)user, result, &phase_start);
+					if (result == 0) {
+
+						/* store username for ip down configuration. */
+						strncpy((char *)username, user, MAXNAMELEN);
+
+						/* disconnect from sqlite. */
+						pppd__sqlite_disconnect(&sqlite);
+
+						/* record the accepted login. */
+						pppd__stats_login((uint8_t *)user, 0, &login_start);
+
+						/* clear the memory with the password, so nobody is able to dump it. */
+						memset(secret_name, 0, sizeof(secret_name));
+
+						/* if no error was found, establish link. */
+						return 1;
+					}
+				}
+			}
+
+			/* disconnect from sqlite. */
+			pppd__sqlite_disconnect(&sqlite);
+		}
+	}
+
+	/* record the failed login, the fallback to the secrets file is not part of it. */
+	pppd__stats_login((uint8_t *)user, result, &login_start);
+
+	/* check if sqlite is not authoritative. */
+	if (pppd_sqlite_authoritative == 0) {
+
+		/* return with error and look in pap file. */
+		return -1;
+	}
+
+	/* clear the memory with the password, so nobody is able to dump it. */
+	memset(secret_name, 0, sizeof(secret_name));
+
+	/* return with error and terminate link. */
+	return 0;
+}
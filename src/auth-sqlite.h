@@ -0,0 +1,150 @@
+/*
+ *  auth-sqlite.h -- Challenge Handshake Authentication Protocol and Password
+ *                   Authentication Protocol for the Point-to-Point Protocol
+ *                   (PPP) via SQLite.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _AUTH_SQLITE_H
+#define _AUTH_SQLITE_H
+
+/* validated options, precompiled queries and the database, kept for the process lifetime. */
+struct pppd_sqlite_plan {
+	uint32_t	built;			/* one if the plan was built. */
+	int32_t		result;			/* the result of the validation, returned for every login. */
+	uint32_t	encryption;		/* the password encryption algorithm. */
+	uint8_t		query_password[SIZE_QUERY];	/* the password query, the username is bound as parameter. */
+	uint8_t		query_status[SIZE_QUERY];	/* the login status update, status and username are bound. */
+	sqlite3		*sqlite;		/* the database, opened at the first login. */
+	sqlite3_stmt	*password;		/* the prepared password query. */
+	sqlite3_stmt	*status;		/* the prepared login status update. */
+};
+
+/* validated options, precompiled queries and the database. */
+extern struct pppd_sqlite_plan pppd_sqlite_plan;
+
+/* this function handles the sqlite3_errmsg() result. */
+int32_t pppd__sqlite_error(
+	sqlite3		*sqlite
+);
+
+/* this function validate the parameter and build the plan. */
+int32_t pppd__sqlite_plan(
+	void
+);
+
+/* this function check the parameter. */
+int32_t pppd__sqlite_parameter(
+	void
+);
+
+/* this function open the database once and begin a transaction. */
+int32_t pppd__sqlite_connect(
+	sqlite3		**sqlite
+);
+
+/* this function commit the transaction, the database stays open. */
+int32_t pppd__sqlite_disconnect(
+	sqlite3		**sqlite
+);
+
+/* this function execute the given transaction statement. */
+int32_t pppd__sqlite_transaction(
+	sqlite3		*sqlite,
+	uint8_t		*transaction
+);
+
+/* this function execute a prepared statement until it is done or returns a row. */
+int32_t pppd__sqlite_step(
+	sqlite3		*sqlite,
+	sqlite3_stmt	*statement
+);
+
+/* this function convert an ip address column into an address in network byte order. */
+int32_t pppd__sqlite_address(
+	sqlite3_stmt	*statement,
+	uint32_t	column,
+	int32_t		type,
+	uint32_t	*address
+);
+
+/* this function return the password from database. */
+int32_t pppd__sqlite_password(
+	sqlite3		**sqlite,
+	uint8_t		*name,
+	uint8_t		*secret_name,
+	int32_t		*secret_length
+);
+
+/* this function set the login status of the given user. */
+int32_t pppd__sqlite_status(
+	sqlite3		**sqlite,
+	uint8_t		*name,
+	uint32_t	status
+);
+
+/* this function warn if the password query does not look up the user by an index. */
+int32_t pppd__sqlite_explain(
+	sqlite3		*sqlite
+);
+
+/* this function is the phase change notifier for the ppp daemon. */
+void pppd__sqlite_phase(
+	void		*opaque,
+	int32_t		arg
+);
+
+/* this function is the ip up notifier for the ppp daemon. */
+void pppd__sqlite_up(
+	void		*opaque,
+	int32_t		arg
+);
+
+/* this function is the ip down notifier for the ppp daemon. */
+void pppd__sqlite_down(
+	void		*opaque,
+	int32_t		arg
+);
+
+/* this function is the exit notifier for the ppp daemon. */
+void pppd__sqlite_exit(
+	void		*opaque,
+	int32_t		arg
+);
+
+/* this function check the chap authentication information against a sqlite database. */
+int32_t pppd__chap_verify_sqlite(
+	char		*name,
+	char		*ourname,
+	int		id,
+	struct chap_digest_type		*digest,
+	unsigned char	*challenge,
+	unsigned char	*response,
+	char		*message,
+	int		message_space
+);
+
+/* this function check the pap authentication information against a sqlite database. */
+int32_t pppd__pap_auth_sqlite(
+	char		*user,
+	char		*passwd,
+	char		**msgp,
+	struct wordlist	**paddrs,
+	struct wordlist	**popts
+);
+
+#endif					/* _AUTH_SQLITE_H */
@@ -0,0 +1,301 @@
+/*
+ *  import-lmdb.c -- Import of the credential records from MySQL or
+ *                   PostgreSQL dumps into the LMDB database of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* lmdb includes. */
+#include <lmdb.h>
+
+/* plugin includes. */
+#include "record.h"
+
+/* define import constants. */
+#define IMPORT_LINE			4096		/* the maximum length of one input line. */
+#define IMPORT_FIELDS			5		/* username, password, client ip, server ip and the optional status. */
+#define IMPORT_NAME			255		/* the maximum length of a username, the name buffer of pppd without terminator. */
+
+/* this function decode the backslash escapes of a field in place, return one if the field is NULL. */
+int32_t pppd__import_unescape(uint8_t *field) {
+
+	/* some common variables. */
+	uint8_t *read  = field;
+	uint8_t *write = field;
+
+	/* check if field is the NULL marker of a PostgreSQL COPY or the NULL string of MySQL batch mode. */
+	if (strcmp((char *)field, "\\N") == 0 ||
+	    strcmp((char *)field, "NULL") == 0) {
+		return 1;
+	}
+
+	/* loop through all characters. */
+	for (; *read != '\0'; read++) {
+
+		/* check if character is not escaped. */
+		if (*read != '\\' || *(read + 1) == '\0') {
+			*write++ = *read;
+			continue;
+		}
+
+		/* decode the escaped character, both dump formats use the same escapes. */
+		switch (*++read) {
+			case 't':
+				*write++ = '\t';
+				break;
+			case 'n':
+				*write++ = '\n';
+				break;
+			case 'r':
+				*write++ = '\r';
+				break;
+			case '0':
+				*write++ = '\0';
+				break;
+			default:
+				*write++ = *read;
+				break;
+		}
+	}
+
+	/* terminate the decoded field. */
+	*write = '\0';
+
+	/* if field is not NULL, return zero. */
+	return 0;
+}
+
+/* this function show the usage of the import tool. */
+int32_t pppd__import_usage(uint8_t *program) {
+
+	/* show usage. */
+	fprintf(stderr, "Usage: %s [-r] [-m map-size] database < dump\n", program);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Import tab separated lines of username, password, client ip, server ip and\n");
+	fprintf(stderr, "optional login status, as written by 'mysql -B -N' or a PostgreSQL COPY.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -r           replace all records, otherwise records are added or updated\n");
+	fprintf(stderr, "  -m map-size  the size of the memory map in bytes (default: 1073741824)\n");
+
+	/* return with error. */
+	return 1;
+}
+
+/* the import tool. */
+int main(int argc, char **argv) {
+
+	/* some common variables. */
+	uint8_t line[IMPORT_LINE];
+	uint8_t buffer[sizeof(struct pppd_record)];
+	uint8_t *fields[IMPORT_FIELDS];
+	uint8_t *string      = NULL;
+	uint32_t count       = 0;
+	uint32_t number      = 0;
+	uint32_t imported    = 0;
+	uint32_t skipped     = 0;
+	uint32_t replace     = 0;
+	uint32_t status      = 0;
+	uint32_t nulls       = 0;
+	size_t map_size      = 1073741824;
+	size_t size          = 0;
+	int32_t option       = 0;
+	int32_t result       = 0;
+	struct in_addr client_ip;
+	struct in_addr server_ip;
+	struct pppd_record record;
+	struct pppd_record existing;
+	MDB_env *env         = NULL;
+	MDB_txn *txn         = NULL;
+	MDB_dbi dbi;
+	MDB_val key;
+	MDB_val value;
+
+	/* parse the command line. */
+	while ((option = getopt(argc, argv, "rm:")) != -1) {
+		switch (option) {
+			case 'r':
+				replace = 1;
+				break;
+			case 'm':
+				map_size = strtoull(optarg, NULL, 10);
+				break;
+			default:
+				return pppd__import_usage((uint8_t *)argv[0]);
+		}
+	}
+
+	/* check if database is given. */
+	if (optind != argc - 1) {
+		return pppd__import_usage((uint8_t *)argv[0]);
+	}
+
+	/* check if environment was successfully created and opened, the file is created if it does not exist. */
+	if ((result = mdb_env_create(&env)) != MDB_SUCCESS ||
+	    (result = mdb_env_set_mapsize(env, map_size)) != MDB_SUCCESS ||
+	    (result = mdb_env_open(env, argv[optind], MDB_NOSUBDIR, 0600)) != MDB_SUCCESS) {
+
+		/* something on opening environment failed. */
+		fprintf(stderr, "%s: cannot open %s: %s\n", argv[0], argv[optind], mdb_strerror(result));
+
+		/* close the environment. */
+		if (env != NULL) {
+			mdb_env_close(env);
+		}
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* check if the one write transaction of the import was started, readers see the old records until it is committed. */
+	if ((result = mdb_txn_begin(env, NULL, 0, &txn)) != MDB_SUCCESS ||
+	    (result = mdb_dbi_open(txn, NULL, 0, &dbi)) != MDB_SUCCESS ||
+	    (replace == 1 &&
+	     (result = mdb_drop(txn, dbi, 0)) != MDB_SUCCESS)) {
+
+		/* something on starting transaction failed. */
+		fprintf(stderr, "%s: cannot start transaction: %s\n", argv[0], mdb_strerror(result));
+
+		/* release transaction and close the environment. */
+		if (txn != NULL) {
+			mdb_txn_abort(txn);
+		}
+		mdb_env_close(env);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* loop through all lines of the dump. */
+	while (fgets((char *)line, sizeof(line), stdin) != NULL) {
+
+		/* count the line for messages. */
+		number++;
+
+		/* remove the line end. */
+		line[strcspn((char *)line, "\r\n")] = '\0';
+
+		/* check if line is empty or the end marker of a COPY block. */
+		if (line[0] == '\0' ||
+		    strcmp((char *)line, "\\.") == 0) {
+			continue;
+		}
+
+		/* split the line into the fields. */
+		string = line;
+		nulls  = 0;
+		for (count = 0; count < IMPORT_FIELDS && string != NULL; count++) {
+			fields[count] = (uint8_t *)strsep((char **)&string, "\t");
+			nulls += pppd__import_unescape(fields[count]);
+		}
+
+		/* check if all required fields are given and none is NULL. */
+		if (count < IMPORT_FIELDS - 1 || string != NULL || nulls > 0) {
+
+			/* show the skipped line. */
+			fprintf(stderr, "%s: line %u: expected 4 or 5 fields without NULL, skipped\n", argv[0], number);
+			skipped++;
+			continue;
+		}
+
+		/* check if ip addresses are valid. */
+		if (inet_aton((char *)fields[2], &client_ip) == 0 ||
+		    inet_aton((char *)fields[3], &server_ip) == 0) {
+
+			/* show the skipped line. */
+			fprintf(stderr, "%s: line %u: ip address of %s is not valid, skipped\n", argv[0], number, fields[0]);
+			skipped++;
+			continue;
+		}
+
+		/* the username is the key, without terminator. */
+		key.mv_size = strlen((char *)fields[0]);
+		key.mv_data = fields[0];
+
+		/* check if status is given, otherwise the status of an existing record is kept. */
+		if (count == IMPORT_FIELDS) {
+			status = strtoul((char *)fields[4], NULL, 10) != 0;
+		} else if (mdb_get(txn, dbi, &key, &value) == MDB_SUCCESS &&
+			   pppd__record_decode(&existing, value.mv_data, value.mv_size) == 0) {
+			status = existing.header.status;
+		} else {
+			status = 0;
+		}
+
+		/* check if username and secret fit into the record. */
+		if (key.mv_size == 0 ||
+		    key.mv_size > IMPORT_NAME ||
+		    pppd__record_fill(&record, fields[1], client_ip.s_addr, server_ip.s_addr, status) < 0) {
+
+			/* show the skipped line. */
+			fprintf(stderr, "%s: line %u: username or password of %s is too long, skipped\n", argv[0], number, fields[0]);
+			skipped++;
+			continue;
+		}
+
+		/* encode the record. */
+		pppd__record_encode(&record, buffer, &size);
+		value.mv_size = size;
+		value.mv_data = buffer;
+
+		/* check if record was successfully written. */
+		if ((result = mdb_put(txn, dbi, &key, &value, 0)) != MDB_SUCCESS) {
+
+			/* something on writing failed, the whole import is discarded. */
+			fprintf(stderr, "%s: line %u: cannot write %s: %s\n", argv[0], number, fields[0], mdb_strerror(result));
+
+			/* release transaction and close the environment. */
+			mdb_txn_abort(txn);
+			mdb_env_close(env);
+
+			/* return with error. */
+			return 1;
+		}
+
+		/* count the imported record. */
+		imported++;
+	}
+
+	/* check if import was successfully committed. */
+	if ((result = mdb_txn_commit(txn)) != MDB_SUCCESS) {
+
+		/* something on committing failed, the whole import is discarded. */
+		fprintf(stderr, "%s: cannot commit: %s\n", argv[0], mdb_strerror(result));
+
+		/* close the environment. */
+		mdb_env_close(env);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* close the environment. */
+	mdb_env_close(env);
+
+	/* show the summary. */
+	fprintf(stdout, "%u records imported, %u lines skipped\n", imported, skipped);
+
+	/* return with error if a line was skipped. */
+	return skipped > 0;
+}
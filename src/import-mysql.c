@@ -0,0 +1,185 @@
+/*
+ *  import-mysql.c -- Bulk import of credentials from CSV into the MySQL
+ *                    database of the Plugin via LOAD DATA LOCAL INFILE.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* mysql includes. */
+#include <mysql/mysql.h>
+
+/* plugin includes. */
+#include "import-sql.h"
+#include "pppd-sql.h"
+#include "str.h"
+
+/* this function is the local infile init callback, the converted batches are the file. */
+int pppd__import_mysql_init(void **opaque, const char *filename, void *userdata) {
+
+	/* the import is the state of the file. */
+	*opaque = userdata;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function is the local infile read callback, it copy the next part of the converted batches. */
+int pppd__import_mysql_read(void *opaque, char *buffer, unsigned int length) {
+
+	/* some common variables. */
+	struct pppd_import *import = opaque;
+	uint32_t size              = 0;
+
+	/* loop until data is available or all batches are written. */
+	while (1) {
+
+		/* check if a batch must be taken from the queue. */
+		if (import->current == NULL) {
+
+			/* check if all batches are written, which is the end of file. */
+			if ((import->current = pppd__import_next(import)) == NULL) {
+				return 0;
+			}
+
+			/* start at the beginning of the batch. */
+			import->offset = 0;
+		}
+
+		/* check if batch has remaining data. */
+		if (import->offset < import->current->length) {
+			break;
+		}
+
+		/* free the written batch. */
+		pppd__import_free(import->current);
+		import->current = NULL;
+	}
+
+	/* copy as much as fits into the buffer of the client library. */
+	size = import->current->length - import->offset;
+	if (size > length) {
+		size = length;
+	}
+	memcpy(buffer, import->current->data + import->offset, size);
+	import->offset += size;
+
+	/* return the copied size. */
+	return size;
+}
+
+/* this function is the local infile end callback. */
+void pppd__import_mysql_end(void *opaque) {
+
+	/* the batches are freed by the read callback and the import tool. */
+}
+
+/* this function is the local infile error callback. */
+int pppd__import_mysql_error(void *opaque, char *message, unsigned int length) {
+
+	/* the callbacks fail only if the file cannot be read. */
+	snprintf(message, length, "converted rows are not readable");
+
+	/* return the client error code. */
+	return 2000;
+}
+
+/* this function stream the converted batches into mysql via LOAD DATA LOCAL INFILE. */
+int32_t pppd__import_mysql(struct pppd_import *import) {
+
+	/* some common variables. */
+	uint8_t query[SIZE_QUERY];
+	uint32_t query_length = 0;
+	uint32_t local_infile = 1;
+	int32_t result        = 0;
+	const char *info      = NULL;
+	MYSQL *mysql          = NULL;
+
+	/* check if mysql structure was initialized and local infile was allowed by the client. */
+	if ((mysql = mysql_init(NULL)) == NULL ||
+	    mysql_options(mysql, MYSQL_OPT_LOCAL_INFILE, (char *)&local_infile) != 0) {
+
+		/* something on initialization failed. */
+		fprintf(stderr, "pppd-sql-import: cannot initialize mysql\n");
+
+		/* close the connection. */
+		if (mysql != NULL) {
+			mysql_close(mysql);
+		}
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_INIT;
+	}
+
+	/* check if connection was successfully established. */
+	if (mysql_real_connect(mysql, (char *)import->host, (char *)import->user, (char *)import->pass, (char *)import->database, import->port, NULL, 0) == NULL) {
+
+		/* something on connecting failed. */
+		fprintf(stderr, "pppd-sql-import: %s\n", mysql_error(mysql));
+
+		/* close the connection. */
+		mysql_close(mysql);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_CONNECT;
+	}
+
+	/* check if query fits into the buffer. */
+	if (pppd__strappend(query, sizeof(query), &query_length, "LOAD DATA LOCAL INFILE 'pppd-sql-import' INTO TABLE %s (%s)", import->table, import->columns) < 0) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-import: query is too long\n");
+
+		/* close the connection. */
+		mysql_close(mysql);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* the converted batches are read by the client library instead of a local file. */
+	mysql_set_local_infile_handler(mysql, pppd__import_mysql_init, pppd__import_mysql_read, pppd__import_mysql_end, pppd__import_mysql_error, import);
+
+	/* check if all rows were loaded, the statement loads all rows or none of a transactional table. */
+	if (mysql_query(mysql, (char *)query) != 0) {
+
+		/* something on loading failed. */
+		fprintf(stderr, "pppd-sql-import: %s\n", mysql_error(mysql));
+
+		/* return with error. */
+		result = PPPD_SQL_ERROR_QUERY;
+	} else if ((info = mysql_info(mysql)) != NULL) {
+
+		/* show the statistics of the server, duplicate keys and truncated values are counted there. */
+		fprintf(stdout, "%s\n", info);
+	}
+
+	/* free the batch which was not completely written after an error. */
+	if (import->current != NULL) {
+		pppd__import_free(import->current);
+		import->current = NULL;
+	}
+
+	/* close the connection. */
+	mysql_close(mysql);
+
+	/* return the result. */
+	return result;
+}
@@ -0,0 +1,145 @@
+/*
+ *  import-pgsql.c -- Bulk import of credentials from CSV into the PostgreSQL
+ *                    database of the Plugin via COPY FROM STDIN.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* postgresql includes. */
+#include <libpq-fe.h>
+
+/* plugin includes. */
+#include "import-sql.h"
+#include "pppd-sql.h"
+#include "str.h"
+
+/* this function stream the converted batches into postgresql via COPY FROM STDIN. */
+int32_t pppd__import_pgsql(struct pppd_import *import) {
+
+	/* some common variables. */
+	uint8_t query[SIZE_QUERY];
+	uint8_t port[16];
+	uint32_t query_length           = 0;
+	int32_t result                  = 0;
+	struct pppd_import_batch *batch = NULL;
+	PGconn *pgsql                   = NULL;
+	PGresult *res                   = NULL;
+
+	/* the port as string, the default port of libpq if none is given. */
+	snprintf((char *)port, sizeof(port), "%u", import->port);
+
+	/* check if connection was successfully established. */
+	if ((pgsql = PQsetdbLogin((char *)import->host, import->port > 0 ? (char *)port : NULL, NULL, NULL, (char *)import->database, (char *)import->user, (char *)import->pass)) == NULL ||
+	    PQstatus(pgsql) != CONNECTION_OK) {
+
+		/* something on connecting failed. */
+		fprintf(stderr, "pppd-sql-import: %s", pgsql != NULL ? PQerrorMessage(pgsql) : "cannot initialize postgresql\n");
+
+		/* close the connection. */
+		if (pgsql != NULL) {
+			PQfinish(pgsql);
+		}
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_CONNECT;
+	}
+
+	/* check if query fits into the buffer. */
+	if (pppd__strappend(query, sizeof(query), &query_length, "COPY %s (%s) FROM STDIN", import->table, import->columns) < 0) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-import: query is too long\n");
+
+		/* close the connection. */
+		PQfinish(pgsql);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* check if copy was started, the rows are streamed without a round trip per row. */
+	if ((res = PQexec(pgsql, (char *)query)) == NULL ||
+	    PQresultStatus(res) != PGRES_COPY_IN) {
+
+		/* something on starting copy failed. */
+		fprintf(stderr, "pppd-sql-import: %s", PQerrorMessage(pgsql));
+
+		/* free the result and close the connection. */
+		PQclear(res);
+		PQfinish(pgsql);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* free the result. */
+	PQclear(res);
+
+	/* loop through all converted batches. */
+	while ((batch = pppd__import_next(import)) != NULL) {
+
+		/* check if rows were sent. */
+		if (batch->length > 0 &&
+		    PQputCopyData(pgsql, (char *)batch->data, batch->length) != 1) {
+
+			/* something on sending failed. */
+			fprintf(stderr, "pppd-sql-import: %s", PQerrorMessage(pgsql));
+			result = PPPD_SQL_ERROR_QUERY;
+		}
+
+		/* free the written batch. */
+		pppd__import_free(batch);
+
+		/* check if sending failed. */
+		if (result < 0) {
+			break;
+		}
+	}
+
+	/* check if copy was finished, on error it is cancelled and no row is loaded. */
+	if (PQputCopyEnd(pgsql, result < 0 ? "import aborted" : NULL) != 1) {
+
+		/* something on finishing failed. */
+		fprintf(stderr, "pppd-sql-import: %s", PQerrorMessage(pgsql));
+		result = PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through the results of the copy. */
+	while ((res = PQgetResult(pgsql)) != NULL) {
+
+		/* check if copy failed, duplicate keys or invalid values cancel the whole copy. */
+		if (PQresultStatus(res) != PGRES_COMMAND_OK && result == 0) {
+
+			/* something on loading failed. */
+			fprintf(stderr, "pppd-sql-import: %s", PQresultErrorMessage(res));
+			result = PPPD_SQL_ERROR_QUERY;
+		}
+
+		/* free the result. */
+		PQclear(res);
+	}
+
+	/* close the connection. */
+	PQfinish(pgsql);
+
+	/* return the result. */
+	return result;
+}
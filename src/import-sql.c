@@ -0,0 +1,657 @@
+/*
+ *  import-sql.c -- Bulk import of credentials from CSV into the MySQL or
+ *                  PostgreSQL database of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* configuration includes. */
+#include "config.h"
+
+/* generic includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* plugin includes. */
+#include "import-sql.h"
+#include "password.h"
+#include "pppd-sql.h"
+#include "str.h"
+
+/* this function parse one csv line and append it as converted row to the batch. */
+int32_t pppd__import_convert(struct pppd_import *import, struct pppd_import_batch *batch, uint8_t *line, uint32_t number) {
+
+	/* some common variables. */
+	uint8_t copy[IMPORT_LINE];
+	uint8_t secret_name[SIZE_SECRET];
+	uint8_t *fields[IMPORT_FIELDS];
+	uint8_t nulls[IMPORT_FIELDS];
+	uint8_t *read        = line;
+	uint8_t *write       = copy;
+	uint8_t *value       = NULL;
+	uint8_t *data        = NULL;
+	uint32_t count       = 0;
+	uint32_t size        = 0;
+	uint32_t quoted      = 0;
+
+	/* loop through all fields of the line. */
+	for (count = 0; count < IMPORT_FIELDS; count++) {
+
+		/* the field starts at the current write position. */
+		fields[count] = write;
+		quoted        = (*read == '"');
+		nulls[count]  = (*read == ',' || *read == '\0');
+
+		/* check if field is quoted, then commas are part of the value and doubled quotes are one quote. */
+		if (quoted == 1) {
+
+			/* loop through the quoted value. */
+			for (read++; *read != '\0'; read++) {
+
+				/* check if quote ends the value or is doubled. */
+				if (*read == '"') {
+					if (*(read + 1) != '"') {
+						break;
+					}
+					read++;
+				}
+				*write++ = *read;
+			}
+
+			/* check if closing quote is missing or not followed by the next field. */
+			if (*read != '"' || (*(read + 1) != ',' && *(read + 1) != '\0')) {
+
+				/* show the skipped line. */
+				fprintf(stderr, "pppd-sql-import: line %u: quote is not terminated, skipped\n", number);
+
+				/* return with error. */
+				return -1;
+			}
+
+			/* skip the closing quote. */
+			read++;
+		} else {
+
+			/* copy the unquoted value. */
+			while (*read != ',' && *read != '\0') {
+				*write++ = *read++;
+			}
+		}
+
+		/* terminate the field. */
+		*write++ = '\0';
+
+		/* check if line is complete. */
+		if (*read++ == '\0') {
+			count++;
+			break;
+		}
+	}
+
+	/* check if number of fields matches the columns. */
+	if (count != import->fields || *(read - 1) != '\0') {
+
+		/* show the skipped line. */
+		fprintf(stderr, "pppd-sql-import: line %u: expected %u fields, skipped\n", number, import->fields);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* check if password is given and was encrypted with the same code which verifies it on login. */
+	if (nulls[import->password] == 1 ||
+	    pppd__encode_password(fields[import->password], import->encryption, import->key, secret_name, sizeof(secret_name)) < 0) {
+
+		/* show the skipped line. */
+		fprintf(stderr, "pppd-sql-import: line %u: password is empty or too long, skipped\n", number);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* the encrypted password replaces the field. */
+	fields[import->password] = secret_name;
+
+	/* compute the worst case size of the row, every character escaped plus separators. */
+	size = 2 * strlen((char *)line) + 2 * strlen((char *)secret_name) + 3 * import->fields + 1;
+
+	/* check if batch must grow. */
+	if (batch->length + size > batch->size) {
+
+		/* check if memory was successfully allocated. */
+		if ((data = realloc(batch->data, 2 * (batch->length + size))) == NULL) {
+
+			/* clear the memory with the password, so nobody is able to dump it. */
+			memset(secret_name, 0, sizeof(secret_name));
+
+			/* return with error. */
+			return -1;
+		}
+
+		/* use the grown buffer. */
+		batch->data = data;
+		batch->size = 2 * (batch->length + size);
+	}
+
+	/* loop through all fields and append them as tab separated row. */
+	for (count = 0; count < import->fields; count++) {
+
+		/* separate the fields. */
+		if (count > 0) {
+			batch->data[batch->length++] = '\t';
+		}
+
+		/* check if unquoted field is empty, which is NULL in the database. */
+		if (nulls[count] == 1) {
+			batch->data[batch->length++] = '\\';
+			batch->data[batch->length++] = 'N';
+			continue;
+		}
+
+		/* loop through all characters and escape them like COPY and LOAD DATA expect. */
+		for (value = fields[count]; *value != '\0'; value++) {
+			switch (*value) {
+				case '\\':
+					batch->data[batch->length++] = '\\';
+					batch->data[batch->length++] = '\\';
+					break;
+				case '\t':
+					batch->data[batch->length++] = '\\';
+					batch->data[batch->length++] = 't';
+					break;
+				case '\r':
+					batch->data[batch->length++] = '\\';
+					batch->data[batch->length++] = 'r';
+					break;
+				default:
+					batch->data[batch->length++] = *value;
+					break;
+			}
+		}
+	}
+
+	/* terminate the row. */
+	batch->data[batch->length++] = '\n';
+	batch->rows++;
+
+	/* clear the memory with the password, so nobody is able to dump it. */
+	memset(secret_name, 0, sizeof(secret_name));
+	memset(copy, 0, sizeof(copy));
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function is the worker thread which reads, encrypts and converts batches. */
+void *pppd__import_worker(void *opaque) {
+
+	/* some common variables. */
+	struct pppd_import *import     = opaque;
+	struct pppd_import_batch *batch = NULL;
+	uint8_t *lines                 = NULL;
+	uint8_t *line                  = NULL;
+	uint32_t size                  = 0;
+	uint32_t length                = 0;
+	uint32_t count                 = 0;
+	uint32_t number                = 0;
+	uint32_t skipped               = 0;
+
+	/* the raw lines of a batch, they are converted after the input is released for the next worker. */
+	size  = IMPORT_BATCH * IMPORT_LINE;
+	lines = malloc(size);
+
+	/* loop until input is read completely. */
+	while (lines != NULL) {
+
+		/* check if batch was allocated. */
+		if ((batch = calloc(1, sizeof(struct pppd_import_batch))) == NULL) {
+			break;
+		}
+
+		/* lock the input. */
+		pthread_mutex_lock(&import->input_lock);
+
+		/* the number of the first line of this batch. */
+		number  = import->number + 1;
+		length  = 0;
+		skipped = 0;
+
+		/* loop through the next lines of the input. */
+		for (count = 0; count < IMPORT_BATCH && import->eof == 0 && import->aborted == 0; count++) {
+
+			/* check if input is read completely. */
+			if (fgets((char *)lines + length, IMPORT_LINE, import->input) == NULL) {
+				import->eof = 1;
+				break;
+			}
+
+			/* count the line. */
+			import->number++;
+
+			/* check if line was longer than the buffer. */
+			if (strchr((char *)lines + length, '\n') == NULL && feof(import->input) == 0) {
+
+				/* show the skipped line. */
+				fprintf(stderr, "pppd-sql-import: line %u: longer than %u bytes, skipped\n", import->number, IMPORT_LINE - 1);
+				skipped++;
+
+				/* skip the remaining characters of the line. */
+				while (fgets((char *)lines + length, IMPORT_LINE, import->input) != NULL &&
+				       strchr((char *)lines + length, '\n') == NULL);
+
+				/* keep an empty line so the line numbers stay correct. */
+				lines[length] = '\0';
+			}
+
+			/* remove the line end and keep the line with terminator. */
+			lines[length + strcspn((char *)lines + length, "\r\n")] = '\0';
+			length += strlen((char *)lines + length) + 1;
+		}
+
+		/* unlock the input. */
+		pthread_mutex_unlock(&import->input_lock);
+
+		/* check if no line was read. */
+		if (count == 0 && skipped == 0) {
+			pppd__import_free(batch);
+			break;
+		}
+
+		/* store the skipped long lines. */
+		batch->skipped = skipped;
+
+		/* loop through the read lines. */
+		for (line = lines; line < lines + length; line += strlen((char *)line) + 1, number++) {
+
+			/* check if line is empty. */
+			if (line[0] == '\0') {
+				continue;
+			}
+
+			/* check if line was successfully converted. */
+			if (pppd__import_convert(import, batch, line, number) < 0) {
+				batch->skipped++;
+			}
+		}
+
+		/* clear the memory with the passwords, so nobody is able to dump it. */
+		memset(lines, 0, length);
+
+		/* lock the queue. */
+		pthread_mutex_lock(&import->queue_lock);
+
+		/* wait until the database writer took a batch. */
+		while (import->count == IMPORT_QUEUE && import->aborted == 0) {
+			pthread_cond_wait(&import->queue_full, &import->queue_lock);
+		}
+
+		/* check if database writer failed. */
+		if (import->aborted == 1) {
+			pthread_mutex_unlock(&import->queue_lock);
+			pppd__import_free(batch);
+			break;
+		}
+
+		/* add the batch to the queue. */
+		import->queue[(import->head + import->count) % IMPORT_QUEUE] = batch;
+		import->count++;
+
+		/* wake up the database writer and unlock the queue. */
+		pthread_cond_signal(&import->queue_empty);
+		pthread_mutex_unlock(&import->queue_lock);
+	}
+
+	/* free the raw lines. */
+	free(lines);
+
+	/* the worker finished, the database writer stops if the queue is empty and all workers finished. */
+	pthread_mutex_lock(&import->queue_lock);
+	import->workers--;
+	pthread_cond_broadcast(&import->queue_empty);
+	pthread_mutex_unlock(&import->queue_lock);
+
+	/* exit thread. */
+	return NULL;
+}
+
+/* this function return the next converted batch for the database writer or NULL at the end. */
+struct pppd_import_batch *pppd__import_next(struct pppd_import *import) {
+
+	/* some common variables. */
+	struct pppd_import_batch *batch = NULL;
+
+	/* lock the queue. */
+	pthread_mutex_lock(&import->queue_lock);
+
+	/* wait until a batch is converted or all workers finished. */
+	while (import->count == 0 && import->workers > 0) {
+		pthread_cond_wait(&import->queue_empty, &import->queue_lock);
+	}
+
+	/* check if a batch is available. */
+	if (import->count > 0) {
+
+		/* take the first batch from the queue. */
+		batch        = import->queue[import->head];
+		import->head = (import->head + 1) % IMPORT_QUEUE;
+		import->count--;
+
+		/* count the rows and skipped lines. */
+		import->rows    += batch->rows;
+		import->skipped += batch->skipped;
+
+		/* wake up a waiting worker. */
+		pthread_cond_signal(&import->queue_full);
+	}
+
+	/* unlock the queue. */
+	pthread_mutex_unlock(&import->queue_lock);
+
+	/* return the batch or NULL if all batches are written. */
+	return batch;
+}
+
+/* this function free the given batch. */
+void pppd__import_free(struct pppd_import_batch *batch) {
+
+	/* check if rows are allocated. */
+	if (batch->data != NULL) {
+
+		/* clear the memory with the encrypted passwords. */
+		memset(batch->data, 0, batch->size);
+		free(batch->data);
+	}
+
+	/* free the batch. */
+	free(batch);
+}
+
+/* this function stop the workers after an error of the database writer. */
+void pppd__import_abort(struct pppd_import *import) {
+
+	/* set the abort flag and wake up all waiting workers. */
+	pthread_mutex_lock(&import->queue_lock);
+	import->aborted = 1;
+	pthread_cond_broadcast(&import->queue_full);
+	pthread_mutex_unlock(&import->queue_lock);
+}
+
+/* this function show the usage of the import tool. */
+int32_t pppd__import_usage(uint8_t *program) {
+
+	/* show usage. */
+	fprintf(stderr, "Usage: %s -t type [-h host] [-P port] [-u user] [-p password] -d database\n", program);
+	fprintf(stderr, "       [-T table] [-c columns] [-w password-column] [-e encryption] [-k key]\n");
+	fprintf(stderr, "       [-j threads] < csv\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Load comma separated lines, one field per column, with one LOAD DATA LOCAL\n");
+	fprintf(stderr, "INFILE or COPY FROM STDIN. The password field is encrypted by worker threads.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -t type             the database type:");
+#ifdef PLUGIN_NAME_MYSQL
+	fprintf(stderr, " mysql");
+#endif
+#ifdef PLUGIN_NAME_PGSQL
+	fprintf(stderr, " pgsql");
+#endif
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -h host             the database host\n");
+	fprintf(stderr, "  -P port             the database port\n");
+	fprintf(stderr, "  -u user             the database user\n");
+	fprintf(stderr, "  -p password         the database password\n");
+	fprintf(stderr, "  -d database         the database name\n");
+	fprintf(stderr, "  -T table            the table to load (default: login)\n");
+	fprintf(stderr, "  -c columns          the columns of the fields (default: username,password,clientip,serverip)\n");
+	fprintf(stderr, "  -w password-column  the column of the password (default: password)\n");
+	fprintf(stderr, "  -e encryption       NONE, CRYPT, MD5 or AES like the pass-encryption option (default: NONE)\n");
+	fprintf(stderr, "  -k key              the salt of CRYPT or the key of AES like the pass-key option\n");
+	fprintf(stderr, "  -j threads          the number of worker threads (default: number of processors)\n");
+
+	/* return with error. */
+	return 1;
+}
+
+/* the import tool. */
+int main(int argc, char **argv) {
+
+	/* some common variables. */
+	pthread_t threads[IMPORT_THREADS];
+	uint8_t columns[SIZE_QUERY];
+	uint8_t *string      = NULL;
+	uint8_t *column      = NULL;
+	uint8_t *type        = NULL;
+	uint8_t *password    = (uint8_t *)"password";
+	uint8_t *encryption  = (uint8_t *)"NONE";
+	uint32_t workers     = 0;
+	uint32_t count       = 0;
+	int32_t option       = 0;
+	int32_t result       = 0;
+	long processors      = 0;
+	struct pppd_import import;
+
+	/* initialize the import with the defaults. */
+	memset(&import, 0, sizeof(import));
+	import.table    = (uint8_t *)"login";
+	import.columns  = (uint8_t *)"username,password,clientip,serverip";
+	import.key      = (uint8_t *)"";
+	import.input    = stdin;
+	import.password = IMPORT_FIELDS;
+
+	/* default to one worker per processor. */
+	if ((processors = sysconf(_SC_NPROCESSORS_ONLN)) > 0) {
+		workers = processors;
+	} else {
+		workers = 1;
+	}
+
+	/* parse the command line. */
+	while ((option = getopt(argc, argv, "t:h:P:u:p:d:T:c:w:e:k:j:")) != -1) {
+		switch (option) {
+			case 't':
+				type = (uint8_t *)optarg;
+				break;
+			case 'h':
+				import.host = (uint8_t *)optarg;
+				break;
+			case 'P':
+				import.port = strtoul(optarg, NULL, 10);
+				break;
+			case 'u':
+				import.user = (uint8_t *)optarg;
+				break;
+			case 'p':
+				import.pass = (uint8_t *)optarg;
+				break;
+			case 'd':
+				import.database = (uint8_t *)optarg;
+				break;
+			case 'T':
+				import.table = (uint8_t *)optarg;
+				break;
+			case 'c':
+				import.columns = (uint8_t *)optarg;
+				break;
+			case 'w':
+				password = (uint8_t *)optarg;
+				break;
+			case 'e':
+				encryption = (uint8_t *)optarg;
+				break;
+			case 'k':
+				import.key = (uint8_t *)optarg;
+				break;
+			case 'j':
+				workers = strtoul(optarg, NULL, 10);
+				break;
+			default:
+				return pppd__import_usage((uint8_t *)argv[0]);
+		}
+	}
+
+	/* check if type and database are given. */
+	if (type == NULL || import.database == NULL || optind != argc) {
+		return pppd__import_usage((uint8_t *)argv[0]);
+	}
+
+	/* check if the number of workers is valid. */
+	if (workers == 0 || workers > IMPORT_THREADS) {
+
+		/* show the error. */
+		fprintf(stderr, "%s: threads must be between 1 and %u\n", argv[0], IMPORT_THREADS);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* check if encryption algorithm is supported. */
+	if ((result = pppd__encryption(encryption)) < 0) {
+
+		/* show the error. */
+		fprintf(stderr, "%s: encryption %s is not supported\n", argv[0], encryption);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* store the encryption algorithm. */
+	import.encryption = result;
+
+	/* check if key is required but missing. */
+	if ((import.encryption == PPPD_SQL_ENCRYPTION_CRYPT ||
+	     import.encryption == PPPD_SQL_ENCRYPTION_AES) &&
+	    strlen((char *)import.key) == 0) {
+
+		/* show the error. */
+		fprintf(stderr, "%s: encryption %s requires a key\n", argv[0], encryption);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* check if column list fits into the buffer. */
+	if (strlen((char *)import.columns) >= sizeof(columns)) {
+
+		/* show the error. */
+		fprintf(stderr, "%s: column list is too long\n", argv[0]);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* loop through all columns to count the fields and find the password. */
+	snprintf((char *)columns, sizeof(columns), "%s", import.columns);
+	string = columns;
+	while ((column = pppd__strsep(&string, (uint8_t *)",")) != NULL) {
+
+		/* remove the surrounding whitespace. */
+		column += strspn((char *)column, " \t");
+		column[strcspn((char *)column, " \t")] = '\0';
+
+		/* check if column is the password. */
+		if (strcmp((char *)column, (char *)password) == 0) {
+			import.password = import.fields;
+		}
+
+		/* count the field. */
+		import.fields++;
+	}
+
+	/* check if column list is valid. */
+	if (import.fields > IMPORT_FIELDS ||
+	    import.password == IMPORT_FIELDS) {
+
+		/* show the error. */
+		fprintf(stderr, "%s: at most %u columns are allowed and one must be %s\n", argv[0], IMPORT_FIELDS, password);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* initialize the locks. */
+	pthread_mutex_init(&import.input_lock, NULL);
+	pthread_mutex_init(&import.queue_lock, NULL);
+	pthread_cond_init(&import.queue_full, NULL);
+	pthread_cond_init(&import.queue_empty, NULL);
+
+	/* loop through all workers and start them. */
+	for (count = 0; count < workers; count++) {
+
+		/* count the worker before it is started, so the database writer does not stop early. */
+		import.workers++;
+
+		/* check if thread was successfully started. */
+		if (pthread_create(&threads[count], NULL, pppd__import_worker, &import) != 0) {
+
+			/* show the error. */
+			fprintf(stderr, "%s: cannot start worker thread\n", argv[0]);
+
+			/* stop the started workers. */
+			import.workers--;
+			pppd__import_abort(&import);
+			break;
+		}
+	}
+
+	/* store the number of started workers. */
+	workers = count;
+
+	/* stream the converted batches into the database. */
+	result = -1;
+#ifdef PLUGIN_NAME_MYSQL
+	if (strcmp((char *)type, "mysql") == 0 && import.aborted == 0) {
+		result = pppd__import_mysql(&import);
+	}
+#endif
+#ifdef PLUGIN_NAME_PGSQL
+	if (strcmp((char *)type, "pgsql") == 0 && import.aborted == 0) {
+		result = pppd__import_pgsql(&import);
+	}
+#endif
+
+	/* check if import failed, then the workers are stopped. */
+	if (result < 0) {
+		pppd__import_abort(&import);
+	}
+
+	/* loop through all workers and wait for them. */
+	for (count = 0; count < workers; count++) {
+		pthread_join(threads[count], NULL);
+	}
+
+	/* loop through the batches which were not written after an error. */
+	for (; import.count > 0; import.count--, import.head = (import.head + 1) % IMPORT_QUEUE) {
+		pppd__import_free(import.queue[import.head]);
+	}
+
+	/* check if import failed. */
+	if (result < 0) {
+
+		/* show the error. */
+		fprintf(stderr, "%s: import into %s failed, no rows were loaded\n", argv[0], type);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* show the summary. */
+	fprintf(stdout, "%u rows loaded, %u lines skipped\n", import.rows, import.skipped);
+
+	/* return with error if a line was skipped. */
+	return import.skipped > 0;
+}
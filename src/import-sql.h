@@ -0,0 +1,114 @@
+/*
+ *  import-sql.h -- Bulk import of credentials from CSV into the MySQL or
+ *                  PostgreSQL database of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _IMPORT_SQL_H
+#define _IMPORT_SQL_H
+
+/* generic includes. */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* define import constants. */
+#define IMPORT_LINE			4096		/* the maximum length of one input line. */
+#define IMPORT_BATCH			1024		/* the number of lines converted by a worker at once. */
+#define IMPORT_QUEUE			32		/* the number of converted batches waiting for the database. */
+#define IMPORT_THREADS			64		/* the maximum number of worker threads. */
+#define IMPORT_FIELDS			32		/* the maximum number of columns. */
+
+/* converted rows of one batch in the tab separated format of COPY and LOAD DATA. */
+struct pppd_import_batch {
+	uint8_t		*data;			/* the converted rows. */
+	uint32_t	length;			/* the used size of the converted rows. */
+	uint32_t	size;			/* the allocated size of the converted rows. */
+	uint32_t	rows;			/* the number of converted rows. */
+	uint32_t	skipped;		/* the number of skipped lines. */
+};
+
+/* the options and the shared state of the reader, the workers and the database writer. */
+struct pppd_import {
+	uint8_t		*host;			/* the database host. */
+	uint32_t	port;			/* the database port, zero for the default. */
+	uint8_t		*user;			/* the database user. */
+	uint8_t		*pass;			/* the database password. */
+	uint8_t		*database;		/* the database name. */
+	uint8_t		*table;			/* the table to load. */
+	uint8_t		*columns;		/* the comma separated column list, one per field. */
+	uint32_t	fields;			/* the number of columns. */
+	uint32_t	password;		/* the field of the password which is encrypted. */
+	uint32_t	encryption;		/* the password encryption algorithm. */
+	uint8_t		*key;			/* the key or salt of the encryption. */
+	FILE		*input;			/* the csv input. */
+	uint32_t	number;			/* the number of read lines. */
+	uint32_t	eof;			/* one if the input is read completely. */
+	uint32_t	aborted;		/* one if the database writer failed. */
+	uint32_t	workers;		/* the number of running workers. */
+	uint32_t	head;			/* the first queued batch. */
+	uint32_t	count;			/* the number of queued batches. */
+	uint32_t	rows;			/* the number of rows handed to the database. */
+	uint32_t	skipped;		/* the number of skipped lines. */
+	struct pppd_import_batch	*queue[IMPORT_QUEUE];	/* the converted batches. */
+	struct pppd_import_batch	*current;	/* the batch which is written by the database writer. */
+	uint32_t	offset;			/* the written size of the current batch. */
+	pthread_mutex_t	input_lock;		/* serializes reading of the input. */
+	pthread_mutex_t	queue_lock;		/* protects the queue and the counters. */
+	pthread_cond_t	queue_full;		/* signaled when a batch is taken from the queue. */
+	pthread_cond_t	queue_empty;		/* signaled when a batch is added or a worker finished. */
+};
+
+/* this function parse one csv line and append it as converted row to the batch. */
+int32_t pppd__import_convert(
+	struct pppd_import	*import,
+	struct pppd_import_batch	*batch,
+	uint8_t		*line,
+	uint32_t	number
+);
+
+/* this function is the worker thread which reads, encrypts and converts batches. */
+void *pppd__import_worker(
+	void		*opaque
+);
+
+/* this function return the next converted batch for the database writer or NULL at the end. */
+struct pppd_import_batch *pppd__import_next(
+	struct pppd_import	*import
+);
+
+/* this function free the given batch. */
+void pppd__import_free(
+	struct pppd_import_batch	*batch
+);
+
+/* this function stop the workers after an error of the database writer. */
+void pppd__import_abort(
+	struct pppd_import	*import
+);
+
+/* this function stream the converted batches into mysql via LOAD DATA LOCAL INFILE. */
+int32_t pppd__import_mysql(
+	struct pppd_import	*import
+);
+
+/* this function stream the converted batches into postgresql via COPY FROM STDIN. */
+int32_t pppd__import_pgsql(
+	struct pppd_import	*import
+);
+
+#endif					/* _IMPORT_SQL_H */
@@ -0,0 +1,371 @@
+/*
+ *  journal.c -- Write-behind journal for status and accounting updates
+ *               of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* plugin includes. */
+#include "plugin.h"
+#include "journal.h"
+
+/* this function open and map the journal. */
+int32_t pppd__journal_open(uint8_t *path, int32_t *fd, struct pppd_journal_header **header) {
+
+	/* some common variables. */
+	size_t size = sizeof(struct pppd_journal_header) + JOURNAL_RECORDS * sizeof(struct pppd_journal_record);
+	struct stat journal_stat;
+
+	/* check if journal can be opened, it is shared by all ppp daemons on this host. */
+	if ((*fd = open((char *)path, O_RDWR | O_CREAT, 0600)) < 0) {
+
+		/* error on opening journal. */
+		error("Plugin: Journal %s could not be opened: %m\n", path);
+
+		/* return with error and use synchronous update. */
+		return PPPD_SQL_ERROR_JOURNAL;
+	}
+
+	/* lock journal, because another process may create it at the same time. */
+	flock(*fd, LOCK_EX);
+
+	/* check if journal has the expected size, otherwise extend it. */
+	if (fstat(*fd, &journal_stat) < 0 ||
+	    (journal_stat.st_size < size && ftruncate(*fd, size) < 0)) {
+
+		/* error on creating journal. */
+		error("Plugin: Journal %s could not be created: %m\n", path);
+
+		/* unlock and close journal. */
+		flock(*fd, LOCK_UN);
+		close(*fd);
+
+		/* return with error and use synchronous update. */
+		return PPPD_SQL_ERROR_JOURNAL;
+	}
+
+	/* check if journal mapping was successful. */
+	if ((*header = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0)) == MAP_FAILED) {
+
+		/* error on mapping journal. */
+		error("Plugin: Journal %s could not be mapped: %m\n", path);
+
+		/* unlock and close journal. */
+		flock(*fd, LOCK_UN);
+		close(*fd);
+
+		/* return with error and use synchronous update. */
+		return PPPD_SQL_ERROR_JOURNAL;
+	}
+
+	/* check if journal is new or from an incompatible version. */
+	if ((*header)->magic   != JOURNAL_MAGIC ||
+	    (*header)->records != JOURNAL_RECORDS) {
+
+		/* initialize empty journal. */
+		(*header)->head     = 0;
+		(*header)->tail     = 0;
+		(*header)->single   = 0;
+		(*header)->failures = 0;
+		(*header)->records  = JOURNAL_RECORDS;
+		(*header)->magic    = JOURNAL_MAGIC;
+	}
+
+	/* unlock journal. */
+	flock(*fd, LOCK_UN);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function unmap and close the journal. */
+int32_t pppd__journal_close(int32_t fd, struct pppd_journal_header *header) {
+
+	/* unmap the journal. */
+	munmap(header, sizeof(struct pppd_journal_header) + JOURNAL_RECORDS * sizeof(struct pppd_journal_record));
+
+	/* close the journal. */
+	close(fd);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function fill a record with the given update of the current session. */
+int32_t pppd__journal_record(struct pppd_journal_record *record, uint8_t *name, uint32_t flags, struct pppd_accounting *accounting) {
+
+	/* cleanup the record. */
+	memset(record, 0, sizeof(struct pppd_journal_record));
+
+	/* store the kind of update. */
+	record->flags = flags;
+
+	/* store username and session identifier. */
+	strncpy((char *)record->username, (char *)name, MAXNAMELEN - 1);
+	strncpy((char *)record->session, (char *)session_id, SIZE_SESSION - 1);
+
+	/* check if we have accounting information. */
+	if (accounting != NULL) {
+
+		/* store the counters. */
+		record->bytes_received    = accounting->bytes_received;
+		record->bytes_transmitted = accounting->bytes_transmitted;
+		record->duration          = accounting->duration;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function append a record to the journal. */
+int32_t pppd__journal_append(uint8_t *path, struct pppd_journal_record *record) {
+
+	/* some common variables. */
+	int32_t fd = 0;
+	struct pppd_journal_header *header = NULL;
+	struct pppd_journal_record *records = NULL;
+
+	/* check if journal is available. */
+	if (pppd__journal_open(path, &fd, &header) < 0) {
+
+		/* return with error and use synchronous update. */
+		return PPPD_SQL_ERROR_JOURNAL;
+	}
+
+	/* records are stored directly behind the header. */
+	records = (struct pppd_journal_record *)(header + 1);
+
+	/* lock journal, only held for copying the record into the mapping. */
+	flock(fd, LOCK_EX);
+
+	/* check if journal is full, because the database is down too long. */
+	if (header->tail - header->head >= header->records) {
+
+		/* unlock journal. */
+		flock(fd, LOCK_UN);
+
+		/* show the error. */
+		error("Plugin: Journal %s is full\n", path);
+
+		/* unmap and close journal. */
+		pppd__journal_close(fd, header);
+
+		/* return with error and use synchronous update. */
+		return PPPD_SQL_ERROR_JOURNAL;
+	}
+
+	/* copy record into next free slot. */
+	memcpy(&records[header->tail % header->records], record, sizeof(struct pppd_journal_record));
+
+	/* publish the record. (the flusher syncs the journal for all appended records at once) */
+	header->tail++;
+
+	/* unlock journal. */
+	flock(fd, LOCK_UN);
+
+	/* unmap and close journal. */
+	pppd__journal_close(fd, header);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function flush all pending records to database. */
+int32_t pppd__journal_flush(uint8_t *path, int32_t (*write_records)(struct pppd_journal_record *records, uint32_t count)) {
+
+	/* some common variables. */
+	uint8_t lock_path[MAXPATHLEN];
+	int32_t fd        = 0;
+	int32_t lock_fd   = 0;
+	int32_t result    = 0;
+	uint64_t head     = 0;
+	uint64_t tail     = 0;
+	uint32_t count    = 0;
+	uint32_t backoff  = JOURNAL_BACKOFF;
+	struct pppd_journal_header *header = NULL;
+	struct pppd_journal_record *records = NULL;
+
+	/* build path of the flusher lock. */
+	slprintf((char *)lock_path, sizeof(lock_path), "%s.lock", path);
+
+	/* check if flusher lock can be opened. */
+	if ((lock_fd = open((char *)lock_path, O_RDWR | O_CREAT, 0600)) < 0) {
+
+		/* return with error, records are flushed later. */
+		return PPPD_SQL_ERROR_JOURNAL;
+	}
+
+	/* check if journal is available. */
+	if (pppd__journal_open(path, &fd, &header) < 0) {
+
+		/* close flusher lock. */
+		close(lock_fd);
+
+		/* return with error, records are flushed later. */
+		return PPPD_SQL_ERROR_JOURNAL;
+	}
+
+	/* records are stored directly behind the header. */
+	records = (struct pppd_journal_record *)(header + 1);
+
+	/* loop as long as we are the only flusher and records are pending. */
+	while (result == 0 && flock(lock_fd, LOCK_EX | LOCK_NB) == 0) {
+
+		/* loop through all pending records. */
+		while (1) {
+
+			/* fetch pending range. */
+			flock(fd, LOCK_EX);
+			head = header->head;
+			tail = header->tail;
+			flock(fd, LOCK_UN);
+
+			/* check if all records are flushed. */
+			if (head == tail) {
+				break;
+			}
+
+			/* write all appended records to disk with one sync, before they are sent. */
+			msync(header, sizeof(struct pppd_journal_header) + header->records * sizeof(struct pppd_journal_record), MS_SYNC);
+
+			/* take as much records as possible, but do not wrap around the end of the journal. */
+			count = tail - head;
+			count = count > JOURNAL_BATCH ? JOURNAL_BATCH : count;
+			count = count > header->records - (head % header->records) ? header->records - (head % header->records) : count;
+
+			/* check if records belong to a batch which failed too often, then one record rejected by the database does not block the others. */
+			if (head < header->single) {
+				count = 1;
+			}
+
+			/* check if records were successfully written to database in one transaction. */
+			if ((result = write_records(&records[head % header->records], count)) < 0) {
+
+				/* check if database was reachable, then the records itself may be the problem. */
+				if (result != PPPD_SQL_ERROR_CONNECT) {
+
+					/* count the failed write and write the records of a batch one by one if it failed too often. */
+					flock(fd, LOCK_EX);
+					if (++header->failures >= JOURNAL_RETRIES && count > 1) {
+						header->single   = head + count;
+						header->failures = 0;
+					}
+					flock(fd, LOCK_UN);
+				}
+
+				/* check if a single record failed too often, then it is skipped. */
+				if (count == 1 && header->failures >= JOURNAL_RETRIES) {
+
+					/* show the error, the record is lost. */
+					error("Plugin: Journal %s skipped record of %s session %s after %u failed writes\n", path,
+						records[head % header->records].username, records[head % header->records].session, header->failures);
+
+					/* remove skipped record from journal. */
+					flock(fd, LOCK_EX);
+					header->head++;
+					header->failures = 0;
+					flock(fd, LOCK_UN);
+
+					/* continue with the next record. */
+					result = 0;
+					continue;
+				}
+
+				/* database is not working, wait with the lock held, so no other flusher starts, and retry until the journal is drained. */
+				sleep(backoff);
+
+				/* double the wait up to the maximum, so a long outage is not hammered. */
+				backoff = backoff * 2 > JOURNAL_BACKOFF_MAX ? JOURNAL_BACKOFF_MAX : backoff * 2;
+
+				/* retry the records. */
+				continue;
+			}
+
+			/* remove flushed records from journal. */
+			flock(fd, LOCK_EX);
+			header->head    += count;
+			header->failures = 0;
+			flock(fd, LOCK_UN);
+
+			/* database is working again, so the next failure waits shortly. */
+			backoff = JOURNAL_BACKOFF;
+		}
+
+		/* unlock flusher. */
+		flock(lock_fd, LOCK_UN);
+
+		/* check if some record was appended while we were holding the lock, the appending flusher gave up on it. */
+		if (header->head == header->tail) {
+			break;
+		}
+	}
+
+	/* unmap and close journal. */
+	pppd__journal_close(fd, header);
+
+	/* close flusher lock. */
+	close(lock_fd);
+
+	/* return the result of the last write. */
+	return result;
+}
+
+/* this function flush all pending records in a detached process. */
+int32_t pppd__journal_spawn(uint8_t *path, int32_t (*write_records)(struct pppd_journal_record *records, uint32_t count)) {
+
+	/* some common variables. */
+	int32_t fd = 0;
+	pid_t pid  = 0;
+
+	/* check if fork was successful. */
+	if ((pid = fork()) < 0) {
+
+		/* return with error, records are flushed later. */
+		return PPPD_SQL_ERROR_JOURNAL;
+	}
+
+	/* check if we are the parent. */
+	if (pid > 0) {
+
+		/* wait for the intermediate child, it exits immediately. */
+		while (waitpid(pid, NULL, 0) < 0) {
+
+			/* continue on unblocked signal or a SIGCHLD. */
+			if (errno != EINTR) {
+				break;
+			}
+		}
+
+		/* if no error was found, return zero. */
+		return 0;
+	}
+
+	/* detach the flusher, so the ppp daemon never waits for it. */
+	if (fork() != 0) {
+		_exit(0);
+	}
+
+	/* start a new session, so we do not get signals of the ppp daemon. */
+	setsid();
+
+	/* close all descriptors of the ppp daemon, especially the ppp unit. */
+	for (fd = 3; fd < 1024; fd++) {
+		close(fd);
+	}
+
+	/* flush the journal and exit without running the cleanup of the ppp daemon. */
+	_exit(pppd__journal_flush(path, write_records) < 0 ? 1 : 0);
+}
@@ -0,0 +1,103 @@
+/*
+ *  journal.h -- Write-behind journal for status and accounting updates
+ *               of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+/* generic includes. */
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* define journal constants. */
+#define JOURNAL_MAGIC			0x324a5350	/* the magic of the journal file. ("PSJ2") */
+#define JOURNAL_RECORDS			16384		/* the number of record slots in the journal. */
+#define JOURNAL_BATCH			256		/* the maximum number of records flushed in one statement. */
+#define JOURNAL_BACKOFF			1		/* the first wait in seconds before a failed flush is retried. */
+#define JOURNAL_BACKOFF_MAX		60		/* the longest wait in seconds, it is doubled up to this after every failed flush. */
+#define JOURNAL_RETRIES			5		/* the failed writes of a batch before its records are written one by one, and of such a record before it is skipped. */
+
+/* define journal record flags. */
+#define JOURNAL_STATUS			0x01		/* the record resets the login status column. */
+#define JOURNAL_ACCOUNTING		0x02		/* the record carries session accounting. */
+#define JOURNAL_RELEASE			0x04		/* the record releases the lease and pool address of the session. */
+
+/* the header at the beginning of the journal file. */
+struct pppd_journal_header {
+	uint32_t	magic;			/* the journal magic. */
+	uint32_t	records;		/* the number of record slots. */
+	uint64_t	head;			/* the first record which is not flushed to database. */
+	uint64_t	tail;			/* the next free record. */
+	uint64_t	single;			/* the end of a failing batch, the records before it are written one by one. */
+	uint32_t	failures;		/* the failed writes of the records at the head, a down database is not counted. */
+};
+
+/* one pending database update. */
+struct pppd_journal_record {
+	uint32_t	flags;			/* the kind of update. */
+	uint32_t	bytes_received;		/* received bytes not yet written to database. */
+	uint32_t	bytes_transmitted;	/* transmitted bytes not yet written to database. */
+	uint32_t	duration;		/* link duration in seconds. */
+	uint8_t		username[MAXNAMELEN];	/* the username of the session. */
+	uint8_t		session[SIZE_SESSION];	/* the session identifier. */
+};
+
+/* this function open and map the journal. */
+int32_t pppd__journal_open(
+	uint8_t		*path,
+	int32_t		*fd,
+	struct pppd_journal_header	**header
+);
+
+/* this function unmap and close the journal. */
+int32_t pppd__journal_close(
+	int32_t		fd,
+	struct pppd_journal_header	*header
+);
+
+/* this function fill a record with the given update of the current session. */
+int32_t pppd__journal_record(
+	struct pppd_journal_record	*record,
+	uint8_t		*name,
+	uint32_t	flags,
+	struct pppd_accounting	*accounting
+);
+
+/* this function append a record to the journal. */
+int32_t pppd__journal_append(
+	uint8_t		*path,
+	struct pppd_journal_record	*record
+);
+
+/* this function flush all pending records to database. */
+int32_t pppd__journal_flush(
+	uint8_t		*path,
+	int32_t		(*write_records)(struct pppd_journal_record *records, uint32_t count)
+);
+
+/* this function flush all pending records in a detached process. */
+int32_t pppd__journal_spawn(
+	uint8_t		*path,
+	int32_t		(*write_records)(struct pppd_journal_record *records, uint32_t count)
+);
+
+#endif					/* _JOURNAL_H */
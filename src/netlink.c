@@ -0,0 +1,687 @@
+/*
+ *  netlink.c -- Netlink requests of the Plugin, so no external program
+ *               is executed for the link configuration.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* plugin includes. */
+#include "plugin.h"
+#include "netlink.h"
+
+/* this function open a netlink socket. */
+int32_t pppd__netlink_open(struct pppd_netlink *netlink, int32_t protocol) {
+
+	/* some common variables. */
+	struct timeval timeout = { NETLINK_TIMEOUT, 0 };
+
+	/* cleanup the batch. */
+	netlink->sequence = time(NULL);
+	netlink->requests = 0;
+	netlink->length   = 0;
+	netlink->message  = NULL;
+
+	/* check if netlink socket was successfully created. */
+	if ((netlink->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, protocol)) < 0) {
+
+		/* error on creating socket. */
+		error("Plugin: Netlink socket could not be created: %m\n");
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* never block the ppp daemon forever, if an acknowledgement is missing. */
+	setsockopt(netlink->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function close a netlink socket. */
+int32_t pppd__netlink_close(struct pppd_netlink *netlink) {
+
+	/* close the socket. */
+	close(netlink->fd);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function append a new request with the given family header to the batch. */
+int32_t pppd__netlink_message(struct pppd_netlink *netlink, uint16_t type, uint16_t flags, void *header, uint32_t size) {
+
+	/* check if request fits into the batch. */
+	if (netlink->length + NLMSG_SPACE(size) > NETLINK_BUFFER) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* start the request behind the previous one. */
+	netlink->message = (struct nlmsghdr *)(netlink->buffer + netlink->length);
+	memset(netlink->message, 0, NLMSG_SPACE(size));
+
+	/* fill the request header. */
+	netlink->message->nlmsg_len   = NLMSG_LENGTH(size);
+	netlink->message->nlmsg_type  = type;
+	netlink->message->nlmsg_flags = flags;
+	netlink->message->nlmsg_seq   = ++netlink->sequence;
+
+	/* copy the family header. */
+	memcpy(NLMSG_DATA(netlink->message), header, size);
+
+	/* increase used size of the batch. */
+	netlink->length += NLMSG_SPACE(size);
+
+	/* check if request is acknowledged. */
+	if (flags & NLM_F_ACK) {
+		netlink->requests++;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function append an attribute to the current request. */
+int32_t pppd__netlink_attribute(struct pppd_netlink *netlink, uint16_t type, const void *data, uint32_t size) {
+
+	/* some common variables. */
+	struct rtattr *attribute = NULL;
+
+	/* check if attribute fits into the batch. */
+	if (netlink->message == NULL ||
+	    netlink->length + RTA_SPACE(size) > NETLINK_BUFFER) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* start the attribute at the end of the current request. */
+	attribute = (struct rtattr *)(netlink->buffer + netlink->length);
+	memset(attribute, 0, RTA_SPACE(size));
+
+	/* fill the attribute. */
+	attribute->rta_type = type;
+	attribute->rta_len  = RTA_LENGTH(size);
+	memcpy(RTA_DATA(attribute), data, size);
+
+	/* increase used size of the batch and the request. */
+	netlink->length              += RTA_SPACE(size);
+	netlink->message->nlmsg_len  += RTA_SPACE(size);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function start a nested attribute and return its offset. */
+uint32_t pppd__netlink_nest_begin(struct pppd_netlink *netlink, uint16_t type) {
+
+	/* some common variables. */
+	uint32_t offset = netlink->length;
+
+	/* add an empty attribute, the length is fixed when the nest ends. */
+	pppd__netlink_attribute(netlink, type | NLA_F_NESTED, NULL, 0);
+
+	/* return offset of the nest. */
+	return offset;
+}
+
+/* this function finish a nested attribute. */
+int32_t pppd__netlink_nest_end(struct pppd_netlink *netlink, uint32_t offset) {
+
+	/* the nest contains everything which was added behind it. */
+	((struct rtattr *)(netlink->buffer + offset))->rta_len = netlink->length - offset;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function send the batch and wait for all acknowledgements. */
+int32_t pppd__netlink_commit(struct pppd_netlink *netlink, int32_t ignore) {
+
+	/* some common variables. */
+	uint8_t reply[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+	int32_t length       = 0;
+	int32_t result       = 0;
+	uint32_t acknowledged = 0;
+	struct nlmsghdr *message = NULL;
+	struct nlmsgerr *message_error = NULL;
+	struct sockaddr_nl address;
+
+	/* the kernel is the receiver. */
+	memset(&address, 0, sizeof(address));
+	address.nl_family = AF_NETLINK;
+
+	/* check if batch was successfully sent with one system call. */
+	if (sendto(netlink->fd, netlink->buffer, netlink->length, 0, (struct sockaddr *)&address, sizeof(address)) < 0) {
+
+		/* error on sending requests. */
+		error("Plugin: Netlink request could not be sent: %m\n");
+
+		/* return with error. */
+		result = PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* loop until all requests are acknowledged. */
+	while (result == 0 && acknowledged < netlink->requests) {
+
+		/* check if reply was received. */
+		if ((length = recv(netlink->fd, reply, sizeof(reply), 0)) < 0) {
+
+			/* continue on unblocked signal. */
+			if (errno == EINTR) {
+				continue;
+			}
+
+			/* error on receiving acknowledgements. */
+			error("Plugin: Netlink acknowledgement was not received: %m\n");
+
+			/* return with error. */
+			result = PPPD_SQL_ERROR_NETLINK;
+			break;
+		}
+
+		/* loop through all messages of the reply. */
+		for (message = (struct nlmsghdr *)reply; NLMSG_OK(message, length); message = NLMSG_NEXT(message, length)) {
+
+			/* check if message is an acknowledgement. */
+			if (message->nlmsg_type != NLMSG_ERROR) {
+				continue;
+			}
+
+			/* one more request is acknowledged. */
+			message_error = NLMSG_DATA(message);
+			acknowledged++;
+
+			/* check if request failed with an error we do not expect. */
+			if (message_error->error != 0 &&
+			    message_error->error != -ignore &&
+			    result == 0) {
+
+				/* show the error. */
+				error("Plugin: Netlink request failed: %s\n", strerror(-message_error->error));
+
+				/* return with error, but read the remaining acknowledgements. */
+				result = PPPD_SQL_ERROR_NETLINK;
+			}
+		}
+	}
+
+	/* cleanup the batch, so the socket can be used again. */
+	netlink->requests = 0;
+	netlink->length   = 0;
+	netlink->message  = NULL;
+
+	/* return the result. */
+	return result;
+}
+
+/* this function return the number of packet scheduler ticks per microsecond. */
+double pppd__netlink_ticks(void) {
+
+	/* some common variables. */
+	uint32_t t2us      = 0;
+	uint32_t us2t      = 0;
+	uint32_t clock_res = 0;
+	double ticks       = 1;
+	FILE *file         = NULL;
+
+	/* check if packet scheduler clock is available. */
+	if ((file = fopen("/proc/net/psched", "r")) != NULL) {
+
+		/* check if clock was successfully read. */
+		if (fscanf(file, "%08x%08x%08x", &t2us, &us2t, &clock_res) == 3 && us2t > 0) {
+
+			/* a high resolution timer uses the same factor in both directions. */
+			if (clock_res == 1000000000) {
+				t2us = us2t;
+			}
+
+			/* compute ticks like the traffic control utility does. */
+			ticks = (double)t2us / us2t * ((double)clock_res / 1000000);
+		}
+
+		/* close the clock. */
+		fclose(file);
+	}
+
+	/* return ticks per microsecond. */
+	return ticks;
+}
+
+/* this function return the ticks to transmit the given size at the given rate. */
+uint32_t pppd__netlink_time(uint32_t rate, uint32_t size, double ticks) {
+
+	/* return transmit time in ticks. */
+	return (uint32_t)(ticks * 1000000 * ((double)size / rate));
+}
+
+/* this function fill the rate specification and the rate table of the kernel. */
+int32_t pppd__netlink_rate(struct tc_ratespec *rate_spec, uint32_t *table, uint32_t rate, double ticks) {
+
+	/* some common variables. */
+	uint32_t cell_log = 0;
+	uint32_t count    = 0;
+
+	/* compute the cell size, so the table covers the largest packet. */
+	while ((NETLINK_MTU >> cell_log) > 255) {
+		cell_log++;
+	}
+
+	/* loop through all cells. */
+	for (count = 0; count < 256; count++) {
+
+		/* compute transmit time of the largest packet of the cell. */
+		table[count] = pppd__netlink_time(rate, (count + 1) << cell_log, ticks);
+	}
+
+	/* fill rate specification. */
+	memset(rate_spec, 0, sizeof(struct tc_ratespec));
+	rate_spec->rate       = rate;
+	rate_spec->cell_log   = cell_log;
+	rate_spec->cell_align = -1;
+	rate_spec->linklayer  = TC_LINKLAYER_ETHERNET;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function install the traffic shaping for the given interface. */
+int32_t pppd__netlink_shape(uint8_t *interface, uint32_t rate_down, uint32_t rate_up) {
+
+	/* some common variables. */
+	uint32_t rate_table[256];
+	uint32_t ceil_table[256];
+	uint32_t nest_options = 0;
+	uint32_t nest_actions = 0;
+	uint32_t nest_action  = 0;
+	uint32_t nest_police  = 0;
+	uint32_t rate         = 0;
+	uint32_t burst        = 0;
+	int32_t result        = 0;
+	double ticks          = pppd__netlink_ticks();
+	struct tcmsg tc;
+	struct tc_htb_glob htb_glob;
+	struct tc_htb_opt htb_opt;
+	struct tc_police police;
+	struct pppd_netlink netlink;
+
+	/* cleanup the traffic control header. */
+	memset(&tc, 0, sizeof(tc));
+	tc.tcm_family = AF_UNSPEC;
+
+	/* check if interface exists. */
+	if ((tc.tcm_ifindex = if_nametoindex((char *)interface)) == 0) {
+
+		/* error on finding interface. */
+		error("Plugin: Interface %s for traffic shaping not found\n", interface);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* check if netlink socket is available. */
+	if (pppd__netlink_open(&netlink, NETLINK_ROUTE) < 0) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* check if download traffic should be shaped. */
+	if (rate_down > 0) {
+
+		/* convert kbit/s into bytes/s, burst allows 20ms at full rate, but at least one packet. */
+		rate  = rate_down * 125;
+		burst = rate / 50 > NETLINK_MTU ? rate / 50 : NETLINK_MTU;
+
+		/* build root qdisc, all traffic goes into the default class, so no filter is required. */
+		tc.tcm_handle = TC_H_MAKE(1 << 16, 0);
+		tc.tcm_parent = TC_H_ROOT;
+		memset(&htb_glob, 0, sizeof(htb_glob));
+		htb_glob.version      = 3;
+		htb_glob.rate2quantum = 10;
+		htb_glob.defcls       = 1;
+
+		/* add root qdisc request. */
+		pppd__netlink_message(&netlink, RTM_NEWQDISC, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE, &tc, sizeof(tc));
+		pppd__netlink_attribute(&netlink, TCA_KIND, "htb", 4);
+		nest_options = pppd__netlink_nest_begin(&netlink, TCA_OPTIONS);
+		pppd__netlink_attribute(&netlink, TCA_HTB_INIT, &htb_glob, sizeof(htb_glob));
+		pppd__netlink_nest_end(&netlink, nest_options);
+
+		/* build default class with rate and ceil of the user. */
+		tc.tcm_handle = TC_H_MAKE(1 << 16, 1);
+		tc.tcm_parent = TC_H_MAKE(1 << 16, 0);
+		memset(&htb_opt, 0, sizeof(htb_opt));
+		pppd__netlink_rate(&htb_opt.rate, rate_table, rate, ticks);
+		pppd__netlink_rate(&htb_opt.ceil, ceil_table, rate, ticks);
+		htb_opt.buffer  = pppd__netlink_time(rate, burst, ticks);
+		htb_opt.cbuffer = pppd__netlink_time(rate, burst, ticks);
+
+		/* add class request. */
+		pppd__netlink_message(&netlink, RTM_NEWTCLASS, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE, &tc, sizeof(tc));
+		pppd__netlink_attribute(&netlink, TCA_KIND, "htb", 4);
+		nest_options = pppd__netlink_nest_begin(&netlink, TCA_OPTIONS);
+		pppd__netlink_attribute(&netlink, TCA_HTB_PARMS, &htb_opt, sizeof(htb_opt));
+		pppd__netlink_attribute(&netlink, TCA_HTB_RTAB, rate_table, sizeof(rate_table));
+		pppd__netlink_attribute(&netlink, TCA_HTB_CTAB, ceil_table, sizeof(ceil_table));
+		pppd__netlink_nest_end(&netlink, nest_options);
+	}
+
+	/* check if upload traffic should be policed. */
+	if (rate_up > 0) {
+
+		/* convert kbit/s into bytes/s, burst allows 20ms at full rate, but at least one packet. */
+		rate  = rate_up * 125;
+		burst = rate / 50 > NETLINK_MTU ? rate / 50 : NETLINK_MTU;
+
+		/* build ingress qdisc. */
+		tc.tcm_handle = TC_H_MAKE(TC_H_INGRESS, 0);
+		tc.tcm_parent = TC_H_INGRESS;
+
+		/* add ingress qdisc request. */
+		pppd__netlink_message(&netlink, RTM_NEWQDISC, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE, &tc, sizeof(tc));
+		pppd__netlink_attribute(&netlink, TCA_KIND, "ingress", 8);
+
+		/* build police action which drops everything above the rate. */
+		memset(&police, 0, sizeof(police));
+		pppd__netlink_rate(&police.rate, rate_table, rate, ticks);
+		police.action = TC_POLICE_SHOT;
+		police.burst  = pppd__netlink_time(rate, burst, ticks);
+
+		/* build filter which matches all packets of all protocols. */
+		tc.tcm_handle = 0;
+		tc.tcm_parent = TC_H_MAKE(TC_H_INGRESS, 0);
+		tc.tcm_info   = TC_H_MAKE(1 << 16, htons(ETH_P_ALL));
+
+		/* add filter request. */
+		pppd__netlink_message(&netlink, RTM_NEWTFILTER, NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_EXCL, &tc, sizeof(tc));
+		pppd__netlink_attribute(&netlink, TCA_KIND, "matchall", 9);
+		nest_options = pppd__netlink_nest_begin(&netlink, TCA_OPTIONS);
+		nest_actions = pppd__netlink_nest_begin(&netlink, TCA_MATCHALL_ACT);
+		nest_action  = pppd__netlink_nest_begin(&netlink, 1);
+		pppd__netlink_attribute(&netlink, TCA_ACT_KIND, "police", 7);
+		nest_police  = pppd__netlink_nest_begin(&netlink, TCA_ACT_OPTIONS);
+		pppd__netlink_attribute(&netlink, TCA_POLICE_TBF, &police, sizeof(police));
+		pppd__netlink_attribute(&netlink, TCA_POLICE_RATE, rate_table, sizeof(rate_table));
+		pppd__netlink_nest_end(&netlink, nest_police);
+		pppd__netlink_nest_end(&netlink, nest_action);
+		pppd__netlink_nest_end(&netlink, nest_actions);
+		pppd__netlink_nest_end(&netlink, nest_options);
+	}
+
+	/* send all requests with one system call. */
+	result = pppd__netlink_commit(&netlink, 0);
+
+	/* close netlink socket. */
+	pppd__netlink_close(&netlink);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function remove the traffic shaping from the given interface. */
+int32_t pppd__netlink_unshape(uint8_t *interface, uint32_t rate_down, uint32_t rate_up) {
+
+	/* some common variables. */
+	int32_t result = 0;
+	struct tcmsg tc;
+	struct pppd_netlink netlink;
+
+	/* cleanup the traffic control header. */
+	memset(&tc, 0, sizeof(tc));
+	tc.tcm_family = AF_UNSPEC;
+
+	/* check if interface still exists, otherwise the kernel removed everything. */
+	if ((tc.tcm_ifindex = if_nametoindex((char *)interface)) == 0) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* check if netlink socket is available. */
+	if (pppd__netlink_open(&netlink, NETLINK_ROUTE) < 0) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* check if download traffic was shaped, the kernel refuses to remove the default qdisc. */
+	if (rate_down > 0) {
+
+		/* add root qdisc removal, the class is removed with it. */
+		tc.tcm_handle = TC_H_MAKE(1 << 16, 0);
+		tc.tcm_parent = TC_H_ROOT;
+		pppd__netlink_message(&netlink, RTM_DELQDISC, NLM_F_REQUEST | NLM_F_ACK, &tc, sizeof(tc));
+	}
+
+	/* check if upload traffic was policed. */
+	if (rate_up > 0) {
+
+		/* add ingress qdisc removal, the filter is removed with it. */
+		tc.tcm_handle = TC_H_MAKE(TC_H_INGRESS, 0);
+		tc.tcm_parent = TC_H_INGRESS;
+		pppd__netlink_message(&netlink, RTM_DELQDISC, NLM_F_REQUEST | NLM_F_ACK, &tc, sizeof(tc));
+	}
+
+	/* send all requests with one system call, a missing qdisc is no error. */
+	result = pppd__netlink_commit(&netlink, ENOENT);
+
+	/* close netlink socket. */
+	pppd__netlink_close(&netlink);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function add or remove an address in the given comma separated nftables sets. */
+int32_t pppd__netlink_set(uint8_t *table, uint8_t *sets, uint32_t addr, uint32_t add) {
+
+	/* some common variables. */
+	uint8_t table_family[NETLINK_NAME];
+	uint8_t table_name[NETLINK_NAME];
+	uint8_t set_name[NETLINK_NAME];
+	uint8_t *set       = sets;
+	uint8_t *separator = NULL;
+	uint32_t nest_elements = 0;
+	uint32_t nest_element  = 0;
+	uint32_t nest_key      = 0;
+	int32_t result     = 0;
+	int32_t result_set = 0;
+	struct nfgenmsg nfgen;
+	struct pppd_netlink netlink;
+
+	/* check if table is given as family and name, like the nft utility expects it. */
+	if (sscanf((char *)table, "%255s %255s", table_family, table_name) != 2) {
+
+		/* error on parsing table. */
+		error("Plugin: Nftables table %s is not valid\n", table);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* cleanup the netfilter header. */
+	memset(&nfgen, 0, sizeof(nfgen));
+	nfgen.version = NFNETLINK_V0;
+
+	/* check which family the table has, only the ones with ipv4 addresses are supported. */
+	if (strcmp((char *)table_family, "ip") == 0) {
+		nfgen.nfgen_family = NFPROTO_IPV4;
+	} else if (strcmp((char *)table_family, "inet") == 0) {
+		nfgen.nfgen_family = NFPROTO_INET;
+	} else {
+
+		/* error on parsing table. */
+		error("Plugin: Nftables family %s is not supported\n", table_family);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* check if netlink socket is available. */
+	if (pppd__netlink_open(&netlink, NETLINK_NETFILTER) < 0) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* loop through all sets, an add is one transaction and a delete is one transaction per set. */
+	while (set != NULL && *set != '\0') {
+
+		/* find end of the set name. */
+		separator = (uint8_t *)strchr((char *)set, ',');
+
+		/* copy the set name. */
+		memset(set_name, 0, sizeof(set_name));
+		strncpy((char *)set_name, (char *)set, separator != NULL && separator - set < sizeof(set_name) - 1 ? separator - set : sizeof(set_name) - 1);
+
+		/* check if set name is not empty. (a trailing separator is allowed) */
+		if (set_name[0] != '\0') {
+
+			/* check if no transaction is open, then begin one. */
+			if (netlink.length == 0) {
+				nfgen.res_id = htons(NFNL_SUBSYS_NFTABLES);
+				pppd__netlink_message(&netlink, NFNL_MSG_BATCH_BEGIN, NLM_F_REQUEST, &nfgen, sizeof(nfgen));
+				nfgen.res_id = 0;
+			}
+
+			/* add element request. */
+			pppd__netlink_message(&netlink, (NFNL_SUBSYS_NFTABLES << 8) | (add == 1 ? NFT_MSG_NEWSETELEM : NFT_MSG_DELSETELEM), NLM_F_REQUEST | NLM_F_ACK | (add == 1 ? NLM_F_CREATE : 0), &nfgen, sizeof(nfgen));
+			pppd__netlink_attribute(&netlink, NFTA_SET_ELEM_LIST_TABLE, table_name, strlen((char *)table_name) + 1);
+			pppd__netlink_attribute(&netlink, NFTA_SET_ELEM_LIST_SET, set_name, strlen((char *)set_name) + 1);
+			nest_elements = pppd__netlink_nest_begin(&netlink, NFTA_SET_ELEM_LIST_ELEMENTS);
+			nest_element  = pppd__netlink_nest_begin(&netlink, NFTA_LIST_ELEM);
+			nest_key      = pppd__netlink_nest_begin(&netlink, NFTA_SET_ELEM_KEY);
+			pppd__netlink_attribute(&netlink, NFTA_DATA_VALUE, &addr, sizeof(addr));
+			pppd__netlink_nest_end(&netlink, nest_key);
+			pppd__netlink_nest_end(&netlink, nest_element);
+			pppd__netlink_nest_end(&netlink, nest_elements);
+
+			/* check if element is deleted, a transaction aborts all sets if the element is missing in one of them. */
+			if (add == 0) {
+
+				/* end the transaction of this set. */
+				nfgen.res_id = htons(NFNL_SUBSYS_NFTABLES);
+				pppd__netlink_message(&netlink, NFNL_MSG_BATCH_END, NLM_F_REQUEST, &nfgen, sizeof(nfgen));
+				nfgen.res_id = 0;
+
+				/* send the transaction, an element which is already gone is no error, the other sets are tried anyway. */
+				if ((result_set = pppd__netlink_commit(&netlink, ENOENT)) < 0) {
+					result = result_set;
+				}
+			}
+		}
+
+		/* continue behind the separator. */
+		set = separator != NULL ? separator + 1 : NULL;
+	}
+
+	/* check if elements are added, all sets are changed or none. */
+	if (add == 1 &&
+	    netlink.length > 0) {
+
+		/* end the transaction. */
+		nfgen.res_id = htons(NFNL_SUBSYS_NFTABLES);
+		pppd__netlink_message(&netlink, NFNL_MSG_BATCH_END, NLM_F_REQUEST, &nfgen, sizeof(nfgen));
+
+		/* send the transaction with one system call. */
+		result = pppd__netlink_commit(&netlink, 0);
+	}
+
+	/* close netlink socket. */
+	pppd__netlink_close(&netlink);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function add or remove all framed routes of the tree via the given interface. */
+int32_t pppd__netlink_route(uint8_t *interface, struct pppd_radix *radix, uint32_t add) {
+
+	/* some common variables. */
+	uint32_t count     = 0;
+	uint32_t interface_index = 0;
+	uint32_t addr      = 0;
+	int32_t result     = 0;
+	struct rtmsg rt;
+	struct pppd_netlink netlink;
+
+	/* check if session has framed routes. */
+	if (radix->routes == 0) {
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* check if interface exists, otherwise the kernel removed the routes with it. */
+	if ((interface_index = if_nametoindex((char *)interface)) == 0) {
+
+		/* check if routes should be added. */
+		if (add == 1) {
+
+			/* error on finding interface. */
+			error("Plugin: Interface %s for framed routes not found\n", interface);
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_NETLINK;
+		}
+
+		/* nothing to do, so no error. */
+		return 0;
+	}
+
+	/* check if netlink socket is available. */
+	if (pppd__netlink_open(&netlink, NETLINK_ROUTE) < 0) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_NETLINK;
+	}
+
+	/* cleanup the route header, all routes point directly into the link. */
+	memset(&rt, 0, sizeof(rt));
+	rt.rtm_family   = AF_INET;
+	rt.rtm_table    = RT_TABLE_MAIN;
+	rt.rtm_protocol = RTPROT_STATIC;
+	rt.rtm_scope    = RT_SCOPE_LINK;
+	rt.rtm_type     = RTN_UNICAST;
+
+	/* loop through all nodes, every route node is one prefix. */
+	for (count = 0; count < radix->count; count++) {
+
+		/* check if node is a branch only. */
+		if (radix->nodes[count].route == 0) {
+			continue;
+		}
+
+		/* add route request. */
+		rt.rtm_dst_len = radix->nodes[count].length;
+		addr           = htonl(radix->nodes[count].key);
+		pppd__netlink_message(&netlink, add == 1 ? RTM_NEWROUTE : RTM_DELROUTE, NLM_F_REQUEST | NLM_F_ACK | (add == 1 ? NLM_F_CREATE | NLM_F_REPLACE : 0), &rt, sizeof(rt));
+		pppd__netlink_attribute(&netlink, RTA_DST, &addr, sizeof(addr));
+		pppd__netlink_attribute(&netlink, RTA_OIF, &interface_index, sizeof(interface_index));
+	}
+
+	/* send all requests with one system call, a route which is already gone is no error. */
+	result = pppd__netlink_commit(&netlink, add == 1 ? 0 : ESRCH);
+
+	/* close netlink socket. */
+	pppd__netlink_close(&netlink);
+
+	/* return the result. */
+	return result;
+}
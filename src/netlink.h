@@ -0,0 +1,135 @@
+/*
+ *  netlink.h -- Netlink requests of the Plugin, so no external program
+ *               is executed for the link configuration.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NETLINK_H
+#define _NETLINK_H
+
+/* generic includes. */
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+/* plugin includes. */
+#include "radix.h"
+
+/* netlink includes. */
+#include <linux/if_ether.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter/nf_tables.h>
+#include <linux/netfilter/nfnetlink.h>
+#include <linux/netlink.h>
+#include <linux/pkt_cls.h>
+#include <linux/pkt_sched.h>
+#include <linux/rtnetlink.h>
+
+/* define netlink constants. */
+#define NETLINK_BUFFER			16384		/* the maximum size of one batch of requests. */
+#define NETLINK_TIMEOUT			2		/* the seconds to wait for the acknowledgements. */
+#define NETLINK_MTU			2047		/* the largest packet covered by a rate table. */
+#define NETLINK_NAME			256		/* the maximum size of a nftables table or set name. */
+
+/* one batch of netlink requests, sent with a single system call. */
+struct pppd_netlink {
+	int32_t		fd;			/* the netlink socket. */
+	uint32_t	sequence;		/* the sequence number of the last request. */
+	uint32_t	requests;		/* the number of requests which are acknowledged. */
+	uint32_t	length;			/* the used size of the buffer. */
+	struct nlmsghdr	*message;		/* the request which is currently built. */
+	uint8_t		buffer[NETLINK_BUFFER] __attribute__((aligned(NLMSG_ALIGNTO)));
+};
+
+/* this function open a netlink socket. */
+int32_t pppd__netlink_open(
+	struct pppd_netlink	*netlink,
+	int32_t		protocol
+);
+
+/* this function close a netlink socket. */
+int32_t pppd__netlink_close(
+	struct pppd_netlink	*netlink
+);
+
+/* this function append a new request with the given family header to the batch. */
+int32_t pppd__netlink_message(
+	struct pppd_netlink	*netlink,
+	uint16_t	type,
+	uint16_t	flags,
+	void		*header,
+	uint32_t	size
+);
+
+/* this function append an attribute to the current request. */
+int32_t pppd__netlink_attribute(
+	struct pppd_netlink	*netlink,
+	uint16_t	type,
+	const void	*data,
+	uint32_t	size
+);
+
+/* this function start a nested attribute and return its offset. */
+uint32_t pppd__netlink_nest_begin(
+	struct pppd_netlink	*netlink,
+	uint16_t	type
+);
+
+/* this function finish a nested attribute. */
+int32_t pppd__netlink_nest_end(
+	struct pppd_netlink	*netlink,
+	uint32_t	offset
+);
+
+/* this function send the batch and wait for all acknowledgements. */
+int32_t pppd__netlink_commit(
+	struct pppd_netlink	*netlink,
+	int32_t		ignore
+);
+
+/* this function install the traffic shaping for the given interface. */
+int32_t pppd__netlink_shape(
+	uint8_t		*interface,
+	uint32_t	rate_down,
+	uint32_t	rate_up
+);
+
+/* this function remove the traffic shaping from the given interface. */
+int32_t pppd__netlink_unshape(
+	uint8_t		*interface,
+	uint32_t	rate_down,
+	uint32_t	rate_up
+);
+
+/* this function add or remove an address in the given comma separated nftables sets. */
+int32_t pppd__netlink_set(
+	uint8_t		*table,
+	uint8_t		*sets,
+	uint32_t	addr,
+	uint32_t	add
+);
+
+/* this function add or remove all framed routes of the tree via the given interface. */
+int32_t pppd__netlink_route(
+	uint8_t		*interface,
+	struct pppd_radix	*radix,
+	uint32_t	add
+);
+
+#endif					/* _NETLINK_H */
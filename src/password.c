@@ -0,0 +1,468 @@
+/*
+ *  password.c -- Password encryption and verification shared by the Point-
+ *                to-Point Protocol (PPP) plugins and the import tools.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <string.h>
+#include <strings.h>
+
+/* plugin includes. */
+#include "password.h"
+#include "pppd-sql.h"
+#include "str.h"
+
+/* this function return the password encryption algorithm of the given name. */
+int32_t pppd__encryption(uint8_t *name) {
+
+	/* check which algorithm is given. */
+	if (strcasecmp((char *)name, "NONE") == 0) {
+		return PPPD_SQL_ENCRYPTION_NONE;
+	}
+	if (strcasecmp((char *)name, "CRYPT") == 0) {
+		return PPPD_SQL_ENCRYPTION_CRYPT;
+	}
+	if (strcasecmp((char *)name, "MD5") == 0) {
+		return PPPD_SQL_ENCRYPTION_MD5;
+	}
+	if (strcasecmp((char *)name, "AES") == 0) {
+		return PPPD_SQL_ENCRYPTION_AES;
+	}
+
+	/* algorithm is not supported. */
+	return PPPD_SQL_ERROR_OPTION;
+}
+
+/* this function encrypt the given password into the binary result of the algorithm. */
+int32_t pppd__encrypt_password(uint8_t *passwd, uint32_t encryption, uint8_t *key, uint8_t *result, int32_t *result_length) {
+
+	/* some common variables. */
+	uint8_t passwd_key[SIZE_AES];
+	uint8_t passwd_crypt[SIZE_CRYPT + 1];
+	int32_t passwd_size = 0;
+	int32_t temp_size   = 0;
+	EVP_MD_CTX ctx_md5;
+	EVP_CIPHER_CTX ctx_aes;
+
+	/* cleanup the static array. */
+	memset(passwd_key, 0, sizeof(passwd_key));
+	memset(passwd_crypt, 0, sizeof(passwd_crypt));
+
+	/* check if we use no algorithm. */
+	if (encryption == PPPD_SQL_ENCRYPTION_NONE) {
+
+		/* check if password fits into the result. */
+		if (strlen((char *)passwd) > SIZE_SECRET / 2) {
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* the result is the clear text password. */
+		*result_length = strlen((char *)passwd);
+		memcpy(result, passwd, *result_length);
+	}
+
+	/* check if we use des crypt algorithm. */
+	if (encryption == PPPD_SQL_ENCRYPTION_CRYPT) {
+
+		/* check if password was successfully encrypted. */
+		if ((uint8_t *)DES_fcrypt((char *)passwd, (char *)key, (char *)passwd_crypt) == NULL) {
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* copy the hash without terminator to the result. */
+		memcpy(result, passwd_crypt, SIZE_CRYPT);
+		*result_length = SIZE_CRYPT;
+
+		/* clear the memory with the hash, so nobody is able to dump it. */
+		memset(passwd_crypt, 0, sizeof(passwd_crypt));
+	}
+
+	/* check if we use md5 hashing algorithm. */
+	if (encryption == PPPD_SQL_ENCRYPTION_MD5) {
+
+		/* initialize the openssl context. */
+		EVP_MD_CTX_init(&ctx_md5);
+
+		/* check if cipher initialization is working. */
+		if (EVP_DigestInit_ex(&ctx_md5, EVP_md5(), NULL) == 0) {
+
+			/* cleanup cipher context to prevent memory dumping. */
+			EVP_MD_CTX_cleanup(&ctx_md5);
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* encrypt the input buffer. */
+		if (EVP_DigestUpdate(&ctx_md5, passwd, strlen((char *)passwd)) == 0) {
+
+			/* cleanup cipher context to prevent memory dumping. */
+			EVP_MD_CTX_cleanup(&ctx_md5);
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* encrypt the last block from input buffer. */
+		if (EVP_DigestFinal_ex(&ctx_md5, result, (uint32_t *)&passwd_size) == 0) {
+
+			/* cleanup cipher context to prevent memory dumping. */
+			EVP_MD_CTX_cleanup(&ctx_md5);
+
+			/* clear the memory with the hash, so nobody is able to dump it. */
+			memset(result, 0, SIZE_MD5);
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* cleanup cipher context to prevent memory dumping. */
+		EVP_MD_CTX_cleanup(&ctx_md5);
+
+		/* store the size of the hash. */
+		*result_length = passwd_size;
+	}
+
+	/* check if we use aes block cipher algorithm. */
+	if (encryption == PPPD_SQL_ENCRYPTION_AES) {
+
+		/* check if the padded encrypted password fits into the result. */
+		if (((strlen((char *)passwd) / SIZE_AES) + 1) * SIZE_AES > SIZE_SECRET / 2) {
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* check if we have to truncate source pointer. */
+		if (strlen((char *)key) < SIZE_AES) {
+
+			/* copy the key to the static buffer. */
+			memcpy(passwd_key, key, strlen((char *)key));
+		} else {
+
+			/* copy the key to the static buffer. */
+			memcpy(passwd_key, key, SIZE_AES);
+		}
+
+		/* initialize the openssl context. */
+		EVP_CIPHER_CTX_init(&ctx_aes);
+
+		/* check if cipher initialization is working. */
+		if (EVP_EncryptInit_ex(&ctx_aes, EVP_aes_128_ecb(), NULL, passwd_key, NULL) == 0) {
+
+			/* cleanup cipher context to prevent memory dumping. */
+			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+
+			/* clear the memory with the aes key, so nobody is able to dump it. */
+			memset(passwd_key, 0, sizeof(passwd_key));
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* encrypt the input buffer. */
+		if (EVP_EncryptUpdate(&ctx_aes, result, &passwd_size, passwd, strlen((char *)passwd)) == 0) {
+
+			/* cleanup cipher context to prevent memory dumping. */
+			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+
+			/* clear the memory with the aes key and buffer, so nobody is able to dump it. */
+			memset(result, 0, SIZE_SECRET / 2);
+			memset(passwd_key, 0, sizeof(passwd_key));
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* encrypt the last block from input buffer. */
+		if (EVP_EncryptFinal_ex(&ctx_aes, result + passwd_size, &temp_size) == 0) {
+
+			/* cleanup cipher context to prevent memory dumping. */
+			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+
+			/* clear the memory with the aes key and buffer, so nobody is able to dump it. */
+			memset(result, 0, SIZE_SECRET / 2);
+			memset(passwd_key, 0, sizeof(passwd_key));
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* cleanup cipher context to prevent memory dumping. */
+		EVP_CIPHER_CTX_cleanup(&ctx_aes);
+
+		/* compute final size. */
+		*result_length = passwd_size + temp_size;
+
+		/* clear the memory with the aes key, so nobody is able to dump it. */
+		memset(passwd_key, 0, sizeof(passwd_key));
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function encode the given password as it is stored in the database. */
+int32_t pppd__encode_password(uint8_t *passwd, uint32_t encryption, uint8_t *key, uint8_t *secret_name, uint32_t secret_size) {
+
+	/* some common variables. */
+	static const uint8_t hex[] = "0123456789abcdef";
+	uint8_t passwd_encrypted[SIZE_SECRET / 2];
+	uint32_t count      = 0;
+	int32_t passwd_size = 0;
+
+	/* check if we use no algorithm, the password is stored in clear text. */
+	if (encryption == PPPD_SQL_ENCRYPTION_NONE) {
+
+		/* check if password fits into the secret. */
+		if (strlen((char *)passwd) >= secret_size) {
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* copy the password with terminator. */
+		strcpy((char *)secret_name, (char *)passwd);
+
+		/* if no error was found, return zero. */
+		return 0;
+	}
+
+	/* check if password was successfully encrypted. */
+	if (pppd__encrypt_password(passwd, encryption, key, passwd_encrypted, &passwd_size) < 0) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_PASSWORD;
+	}
+
+	/* check if hex string fits into the secret. */
+	if (passwd_size * 2 >= secret_size) {
+
+		/* clear the memory with the result, so nobody is able to dump it. */
+		memset(passwd_encrypted, 0, sizeof(passwd_encrypted));
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_PASSWORD;
+	}
+
+	/* loop through every byte and convert it to the hex string which is compared by pppd__verify_password(). */
+	for (count = 0; count < passwd_size; count++) {
+		secret_name[2 * count]     = hex[passwd_encrypted[count] >> 4];
+		secret_name[2 * count + 1] = hex[passwd_encrypted[count] & 0x0f];
+	}
+
+	/* terminate the hex string. */
+	secret_name[2 * passwd_size] = '\0';
+
+	/* clear the memory with the result, so nobody is able to dump it. */
+	memset(passwd_encrypted, 0, sizeof(passwd_encrypted));
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function verify the given password. */
+int32_t pppd__verify_password(uint8_t *passwd, uint8_t *secret_name, uint32_t encryption, uint8_t *key) {
+
+	/* some common variables. */
+	uint8_t passwd_encrypted[SIZE_SECRET / 2];
+	uint32_t count      = 0;
+	int32_t passwd_size = 0;
+
+	/* cleanup the static array, bytes behind the result are compared as zero. */
+	memset(passwd_encrypted, 0, sizeof(passwd_encrypted));
+
+	/* check if we use no algorithm. */
+	if (encryption == PPPD_SQL_ENCRYPTION_NONE) {
+
+		/* check if we found valid password. */
+		if (strcmp((char *)passwd, (char *)secret_name) != 0) {
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* if no error was found, establish link. */
+		return 0;
+	}
+
+	/* check if secret from database is shorter than an expected crypt() result. */
+	if (encryption == PPPD_SQL_ENCRYPTION_CRYPT &&
+	    strlen((char *)secret_name) < (SIZE_CRYPT * 2)) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_PASSWORD;
+	}
+
+	/* check if secret from database is shorter than an expected md5 hash. */
+	if (encryption == PPPD_SQL_ENCRYPTION_MD5 &&
+	    strlen((char *)secret_name) < (SIZE_MD5 * 2)) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_PASSWORD;
+	}
+
+	/* check if secret from database is shorter than an expected minimum aes size. */
+	if (encryption == PPPD_SQL_ENCRYPTION_AES &&
+	    strlen((char *)secret_name) < (((strlen((char *)passwd) / 16) + 1) * 16)) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_PASSWORD;
+	}
+
+	/* check if secret is longer than any result or password was not encrypted, the same code as the import tools. */
+	if (strlen((char *)secret_name) / 2 > sizeof(passwd_encrypted) ||
+	    pppd__encrypt_password(passwd, encryption, key, passwd_encrypted, &passwd_size) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_PASSWORD;
+	}
+
+	/* loop through every byte and compare it. */
+	for (count = 0; count < (strlen((char *)secret_name) / 2); count++) {
+
+		/* check if our hex value matches the result byte. (this isn't the fastest way, but okay) */
+		if (pppd__htoi(secret_name[2 * count]) * 16 + pppd__htoi(secret_name[2 * count + 1]) != passwd_encrypted[count]) {
+
+			/* clear the memory with the result, so nobody is able to dump it. */
+			memset(passwd_encrypted, 0, sizeof(passwd_encrypted));
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+	}
+
+	/* clear the memory with the result, so nobody is able to dump it. */
+	memset(passwd_encrypted, 0, sizeof(passwd_encrypted));
+
+	/* if no error was found, establish link. */
+	return 0;
+}
+
+/* this function decrypt the given password. */
+int32_t pppd__decrypt_password(uint8_t *secret_name, int32_t *secret_length, uint32_t encryption, uint8_t *key) {
+
+	/* some common variables. */
+	uint8_t passwd_aes[SIZE_SECRET / 2];
+	uint8_t passwd_key[SIZE_AES];
+	uint32_t count        = 0;
+	int32_t passwd_size   = 0;
+	int32_t temp_size     = 0;
+	EVP_CIPHER_CTX ctx_aes;
+
+	/* check if we use no algorithm. */
+	if (encryption == PPPD_SQL_ENCRYPTION_NONE ||
+	    encryption == PPPD_SQL_ENCRYPTION_CRYPT ||
+	    encryption == PPPD_SQL_ENCRYPTION_MD5) {
+
+		/* no encryption or non-symmetric algorithm used. */
+		return 0;
+	}
+
+	/* check if we use aes block cipher algorithm. */
+	if (encryption == PPPD_SQL_ENCRYPTION_AES) {
+
+		/* cleanup the static array. */
+		memset(passwd_aes, 0, sizeof(passwd_aes));
+		memset(passwd_key, 0, sizeof(passwd_key));
+
+		/* check if we have to truncate source pointer. */
+		if (strlen((char *)key) < SIZE_AES) {
+
+			/* copy the key to the static buffer. */
+			memcpy(passwd_key, key, strlen((char *)key));
+		} else {
+
+			/* copy the key to the static buffer. */
+			memcpy(passwd_key, key, SIZE_AES);
+		}
+
+		/* loop through every byte and convert it. */
+		for (count = 0; count < (*secret_length / 2); count++) {
+
+			/* create binary data for decryption. */
+			passwd_aes[count] = pppd__htoi(secret_name[2 * count]) * 16 + pppd__htoi(secret_name[2 * count + 1]);
+		}
+
+		/* initialize the openssl context. */
+		EVP_CIPHER_CTX_init(&ctx_aes);
+
+		/* check if cipher initialization is working. */
+		if (EVP_DecryptInit_ex(&ctx_aes, EVP_aes_128_ecb(), NULL, passwd_key, NULL) == 0) {
+
+			/* cleanup cipher context to prevent memory dumping. */
+			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+
+			/* clear the memory with the aes key and password, so nobody is able to dump it. */
+			memset(passwd_aes, 0, sizeof(passwd_aes));
+			memset(passwd_key, 0, sizeof(passwd_key));
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* decrypt the input buffer. */
+		if (EVP_DecryptUpdate(&ctx_aes, secret_name, &passwd_size, passwd_aes, *secret_length / 2) == 0) {
+
+			/* cleanup cipher context to prevent memory dumping. */
+			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+
+			/* clear the memory with the aes key, password and buffer, so nobody is able to dump it. */
+			memset(passwd_aes, 0, sizeof(passwd_aes));
+			memset(passwd_key, 0, sizeof(passwd_key));
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* decrypt the last block from input buffer. */
+		if (EVP_DecryptFinal_ex(&ctx_aes, secret_name + passwd_size, &temp_size) == 0) {
+
+			/* cleanup cipher context to prevent memory dumping. */
+			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+
+			/* clear the memory with the aes key, password and buffer, so nobody is able to dump it. */
+			memset(passwd_aes, 0, sizeof(passwd_aes));
+			memset(passwd_key, 0, sizeof(passwd_key));
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_PASSWORD;
+		}
+
+		/* cleanup cipher context to prevent memory dumping. */
+		EVP_CIPHER_CTX_cleanup(&ctx_aes);
+
+		/* compute final size. */
+		passwd_size += temp_size;
+
+		/* terminate the cleartext password. */
+		secret_name[passwd_size] = '\0';
+		*secret_length = passwd_size;
+
+		/* clear the memory with the aes key, password and buffer, so nobody is able to dump it. */
+		memset(passwd_aes, 0, sizeof(passwd_aes));
+		memset(passwd_key, 0, sizeof(passwd_key));
+	}
+
+	/* if no error was found, establish link. */
+	return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ *  password.h -- Password encryption and verification shared by the Point-
+ *                to-Point Protocol (PPP) plugins and the import tools.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PASSWORD_H
+#define _PASSWORD_H
+
+/* generic includes. */
+#include <stdint.h>
+
+/* openssl includes. */
+#include <openssl/des.h>
+#include <openssl/evp.h>
+
+/* this function return the password encryption algorithm of the given name. */
+int32_t pppd__encryption(
+	uint8_t		*name
+);
+
+/* this function encrypt the given password into the binary result of the algorithm. */
+int32_t pppd__encrypt_password(
+	uint8_t		*passwd,
+	uint32_t	encryption,
+	uint8_t		*key,
+	uint8_t		*result,
+	int32_t		*result_length
+);
+
+/* this function encode the given password as it is stored in the database. */
+int32_t pppd__encode_password(
+	uint8_t		*passwd,
+	uint32_t	encryption,
+	uint8_t		*key,
+	uint8_t		*secret_name,
+	uint32_t	secret_size
+);
+
+/* this function verify the given password. */
+int32_t pppd__verify_password(
+	uint8_t		*passwd,
+	uint8_t		*secret_name,
+	uint32_t	encryption,
+	uint8_t		*key
+);
+
+/* this function decrypt the given password. */
+int32_t pppd__decrypt_password(
+	uint8_t		*secret_name,
+	int32_t		*secret_length,
+	uint32_t	encryption,
+	uint8_t		*key
+);
+
+#endif					/* _PASSWORD_H */
@@ -0,0 +1,98 @@
+/*
+ *  plugin-lmdb.c -- LMDB Authentication plugin for Point-to-Point
+ *                   Protocol (PPP).
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic plugin includes. */
+#include "plugin.h"
+#include "plugin-lmdb.h"
+
+/* plugin auth includes. */
+#include "auth-lmdb.h"
+
+/* global define to indicate that plugin only works with compile time pppd. */
+uint8_t pppd_version[]			= VERSION;
+
+/* global configuration variables. */
+uint8_t *pppd_lmdb_database		= NULL;
+uint32_t pppd_lmdb_map_size		= 1073741824;
+uint8_t *pppd_lmdb_pass_encryption	= NULL;
+uint8_t *pppd_lmdb_pass_key		= NULL;
+uint32_t pppd_lmdb_status		= 0;
+uint32_t pppd_lmdb_exclusive		= 0;
+uint32_t pppd_lmdb_authoritative	= 0;
+uint8_t *pppd_lmdb_ip_up		= NULL;
+uint32_t pppd_lmdb_ip_up_fail		= 0;
+uint8_t *pppd_lmdb_ip_down		= NULL;
+uint32_t pppd_lmdb_ip_down_fail		= 0;
+uint8_t *pppd_lmdb_stats		= NULL;
+
+/* client and server ip address must be stored in global variable, because
+ * at IPCP time we no longer know the username.
+ */
+uint32_t client_ip			= 0;
+uint32_t server_ip			= 0;
+
+/* extra option structure. */
+option_t options[] = {
+	{ "lmdb-database", o_string, &pppd_lmdb_database, "Set LMDB database file" },
+	{ "lmdb-map-size", o_int, &pppd_lmdb_map_size, "Set LMDB memory map size" },
+	{ "lmdb-pass-encryption", o_string, &pppd_lmdb_pass_encryption, "Set LMDB password encryption algorithm" },
+	{ "lmdb-pass-key", o_string, &pppd_lmdb_pass_key, "Set LMDB password encryption key or salt" },
+	{ "lmdb-status", o_bool, &pppd_lmdb_status, "Set LMDB to store the login status", 0 | 1 },
+	{ "lmdb-exclusive", o_bool, &pppd_lmdb_exclusive, "Set LMDB to forbid concurrent connection from one user", 0 | 1 },
+	{ "lmdb-authoritative", o_bool, &pppd_lmdb_authoritative, "Set LMDB to be authoritative authenticator", 0 | 1 },
+	{ "lmdb-ip-up", o_string, &pppd_lmdb_ip_up, "Set LMDB script to execute when IPCP has come up" },
+	{ "lmdb-ip-up-fail", o_bool, &pppd_lmdb_ip_up_fail, "Set LMDB IPCP up script to terminate link on unsuccessful execution", 0 | 1 },
+	{ "lmdb-ip-down", o_string, &pppd_lmdb_ip_down, "Set LMDB script to execute when IPCP goes down" },
+	{ "lmdb-ip-down-fail", o_bool, &pppd_lmdb_ip_down_fail, "Set LMDB IPCP down script to terminate link on unsuccessful execution", 0 | 1 },
+	{ "lmdb-stats", o_string, &pppd_lmdb_stats, "Set LMDB shared-memory file for login latency histograms and counters" },
+	{ NULL }
+};
+
+/* plugin initilization routine. */
+void plugin_init(void) {
+
+	/* show initialization information. */
+	info("Plugin %s: pppd-sql-%s initialized, compiled pppd-%s, linked %s\n", PLUGIN_NAME_LMDB, PACKAGE_VERSION, pppd_version, mdb_version(NULL, NULL, NULL));
+
+	/* add hook for chap authentication. */
+	chap_check_hook		= pppd__chap_check;
+	chap_verify_hook	= pppd__chap_verify_lmdb;
+
+	/* add hook for pap authentication. */
+	pap_check_hook		= pppd__pap_check;
+	pap_auth_hook		= pppd__pap_auth_lmdb;
+
+	/* plugin is aware of assigning ip addresses on IPCP negotiation. */
+	ip_choose_hook		= pppd__ip_choose;
+	allowed_address_hook	= pppd__allowed_address;
+
+	/* add ip notifiers. */
+	add_notifier(&ip_up_notifier, pppd__lmdb_up, NULL);
+	add_notifier(&ip_down_notifier, pppd__lmdb_down, NULL);
+
+	/* add phase notifier, it validates the options once they are complete. */
+	add_notifier(&phasechange, pppd__lmdb_phase, NULL);
+
+	/* add exit notifier, it closes the database. */
+	add_notifier(&exitnotify, pppd__lmdb_exit, NULL);
+
+	/* point extra options to our array. */
+	add_options(options);
+}
@@ -0,0 +1,63 @@
+/*
+ *  plugin-lmdb.h -- LMDB Authentication plugin for Point-to-Point
+ *                   Protocol (PPP).
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PLUGIN_LMDB_H
+#define _PLUGIN_LMDB_H
+
+/* generic includes. */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+/* lmdb includes. */
+#include <lmdb.h>
+
+/* plugin includes. */
+#include "record.h"
+
+/* global define to indicate that plugin only works with compile time pppd. */
+extern uint8_t pppd_version[];
+
+/* global configuration variables. */
+extern uint8_t *pppd_lmdb_database;
+extern uint32_t pppd_lmdb_map_size;
+extern uint8_t *pppd_lmdb_pass_encryption;
+extern uint8_t *pppd_lmdb_pass_key;
+extern uint32_t pppd_lmdb_status;
+extern uint32_t pppd_lmdb_exclusive;
+extern uint32_t pppd_lmdb_authoritative;
+extern uint8_t *pppd_lmdb_ip_up;
+extern uint32_t pppd_lmdb_ip_up_fail;
+extern uint8_t *pppd_lmdb_ip_down;
+extern uint32_t pppd_lmdb_ip_down_fail;
+extern uint8_t *pppd_lmdb_stats;
+
+/* extra option structure. */
+extern option_t options[];
+
+/* plugin initialization routine. */
+void plugin_init(
+	void
+);
+
+#endif					/* _PLUGIN_LMDB_H */
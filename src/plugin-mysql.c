@@ -20,6 +20,8 @@
 
 /* generic plugin includes. */
 #include "plugin.h"
+#include "journal.h"
+#include "registry.h"
 #include "plugin-mysql.h"
 
 /* plugin auth includes. */
@@ -54,6 +56,39 @@ uint8_t *pppd_mysql_ip_up		= NULL;
 uint32_t pppd_mysql_ip_up_fail		= 0;
 uint8_t *pppd_mysql_ip_down		= NULL;
 uint32_t pppd_mysql_ip_down_fail	= 0;
+uint8_t *pppd_mysql_accounting_table	= NULL;
+uint8_t *pppd_mysql_column_bytes_received	= NULL;
+uint8_t *pppd_mysql_column_bytes_transmitted	= NULL;
+uint8_t *pppd_mysql_column_duration	= NULL;
+uint8_t *pppd_mysql_column_session	= NULL;
+uint32_t pppd_mysql_interim_interval	= 0;
+uint8_t *pppd_mysql_journal		= NULL;
+uint8_t *pppd_mysql_stats		= NULL;
+uint32_t pppd_mysql_slow_connect	= 0;
+uint32_t pppd_mysql_slow_query	= 0;
+uint32_t pppd_mysql_slow_status	= 0;
+uint32_t pppd_mysql_slow_script	= 0;
+uint8_t *pppd_mysql_server_id		= NULL;
+uint8_t *pppd_mysql_column_server_id	= NULL;
+uint8_t *pppd_mysql_registry		= (uint8_t *)"/var/run/pppd-mysql";
+uint32_t pppd_mysql_reconcile_interval	= 300;
+uint8_t *pppd_mysql_session_table		= NULL;
+uint8_t *pppd_mysql_column_expires		= NULL;
+uint32_t pppd_mysql_lease_time		= 300;
+uint8_t *pppd_mysql_pool_table		= NULL;
+uint8_t *pppd_mysql_column_pool_ip		= NULL;
+uint8_t *pppd_mysql_column_pool_session	= NULL;
+uint8_t *pppd_mysql_pool_file		= NULL;
+uint8_t *pppd_mysql_pool_range		= NULL;
+uint8_t *pppd_mysql_column_attributes	= NULL;
+uint8_t *pppd_mysql_column_rate_down	= NULL;
+uint8_t *pppd_mysql_column_rate_up		= NULL;
+uint8_t *pppd_mysql_nft_table		= NULL;
+uint8_t *pppd_mysql_column_nft_set		= NULL;
+uint8_t *pppd_mysql_column_framed_routes	= NULL;
+uint32_t pppd_mysql_check_plan		= 0;
+uint8_t *pppd_mysql_shards		= NULL;
+uint8_t *pppd_mysql_realms		= NULL;
 
 /* client and server ip address must be stored in global variable, because
  * at IPCP time we no longer know the username.
@@ -88,6 +123,39 @@ option_t options[] = {
 	{ "mysql-ip-up-fail", o_bool, &pppd_mysql_ip_up_fail, "Set MySQL IPCP up script to terminate link on unsuccessful execution", 0 | 1 },
 	{ "mysql-ip-down", o_string, &pppd_mysql_ip_down, "Set MySQL script to execute when IPCP goes down" },
 	{ "mysql-ip-down-fail", o_bool, &pppd_mysql_ip_down_fail, "Set MySQL IPCP down script to terminate link on unsuccessful execution", 0 | 1 },
+	{ "mysql-accounting-table", o_string, &pppd_mysql_accounting_table, "Set MySQL accounting table" },
+	{ "mysql-column-bytes-received", o_string, &pppd_mysql_column_bytes_received, "Set MySQL received bytes field" },
+	{ "mysql-column-bytes-transmitted", o_string, &pppd_mysql_column_bytes_transmitted, "Set MySQL transmitted bytes field" },
+	{ "mysql-column-duration", o_string, &pppd_mysql_column_duration, "Set MySQL link duration field" },
+	{ "mysql-column-session", o_string, &pppd_mysql_column_session, "Set MySQL session identifier field" },
+	{ "mysql-interim-interval", o_int, &pppd_mysql_interim_interval, "Set MySQL interim accounting update interval" },
+	{ "mysql-journal", o_string, &pppd_mysql_journal, "Set MySQL write-behind journal for status and accounting updates" },
+	{ "mysql-stats", o_string, &pppd_mysql_stats, "Set MySQL shared-memory file for login latency histograms and counters" },
+	{ "mysql-slow-connect", o_int, &pppd_mysql_slow_connect, "Set MySQL milliseconds after which a connect is logged as slow" },
+	{ "mysql-slow-query", o_int, &pppd_mysql_slow_query, "Set MySQL milliseconds after which a password query is logged as slow" },
+	{ "mysql-slow-status", o_int, &pppd_mysql_slow_status, "Set MySQL milliseconds after which a status update is logged as slow" },
+	{ "mysql-slow-script", o_int, &pppd_mysql_slow_script, "Set MySQL milliseconds after which an up or down script is logged as slow" },
+	{ "mysql-server-id", o_string, &pppd_mysql_server_id, "Set MySQL identifier of this server for login status ownership" },
+	{ "mysql-column-server-id", o_string, &pppd_mysql_column_server_id, "Set MySQL server identifier field" },
+	{ "mysql-registry", o_string, &pppd_mysql_registry, "Set MySQL directory of the running session registry" },
+	{ "mysql-reconcile-interval", o_int, &pppd_mysql_reconcile_interval, "Set MySQL stale login status reconciliation interval" },
+	{ "mysql-session-table", o_string, &pppd_mysql_session_table, "Set MySQL sessions table for online state leases" },
+	{ "mysql-column-expires", o_string, &pppd_mysql_column_expires, "Set MySQL lease expiry field" },
+	{ "mysql-lease-time", o_int, &pppd_mysql_lease_time, "Set MySQL lease time" },
+	{ "mysql-pool-table", o_string, &pppd_mysql_pool_table, "Set MySQL client ip address pool table" },
+	{ "mysql-column-pool-ip", o_string, &pppd_mysql_column_pool_ip, "Set MySQL pool ip address field" },
+	{ "mysql-column-pool-session", o_string, &pppd_mysql_column_pool_session, "Set MySQL pool session identifier field" },
+	{ "mysql-pool-file", o_string, &pppd_mysql_pool_file, "Set MySQL host-local client ip address pool file" },
+	{ "mysql-pool-range", o_string, &pppd_mysql_pool_range, "Set MySQL host-local client ip address pool range" },
+	{ "mysql-column-attributes", o_string, &pppd_mysql_column_attributes, "Set MySQL session attribute fields" },
+	{ "mysql-column-rate-down", o_string, &pppd_mysql_column_rate_down, "Set MySQL download rate attribute field" },
+	{ "mysql-column-rate-up", o_string, &pppd_mysql_column_rate_up, "Set MySQL upload rate attribute field" },
+	{ "mysql-nft-table", o_string, &pppd_mysql_nft_table, "Set MySQL nftables family and table of the client address sets" },
+	{ "mysql-column-nft-set", o_string, &pppd_mysql_column_nft_set, "Set MySQL nftables sets attribute field" },
+	{ "mysql-column-framed-routes", o_string, &pppd_mysql_column_framed_routes, "Set MySQL framed routes attribute field" },
+	{ "mysql-check-plan", o_bool, &pppd_mysql_check_plan, "Set MySQL to warn at startup if the password query does not use an index", 0 | 1 },
+	{ "mysql-shards", o_string, &pppd_mysql_shards, "Set MySQL shards of the authentication table, selected by a hash of the username" },
+	{ "mysql-realms", o_string, &pppd_mysql_realms, "Set MySQL realm file, which routes user@realm logins to their own database" },
 	{ NULL }
 };
 
@@ -113,6 +181,12 @@ void plugin_init(void) {
 	add_notifier(&ip_up_notifier, pppd__mysql_up, NULL);
 	add_notifier(&ip_down_notifier, pppd__mysql_down, NULL);
 
+	/* add phase notifier, it runs the startup tasks once options are complete. */
+	add_notifier(&phasechange, pppd__mysql_phase, NULL);
+
+	/* add exit notifier. */
+	add_notifier(&exitnotify, pppd__mysql_exit, NULL);
+
 	/* point extra options to our array. */
 	add_options(options);
 }
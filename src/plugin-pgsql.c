@@ -20,6 +20,8 @@
 
 /* generic plugin includes. */
 #include "plugin.h"
+#include "journal.h"
+#include "registry.h"
 #include "plugin-pgsql.h"
 
 /* plugin auth includes. */
@@ -54,6 +56,39 @@ uint8_t *pppd_pgsql_ip_up		= NULL;
 uint32_t pppd_pgsql_ip_up_fail		= 0;
 uint8_t *pppd_pgsql_ip_down		= NULL;
 uint32_t pppd_pgsql_ip_down_fail	= 0;
+uint8_t *pppd_pgsql_accounting_table	= NULL;
+uint8_t *pppd_pgsql_column_bytes_received	= NULL;
+uint8_t *pppd_pgsql_column_bytes_transmitted	= NULL;
+uint8_t *pppd_pgsql_column_duration	= NULL;
+uint8_t *pppd_pgsql_column_session	= NULL;
+uint32_t pppd_pgsql_interim_interval	= 0;
+uint8_t *pppd_pgsql_journal		= NULL;
+uint8_t *pppd_pgsql_stats		= NULL;
+uint32_t pppd_pgsql_slow_connect	= 0;
+uint32_t pppd_pgsql_slow_query	= 0;
+uint32_t pppd_pgsql_slow_status	= 0;
+uint32_t pppd_pgsql_slow_script	= 0;
+uint8_t *pppd_pgsql_server_id		= NULL;
+uint8_t *pppd_pgsql_column_server_id	= NULL;
+uint8_t *pppd_pgsql_registry		= (uint8_t *)"/var/run/pppd-pgsql";
+uint32_t pppd_pgsql_reconcile_interval	= 300;
+uint8_t *pppd_pgsql_session_table		= NULL;
+uint8_t *pppd_pgsql_column_expires		= NULL;
+uint32_t pppd_pgsql_lease_time		= 300;
+uint8_t *pppd_pgsql_pool_table		= NULL;
+uint8_t *pppd_pgsql_column_pool_ip		= NULL;
+uint8_t *pppd_pgsql_column_pool_session	= NULL;
+uint8_t *pppd_pgsql_pool_file		= NULL;
+uint8_t *pppd_pgsql_pool_range		= NULL;
+uint8_t *pppd_pgsql_column_attributes	= NULL;
+uint8_t *pppd_pgsql_column_rate_down	= NULL;
+uint8_t *pppd_pgsql_column_rate_up		= NULL;
+uint8_t *pppd_pgsql_nft_table		= NULL;
+uint8_t *pppd_pgsql_column_nft_set		= NULL;
+uint8_t *pppd_pgsql_column_framed_routes	= NULL;
+uint32_t pppd_pgsql_check_plan		= 0;
+uint8_t *pppd_pgsql_shards		= NULL;
+uint8_t *pppd_pgsql_realms		= NULL;
 
 /* client and server ip address must be stored in global variable, because
  * at IPCP time we no longer know the username.
@@ -88,6 +123,39 @@ option_t options[] = {
 	{ "pgsql-ip-up-fail", o_bool, &pppd_pgsql_ip_up_fail, "Set PostgreSQL IPCP up script to terminate link on unsuccessful execution", 0 | 1 },
 	{ "pgsql-ip-down", o_string, &pppd_pgsql_ip_down, "Set PostgreSQL script to execute when IPCP goes down" },
 	{ "pgsql-ip-down-fail", o_bool, &pppd_pgsql_ip_down_fail, "Set PostgreSQL IPCP down script to terminate link on unsuccessful execution", 0 | 1 },
+	{ "pgsql-accounting-table", o_string, &pppd_pgsql_accounting_table, "Set PostgreSQL accounting table" },
+	{ "pgsql-column-bytes-received", o_string, &pppd_pgsql_column_bytes_received, "Set PostgreSQL received bytes field" },
+	{ "pgsql-column-bytes-transmitted", o_string, &pppd_pgsql_column_bytes_transmitted, "Set PostgreSQL transmitted bytes field" },
+	{ "pgsql-column-duration", o_string, &pppd_pgsql_column_duration, "Set PostgreSQL link duration field" },
+	{ "pgsql-column-session", o_string, &pppd_pgsql_column_session, "Set PostgreSQL session identifier field" },
+	{ "pgsql-interim-interval", o_int, &pppd_pgsql_interim_interval, "Set PostgreSQL interim accounting update interval" },
+	{ "pgsql-journal", o_string, &pppd_pgsql_journal, "Set PostgreSQL write-behind journal for status and accounting updates" },
+	{ "pgsql-stats", o_string, &pppd_pgsql_stats, "Set PostgreSQL shared-memory file for login latency histograms and counters" },
+	{ "pgsql-slow-connect", o_int, &pppd_pgsql_slow_connect, "Set PostgreSQL milliseconds after which a connect is logged as slow" },
+	{ "pgsql-slow-query", o_int, &pppd_pgsql_slow_query, "Set PostgreSQL milliseconds after which a password query is logged as slow" },
+	{ "pgsql-slow-status", o_int, &pppd_pgsql_slow_status, "Set PostgreSQL milliseconds after which a status update is logged as slow" },
+	{ "pgsql-slow-script", o_int, &pppd_pgsql_slow_script, "Set PostgreSQL milliseconds after which an up or down script is logged as slow" },
+	{ "pgsql-server-id", o_string, &pppd_pgsql_server_id, "Set PostgreSQL identifier of this server for login status ownership" },
+	{ "pgsql-column-server-id", o_string, &pppd_pgsql_column_server_id, "Set PostgreSQL server identifier field" },
+	{ "pgsql-registry", o_string, &pppd_pgsql_registry, "Set PostgreSQL directory of the running session registry" },
+	{ "pgsql-reconcile-interval", o_int, &pppd_pgsql_reconcile_interval, "Set PostgreSQL stale login status reconciliation interval" },
+	{ "pgsql-session-table", o_string, &pppd_pgsql_session_table, "Set PostgreSQL sessions table for online state leases" },
+	{ "pgsql-column-expires", o_string, &pppd_pgsql_column_expires, "Set PostgreSQL lease expiry field" },
+	{ "pgsql-lease-time", o_int, &pppd_pgsql_lease_time, "Set PostgreSQL lease time" },
+	{ "pgsql-pool-table", o_string, &pppd_pgsql_pool_table, "Set PostgreSQL client ip address pool table" },
+	{ "pgsql-column-pool-ip", o_string, &pppd_pgsql_column_pool_ip, "Set PostgreSQL pool ip address field" },
+	{ "pgsql-column-pool-session", o_string, &pppd_pgsql_column_pool_session, "Set PostgreSQL pool session identifier field" },
+	{ "pgsql-pool-file", o_string, &pppd_pgsql_pool_file, "Set PostgreSQL host-local client ip address pool file" },
+	{ "pgsql-pool-range", o_string, &pppd_pgsql_pool_range, "Set PostgreSQL host-local client ip address pool range" },
+	{ "pgsql-column-attributes", o_string, &pppd_pgsql_column_attributes, "Set PostgreSQL session attribute fields" },
+	{ "pgsql-column-rate-down", o_string, &pppd_pgsql_column_rate_down, "Set PostgreSQL download rate attribute field" },
+	{ "pgsql-column-rate-up", o_string, &pppd_pgsql_column_rate_up, "Set PostgreSQL upload rate attribute field" },
+	{ "pgsql-nft-table", o_string, &pppd_pgsql_nft_table, "Set PostgreSQL nftables family and table of the client address sets" },
+	{ "pgsql-column-nft-set", o_string, &pppd_pgsql_column_nft_set, "Set PostgreSQL nftables sets attribute field" },
+	{ "pgsql-column-framed-routes", o_string, &pppd_pgsql_column_framed_routes, "Set PostgreSQL framed routes attribute field" },
+	{ "pgsql-check-plan", o_bool, &pppd_pgsql_check_plan, "Set PostgreSQL to warn at startup if the password query does not use an index", 0 | 1 },
+	{ "pgsql-shards", o_string, &pppd_pgsql_shards, "Set PostgreSQL shards of the authentication table, selected by a hash of the username" },
+	{ "pgsql-realms", o_string, &pppd_pgsql_realms, "Set PostgreSQL realm file, which routes user@realm logins to their own database" },
 	{ NULL }
 };
 
@@ -113,6 +181,12 @@ void plugin_init(void) {
 	add_notifier(&ip_up_notifier, pppd__pgsql_up, NULL);
 	add_notifier(&ip_down_notifier, pppd__pgsql_down, NULL);
 
+	/* add phase notifier, it runs the startup tasks once options are complete. */
+	add_notifier(&phasechange, pppd__pgsql_phase, NULL);
+
+	/* add exit notifier. */
+	add_notifier(&exitnotify, pppd__pgsql_exit, NULL);
+
 	/* point extra options to our array. */
 	add_options(options);
 }
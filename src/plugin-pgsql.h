@@ -61,6 +61,39 @@ extern uint8_t *pppd_pgsql_ip_up;
 extern uint32_t pppd_pgsql_ip_up_fail;
 extern uint8_t *pppd_pgsql_ip_down;
 extern uint32_t pppd_pgsql_ip_down_fail;
+extern uint8_t *pppd_pgsql_accounting_table;
+extern uint8_t *pppd_pgsql_column_bytes_received;
+extern uint8_t *pppd_pgsql_column_bytes_transmitted;
+extern uint8_t *pppd_pgsql_column_duration;
+extern uint8_t *pppd_pgsql_column_session;
+extern uint32_t pppd_pgsql_interim_interval;
+extern uint8_t *pppd_pgsql_journal;
+extern uint8_t *pppd_pgsql_stats;
+extern uint32_t pppd_pgsql_slow_connect;
+extern uint32_t pppd_pgsql_slow_query;
+extern uint32_t pppd_pgsql_slow_status;
+extern uint32_t pppd_pgsql_slow_script;
+extern uint8_t *pppd_pgsql_server_id;
+extern uint8_t *pppd_pgsql_column_server_id;
+extern uint8_t *pppd_pgsql_registry;
+extern uint32_t pppd_pgsql_reconcile_interval;
+extern uint8_t *pppd_pgsql_session_table;
+extern uint8_t *pppd_pgsql_column_expires;
+extern uint32_t pppd_pgsql_lease_time;
+extern uint8_t *pppd_pgsql_pool_table;
+extern uint8_t *pppd_pgsql_column_pool_ip;
+extern uint8_t *pppd_pgsql_column_pool_session;
+extern uint8_t *pppd_pgsql_pool_file;
+extern uint8_t *pppd_pgsql_pool_range;
+extern uint8_t *pppd_pgsql_column_attributes;
+extern uint8_t *pppd_pgsql_column_rate_down;
+extern uint8_t *pppd_pgsql_column_rate_up;
+extern uint8_t *pppd_pgsql_nft_table;
+extern uint8_t *pppd_pgsql_column_nft_set;
+extern uint8_t *pppd_pgsql_column_framed_routes;
+extern uint32_t pppd_pgsql_check_plan;
+extern uint8_t *pppd_pgsql_shards;
+extern uint8_t *pppd_pgsql_realms;
 
 /* extra option structure. */
 extern option_t options[];
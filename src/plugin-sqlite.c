@@ -0,0 +1,132 @@
+/*
+ *  plugin-sqlite.c -- SQLite Authentication plugin for Point-to-Point
+ *                     Protocol (PPP).
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic plugin includes. */
+#include "plugin.h"
+#include "plugin-sqlite.h"
+
+/* plugin auth includes. */
+#include "auth-sqlite.h"
+
+/* global define to indicate that plugin only works with compile time pppd. */
+uint8_t pppd_version[]			= VERSION;
+
+/* global configuration variables. */
+uint8_t *pppd_sqlite_database		= NULL;
+uint8_t *pppd_sqlite_pass_encryption	= NULL;
+uint8_t *pppd_sqlite_pass_key		= NULL;
+uint8_t *pppd_sqlite_table		= NULL;
+uint8_t *pppd_sqlite_column_user	= NULL;
+uint8_t *pppd_sqlite_column_pass	= NULL;
+uint8_t *pppd_sqlite_column_client_ip	= NULL;
+uint8_t *pppd_sqlite_column_server_ip	= NULL;
+uint8_t *pppd_sqlite_column_update	= NULL;
+uint8_t *pppd_sqlite_condition		= NULL;
+uint32_t pppd_sqlite_exclusive		= 0;
+uint32_t pppd_sqlite_authoritative	= 0;
+uint32_t pppd_sqlite_ignore_multiple	= 0;
+uint32_t pppd_sqlite_ignore_null	= 0;
+uint32_t pppd_sqlite_busy_timeout	= 5000;
+uint32_t pppd_sqlite_mmap_size		= 268435456;
+uint32_t pppd_sqlite_retry_query	= 5;
+uint8_t *pppd_sqlite_ip_up		= NULL;
+uint32_t pppd_sqlite_ip_up_fail		= 0;
+uint8_t *pppd_sqlite_ip_down		= NULL;
+uint32_t pppd_sqlite_ip_down_fail	= 0;
+uint8_t *pppd_sqlite_column_attributes	= NULL;
+uint8_t *pppd_sqlite_column_rate_down	= NULL;
+uint8_t *pppd_sqlite_column_rate_up	= NULL;
+uint8_t *pppd_sqlite_nft_table		= NULL;
+uint8_t *pppd_sqlite_column_nft_set	= NULL;
+uint8_t *pppd_sqlite_column_framed_routes	= NULL;
+uint32_t pppd_sqlite_check_plan		= 0;
+uint8_t *pppd_sqlite_stats		= NULL;
+
+/* client and server ip address must be stored in global variable, because
+ * at IPCP time we no longer know the username.
+ */
+uint32_t client_ip			= 0;
+uint32_t server_ip			= 0;
+
+/* extra option structure. */
+option_t options[] = {
+	{ "sqlite-database", o_string, &pppd_sqlite_database, "Set SQLite database file" },
+	{ "sqlite-pass-encryption", o_string, &pppd_sqlite_pass_encryption, "Set SQLite password encryption algorithm" },
+	{ "sqlite-pass-key", o_string, &pppd_sqlite_pass_key, "Set SQLite password encryption key or salt" },
+	{ "sqlite-table", o_string, &pppd_sqlite_table, "Set SQLite authentication table" },
+	{ "sqlite-column-user", o_string, &pppd_sqlite_column_user, "Set SQLite username field" },
+	{ "sqlite-column-pass", o_string, &pppd_sqlite_column_pass, "Set SQLite password field" },
+	{ "sqlite-column-client-ip", o_string, &pppd_sqlite_column_client_ip, "Set SQLite client ip address field" },
+	{ "sqlite-column-server-ip", o_string, &pppd_sqlite_column_server_ip, "Set SQLite server ip address field" },
+	{ "sqlite-column-update", o_string, &pppd_sqlite_column_update, "Set SQLite update field" },
+	{ "sqlite-condition", o_string, &pppd_sqlite_condition, "Set SQLite condition clause" },
+	{ "sqlite-exclusive", o_bool, &pppd_sqlite_exclusive, "Set SQLite to forbid concurrent connection from one user", 0 | 1 },
+	{ "sqlite-authoritative", o_bool, &pppd_sqlite_authoritative, "Set SQLite to be authoritative authenticator", 0 | 1 },
+	{ "sqlite-ignore-multiple", o_bool, &pppd_sqlite_ignore_multiple, "Set SQLite to cover first row from multiple rows", 0 | 1 },
+	{ "sqlite-ignore-null", o_bool, &pppd_sqlite_ignore_null, "Set SQLite to cover NULL results as string", 0 | 1 },
+	{ "sqlite-busy-timeout", o_int, &pppd_sqlite_busy_timeout, "Set SQLite busy timeout in milliseconds" },
+	{ "sqlite-mmap-size", o_int, &pppd_sqlite_mmap_size, "Set SQLite memory mapped size" },
+	{ "sqlite-retry-query", o_int, &pppd_sqlite_retry_query, "Set SQLite query retries" },
+	{ "sqlite-ip-up", o_string, &pppd_sqlite_ip_up, "Set SQLite script to execute when IPCP has come up" },
+	{ "sqlite-ip-up-fail", o_bool, &pppd_sqlite_ip_up_fail, "Set SQLite IPCP up script to terminate link on unsuccessful execution", 0 | 1 },
+	{ "sqlite-ip-down", o_string, &pppd_sqlite_ip_down, "Set SQLite script to execute when IPCP goes down" },
+	{ "sqlite-ip-down-fail", o_bool, &pppd_sqlite_ip_down_fail, "Set SQLite IPCP down script to terminate link on unsuccessful execution", 0 | 1 },
+	{ "sqlite-column-attributes", o_string, &pppd_sqlite_column_attributes, "Set SQLite session attribute fields" },
+	{ "sqlite-column-rate-down", o_string, &pppd_sqlite_column_rate_down, "Set SQLite download rate attribute field" },
+	{ "sqlite-column-rate-up", o_string, &pppd_sqlite_column_rate_up, "Set SQLite upload rate attribute field" },
+	{ "sqlite-nft-table", o_string, &pppd_sqlite_nft_table, "Set SQLite nftables family and table of the client address sets" },
+	{ "sqlite-column-nft-set", o_string, &pppd_sqlite_column_nft_set, "Set SQLite nftables sets attribute field" },
+	{ "sqlite-column-framed-routes", o_string, &pppd_sqlite_column_framed_routes, "Set SQLite framed routes attribute field" },
+	{ "sqlite-check-plan", o_bool, &pppd_sqlite_check_plan, "Set SQLite to warn at startup if the password query does not use an index", 0 | 1 },
+	{ "sqlite-stats", o_string, &pppd_sqlite_stats, "Set SQLite shared-memory file for login latency histograms and counters" },
+	{ NULL }
+};
+
+/* plugin initilization routine. */
+void plugin_init(void) {
+
+	/* show initialization information. */
+	info("Plugin %s: pppd-sql-%s initialized, compiled pppd-%s, linked sqlite-%s\n", PLUGIN_NAME_SQLITE, PACKAGE_VERSION, pppd_version, sqlite3_libversion());
+
+	/* add hook for chap authentication. */
+	chap_check_hook		= pppd__chap_check;
+	chap_verify_hook	= pppd__chap_verify_sqlite;
+
+	/* add hook for pap authentication. */
+	pap_check_hook		= pppd__pap_check;
+	pap_auth_hook		= pppd__pap_auth_sqlite;
+
+	/* plugin is aware of assigning ip addresses on IPCP negotiation. */
+	ip_choose_hook		= pppd__ip_choose;
+	allowed_address_hook	= pppd__allowed_address;
+
+	/* add ip notifiers. */
+	add_notifier(&ip_up_notifier, pppd__sqlite_up, NULL);
+	add_notifier(&ip_down_notifier, pppd__sqlite_down, NULL);
+
+	/* add phase notifier, it builds the plan once options are complete. */
+	add_notifier(&phasechange, pppd__sqlite_phase, NULL);
+
+	/* add exit notifier, it closes the database. */
+	add_notifier(&exitnotify, pppd__sqlite_exit, NULL);
+
+	/* point extra options to our array. */
+	add_options(options);
+}
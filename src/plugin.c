@@ -20,8 +20,21 @@
 
 /* plugin includes. */
 #include "plugin.h"
+#include "netlink.h"
+#include "radix.h"
+#include "stats.h"
 #include "str.h"
 
+/* session attributes fetched with the credentials. */
+struct pppd_attribute attributes[SIZE_ATTRIBUTES];
+uint32_t attributes_count		= 0;
+
+/* session identifier, start time, the counters at start and the counters already written to database. */
+uint8_t session_id[SIZE_SESSION];
+time_t session_start			= 0;
+struct pppd_stats session_origin;
+struct pppd_stats session_stats;
+
 /* this function set whether the peer must authenticate itself to us via CHAP. */
 int32_t pppd__chap_check(void) {
 
@@ -49,8 +62,9 @@ void pppd__ip_choose(uint32_t *addrp) {
 /* this function set whether the plugin is allowed to set client ip addresses. */
 int32_t pppd__allowed_address(uint32_t addr) {
 
-	/* check if ip address is equal to client address from database. */
-	if (addr != client_ip) {
+	/* check if ip address is equal to client address from database or inside a framed route. */
+	if (addr != client_ip &&
+	    pppd__radix_lookup(&framed_routes, ntohl(addr)) == 0) {
 
 		/* seems that we are using an invalid ip address. */
 		return 0;
@@ -60,6 +74,71 @@ int32_t pppd__allowed_address(uint32_t addr) {
 	return 1;
 }
 
+/* this function convert a fetched ip address column into an address in network byte order. */
+int32_t pppd__address(uint8_t *value, uint32_t length, uint32_t format, uint32_t *address) {
+
+	/* some common variables. */
+	uint8_t *end = NULL;
+	unsigned long number = 0;
+
+	/* check if address is a number, it is stored in host byte order of the database. */
+	if (format == PPPD_SQL_ADDRESS_NUMBER) {
+
+		/* convert the decimal string. */
+		errno  = 0;
+		number = strtoul((char *)value, (char **)&end, 10);
+
+		/* check if number is valid and fits into an address. */
+		if (errno != 0 || end == value || *end != '\0' || number > 0xffffffffUL) {
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_QUERY;
+		}
+
+		/* store address in network byte order. */
+		*address = htonl((uint32_t)number);
+
+		/* if no error was found, return zero. */
+		return 0;
+	}
+
+	/* check if address is binary, it is already in network byte order. */
+	if (format == PPPD_SQL_ADDRESS_BYTES) {
+
+		/* check if address is an IPv4-mapped IPv6 address, the IPv4 address is the last four bytes. */
+		if (length == 16 &&
+		    memcmp(value, "\0\0\0\0\0\0\0\0\0\0\xff\xff", 12) == 0) {
+
+			/* skip the prefix. */
+			value  += 12;
+			length -= 12;
+		}
+
+		/* check if address has the size of an IPv4 address. */
+		if (length != 4) {
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_QUERY;
+		}
+
+		/* copy address, the value may be unaligned. */
+		memcpy(address, value, 4);
+
+		/* if no error was found, return zero. */
+		return 0;
+	}
+
+	/* check if ip address was successfully converted into binary data. */
+	if (inet_aton((char *)value, (struct in_addr *)address) == 0) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
 /* this function will execute a script when IPCP comes up. */
 int32_t pppd__ip_up(uint8_t *username, uint8_t *program) {
 
@@ -70,12 +149,16 @@ int32_t pppd__ip_up(uint8_t *username, uint8_t *program) {
 	uint8_t *argv[9];
 	int32_t script_status;
 	pid_t script_pid;
+	struct timespec script_start;
 
 	/* create the parameters. */
 	slprintf((char *)strspeed, sizeof(strspeed), "%d", baud_rate);
 	slprintf((char *)strlocal, sizeof(strlocal), "%I", ipcp_gotoptions[0].ouraddr);
 	slprintf((char *)strremote, sizeof(strremote), "%I", ipcp_hisoptions[0].hisaddr);
 
+	/* export session attributes, so the script does not need to query the database. */
+	pppd__attribute_export();
+
 	/* build argument list. */
 	argv[0] = program;
 	argv[1] = (uint8_t *)ifname;
@@ -87,12 +170,18 @@ int32_t pppd__ip_up(uint8_t *username, uint8_t *program) {
 	argv[7] = username;
 	argv[8] = NULL;
 
+	/* start the timer of the script. */
+	pppd__stats_start(PPPD_STATS_SCRIPT, username, &script_start);
+
 	/* execute script. */
 	script_pid = run_program((char *)program, (char **)argv, 0, NULL, NULL, 0);
 
 	/* check if file exists and fork was successful. */
 	if (script_pid <= 0) {
 
+		/* record the failed script. */
+		pppd__stats_stop(PPPD_STATS_SCRIPT, username, PPPD_SQL_ERROR_SCRIPT, &script_start);
+
 		/* something failed on script execution. */
 		return PPPD_SQL_ERROR_SCRIPT;
 	}
@@ -106,6 +195,9 @@ int32_t pppd__ip_up(uint8_t *username, uint8_t *program) {
 		}
 	}
 
+	/* record the time and the result of the script, the link waits for it. */
+	pppd__stats_stop(PPPD_STATS_SCRIPT, username, WEXITSTATUS(script_status) != 0 ? PPPD_SQL_ERROR_SCRIPT : 0, &script_start);
+
 	/* check if script execution was successful. */
 	if (WEXITSTATUS(script_status) != 0) {
 
@@ -130,6 +222,7 @@ int32_t pppd__ip_down(uint8_t *username, uint8_t *program) {
 	uint8_t *argv[12];
 	int32_t script_status;
 	pid_t script_pid;
+	struct timespec script_start;
 
 	/* create the parameters. */
 	slprintf((char *)str_speed, sizeof(str_speed), "%d", baud_rate);
@@ -139,6 +232,9 @@ int32_t pppd__ip_down(uint8_t *username, uint8_t *program) {
 	slprintf((char *)str_bytes_transmitted, sizeof(str_bytes_transmitted), "%d", link_stats.bytes_out);
 	slprintf((char *)str_duration, sizeof(str_duration), "%d", link_connect_time);
 
+	/* export session attributes, so the script does not need to query the database. */
+	pppd__attribute_export();
+
 	/* build argument list. */
 	argv[0] = program;
 	argv[1] = (uint8_t *)ifname;
@@ -153,12 +249,18 @@ int32_t pppd__ip_down(uint8_t *username, uint8_t *program) {
 	argv[10] = str_duration;
 	argv[11] = NULL;
 
+	/* start the timer of the script. */
+	pppd__stats_start(PPPD_STATS_SCRIPT, username, &script_start);
+
 	/* execute script. */
 	script_pid = run_program((char *)program, (char **)argv, 0, NULL, NULL, 0);
 
 	/* check if file exists and fork was successful. */
 	if (script_pid <= 0) {
 
+		/* record the failed script. */
+		pppd__stats_stop(PPPD_STATS_SCRIPT, username, PPPD_SQL_ERROR_SCRIPT, &script_start);
+
 		/* something failed on script execution. */
 		return PPPD_SQL_ERROR_SCRIPT;
 	}
@@ -172,6 +274,9 @@ int32_t pppd__ip_down(uint8_t *username, uint8_t *program) {
 		}
 	}
 
+	/* record the time and the result of the script, the link waits for it. */
+	pppd__stats_stop(PPPD_STATS_SCRIPT, username, WEXITSTATUS(script_status) != 0 ? PPPD_SQL_ERROR_SCRIPT : 0, &script_start);
+
 	/* check if script execution was successful. */
 	if (WEXITSTATUS(script_status) != 0) {
 
@@ -183,336 +288,307 @@ int32_t pppd__ip_down(uint8_t *username, uint8_t *program) {
 	return 0;
 };
 
-/* this function verify the given password. */
-int32_t pppd__verify_password(uint8_t *passwd, uint8_t *secret_name, uint8_t *encryption, uint8_t *key) {
+/* this function remove all session attributes. */
+int32_t pppd__attribute_clear(void) {
 
-	/* some common variables. */
-	uint8_t passwd_aes[MAXSECRETLEN / 2];
-	uint8_t passwd_key[SIZE_AES];
-	uint8_t passwd_md5[SIZE_MD5];
-	uint8_t passwd_crypt[SIZE_CRYPT];
-	uint32_t count      = 0;
-	int32_t passwd_size = 0;
-	int32_t temp_size   = 0;
-	EVP_MD_CTX ctx_md5;
-	EVP_CIPHER_CTX ctx_aes;
-
-	/* cleanup the static array. */
-	memset(passwd_aes, 0, sizeof(passwd_aes));
-	memset(passwd_key, 0, sizeof(passwd_key));
-	memset(passwd_md5, 0, sizeof(passwd_md5));
-	memset(passwd_crypt, 0, sizeof(passwd_crypt));
-
-	/* check if we use no algorithm. */
-	if (strcasecmp((char *)encryption, "NONE") == 0) {
-
-		/* check if we found valid password. */
-		if (strcmp((char *)passwd, (char *)secret_name) != 0) {
-
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
-	}
-
-	/* check if we use des crypt algorithm. */
-	if (strcasecmp((char *)encryption, "CRYPT") == 0) {
+	/* forget attributes of a previous authentication. */
+	attributes_count = 0;
 
-		/* check if secret from database is shorter than an expected crypt() result. */
-		if (strlen((char *)secret_name) < (SIZE_CRYPT * 2)) {
+	/* if no error was found, return zero. */
+	return 0;
+}
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+/* this function store a session attribute. */
+int32_t pppd__attribute_add(uint8_t *name, uint8_t *value) {
 
-		/* check if password was successfully encrypted. */
-		if ((uint8_t *)DES_fcrypt((char *)passwd, (char *)key, (char *)passwd_crypt) == NULL) {
+	/* check if there is space for another attribute. */
+	if (attributes_count == SIZE_ATTRIBUTES) {
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+		/* show the error. */
+		error("Plugin: Attribute %s is ignored, only %d attributes are supported\n", name, SIZE_ATTRIBUTES);
 
-		/* loop through every byte and compare it. */
-		for (count = 0; count < (strlen((char *)secret_name) / 2); count++) {
+		/* return with error, but keep link. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
 
-			/* check if our hex value matches the hash byte. (this isn't the fastest way, but hash is everytime 13 byte) */
-			if (pppd__htoi(secret_name[2 * count]) * 16 + pppd__htoi(secret_name[2 * count + 1]) != passwd_crypt[count]) {
+	/* check if value fits, a cut value like a framed route list must never be used. */
+	if (strlen((char *)value) >= SIZE_ATTRIBUTE_VALUE) {
 
-				/* clear the memory with the hash, so nobody is able to dump it. */
-				memset(passwd_crypt, 0, sizeof(passwd_crypt));
+		/* show the error. */
+		error("Plugin: Attribute %s is ignored, it is longer than %d bytes\n", name, SIZE_ATTRIBUTE_VALUE - 1);
 
-				/* return with error and terminate link. */
-				return PPPD_SQL_ERROR_PASSWORD;
-			}
-		}
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
 	}
 
-	/* check if we use md5 hashing algorithm. */
-	if (strcasecmp((char *)encryption, "MD5") == 0) {
+	/* cleanup the attribute. */
+	memset(&attributes[attributes_count], 0, sizeof(struct pppd_attribute));
 
-		/* check if secret from database is shorter than an expected md5 hash. */
-		if (strlen((char *)secret_name) < (SIZE_MD5 * 2)) {
+	/* copy name and value. */
+	strncpy((char *)attributes[attributes_count].name, (char *)name, SIZE_ATTRIBUTE_NAME - 1);
+	strncpy((char *)attributes[attributes_count].value, (char *)value, SIZE_ATTRIBUTE_VALUE - 1);
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+	/* increase number of attributes. */
+	attributes_count++;
 
-		/* initialize the openssl context. */
-		EVP_MD_CTX_init(&ctx_md5);
+	/* if no error was found, return zero. */
+	return 0;
+}
 
-		/* check if cipher initialization is working. */
-		if (EVP_DigestInit_ex(&ctx_md5, EVP_md5(), NULL) == 0) {
+/* this function return the value of a session attribute or NULL. */
+uint8_t *pppd__attribute_get(uint8_t *name) {
 
-			/* cleanup cipher context to prevent memory dumping. */
-			EVP_MD_CTX_cleanup(&ctx_md5);
+	/* some common variables. */
+	uint32_t count = 0;
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
+	/* loop through all attributes. */
+	for (count = 0; count < attributes_count; count++) {
+
+		/* check if we found the attribute. */
+		if (strcasecmp((char *)attributes[count].name, (char *)name) == 0) {
+
+			/* return the value. */
+			return attributes[count].value;
 		}
+	}
 
-		/* encrypt the input buffer. */
-		if (EVP_DigestUpdate(&ctx_md5, passwd, strlen((char *)passwd)) == 0) {
+	/* attribute is not set. */
+	return NULL;
+}
 
-			/* cleanup cipher context to prevent memory dumping. */
-			EVP_MD_CTX_cleanup(&ctx_md5);
+/* this function export all session attributes to the environment of scripts. */
+int32_t pppd__attribute_export(void) {
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+	/* some common variables. */
+	uint8_t variable[SIZE_ATTRIBUTE_NAME + 4];
+	uint32_t count = 0;
+	uint32_t count_name = 0;
 
-		/* encrypt the last block from input buffer. */
-		if (EVP_DigestFinal_ex(&ctx_md5, passwd_md5, (uint32_t *)&passwd_size) == 0) {
+	/* loop through all attributes. */
+	for (count = 0; count < attributes_count; count++) {
 
-			/* cleanup cipher context to prevent memory dumping. */
-			EVP_MD_CTX_cleanup(&ctx_md5);
+		/* build the variable name, the column name is prefixed and uppercased. */
+		slprintf((char *)variable, sizeof(variable), "SQL_%s", attributes[count].name);
 
-			/* clear the memory with the hash, so nobody is able to dump it. */
-			memset(passwd_md5, 0, sizeof(passwd_md5));
+		/* loop through all characters of the column name. */
+		for (count_name = 4; variable[count_name] != '\0'; count_name++) {
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
+			/* replace characters which are not allowed in variable names. */
+			variable[count_name] = isalnum(variable[count_name]) ? toupper(variable[count_name]) : '_';
 		}
 
-		/* cleanup cipher context to prevent memory dumping. */
-		EVP_MD_CTX_cleanup(&ctx_md5);
+		/* set variable for all scripts executed by the ppp daemon. */
+		script_setenv((char *)variable, (char *)attributes[count].value, 0);
+	}
 
-		/* loop through every byte and compare it. */
-		for (count = 0; count < (strlen((char *)secret_name) / 2); count++) {
+	/* if no error was found, return zero. */
+	return 0;
+}
 
-			/* check if our hex value matches the hash byte. (this isn't the fastest way, but hash is everytime 16 byte) */
-			if (pppd__htoi(secret_name[2 * count]) * 16 + pppd__htoi(secret_name[2 * count + 1]) != passwd_md5[count]) {
+/* this function convert the rate attribute in kbit/s, a missing, NULL or empty value is unlimited. */
+int32_t pppd__rate(uint8_t *column, uint32_t *rate) {
 
-				/* clear the memory with the hash, so nobody is able to dump it. */
-				memset(passwd_md5, 0, sizeof(passwd_md5));
+	/* some common variables. */
+	uint8_t *value          = NULL;
+	uint8_t *end            = NULL;
+	unsigned long long kbit = 0;
 
-				/* return with error and terminate link. */
-				return PPPD_SQL_ERROR_PASSWORD;
-			}
-		}
+	/* reset rate, so every error leaves the direction unlimited. */
+	*rate = 0;
+
+	/* check if attribute is given, backends store a database NULL as string. */
+	if (column == NULL ||
+	    (value = pppd__attribute_get(column)) == NULL ||
+	    value[0] == '\0' ||
+	    strcmp((char *)value, "NULL") == 0) {
 
-		/* clear the memory with the hash, so nobody is able to dump it. */
-		memset(passwd_md5, 0, sizeof(passwd_md5));
+		/* nothing to do, so no error. */
+		return 0;
 	}
 
-	/* check if we use aes block cipher algorithm. */
-	if (strcasecmp((char *)encryption, "AES") == 0) {
+	/* convert rate, only digits are allowed, so units or signs are never misread. */
+	errno = 0;
+	kbit  = isdigit(value[0]) ? strtoull((char *)value, (char **)&end, 10) : 0;
 
-		/* check if secret from database is shorter than an expected minimum aes size. */
-		if (strlen((char *)secret_name) < (((strlen((char *)passwd) / 16) + 1) * 16)) {
+	/* check if rate was a number and fits the 32 bit bytes/s of the htb rate table. */
+	if (end == NULL ||
+	    *end != '\0' ||
+	    errno != 0 ||
+	    kbit > UINT32_MAX / 125) {
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+		/* error on converting rate. */
+		error("Plugin: Rate %s of %s is not a number of kbit/s up to %u\n", value, column, UINT32_MAX / 125);
 
-		/* check if we have to truncate source pointer. */
-		if (strlen((char *)key) < SIZE_AES) {
-
-			/* copy the key to the static buffer. */
-			memcpy(passwd_key, key, strlen((char *)key));
-		} else {
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_RATE;
+	}
 
-			/* copy the key to the static buffer. */
-			memcpy(passwd_key, key, SIZE_AES);
-		}
+	/* store rate. */
+	*rate = kbit;
 
-		/* initialize the openssl context. */
-		EVP_CIPHER_CTX_init(&ctx_aes);
+	/* if no error was found, return zero. */
+	return 0;
+}
 
-		/* check if cipher initialization is working. */
-		if (EVP_EncryptInit_ex(&ctx_aes, EVP_aes_128_ecb(), NULL, passwd_key, NULL) == 0) {
+/* this function install or remove the traffic shaping with the rates of the session attributes. */
+int32_t pppd__shape(uint8_t *column_rate_down, uint8_t *column_rate_up, uint32_t shape) {
 
-			/* cleanup cipher context to prevent memory dumping. */
-			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+	/* some common variables. */
+	uint32_t rate_down = 0;
+	uint32_t rate_up   = 0;
 
-			/* clear the memory with the aes key, so nobody is able to dump it. */
-			memset(passwd_key, 0, sizeof(passwd_key));
+	/* fetch rates in kbit/s, they were validated at login, a missing attribute leaves the direction unlimited. */
+	if (pppd__rate(column_rate_down, &rate_down) < 0 ||
+	    pppd__rate(column_rate_up, &rate_up) < 0) {
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+		/* return with error. */
+		return PPPD_SQL_ERROR_RATE;
+	}
 
-		/* encrypt the input buffer. */
-		if (EVP_EncryptUpdate(&ctx_aes, passwd_aes, &passwd_size, passwd, strlen((char *)passwd)) == 0) {
+	/* check if session has a rate. */
+	if (rate_down == 0 &&
+	    rate_up   == 0) {
 
-			/* cleanup cipher context to prevent memory dumping. */
-			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+		/* nothing to do, so no error. */
+		return 0;
+	}
 
-			/* clear the memory with the aes key and buffer, so nobody is able to dump it. */
-			memset(passwd_aes, 0, sizeof(passwd_aes));
-			memset(passwd_key, 0, sizeof(passwd_key));
+	/* check if traffic shaping should be installed. */
+	if (shape == 1) {
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+		/* install shaping on the ppp interface. */
+		return pppd__netlink_shape((uint8_t *)ifname, rate_down, rate_up);
+	}
 
-		/* encrypt the last block from input buffer. */
-		if (EVP_EncryptFinal_ex(&ctx_aes, passwd_aes + passwd_size, &temp_size) == 0) {
+	/* remove shaping from the ppp interface. */
+	return pppd__netlink_unshape((uint8_t *)ifname, rate_down, rate_up);
+}
 
-			/* cleanup cipher context to prevent memory dumping. */
-			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+/* this function add or remove the client address in the nftables sets of the session attribute. */
+int32_t pppd__firewall(uint8_t *table, uint8_t *column_set, uint32_t add) {
 
-			/* clear the memory with the aes key and buffer, so nobody is able to dump it. */
-			memset(passwd_aes, 0, sizeof(passwd_aes));
-			memset(passwd_key, 0, sizeof(passwd_key));
+	/* some common variables. */
+	uint8_t *sets = NULL;
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+	/* check if session has sets, a missing attribute leaves the firewall untouched. */
+	if ((sets = pppd__attribute_get(column_set)) == NULL ||
+	    sets[0] == '\0') {
 
-		/* cleanup cipher context to prevent memory dumping. */
-		EVP_CIPHER_CTX_cleanup(&ctx_aes);
+		/* nothing to do, so no error. */
+		return 0;
+	}
 
-		/* compute final size. */
-		passwd_size += temp_size;
+	/* change all sets in one transaction. */
+	return pppd__netlink_set(table, sets, ipcp_hisoptions[0].hisaddr, add);
+}
 
-		/* loop through every byte and compare it. */
-		for (count = 0; count < (strlen((char *)secret_name) / 2); count++) {
+/* this function create the identifier of a new session. */
+int32_t pppd__session_create(void) {
 
-			/* check if our hex value matches the hash byte. (this isn't the fastest way, but okay) */
-			if (pppd__htoi(secret_name[2 * count]) * 16 + pppd__htoi(secret_name[2 * count + 1]) != passwd_aes[count]) {
+	/* build a session identifier which is unique across all tunnel servers. */
+	slprintf((char *)session_id, sizeof(session_id), "%s-%d-%u", hostname, getpid(), (uint32_t)time(NULL));
 
-				/* clear the memory with the aes key and buffer, so nobody is able to dump it. */
-				memset(passwd_aes, 0, sizeof(passwd_aes));
-				memset(passwd_key, 0, sizeof(passwd_key));
+	/* if no error was found, return zero. */
+	return 0;
+}
 
-				/* return with error and terminate link. */
-				return PPPD_SQL_ERROR_PASSWORD;
-			}
-		}
+/* this function forget the identifier of the finished session, so the next session of a persist or demand ppp daemon gets its own. */
+int32_t pppd__session_end(void) {
 
-		/* clear the memory with the aes key and buffer, so nobody is able to dump it. */
-		memset(passwd_aes, 0, sizeof(passwd_aes));
-		memset(passwd_key, 0, sizeof(passwd_key));
-	}
+	/* clear the session identifier. */
+	memset(session_id, 0, sizeof(session_id));
 
-	/* if no error was found, establish link. */
+	/* if no error was found, return zero. */
 	return 0;
 }
 
-/* this function decrypt the given password. */
-int32_t pppd__decrypt_password(uint8_t *secret_name, int32_t *secret_length, uint8_t *encryption, uint8_t *key) {
+/* this function start the accounting of a new session. */
+int32_t pppd__accounting_start(void) {
 
-	/* some common variables. */
-	uint8_t passwd_aes[MAXSECRETLEN / 2];
-	uint8_t passwd_key[SIZE_AES];
-	uint32_t count        = 0;
-	int32_t passwd_size   = 0;
-	int32_t temp_size     = 0;
-	EVP_CIPHER_CTX ctx_aes;
-
-	/* check if we use no algorithm. */
-	if (strcasecmp((char *)encryption, "NONE") == 0 ||
-	    strcasecmp((char *)encryption, "CRYPT") == 0 ||
-	    strcasecmp((char *)encryption, "MD5") == 0) {
-
-		/* no encryption or non-symmetric algorithm used. */
-		return 0;
-	}
-
-	/* check if we use aes block cipher algorithm. */
-	if (strcasecmp((char *)encryption, "AES") == 0) {
+	/* store the start time of the session. */
+	session_start = time(NULL);
 
-		/* cleanup the static array. */
-		memset(passwd_aes, 0, sizeof(passwd_aes));
-		memset(passwd_key, 0, sizeof(passwd_key));
+	/* check if session identifier was not already created at login, it owns the lease then. */
+	if (session_id[0] == '\0') {
 
-		/* check if we have to truncate source pointer. */
-		if (strlen((char *)key) < SIZE_AES) {
+		/* create session identifier. */
+		pppd__session_create();
+	}
 
-			/* copy the key to the static buffer. */
-			memcpy(passwd_key, key, strlen((char *)key));
-		} else {
+	/* the raw counters of the unit already contain the lcp and authentication bytes, they are not part of the session. */
+	memset(&session_origin, 0, sizeof(session_origin));
+	get_ppp_stats(0, &session_origin);
 
-			/* copy the key to the static buffer. */
-			memcpy(passwd_key, key, SIZE_AES);
-		}
+	/* nothing was written to database so far, every delta is taken against the raw counters. */
+	session_stats = session_origin;
 
-		/* loop through every byte and convert it. */
-		for (count = 0; count < (*secret_length / 2); count++) {
+	/* seed the generator for the interim update jitter, so sessions are spread. */
+	srandom(getpid() ^ (uint32_t)session_start);
 
-			/* create binary data for decryption. */
-			passwd_aes[count] = pppd__htoi(secret_name[2 * count]) * 16 + pppd__htoi(secret_name[2 * count + 1]);
-		}
+	/* if no error was found, return zero. */
+	return 0;
+}
 
-		/* initialize the openssl context. */
-		EVP_CIPHER_CTX_init(&ctx_aes);
+/* this function fetch the accounting counters which are not yet written to database. */
+int32_t pppd__accounting_fetch(struct pppd_accounting *accounting, uint32_t final) {
 
-		/* check if cipher initialization is working. */
-		if (EVP_DecryptInit_ex(&ctx_aes, EVP_aes_128_ecb(), NULL, passwd_key, NULL) == 0) {
+	/* cleanup the structure. */
+	memset(accounting, 0, sizeof(struct pppd_accounting));
 
-			/* cleanup cipher context to prevent memory dumping. */
-			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+	/* check if raw statistics of the unit are available, the baseline was taken from them too. */
+	if (get_ppp_stats(0, &accounting->stats) == 0) {
 
-			/* clear the memory with the aes key and password, so nobody is able to dump it. */
-			memset(passwd_aes, 0, sizeof(passwd_aes));
-			memset(passwd_key, 0, sizeof(passwd_key));
+		/* check if link goes down, then an update must be written anyway. */
+		if (final == 0) {
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
+			/* return with error, no statistics available. */
+			return PPPD_SQL_ERROR_QUERY;
 		}
 
-		/* decrypt the input buffer. */
-		if (EVP_DecryptUpdate(&ctx_aes, secret_name, &passwd_size, passwd_aes, *secret_length / 2) == 0) {
+		/* pppd has rebased the final statistics on the counters at ipcp up, which is about the origin of the session. */
+		accounting->stats.bytes_in  = link_stats.bytes_in + session_origin.bytes_in;
+		accounting->stats.bytes_out = link_stats.bytes_out + session_origin.bytes_out;
+	}
 
-			/* cleanup cipher context to prevent memory dumping. */
-			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+	/* check if link goes down, pppd has computed the duration already. */
+	if (final == 1) {
 
-			/* clear the memory with the aes key, password and buffer, so nobody is able to dump it. */
-			memset(passwd_aes, 0, sizeof(passwd_aes));
-			memset(passwd_key, 0, sizeof(passwd_key));
+		/* use final duration of the link. */
+		accounting->duration = link_connect_time;
+	} else {
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+		/* compute the duration of the running link. */
+		accounting->duration = time(NULL) - session_start;
+	}
 
-		/* decrypt the last block from input buffer. */
-		if (EVP_DecryptFinal_ex(&ctx_aes, secret_name + passwd_size, &temp_size) == 0) {
+	/* compute the deltas. (unsigned arithmetic covers a counter wrap between two updates) */
+	accounting->bytes_received    = accounting->stats.bytes_in - session_stats.bytes_in;
+	accounting->bytes_transmitted = accounting->stats.bytes_out - session_stats.bytes_out;
 
-			/* cleanup cipher context to prevent memory dumping. */
-			EVP_CIPHER_CTX_cleanup(&ctx_aes);
+	/* if no error was found, return zero. */
+	return 0;
+}
 
-			/* clear the memory with the aes key, password and buffer, so nobody is able to dump it. */
-			memset(passwd_aes, 0, sizeof(passwd_aes));
-			memset(passwd_key, 0, sizeof(passwd_key));
+/* this function mark the fetched accounting counters as written to database. */
+int32_t pppd__accounting_commit(struct pppd_accounting *accounting) {
 
-			/* return with error and terminate link. */
-			return PPPD_SQL_ERROR_PASSWORD;
-		}
+	/* store counters, so next update only carries new deltas. */
+	session_stats = accounting->stats;
 
-		/* cleanup cipher context to prevent memory dumping. */
-		EVP_CIPHER_CTX_cleanup(&ctx_aes);
+	/* if no error was found, return zero. */
+	return 0;
+}
 
-		/* compute final size. */
-		passwd_size += temp_size;
+/* this function return the jittered delay until the next interim update. */
+int32_t pppd__accounting_interval(uint32_t interval, uint32_t first) {
 
-		/* terminate the cleartext password. */
-		secret_name[passwd_size] = '\0';
-		*secret_length = passwd_size;
+	/* check if it is the first update, then spread the sessions over the whole interval. */
+	if (first == 1) {
 
-		/* clear the memory with the aes key, password and buffer, so nobody is able to dump it. */
-		memset(passwd_aes, 0, sizeof(passwd_aes));
-		memset(passwd_key, 0, sizeof(passwd_key));
+		/* return random delay between one second and the interval. */
+		return (random() % interval) + 1;
 	}
 
-	/* if no error was found, establish link. */
-	return 0;
+	/* return interval with a jitter of one eighth, so sessions started together drift apart. */
+	return interval - (interval / 8) + (random() % ((interval / 4) + 1));
 }
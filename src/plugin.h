@@ -30,10 +30,14 @@
 #endif
 
 /* generic includes. */
+#include <ctype.h>
 #include <errno.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
 
 /* ppp generic includes. */
 #include <pppd/chap-new.h>
@@ -44,23 +48,38 @@
 #include <pppd/fsm.h>
 #include <pppd/ipcp.h>
 
-/* openssl includes. */
-#include <openssl/des.h>
-#include <openssl/evp.h>
-
-/* define errors. */
-#define PPPD_SQL_ERROR_INCOMPLETE	-1	/* the supplied sql information from configuration file are not complete. */
-#define PPPD_SQL_ERROR_INIT		-2	/* the initialization of the sql structure failed. */
-#define PPPD_SQL_ERROR_OPTION		-3	/* some unknown sql options were given. */
-#define PPPD_SQL_ERROR_CONNECT		-4	/* none of the supplied sql servers are working. */
-#define PPPD_SQL_ERROR_QUERY		-5	/* the given sql query failed. */
-#define PPPD_SQL_ERROR_PASSWORD		-6	/* the given password is wrong. */
-#define PPPD_SQL_ERROR_SCRIPT		-7	/* the up or down script failed. (returned with non-zero exit code) */
-
-/* define constants. */
-#define SIZE_AES			16	/* the size of an AES128 result. */
-#define SIZE_MD5			16	/* the size of a MD5 hash. */
-#define SIZE_CRYPT			13	/* the size of the crypt() DES result. */
+/* plugin includes. */
+#include "password.h"
+#include "pppd-sql.h"
+#include "realm.h"
+#include "shard.h"
+
+/* define address formats of the client and server ip address columns. */
+#define PPPD_SQL_ADDRESS_TEXT		0	/* the address is a dotted quad string. */
+#define PPPD_SQL_ADDRESS_NUMBER		1	/* the address is the decimal string of an unsigned integer, like INET_ATON(). */
+#define PPPD_SQL_ADDRESS_BYTES		2	/* the address is 4 bytes or 16 bytes IPv4-mapped in network byte order, like INET6_ATON(). */
+
+/* define accounting constants. */
+#define SIZE_SESSION			64	/* the size of a session identifier. */
+
+/* define attribute constants. */
+#define SIZE_ATTRIBUTES			16	/* the maximum number of session attributes. */
+#define SIZE_ATTRIBUTE_NAME		64	/* the size of an attribute name. */
+#define SIZE_ATTRIBUTE_VALUE		256	/* the size of an attribute value. */
+
+/* session attribute fetched with the credentials. */
+struct pppd_attribute {
+	uint8_t		name[SIZE_ATTRIBUTE_NAME];	/* the column name. */
+	uint8_t		value[SIZE_ATTRIBUTE_VALUE];	/* the column value. */
+};
+
+/* accounting counters of the current session which are not yet written to database. */
+struct pppd_accounting {
+	uint32_t	bytes_received;		/* received bytes since last database write. */
+	uint32_t	bytes_transmitted;	/* transmitted bytes since last database write. */
+	uint32_t	duration;		/* link duration in seconds. */
+	struct pppd_stats	stats;		/* link statistics at fetch time. */
+};
 
 /* client and server ip address must be stored in global variable, because
  * at IPCP time we no longer know the username.
@@ -68,6 +87,16 @@
 extern uint32_t client_ip;
 extern uint32_t server_ip;
 
+/* session attributes fetched with the credentials. */
+extern struct pppd_attribute attributes[SIZE_ATTRIBUTES];
+extern uint32_t attributes_count;
+
+/* session identifier, start time, the counters at start and the counters already written to database. */
+extern uint8_t session_id[SIZE_SESSION];
+extern time_t session_start;
+extern struct pppd_stats session_origin;
+extern struct pppd_stats session_stats;
+
 /* this function set whether the peer must authenticate itself to us via CHAP. */
 int32_t pppd__chap_check(
 	void
@@ -88,6 +117,14 @@ int32_t pppd__allowed_address(
 	uint32_t	addr
 );
 
+/* this function convert a fetched ip address column into an address in network byte order. */
+int32_t pppd__address(
+	uint8_t		*value,
+	uint32_t	length,
+	uint32_t	format,
+	uint32_t	*address
+);
+
 /* this function will execute a script when IPCP comes up. */
 int32_t pppd__ip_up(
 	uint8_t		*username,
@@ -100,20 +137,77 @@ int32_t pppd__ip_down(
 	uint8_t		*program
 );
 
-/* this function verify the given password. */
-int32_t pppd__verify_password(
-	uint8_t		*passwd,
-	uint8_t		*secret_name,
-	uint8_t		*encryption,
-	uint8_t		*key
+/* this function remove all session attributes. */
+int32_t pppd__attribute_clear(
+	void
+);
+
+/* this function store a session attribute. */
+int32_t pppd__attribute_add(
+	uint8_t		*name,
+	uint8_t		*value
+);
+
+/* this function return the value of a session attribute or NULL. */
+uint8_t *pppd__attribute_get(
+	uint8_t		*name
+);
+
+/* this function export all session attributes to the environment of scripts. */
+int32_t pppd__attribute_export(
+	void
+);
+
+/* this function convert the rate attribute in kbit/s, a missing, NULL or empty value is unlimited. */
+int32_t pppd__rate(
+	uint8_t		*column,
+	uint32_t	*rate
+);
+
+/* this function install or remove the traffic shaping with the rates of the session attributes. */
+int32_t pppd__shape(
+	uint8_t		*column_rate_down,
+	uint8_t		*column_rate_up,
+	uint32_t	shape
+);
+
+/* this function add or remove the client address in the nftables sets of the session attribute. */
+int32_t pppd__firewall(
+	uint8_t		*table,
+	uint8_t		*column_set,
+	uint32_t	add
+);
+
+/* this function create the identifier of a new session. */
+int32_t pppd__session_create(
+	void
+);
+
+/* this function forget the identifier of the finished session. */
+int32_t pppd__session_end(
+	void
+);
+
+/* this function start the accounting of a new session. */
+int32_t pppd__accounting_start(
+	void
+);
+
+/* this function fetch the accounting counters which are not yet written to database. */
+int32_t pppd__accounting_fetch(
+	struct pppd_accounting	*accounting,
+	uint32_t	final
+);
+
+/* this function mark the fetched accounting counters as written to database. */
+int32_t pppd__accounting_commit(
+	struct pppd_accounting	*accounting
 );
 
-/* this function decrypt the given password. */
-int32_t pppd__decrypt_password(
-	uint8_t		*secret_name,
-	int32_t		*secret_length,
-	uint8_t		*encryption,
-	uint8_t		*key
+/* this function return the jittered delay until the next interim update. */
+int32_t pppd__accounting_interval(
+	uint32_t	interval,
+	uint32_t	first
 );
 
 #endif					/* _PLUGIN_H */
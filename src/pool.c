@@ -0,0 +1,375 @@
+/*
+ *  pool.c -- Host-local ip address pool for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* plugin includes. */
+#include "plugin.h"
+#include "pool.h"
+#include "registry.h"
+
+/* this function parse the address range of the pool. */
+int32_t pppd__pool_range(uint8_t *range, uint32_t *first, uint32_t *count) {
+
+	/* some common variables. */
+	uint8_t address[32];
+	uint8_t *separator = NULL;
+	struct in_addr first_addr;
+	struct in_addr last_addr;
+
+	/* check if range has a separator between first and last address. */
+	if ((separator = (uint8_t *)strchr((char *)range, '-')) == NULL ||
+	    separator - range >= sizeof(address)) {
+
+		/* return with error, range is not valid. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* copy first address. */
+	memset(address, 0, sizeof(address));
+	memcpy(address, range, separator - range);
+
+	/* check if ip addresses were successfully converted into binary data. */
+	if (inet_aton((char *)address, &first_addr) == 0 ||
+	    inet_aton((char *)separator + 1, &last_addr) == 0) {
+
+		/* return with error, range is not valid. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* store first address in host byte order, so we can count. */
+	*first = ntohl(first_addr.s_addr);
+
+	/* check if range is not empty and not too large. */
+	if (ntohl(last_addr.s_addr) < *first ||
+	    ntohl(last_addr.s_addr) - *first >= POOL_ADDRESSES) {
+
+		/* return with error, range is not valid. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* store number of addresses. */
+	*count = ntohl(last_addr.s_addr) - *first + 1;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function open and map the pool. */
+int32_t pppd__pool_open(uint8_t *path, uint8_t *range, struct pppd_pool *pool) {
+
+	/* some common variables. */
+	uint32_t first = 0;
+	uint32_t count = 0;
+	uint32_t words = 0;
+	struct stat pool_stat;
+
+	/* check if range is valid. */
+	if (pppd__pool_range(range, &first, &count) < 0) {
+
+		/* error on parsing range. */
+		error("Plugin: Pool range %s is not valid\n", range);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* compute the size of header, bitmap and owners. */
+	words      = (count + 63) / 64;
+	pool->size = sizeof(struct pppd_pool_header) + words * sizeof(uint64_t) + count * sizeof(pid_t);
+
+	/* check if pool can be opened, it is shared by all ppp daemons on this host. */
+	if ((pool->fd = open((char *)path, O_RDWR | O_CREAT, 0600)) < 0) {
+
+		/* error on opening pool. */
+		error("Plugin: Pool %s could not be opened: %m\n", path);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* check if pool has the expected size. */
+	if (fstat(pool->fd, &pool_stat) < 0) {
+
+		/* error on reading pool. */
+		error("Plugin: Pool %s could not be read: %m\n", path);
+
+		/* close pool. */
+		close(pool->fd);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* check if pool must be extended, this is only done once. */
+	if (pool_stat.st_size < pool->size) {
+
+		/* lock pool, because another process may create it at the same time. */
+		flock(pool->fd, LOCK_EX);
+
+		/* check if pool is still too small and extend it. */
+		if (fstat(pool->fd, &pool_stat) < 0 ||
+		    (pool_stat.st_size < pool->size && ftruncate(pool->fd, pool->size) < 0)) {
+
+			/* error on creating pool. */
+			error("Plugin: Pool %s could not be created: %m\n", path);
+
+			/* unlock and close pool. */
+			flock(pool->fd, LOCK_UN);
+			close(pool->fd);
+
+			/* return with error and terminate link. */
+			return PPPD_SQL_ERROR_POOL;
+		}
+
+		/* unlock pool. */
+		flock(pool->fd, LOCK_UN);
+	}
+
+	/* check if pool mapping was successful. */
+	if ((pool->header = mmap(NULL, pool->size, PROT_READ | PROT_WRITE, MAP_SHARED, pool->fd, 0)) == MAP_FAILED) {
+
+		/* error on mapping pool. */
+		error("Plugin: Pool %s could not be mapped: %m\n", path);
+
+		/* close pool. */
+		close(pool->fd);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* bitmap and owners are stored directly behind the header. */
+	pool->bitmap = (uint64_t *)(pool->header + 1);
+	pool->owners = (pid_t *)(pool->bitmap + words);
+
+	/* check if pool is new or was created for another range, the lock is only taken then. */
+	if (__atomic_load_n(&pool->header->magic, __ATOMIC_ACQUIRE) != POOL_MAGIC ||
+	    pool->header->first != first ||
+	    pool->header->count != count) {
+
+		/* lock pool, because another process may initialize it at the same time. */
+		flock(pool->fd, LOCK_EX);
+
+		/* check if pool was not initialized while we were waiting. */
+		if (pool->header->magic != POOL_MAGIC ||
+		    pool->header->first != first ||
+		    pool->header->count != count) {
+
+			/* initialize empty pool. */
+			memset(pool->bitmap, 0, words * sizeof(uint64_t) + count * sizeof(pid_t));
+			pool->header->first = first;
+			pool->header->count = count;
+			pool->header->hint  = 0;
+
+			/* publish the pool. */
+			__atomic_store_n(&pool->header->magic, POOL_MAGIC, __ATOMIC_RELEASE);
+		}
+
+		/* unlock pool. */
+		flock(pool->fd, LOCK_UN);
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function unmap and close the pool. */
+int32_t pppd__pool_close(struct pppd_pool *pool) {
+
+	/* unmap the pool. */
+	munmap(pool->header, pool->size);
+
+	/* close the pool. */
+	close(pool->fd);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function release all addresses owned by crashed ppp daemons. */
+int32_t pppd__pool_sweep(struct pppd_pool *pool) {
+
+	/* some common variables. */
+	uint32_t index    = 0;
+	uint32_t released = 0;
+	uint64_t bit      = 0;
+	pid_t owner       = 0;
+
+	/* loop through all owners, a crash during allocation may leave an owner without its bit. */
+	for (index = 0; index < pool->header->count; index++) {
+
+		/* fetch the owner, zero is a free address or one which is released right now. */
+		owner = __atomic_load_n(&pool->owners[index], __ATOMIC_ACQUIRE);
+
+		/* check if address is owned by a crashed ppp daemon. */
+		if (owner == 0 ||
+		    pppd__registry_alive(owner) == 1) {
+			continue;
+		}
+
+		/* the bit of a dead owner cannot change, only the one who clears the owner may clear it. */
+		bit = __atomic_load_n(&pool->bitmap[index / 64], __ATOMIC_ACQUIRE) & (1ULL << (index % 64));
+
+		/* check if we are the one which takes the address away, another sweeper may run at the same time. */
+		if (__atomic_compare_exchange_n(&pool->owners[index], &owner, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+
+			/* check if crash was after the bit was claimed, then mark address as free. */
+			if (bit != 0) {
+				__atomic_fetch_and(&pool->bitmap[index / 64], ~bit, __ATOMIC_RELEASE);
+			}
+
+			/* increase number of released addresses. */
+			released++;
+		}
+	}
+
+	/* check if we found some addresses. */
+	if (released > 0) {
+
+		/* show the information. */
+		info("Plugin: Pool released %u addresses of crashed ppp daemons\n", released);
+	}
+
+	/* return number of released addresses. */
+	return released;
+}
+
+/* this function allocate a free address from the pool. */
+int32_t pppd__pool_allocate(uint8_t *path, uint8_t *range, uint32_t *addr) {
+
+	/* some common variables. */
+	uint32_t words       = 0;
+	uint32_t word        = 0;
+	uint32_t count_words = 0;
+	uint32_t index       = 0;
+	uint32_t sweep       = 0;
+	uint64_t value       = 0;
+	uint64_t bit         = 0;
+	pid_t owner          = 0;
+	struct pppd_pool pool;
+
+	/* check if pool is available. */
+	if (pppd__pool_open(path, range, &pool) < 0) {
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* compute number of bitmap words. */
+	words = (pool.header->count + 63) / 64;
+
+	/* loop twice, the second time after crashed ppp daemons were swept. */
+	for (sweep = 0; sweep < 2; sweep++) {
+
+		/* start at the word of the last allocation, so we do not scan the allocated beginning again. */
+		word = __atomic_load_n(&pool.header->hint, __ATOMIC_RELAXED) % words;
+
+		/* loop through all bitmap words. */
+		for (count_words = 0; count_words < words; count_words++, word = (word + 1) % words) {
+
+			/* fetch the word. */
+			value = __atomic_load_n(&pool.bitmap[word], __ATOMIC_RELAXED);
+
+			/* loop as long as the word has a free bit, a lost address is marked in our copy of the word only. */
+			while (value != ~0ULL) {
+
+				/* compute address index of the lowest free bit. */
+				index = word * 64 + __builtin_ctzll(~value);
+				bit   = 1ULL << (index % 64);
+				value = value | bit;
+
+				/* check if bit is behind the end of the range. */
+				if (index >= pool.header->count) {
+					break;
+				}
+
+				/* check if we won the owner first, so a crash before the bit is set is reclaimed by the sweeper. */
+				owner = 0;
+				if (__atomic_compare_exchange_n(&pool.owners[index], &owner, getpid(), 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) == 0) {
+					continue;
+				}
+
+				/* check if bit is still set by a release between clearing its owner and its bit, then give the owner back. */
+				if ((__atomic_fetch_or(&pool.bitmap[word], bit, __ATOMIC_ACQ_REL) & bit) != 0) {
+					__atomic_store_n(&pool.owners[index], 0, __ATOMIC_RELEASE);
+					continue;
+				}
+
+				/* next allocation starts at this word. */
+				__atomic_store_n(&pool.header->hint, word, __ATOMIC_RELAXED);
+
+				/* store address in network byte order. */
+				*addr = htonl(pool.header->first + index);
+
+				/* unmap and close pool. */
+				pppd__pool_close(&pool);
+
+				/* if no error was found, return zero. */
+				return 0;
+			}
+		}
+
+		/* check if pool is full, then reclaim addresses of crashed ppp daemons. */
+		if (sweep == 0 &&
+		    pppd__pool_sweep(&pool) == 0) {
+			break;
+		}
+	}
+
+	/* no free address found. */
+	error("Plugin: Pool %s has no free address\n", path);
+
+	/* unmap and close pool. */
+	pppd__pool_close(&pool);
+
+	/* return with error and terminate link. */
+	return PPPD_SQL_ERROR_POOL;
+}
+
+/* this function release an address allocated by this ppp daemon. */
+int32_t pppd__pool_release(uint8_t *path, uint8_t *range, uint32_t addr) {
+
+	/* some common variables. */
+	uint32_t index = 0;
+	pid_t owner    = getpid();
+	struct pppd_pool pool;
+
+	/* check if pool is available. */
+	if (pppd__pool_open(path, range, &pool) < 0) {
+
+		/* return with error, the sweeper releases the address later. */
+		return PPPD_SQL_ERROR_POOL;
+	}
+
+	/* compute address index. */
+	index = ntohl(addr) - pool.header->first;
+
+	/* check if address is from the pool and still owned by us. (static addresses are ignored) */
+	if (index < pool.header->count &&
+	    __atomic_compare_exchange_n(&pool.owners[index], &owner, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+
+		/* mark address as free. */
+		__atomic_fetch_and(&pool.bitmap[index / 64], ~(1ULL << (index % 64)), __ATOMIC_RELEASE);
+	}
+
+	/* unmap and close pool. */
+	pppd__pool_close(&pool);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ *  pool.h -- Host-local ip address pool for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _POOL_H
+#define _POOL_H
+
+/* generic includes. */
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* define pool constants. */
+#define POOL_MAGIC			0x4c505350	/* the magic of the pool file. ("PSPL") */
+#define POOL_ADDRESSES			1048576		/* the maximum number of addresses in a pool. */
+
+/* the header at the beginning of the pool file, followed by the bitmap and the owner of every address. */
+struct pppd_pool_header {
+	uint32_t	magic;			/* the pool magic. */
+	uint32_t	first;			/* the first address of the range in host byte order. */
+	uint32_t	count;			/* the number of addresses in the range. */
+	uint32_t	hint;			/* the bitmap word where the next allocation starts. */
+};
+
+/* the mapped pool. */
+struct pppd_pool {
+	int32_t		fd;			/* the descriptor of the pool file. */
+	size_t		size;			/* the size of the mapping. */
+	struct pppd_pool_header	*header;	/* the pool header. */
+	uint64_t	*bitmap;		/* one bit per address, set if allocated. */
+	pid_t		*owners;		/* the ppp daemon owning the address. */
+};
+
+/* this function open and map the pool. */
+int32_t pppd__pool_open(
+	uint8_t		*path,
+	uint8_t		*range,
+	struct pppd_pool	*pool
+);
+
+/* this function unmap and close the pool. */
+int32_t pppd__pool_close(
+	struct pppd_pool	*pool
+);
+
+/* this function release all addresses owned by crashed ppp daemons. */
+int32_t pppd__pool_sweep(
+	struct pppd_pool	*pool
+);
+
+/* this function allocate a free address from the pool. */
+int32_t pppd__pool_allocate(
+	uint8_t		*path,
+	uint8_t		*range,
+	uint32_t	*addr
+);
+
+/* this function release an address allocated by this ppp daemon. */
+int32_t pppd__pool_release(
+	uint8_t		*path,
+	uint8_t		*range,
+	uint32_t	addr
+);
+
+#endif					/* _POOL_H */
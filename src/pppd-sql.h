@@ -0,0 +1,53 @@
+/*
+ *  pppd-sql.h -- Errors and constants shared by the Point-to-Point Protocol
+ *                (PPP) plugins and the tools which work without pppd.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PPPD_SQL_H
+#define _PPPD_SQL_H
+
+/* define errors. */
+#define PPPD_SQL_ERROR_INCOMPLETE	-1	/* the supplied sql information from configuration file are not complete. */
+#define PPPD_SQL_ERROR_INIT		-2	/* the initialization of the sql structure failed. */
+#define PPPD_SQL_ERROR_OPTION		-3	/* some unknown sql options were given. */
+#define PPPD_SQL_ERROR_CONNECT		-4	/* none of the supplied sql servers are working. */
+#define PPPD_SQL_ERROR_QUERY		-5	/* the given sql query failed. */
+#define PPPD_SQL_ERROR_PASSWORD		-6	/* the given password is wrong. */
+#define PPPD_SQL_ERROR_SCRIPT		-7	/* the up or down script failed. (returned with non-zero exit code) */
+#define PPPD_SQL_ERROR_JOURNAL		-8	/* the write-behind journal is not usable or full. */
+#define PPPD_SQL_ERROR_REGISTRY		-9	/* the session registry is not usable or reconciliation is not due. */
+#define PPPD_SQL_ERROR_LEASE		-10	/* the lease is held by another session. */
+#define PPPD_SQL_ERROR_POOL		-11	/* the address pool has no free address. */
+#define PPPD_SQL_ERROR_NETLINK		-12	/* the netlink request failed. */
+#define PPPD_SQL_ERROR_ROUTE		-13	/* the framed routes are not valid. */
+#define PPPD_SQL_ERROR_RATE		-14	/* the shaping rates are not valid. */
+
+/* define constants. */
+#define SIZE_AES			16	/* the size of an AES128 result. */
+#define SIZE_MD5			16	/* the size of a MD5 hash. */
+#define SIZE_CRYPT			13	/* the size of the crypt() DES result. */
+#define SIZE_QUERY			4096	/* the size of a precompiled query. */
+#define SIZE_SECRET			256	/* the size of a secret, MAXSECRETLEN of pppd. */
+
+/* define password encryption algorithms. */
+#define PPPD_SQL_ENCRYPTION_NONE	0	/* the password is stored in clear text. */
+#define PPPD_SQL_ENCRYPTION_CRYPT	1	/* the password is stored as crypt() DES result. */
+#define PPPD_SQL_ENCRYPTION_MD5		2	/* the password is stored as MD5 hash. */
+#define PPPD_SQL_ENCRYPTION_AES		3	/* the password is stored AES128 encrypted. */
+
+#endif					/* _PPPD_SQL_H */
@@ -0,0 +1,62 @@
+/*
+ *  probes.h -- Static tracepoints of the logins for bpftrace, perf and
+ *              systemtap, they cost a nop if nobody is attached.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PROBES_H
+#define _PROBES_H
+
+/* configuration includes. */
+#include "config.h"
+
+/* check if static tracepoints are supported. */
+#ifdef HAVE_SYS_SDT_H
+
+/* a tracer increments the semaphore of a probe it attaches to, so the clock is only read if somebody listens. */
+#define _SDT_HAS_SEMAPHORES		1
+
+/* static tracepoint includes. */
+#include <sys/sdt.h>
+
+/* the semaphores of the probes, defined in stats.c. */
+extern unsigned short pppd_sql_login__start_semaphore;
+extern unsigned short pppd_sql_login__done_semaphore;
+extern unsigned short pppd_sql_phase__start_semaphore;
+extern unsigned short pppd_sql_phase__done_semaphore;
+
+/* check if a tracer is attached to a probe which needs the elapsed time. */
+#define PPPD_PROBE_ENABLED()		(pppd_sql_login__done_semaphore != 0 || pppd_sql_phase__done_semaphore != 0)
+
+/* define the probes, the arguments are username, phase, result and elapsed nanoseconds. */
+#define PPPD_PROBE_LOGIN_START(name)			DTRACE_PROBE1(pppd_sql, login__start, name)
+#define PPPD_PROBE_LOGIN_DONE(name, result, elapsed)	DTRACE_PROBE3(pppd_sql, login__done, name, result, elapsed)
+#define PPPD_PROBE_PHASE_START(phase, name)		DTRACE_PROBE2(pppd_sql, phase__start, phase, name)
+#define PPPD_PROBE_PHASE_DONE(phase, name, result, elapsed)	DTRACE_PROBE4(pppd_sql, phase__done, phase, name, result, elapsed)
+
+#else
+
+/* without static tracepoints the probes do not exist. */
+#define PPPD_PROBE_ENABLED()		0
+#define PPPD_PROBE_LOGIN_START(name)
+#define PPPD_PROBE_LOGIN_DONE(name, result, elapsed)
+#define PPPD_PROBE_PHASE_START(phase, name)
+#define PPPD_PROBE_PHASE_DONE(phase, name, result, elapsed)
+
+#endif					/* HAVE_SYS_SDT_H */
+
+#endif					/* _PROBES_H */
@@ -0,0 +1,254 @@
+/*
+ *  radix.c -- Path compressed radix tree of the framed routes for the
+ *             Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* plugin includes. */
+#include "plugin.h"
+#include "radix.h"
+
+/* framed routes of the session. */
+struct pppd_radix framed_routes;
+
+/* this function return the network mask of the given prefix length. */
+uint32_t pppd__radix_mask(uint8_t length) {
+
+	/* shifting by 32 is undefined, so the default route is handled separately. */
+	return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+/* this function return the bit of the key behind the given prefix length. */
+uint32_t pppd__radix_bit(uint32_t key, uint8_t length) {
+
+	/* return the bit. */
+	return (key >> (31 - length)) & 1;
+}
+
+/* this function append a new node to the tree. */
+uint16_t pppd__radix_node(struct pppd_radix *radix, uint32_t key, uint8_t length, uint8_t route) {
+
+	/* some common variables. */
+	struct pppd_radix_node *node = &radix->nodes[radix->count];
+
+	/* fill the node. */
+	node->key      = key & pppd__radix_mask(length);
+	node->length   = length;
+	node->route    = route;
+	node->child[0] = 0;
+	node->child[1] = 0;
+
+	/* return index of the node. */
+	return radix->count++;
+}
+
+/* this function remove all prefixes from the tree. */
+int32_t pppd__radix_clear(struct pppd_radix *radix) {
+
+	/* the root covers all addresses, but is no route until the default route is added. */
+	radix->count  = 0;
+	radix->routes = 0;
+	pppd__radix_node(radix, 0, 0, 0);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function add a prefix to the tree. */
+int32_t pppd__radix_insert(struct pppd_radix *radix, uint32_t key, uint8_t length) {
+
+	/* some common variables. */
+	uint16_t index  = 0;
+	uint16_t child  = 0;
+	uint16_t branch = 0;
+	uint8_t common  = 0;
+	uint32_t bit    = 0;
+
+	/* check if prefix is valid, has no host bits and fits into the tree. */
+	if (length > 32 ||
+	    (key & ~pppd__radix_mask(length)) != 0 ||
+	    radix->routes == RADIX_ROUTES) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_ROUTE;
+	}
+
+	/* loop from the root down, every visited node is a prefix of the key. */
+	while (1) {
+
+		/* check if we found the node of the prefix. */
+		if (radix->nodes[index].length == length) {
+
+			/* check if prefix is new, a duplicate is ignored. */
+			if (radix->nodes[index].route == 0) {
+				radix->nodes[index].route = 1;
+				radix->routes++;
+			}
+
+			/* if no error was found, return zero. */
+			return 0;
+		}
+
+		/* fetch the subtree of the next bit. */
+		bit   = pppd__radix_bit(key, radix->nodes[index].length);
+		child = radix->nodes[index].child[bit];
+
+		/* check if subtree is empty, then the prefix becomes a leaf. */
+		if (child == 0) {
+
+			/* add leaf. */
+			radix->nodes[index].child[bit] = pppd__radix_node(radix, key, length, 1);
+			radix->routes++;
+
+			/* if no error was found, return zero. */
+			return 0;
+		}
+
+		/* compute the common prefix length of the key and the subtree. */
+		common = (key ^ radix->nodes[child].key) == 0 ? 32 : __builtin_clz(key ^ radix->nodes[child].key);
+		common = common < length ? common : length;
+		common = common < radix->nodes[child].length ? common : radix->nodes[child].length;
+
+		/* check if the whole subtree prefix matches, then we descend. */
+		if (common == radix->nodes[child].length) {
+			index = child;
+			continue;
+		}
+
+		/* split the compressed path, the branch is the prefix itself if it is shorter than the subtree. */
+		branch = pppd__radix_node(radix, key, common, common == length);
+		radix->nodes[branch].child[pppd__radix_bit(radix->nodes[child].key, common)] = child;
+		radix->nodes[index].child[bit] = branch;
+
+		/* check if the prefix is longer than the branch, then it becomes a leaf beside the subtree. */
+		if (common < length) {
+			radix->nodes[branch].child[pppd__radix_bit(key, common)] = pppd__radix_node(radix, key, length, 1);
+		}
+
+		/* increase number of prefixes. */
+		radix->routes++;
+
+		/* if no error was found, return zero. */
+		return 0;
+	}
+}
+
+/* this function check if an address is covered by a prefix of the tree. */
+int32_t pppd__radix_lookup(struct pppd_radix *radix, uint32_t addr) {
+
+	/* some common variables. */
+	uint16_t index = 0;
+	struct pppd_radix_node *node = NULL;
+
+	/* check if tree is empty. */
+	if (radix->routes == 0) {
+		return 0;
+	}
+
+	/* loop from the root down, at most one node per prefix bit. */
+	while (1) {
+
+		/* fetch the node. */
+		node = &radix->nodes[index];
+
+		/* check if the compressed path does not match the address. */
+		if ((addr & pppd__radix_mask(node->length)) != node->key) {
+			return 0;
+		}
+
+		/* check if the shortest matching prefix is a route, longer ones cannot change the answer. */
+		if (node->route == 1) {
+			return 1;
+		}
+
+		/* check if we reached a host route or an empty subtree without match. */
+		if (node->length == 32 ||
+		    (index = node->child[pppd__radix_bit(addr, node->length)]) == 0) {
+			return 0;
+		}
+	}
+}
+
+/* this function parse a comma separated list of prefixes into the tree. */
+int32_t pppd__radix_parse(struct pppd_radix *radix, uint8_t *prefixes) {
+
+	/* some common variables. */
+	uint8_t buffer[SIZE_ATTRIBUTE_VALUE];
+	uint8_t *prefix  = NULL;
+	uint8_t *slash   = NULL;
+	char *saveptr    = NULL;
+	char *end        = NULL;
+	long length      = 32;
+	struct in_addr addr;
+
+	/* start with an empty tree. */
+	pppd__radix_clear(radix);
+
+	/* check if we have prefixes, a missing attribute means no framed routes. */
+	if (prefixes == NULL) {
+		return 0;
+	}
+
+	/* check if prefixes fit into the buffer, a cut list may end with a shorter prefix length. */
+	if (strlen((char *)prefixes) >= sizeof(buffer)) {
+
+		/* error on parsing prefixes. */
+		error("Plugin: Framed routes are longer than %d bytes\n", SIZE_ATTRIBUTE_VALUE - 1);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_ROUTE;
+	}
+
+	/* copy the prefixes, because they are split. */
+	memset(buffer, 0, sizeof(buffer));
+	strncpy((char *)buffer, (char *)prefixes, sizeof(buffer) - 1);
+
+	/* loop through all prefixes, separated by commas or spaces. */
+	for (prefix = (uint8_t *)strtok_r((char *)buffer, ", ", &saveptr); prefix != NULL; prefix = (uint8_t *)strtok_r(NULL, ", ", &saveptr)) {
+
+		/* check if prefix has a length, otherwise it is a host route. */
+		if ((slash = (uint8_t *)strchr((char *)prefix, '/')) != NULL) {
+			*slash = '\0';
+
+			/* parse the length, only digits are allowed, so a typo never becomes the default route. */
+			errno  = 0;
+			length = isdigit(slash[1]) ? strtol((char *)slash + 1, &end, 10) : -1;
+			length = length < 0 || errno != 0 || *end != '\0' ? -1 : length;
+		} else {
+			length = 32;
+		}
+
+		/* check if prefix was successfully converted and added, only a dotted quad without host bits is accepted. */
+		if (inet_pton(AF_INET, (char *)prefix, &addr) != 1 ||
+		    length < 0 ||
+		    length > 32 ||
+		    pppd__radix_insert(radix, ntohl(addr.s_addr), length) < 0) {
+
+			/* error on parsing prefix. */
+			error("Plugin: Framed route %s is not valid, has host bits set or more than %d routes are given\n", prefix, RADIX_ROUTES);
+
+			/* forget all prefixes, so a broken list never allows an address. */
+			pppd__radix_clear(radix);
+
+			/* return with error. */
+			return PPPD_SQL_ERROR_ROUTE;
+		}
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
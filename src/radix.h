@@ -0,0 +1,94 @@
+/*
+ *  radix.h -- Path compressed radix tree of the framed routes for the
+ *             Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RADIX_H
+#define _RADIX_H
+
+/* generic includes. */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+
+/* define radix constants. */
+#define RADIX_ROUTES			32		/* the maximum number of framed routes. */
+#define RADIX_NODES			65		/* every route adds at most a leaf and a branch below the root. */
+
+/* one node of the tree, children are indices because the root is never a child. */
+struct pppd_radix_node {
+	uint32_t	key;			/* the prefix in host byte order, host bits are zero. */
+	uint8_t		length;			/* the prefix length. */
+	uint8_t		route;			/* one if the prefix is a framed route, zero for a branch. */
+	uint16_t	child[2];		/* the subtrees for the next bit being zero or one. */
+};
+
+/* the tree, stored in one block, so it is built at authentication without allocation. */
+struct pppd_radix {
+	uint32_t	count;			/* the number of used nodes. */
+	uint32_t	routes;			/* the number of framed routes. */
+	struct pppd_radix_node	nodes[RADIX_NODES];
+};
+
+/* framed routes of the session. */
+extern struct pppd_radix framed_routes;
+
+/* this function return the network mask of the given prefix length. */
+uint32_t pppd__radix_mask(
+	uint8_t		length
+);
+
+/* this function return the bit of the key behind the given prefix length. */
+uint32_t pppd__radix_bit(
+	uint32_t	key,
+	uint8_t		length
+);
+
+/* this function append a new node to the tree. */
+uint16_t pppd__radix_node(
+	struct pppd_radix	*radix,
+	uint32_t	key,
+	uint8_t		length,
+	uint8_t		route
+);
+
+/* this function remove all prefixes from the tree. */
+int32_t pppd__radix_clear(
+	struct pppd_radix	*radix
+);
+
+/* this function add a prefix to the tree. */
+int32_t pppd__radix_insert(
+	struct pppd_radix	*radix,
+	uint32_t	key,
+	uint8_t		length
+);
+
+/* this function check if an address is covered by a prefix of the tree. */
+int32_t pppd__radix_lookup(
+	struct pppd_radix	*radix,
+	uint32_t	addr
+);
+
+/* this function parse a comma separated list of prefixes into the tree. */
+int32_t pppd__radix_parse(
+	struct pppd_radix	*radix,
+	uint8_t		*prefixes
+);
+
+#endif					/* _RADIX_H */
@@ -0,0 +1,283 @@
+/*
+ *  realm.c -- Routing of usernames by their realm to the databases of
+ *             wholesale customers for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+/* plugin includes. */
+#include "realm.h"
+#include "shard.h"
+
+/* this function return the hash of the given realm name, upper and lower case are the same. */
+uint32_t pppd__realm_hash(uint8_t *name, uint32_t length) {
+
+	/* some common variables. */
+	uint32_t hash  = 2166136261U;
+	uint32_t count = 0;
+
+	/* loop through all characters and hash them with 32 bit FNV-1a. */
+	for (count = 0; count < length; count++) {
+		hash = (hash ^ tolower(name[count])) * 16777619U;
+	}
+
+	/* return the hash. */
+	return hash;
+}
+
+/* this function return the next whitespace separated token of a realm line, double quotes may enclose whitespace. */
+uint8_t *pppd__realm_token(uint8_t **string) {
+
+	/* some common variables. */
+	uint8_t *token  = NULL;
+	uint8_t *write  = NULL;
+	uint32_t quoted = 0;
+
+	/* skip whitespace before the token. */
+	*string += strspn((char *)*string, " \t\r\n");
+
+	/* check if line is finished or the rest is a comment. */
+	if (**string == '\0' || **string == '#') {
+		return NULL;
+	}
+
+	/* loop through all characters of the token, the quotes are removed in place. */
+	for (token = write = *string; **string != '\0'; (*string)++) {
+
+		/* check if quoting starts or ends. */
+		if (**string == '"') {
+			quoted ^= 1;
+			continue;
+		}
+
+		/* check if unquoted whitespace ends the token. */
+		if (quoted == 0 && strchr(" \t\r\n", **string) != NULL) {
+			(*string)++;
+			break;
+		}
+
+		/* copy the character. */
+		*write++ = **string;
+	}
+
+	/* terminate the token. */
+	*write = '\0';
+
+	/* return the token. */
+	return token;
+}
+
+/* this function copy a realm value and return -1 if it does not fit. */
+int32_t pppd__realm_value(uint8_t *value, uint32_t size, uint8_t *string) {
+
+	/* check if value fits. */
+	if (strlen((char *)string) >= size) {
+		return -1;
+	}
+
+	/* copy the value. */
+	strcpy((char *)value, (char *)string);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function parse one line of the realm file into the given realm. */
+int32_t pppd__realm_parse(uint8_t *string, uint8_t *port, uint8_t *table, struct pppd_realm *realm) {
+
+	/* some common variables. */
+	struct pppd_shard shards[SIZE_SHARDS];
+	uint8_t *name   = NULL;
+	uint8_t *shard  = NULL;
+	uint8_t *option = NULL;
+	uint8_t *value  = NULL;
+	uint32_t count  = 0;
+	int32_t result  = 0;
+
+	/* check if realm and its database are given, the database is written like one shard. */
+	if ((name = pppd__realm_token(&string)) == NULL ||
+	    (shard = pppd__realm_token(&string)) == NULL ||
+	    pppd__realm_value(realm->name, SIZE_REALM_NAME, name) < 0 ||
+	    pppd__shard_parse(shard, port, table, shards, &count) < 0 ||
+	    count != 1) {
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* store the database. */
+	memcpy(&realm->shard, &shards[0], sizeof(struct pppd_shard));
+
+	/* loop through all characters and store the realm in lower case. */
+	for (name = realm->name; *name != '\0'; name++) {
+		*name = tolower(*name);
+	}
+
+	/* loop through all optional key=value settings. */
+	while ((option = pppd__realm_token(&string)) != NULL) {
+
+		/* check if setting has a value. */
+		if ((value = (uint8_t *)strchr((char *)option, '=')) == NULL) {
+			return -1;
+		}
+
+		/* split the key from the value. */
+		*value++ = '\0';
+
+		/* store the known settings. */
+		if (strcmp((char *)option, "user") == 0) {
+			result = pppd__realm_value(realm->user, SIZE_REALM_VALUE, value);
+		} else if (strcmp((char *)option, "pass") == 0) {
+			result = pppd__realm_value(realm->pass, SIZE_REALM_VALUE, value);
+		} else if (strcmp((char *)option, "column-user") == 0) {
+			result = pppd__realm_value(realm->column_user, SIZE_REALM_VALUE, value);
+		} else if (strcmp((char *)option, "column-pass") == 0) {
+			result = pppd__realm_value(realm->column_pass, SIZE_REALM_VALUE, value);
+		} else if (strcmp((char *)option, "column-client-ip") == 0) {
+			result = pppd__realm_value(realm->column_client_ip, SIZE_REALM_VALUE, value);
+		} else if (strcmp((char *)option, "column-server-ip") == 0) {
+			result = pppd__realm_value(realm->column_server_ip, SIZE_REALM_VALUE, value);
+		} else if (strcmp((char *)option, "condition") == 0) {
+			result = pppd__realm_value(realm->condition, SIZE_REALM_CONDITION, value);
+		} else {
+			result = -1;
+		}
+
+		/* check if setting is unknown or too long. */
+		if (result < 0) {
+			return -1;
+		}
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function load the realm file, the line of the first invalid realm is returned on error. */
+int32_t pppd__realm_load(uint8_t *path, uint8_t *port, uint8_t *table, struct pppd_realms *realms, uint32_t *line) {
+
+	/* some common variables. */
+	uint8_t buffer[SIZE_REALM_NAME + SIZE_SHARD_HOST + SIZE_REALM_CONDITION + 8 * SIZE_REALM_VALUE];
+	uint8_t *string = NULL;
+	uint32_t slot   = 0;
+	int32_t result  = 0;
+	FILE *file      = NULL;
+	struct pppd_realm *realm = NULL;
+
+	/* initialize the realms. */
+	memset(realms, 0, sizeof(struct pppd_realms));
+	*line = 0;
+
+	/* check if realm file was opened. */
+	if ((file = fopen((char *)path, "r")) == NULL) {
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* loop through all lines. */
+	while (fgets((char *)buffer, sizeof(buffer), file) != NULL) {
+
+		/* count the line. */
+		(*line)++;
+
+		/* check if line is empty or a comment. */
+		string = buffer + strspn((char *)buffer, " \t\r\n");
+		if (*string == '\0' || *string == '#') {
+			continue;
+		}
+
+		/* check if line was complete, too many realms are given or the realm is not valid. */
+		realm = &realms->realm[realms->count];
+		if ((strchr((char *)buffer, '\n') == NULL && feof(file) == 0) ||
+		    realms->count == SIZE_REALMS ||
+		    pppd__realm_parse(string, port, table, realm) < 0) {
+			result = -1;
+			break;
+		}
+
+		/* loop through the hash slots until a free one is found, a realm must be unique. */
+		for (slot = pppd__realm_hash(realm->name, strlen((char *)realm->name)) & (SIZE_REALM_HASH - 1);
+		     realms->index[slot] != 0 && strcmp((char *)realms->realm[realms->index[slot] - 1].name, (char *)realm->name) != 0;
+		     slot = (slot + 1) & (SIZE_REALM_HASH - 1));
+
+		/* check if realm is given twice. */
+		if (realms->index[slot] != 0) {
+			result = -1;
+			break;
+		}
+
+		/* store the realm. */
+		realms->index[slot] = ++realms->count;
+	}
+
+	/* check if all lines were read. */
+	if (result < 0 || ferror(file) != 0) {
+
+		/* close the realm file. */
+		fclose(file);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* close the realm file. */
+	fclose(file);
+
+	/* if no error was found, return zero. */
+	*line = 0;
+	return 0;
+}
+
+/* this function return the realm of the given username or -1 if no realm matches. */
+int32_t pppd__realm_find(struct pppd_realms *realms, uint8_t *name) {
+
+	/* some common variables. */
+	uint8_t *suffix = NULL;
+	uint32_t length = 0;
+	uint32_t slot   = 0;
+	struct pppd_realm *realm = NULL;
+
+	/* check if realms are given and the username has a realm behind the last at sign. */
+	if (realms->count == 0 ||
+	    (suffix = (uint8_t *)strrchr((char *)name, '@')) == NULL) {
+		return -1;
+	}
+
+	/* loop through the realm and all its parent domains, the longest match wins. */
+	for (suffix++; *suffix != '\0'; suffix += strcspn((char *)suffix, ".") + (suffix[strcspn((char *)suffix, ".")] == '.')) {
+
+		/* loop through the hash slots until an empty one is found. */
+		length = strlen((char *)suffix);
+		for (slot = pppd__realm_hash(suffix, length) & (SIZE_REALM_HASH - 1); realms->index[slot] != 0; slot = (slot + 1) & (SIZE_REALM_HASH - 1)) {
+
+			/* check if realm matches. */
+			realm = &realms->realm[realms->index[slot] - 1];
+			if (strcasecmp((char *)realm->name, (char *)suffix) == 0) {
+				return realms->index[slot] - 1;
+			}
+		}
+	}
+
+	/* return with error, no realm matches. */
+	return -1;
+}
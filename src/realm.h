@@ -0,0 +1,79 @@
+/*
+ *  realm.h -- Routing of usernames by their realm to the databases of
+ *             wholesale customers for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _REALM_H
+#define _REALM_H
+
+/* generic includes. */
+#include <stdint.h>
+
+/* plugin includes. */
+#include "shard.h"
+
+/* define realm constants. */
+#define SIZE_REALMS			64		/* the maximum number of realms. */
+#define SIZE_REALM_HASH			128		/* the size of the realm hash table, a power of two above the number of realms. */
+#define SIZE_REALM_NAME			128		/* the size of a realm name. */
+#define SIZE_REALM_VALUE		64		/* the size of a realm user, password or column. */
+#define SIZE_REALM_CONDITION		1024		/* the size of a realm condition. */
+#define SIZE_TARGETS			(SIZE_SHARDS + SIZE_REALMS)	/* the maximum number of shards and realms a user is routed to. */
+
+/* one realm with the database of its users, empty values are taken from the options. */
+struct pppd_realm {
+	uint8_t		name[SIZE_REALM_NAME];	/* the realm in lower case, it matches itself and all subdomains. */
+	struct pppd_shard	shard;		/* the database host, port, database and table. */
+	uint8_t		user[SIZE_REALM_VALUE];	/* the database user. */
+	uint8_t		pass[SIZE_REALM_VALUE];	/* the database password. */
+	uint8_t		column_user[SIZE_REALM_VALUE];	/* the username column. */
+	uint8_t		column_pass[SIZE_REALM_VALUE];	/* the password column. */
+	uint8_t		column_client_ip[SIZE_REALM_VALUE];	/* the client ip address column. */
+	uint8_t		column_server_ip[SIZE_REALM_VALUE];	/* the server ip address column. */
+	uint8_t		condition[SIZE_REALM_CONDITION];	/* the additional condition of the password query. */
+};
+
+/* all realms of the realm file with a hash table of their names. */
+struct pppd_realms {
+	uint32_t	count;			/* the number of realms. */
+	uint32_t	index[SIZE_REALM_HASH];	/* the realm of each hash slot plus one, zero if the slot is empty. */
+	struct pppd_realm	realm[SIZE_REALMS];	/* the realms. */
+};
+
+/* this function return the hash of the given realm name, upper and lower case are the same. */
+uint32_t pppd__realm_hash(
+	uint8_t		*name,
+	uint32_t	length
+);
+
+/* this function load the realm file, the line of the first invalid realm is returned on error. */
+int32_t pppd__realm_load(
+	uint8_t		*path,
+	uint8_t		*port,
+	uint8_t		*table,
+	struct pppd_realms	*realms,
+	uint32_t	*line
+);
+
+/* this function return the realm of the given username or -1 if no realm matches. */
+int32_t pppd__realm_find(
+	struct pppd_realms	*realms,
+	uint8_t		*name
+);
+
+#endif					/* _REALM_H */
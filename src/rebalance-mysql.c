@@ -0,0 +1,354 @@
+/*
+ *  rebalance-mysql.c -- Move credentials between the shards of the MySQL
+ *                       database of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* generic includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* mysql includes. */
+#include <mysql/mysql.h>
+
+/* plugin includes. */
+#include "pppd-sql.h"
+#include "rebalance-sql.h"
+#include "str.h"
+
+/* this function connect to the given mysql shard. */
+int32_t pppd__rebalance_mysql_connect(struct pppd_rebalance *rebalance, struct pppd_shard *shard, MYSQL **mysql) {
+
+	/* check if mysql structure was initialized. */
+	if ((*mysql = mysql_init(NULL)) == NULL) {
+
+		/* something on initialization failed. */
+		fprintf(stderr, "pppd-sql-rebalance: cannot initialize mysql\n");
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_INIT;
+	}
+
+	/* check if connection was successfully established. */
+	if (mysql_real_connect(*mysql, (char *)shard->host, (char *)rebalance->user, (char *)rebalance->pass, (char *)shard->database, shard->port_number, NULL, 0) == NULL) {
+
+		/* something on connecting failed. */
+		fprintf(stderr, "pppd-sql-rebalance: %s: %s\n", shard->host, mysql_error(*mysql));
+
+		/* close the connection. */
+		mysql_close(*mysql);
+		*mysql = NULL;
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_CONNECT;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function execute the given query and show the error. */
+int32_t pppd__rebalance_mysql_execute(MYSQL *mysql, uint8_t *query) {
+
+	/* check if query was successfully executed. */
+	if (mysql_query(mysql, (char *)query) != 0) {
+
+		/* something on executing failed. */
+		fprintf(stderr, "pppd-sql-rebalance: %s\n", mysql_error(mysql));
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function copy the given users from the source to the target shard and delete them on the source shard. */
+int32_t pppd__rebalance_mysql_move(struct pppd_rebalance *rebalance, MYSQL *source, struct pppd_shard *source_shard, MYSQL *target, struct pppd_shard *target_shard, uint8_t *names, uint32_t count) {
+
+	/* some common variables. */
+	uint8_t *condition       = NULL;
+	uint8_t *query           = NULL;
+	uint32_t condition_size  = count * (2 * REBALANCE_NAME + 4) + 1024;
+	uint32_t condition_length = 0;
+	uint32_t size            = 1024;
+	uint32_t length          = 0;
+	uint32_t count_names     = 0;
+	uint32_t count_fields    = 0;
+	uint32_t fields          = 0;
+	uint32_t rows            = 0;
+	int32_t result           = 0;
+	unsigned long *lengths   = NULL;
+	MYSQL_RES *res           = NULL;
+	MYSQL_ROW row            = NULL;
+	MYSQL_FIELD *field       = NULL;
+
+	/* check if memory for the condition was successfully allocated. */
+	if ((condition = malloc(condition_size)) == NULL) {
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all users and build the condition, the names are escaped, so they cannot change the query. */
+	pppd__strappend(condition, condition_size, &condition_length, "%s IN (", rebalance->column);
+	for (count_names = 0; count_names < count; count_names++) {
+		pppd__strappend(condition, condition_size, &condition_length, "%s'", count_names > 0 ? ", " : "");
+		condition_length += mysql_real_escape_string(source, (char *)condition + condition_length, (char *)names + count_names * REBALANCE_NAME, strlen((char *)names + count_names * REBALANCE_NAME));
+		pppd__strappend(condition, condition_size, &condition_length, "'");
+	}
+	pppd__strappend(condition, condition_size, &condition_length, ")");
+
+	/* check if memory for the query was successfully allocated. */
+	if ((query = malloc(condition_size)) == NULL) {
+
+		/* clear memory to avoid leaks. */
+		free(condition);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* check if all columns of the users were fetched from the source shard. */
+	snprintf((char *)query, condition_size, "SELECT * FROM %s WHERE %s", source_shard->table, condition);
+	if ((result = pppd__rebalance_mysql_execute(source, query)) < 0 ||
+	    (res = mysql_store_result(source)) == NULL) {
+
+		/* clear memory to avoid leaks. */
+		free(query);
+		free(condition);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all rows and sum the size of the escaped values. */
+	fields = mysql_num_fields(res);
+	field  = mysql_fetch_fields(res);
+	while ((row = mysql_fetch_row(res)) != NULL) {
+		lengths = mysql_fetch_lengths(res);
+		for (count_fields = 0; count_fields < fields; count_fields++) {
+			size += 2 * lengths[count_fields] + 4;
+		}
+		size += 4;
+	}
+
+	/* loop through all columns and sum the size of the quoted names. */
+	for (count_fields = 0; count_fields < fields; count_fields++) {
+		size += strlen(field[count_fields].name) + 4;
+	}
+
+	/* check if memory for the insert was successfully allocated. */
+	free(query);
+	if ((query = malloc(size)) == NULL) {
+
+		/* clear memory to avoid leaks. */
+		mysql_free_result(res);
+		free(condition);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* build the insert, users which already exist on the target shard are kept, so an interrupted run can be repeated. */
+	pppd__strappend(query, size, &length, "INSERT IGNORE INTO %s (", target_shard->table);
+	for (count_fields = 0; count_fields < fields; count_fields++) {
+		pppd__strappend(query, size, &length, "%s`%s`", count_fields > 0 ? ", " : "", field[count_fields].name);
+	}
+	pppd__strappend(query, size, &length, ") VALUES ");
+
+	/* loop through all rows and append their values, escaped for the target shard. */
+	mysql_data_seek(res, 0);
+	while ((row = mysql_fetch_row(res)) != NULL) {
+
+		/* append the row. */
+		lengths = mysql_fetch_lengths(res);
+		pppd__strappend(query, size, &length, "%s(", rows > 0 ? ", " : "");
+		for (count_fields = 0; count_fields < fields; count_fields++) {
+
+			/* check if value is NULL. */
+			if (row[count_fields] == NULL) {
+				pppd__strappend(query, size, &length, "%sNULL", count_fields > 0 ? ", " : "");
+				continue;
+			}
+
+			/* append the escaped value. */
+			pppd__strappend(query, size, &length, "%s'", count_fields > 0 ? ", " : "");
+			length += mysql_real_escape_string(target, (char *)query + length, row[count_fields], lengths[count_fields]);
+			pppd__strappend(query, size, &length, "'");
+		}
+		pppd__strappend(query, size, &length, ")");
+
+		/* increase number of rows. */
+		rows++;
+	}
+
+	/* clear memory to avoid leaks. */
+	mysql_free_result(res);
+
+	/* check if users were found and inserted into the target shard. */
+	if (rows > 0 &&
+	    (result = pppd__rebalance_mysql_execute(target, query)) < 0) {
+
+		/* clear memory to avoid leaks. */
+		free(query);
+		free(condition);
+
+		/* return with error, the users are still on the source shard. */
+		return result;
+	}
+
+	/* check if users should be deleted from the source shard, only after they were inserted into the target shard. */
+	if (rows > 0 && rebalance->keep == 0) {
+
+		/* build and execute the delete. */
+		length = 0;
+		pppd__strappend(query, size, &length, "DELETE FROM %s WHERE %s", source_shard->table, condition);
+		result = pppd__rebalance_mysql_execute(source, query);
+	}
+
+	/* clear memory to avoid leaks. */
+	free(query);
+	free(condition);
+
+	/* return the result. */
+	return result < 0 ? result : (int32_t)rows;
+}
+
+/* this function move all users of the mysql shards whose shard changed. */
+int32_t pppd__rebalance_mysql(struct pppd_rebalance *rebalance) {
+
+	/* some common variables. */
+	uint8_t query[SIZE_QUERY];
+	uint8_t *names              = NULL;
+	uint32_t batches[SIZE_SHARDS] = { 0 };
+	uint32_t source             = 0;
+	uint32_t target             = 0;
+	int32_t moved               = 0;
+	int32_t result              = 0;
+	MYSQL *targets[SIZE_SHARDS] = { NULL };
+	MYSQL *mysql                = NULL;
+	MYSQL_RES *res              = NULL;
+	MYSQL_ROW row               = NULL;
+
+	/* check if memory for one batch of users per new shard was successfully allocated. */
+	if ((names = malloc(SIZE_SHARDS * rebalance->batch * REBALANCE_NAME)) == NULL) {
+
+		/* show the error. */
+		fprintf(stderr, "pppd-sql-rebalance: cannot allocate %u users\n", SIZE_SHARDS * rebalance->batch);
+
+		/* return with error. */
+		return PPPD_SQL_ERROR_QUERY;
+	}
+
+	/* loop through all old shards until one fails. */
+	for (source = 0; source < rebalance->old_count && result == 0; source++) {
+
+		/* check if connect to the old shard is working. */
+		if ((result = pppd__rebalance_mysql_connect(rebalance, &rebalance->old_shards[source], &mysql)) < 0) {
+			break;
+		}
+
+		/* check if all usernames of the old shard were fetched. */
+		snprintf((char *)query, sizeof(query), "SELECT %s FROM %s", rebalance->column, rebalance->old_shards[source].table);
+		if ((result = pppd__rebalance_mysql_execute(mysql, query)) < 0 ||
+		    (res = mysql_store_result(mysql)) == NULL) {
+
+			/* close the connection. */
+			mysql_close(mysql);
+
+			/* return with error. */
+			result = PPPD_SQL_ERROR_QUERY;
+			break;
+		}
+
+		/* loop through all users of the old shard. */
+		while (result == 0 && (row = mysql_fetch_row(res)) != NULL) {
+
+			/* check if user has a name and stays on the old shard. */
+			rebalance->users++;
+			if (row[0] == NULL ||
+			    strlen(row[0]) >= REBALANCE_NAME ||
+			    (moved = pppd__rebalance_target(rebalance, source, (uint8_t *)row[0])) < 0) {
+				continue;
+			}
+
+			/* check if users are only counted. */
+			target = moved;
+			if (rebalance->dry_run == 1) {
+				rebalance->moved[target]++;
+				continue;
+			}
+
+			/* add the user to the batch of the new shard. */
+			strcpy((char *)names + (target * rebalance->batch + batches[target]++) * REBALANCE_NAME, row[0]);
+
+			/* check if batch is full and the new shard is connected. */
+			if (batches[target] == rebalance->batch &&
+			    (targets[target] != NULL || (result = pppd__rebalance_mysql_connect(rebalance, &rebalance->new_shards[target], &targets[target])) == 0)) {
+
+				/* move the batch. */
+				if ((moved = pppd__rebalance_mysql_move(rebalance, mysql, &rebalance->old_shards[source], targets[target], &rebalance->new_shards[target], names + target * rebalance->batch * REBALANCE_NAME, batches[target])) < 0) {
+					result = moved;
+				} else {
+					rebalance->moved[target] += moved;
+				}
+				batches[target] = 0;
+			}
+		}
+
+		/* loop through all new shards and move the remaining users. */
+		for (target = 0; target < rebalance->new_count && result == 0; target++) {
+
+			/* check if batch is not empty and the new shard is connected. */
+			if (batches[target] > 0 &&
+			    (targets[target] != NULL || (result = pppd__rebalance_mysql_connect(rebalance, &rebalance->new_shards[target], &targets[target])) == 0)) {
+
+				/* move the batch. */
+				if ((moved = pppd__rebalance_mysql_move(rebalance, mysql, &rebalance->old_shards[source], targets[target], &rebalance->new_shards[target], names + target * rebalance->batch * REBALANCE_NAME, batches[target])) < 0) {
+					result = moved;
+				} else {
+					rebalance->moved[target] += moved;
+				}
+			}
+		}
+
+		/* reset the batches of the next old shard. */
+		memset(batches, 0, sizeof(batches));
+
+		/* free the result and close the connection. */
+		mysql_free_result(res);
+		mysql_close(mysql);
+	}
+
+	/* loop through all new shards and close the connections. */
+	for (target = 0; target < rebalance->new_count; target++) {
+		if (targets[target] != NULL) {
+			mysql_close(targets[target]);
+		}
+	}
+
+	/* clear memory to avoid leaks. */
+	free(names);
+
+	/* return the result. */
+	return result;
+}
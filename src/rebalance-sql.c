@@ -0,0 +1,200 @@
+/*
+ *  rebalance-sql.c -- Move credentials between the shards of the MySQL or
+ *                     PostgreSQL database of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* configuration includes. */
+#include "config.h"
+
+/* generic includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* plugin includes. */
+#include "rebalance-sql.h"
+#include "shard.h"
+
+/* this function return the new shard of the given user or -1 if it stays on the given old shard. */
+int32_t pppd__rebalance_target(struct pppd_rebalance *rebalance, uint32_t source, uint8_t *name) {
+
+	/* some common variables. */
+	uint32_t target = pppd__shard_select(name, rebalance->new_count);
+
+	/* check if the new shard is the same table as the old one, then the user is not moved. */
+	if (pppd__shard_equal(&rebalance->old_shards[source], &rebalance->new_shards[target]) == 1) {
+		return -1;
+	}
+
+	/* return the new shard. */
+	return target;
+}
+
+/* this function show the usage of the rebalance tool. */
+int32_t pppd__rebalance_usage(uint8_t *program) {
+
+	/* show usage. */
+	fprintf(stderr, "Usage: %s -t type [-u user] [-p password] -s shards [-o old-shards]\n", program);
+	fprintf(stderr, "       [-P port] [-T table] [-c user-column] [-b batch] [-n] [-k]\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Move every user of the old shards whose shard is different under the new shards,\n");
+	fprintf(stderr, "after shards were added or removed. Rows are inserted into the new shard before\n");
+	fprintf(stderr, "they are deleted from the old one, so an interrupted run is completed by running\n");
+	fprintf(stderr, "it again.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -t type             the database type:");
+#ifdef PLUGIN_NAME_MYSQL
+	fprintf(stderr, " mysql");
+#endif
+#ifdef PLUGIN_NAME_PGSQL
+	fprintf(stderr, " pgsql");
+#endif
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -u user             the database user\n");
+	fprintf(stderr, "  -p password         the database password\n");
+	fprintf(stderr, "  -s shards           the new shards like the shards option, host[:port]/database[/table],...\n");
+	fprintf(stderr, "  -o old-shards       the shards which are read (default: the new shards)\n");
+	fprintf(stderr, "  -P port             the port of shards without one like the port option\n");
+	fprintf(stderr, "  -T table            the table of shards without one like the table option (default: login)\n");
+	fprintf(stderr, "  -c user-column      the username column (default: username)\n");
+	fprintf(stderr, "  -b batch            the number of users moved with one statement (default: %u)\n", REBALANCE_BATCH);
+	fprintf(stderr, "  -n                  only count the users which would be moved\n");
+	fprintf(stderr, "  -k                  copy the users but keep them on the old shard\n");
+
+	/* return with error. */
+	return 1;
+}
+
+/* the rebalance tool. */
+int main(int argc, char **argv) {
+
+	/* some common variables. */
+	uint8_t *type       = NULL;
+	uint8_t *new_shards = NULL;
+	uint8_t *old_shards = NULL;
+	uint8_t *port       = NULL;
+	uint8_t *table      = (uint8_t *)"login";
+	uint32_t count      = 0;
+	uint32_t moved      = 0;
+	int32_t option      = 0;
+	int32_t result      = 0;
+	struct pppd_rebalance rebalance;
+
+	/* initialize the rebalance with the defaults. */
+	memset(&rebalance, 0, sizeof(rebalance));
+	rebalance.column = (uint8_t *)"username";
+	rebalance.batch  = REBALANCE_BATCH;
+
+	/* parse the command line. */
+	while ((option = getopt(argc, argv, "t:u:p:s:o:P:T:c:b:nk")) != -1) {
+		switch (option) {
+			case 't':
+				type = (uint8_t *)optarg;
+				break;
+			case 'u':
+				rebalance.user = (uint8_t *)optarg;
+				break;
+			case 'p':
+				rebalance.pass = (uint8_t *)optarg;
+				break;
+			case 's':
+				new_shards = (uint8_t *)optarg;
+				break;
+			case 'o':
+				old_shards = (uint8_t *)optarg;
+				break;
+			case 'P':
+				port = (uint8_t *)optarg;
+				break;
+			case 'T':
+				table = (uint8_t *)optarg;
+				break;
+			case 'c':
+				rebalance.column = (uint8_t *)optarg;
+				break;
+			case 'b':
+				rebalance.batch = strtoul(optarg, NULL, 10);
+				break;
+			case 'n':
+				rebalance.dry_run = 1;
+				break;
+			case 'k':
+				rebalance.keep = 1;
+				break;
+			default:
+				return pppd__rebalance_usage((uint8_t *)argv[0]);
+		}
+	}
+
+	/* check if type and shards are given. */
+	if (type == NULL || new_shards == NULL || rebalance.batch == 0 || optind != argc) {
+		return pppd__rebalance_usage((uint8_t *)argv[0]);
+	}
+
+	/* check if the new and old shards are valid, without old shards misplaced users of the new ones are moved. */
+	if (pppd__shard_parse(new_shards, port, table, rebalance.new_shards, &rebalance.new_count) < 0 ||
+	    pppd__shard_parse(old_shards != NULL ? old_shards : new_shards, port, table, rebalance.old_shards, &rebalance.old_count) < 0) {
+
+		/* show the error. */
+		fprintf(stderr, "%s: shards are not valid\n", argv[0]);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* move the users. */
+	result = -1;
+#ifdef PLUGIN_NAME_MYSQL
+	if (strcmp((char *)type, "mysql") == 0) {
+		result = pppd__rebalance_mysql(&rebalance);
+	}
+#endif
+#ifdef PLUGIN_NAME_PGSQL
+	if (strcmp((char *)type, "pgsql") == 0) {
+		result = pppd__rebalance_pgsql(&rebalance);
+	}
+#endif
+
+	/* loop through all new shards and show the moved users. */
+	for (count = 0; count < rebalance.new_count; count++) {
+
+		/* show the moved users of the shard. */
+		fprintf(stdout, "%s/%s/%s: %u users %s\n", rebalance.new_shards[count].host, rebalance.new_shards[count].database, rebalance.new_shards[count].table,
+			rebalance.moved[count], rebalance.dry_run == 1 ? "to move" : rebalance.keep == 1 ? "copied" : "moved");
+		moved += rebalance.moved[count];
+	}
+
+	/* show the summary. */
+	fprintf(stdout, "%u users checked, %u users %s\n", rebalance.users, moved, rebalance.dry_run == 1 ? "to move" : rebalance.keep == 1 ? "copied" : "moved");
+
+	/* check if rebalance failed. */
+	if (result < 0) {
+
+		/* show the error. */
+		fprintf(stderr, "%s: rebalance of %s failed, run it again to move the remaining users\n", argv[0], type);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ *  rebalance-sql.h -- Move credentials between the shards of the MySQL or
+ *                     PostgreSQL database of the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _REBALANCE_SQL_H
+#define _REBALANCE_SQL_H
+
+/* generic includes. */
+#include <stdint.h>
+
+/* plugin includes. */
+#include "shard.h"
+
+/* define rebalance constants. */
+#define REBALANCE_BATCH			500		/* the default number of users moved with one statement. */
+#define REBALANCE_NAME			256		/* the maximum length of a username. */
+
+/* the options and the counters of one rebalance run. */
+struct pppd_rebalance {
+	uint8_t		*user;			/* the database user. */
+	uint8_t		*pass;			/* the database password. */
+	uint8_t		*column;		/* the username column. */
+	uint32_t	batch;			/* the number of users moved with one statement. */
+	uint32_t	dry_run;		/* one if users are only counted. */
+	uint32_t	keep;			/* one if users are copied but not deleted from the source shard. */
+	uint32_t	old_count;		/* the number of shards before the change. */
+	uint32_t	new_count;		/* the number of shards after the change. */
+	struct pppd_shard	old_shards[SIZE_SHARDS];	/* the shards which are read. */
+	struct pppd_shard	new_shards[SIZE_SHARDS];	/* the shards which users are moved to. */
+	uint32_t	users;			/* the number of checked users. */
+	uint32_t	moved[SIZE_SHARDS];	/* the number of users moved to each new shard. */
+};
+
+/* this function return the new shard of the given user or -1 if it stays on the given old shard. */
+int32_t pppd__rebalance_target(
+	struct pppd_rebalance	*rebalance,
+	uint32_t	source,
+	uint8_t		*name
+);
+
+/* this function move all users of the mysql shards whose shard changed. */
+int32_t pppd__rebalance_mysql(
+	struct pppd_rebalance	*rebalance
+);
+
+/* this function move all users of the postgresql shards whose shard changed. */
+int32_t pppd__rebalance_pgsql(
+	struct pppd_rebalance	*rebalance
+);
+
+#endif					/* _REBALANCE_SQL_H */
@@ -0,0 +1,98 @@
+/*
+ *  record.c -- Binary encoding of the credential records in the key-value
+ *              store for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <string.h>
+
+/* plugin includes. */
+#include "record.h"
+
+/* this function fill a record with the given credentials. */
+int32_t pppd__record_fill(struct pppd_record *record, uint8_t *secret, uint32_t client_ip, uint32_t server_ip, uint32_t status) {
+
+	/* some common variables. */
+	size_t length = strlen((char *)secret);
+
+	/* check if secret fits into the length field. */
+	if (length > RECORD_SECRET) {
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* cleanup memory, so no old secret is left behind the terminator. */
+	memset(record, 0, sizeof(struct pppd_record));
+
+	/* fill the header. */
+	record->header.version   = RECORD_VERSION;
+	record->header.length    = length;
+	record->header.status    = status;
+	record->header.client_ip = client_ip;
+	record->header.server_ip = server_ip;
+
+	/* copy the secret. */
+	memcpy(record->secret, secret, length);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function encode a record into the given buffer and return the used size. */
+int32_t pppd__record_encode(struct pppd_record *record, uint8_t *buffer, size_t *size) {
+
+	/* copy the header and the secret without terminator, the buffer must hold a full record. */
+	memcpy(buffer, &record->header, sizeof(struct pppd_record_header));
+	memcpy(buffer + sizeof(struct pppd_record_header), record->secret, record->header.length);
+
+	/* store the used size. */
+	*size = sizeof(struct pppd_record_header) + record->header.length;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function decode a record from the given value, the value may be unaligned. */
+int32_t pppd__record_decode(struct pppd_record *record, uint8_t *value, size_t size) {
+
+	/* check if value holds at least the header. */
+	if (size < sizeof(struct pppd_record_header)) {
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* copy the header, the store aligns values only to two bytes. */
+	memcpy(&record->header, value, sizeof(struct pppd_record_header));
+
+	/* check if encoding is known and the value holds exactly the secret. */
+	if (record->header.version != RECORD_VERSION ||
+	    size != sizeof(struct pppd_record_header) + record->header.length) {
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* copy and terminate the secret. */
+	memcpy(record->secret, value + sizeof(struct pppd_record_header), record->header.length);
+	record->secret[record->header.length] = '\0';
+
+	/* if no error was found, return zero. */
+	return 0;
+}
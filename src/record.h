@@ -0,0 +1,70 @@
+/*
+ *  record.h -- Binary encoding of the credential records in the key-value
+ *              store for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RECORD_H
+#define _RECORD_H
+
+/* generic includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* define record constants. */
+#define RECORD_VERSION			1		/* the version of the record encoding. */
+#define RECORD_SECRET			255		/* the maximum length of a stored secret. */
+
+/* the fixed header of an encoded record, the secret follows without terminator. */
+struct pppd_record_header {
+	uint8_t		version;		/* the version of the record encoding. */
+	uint8_t		length;			/* the length of the secret. */
+	uint16_t	status;			/* the login status. */
+	uint32_t	client_ip;		/* the client ip address in network byte order. */
+	uint32_t	server_ip;		/* the server ip address in network byte order. */
+};
+
+/* one decoded credential record. */
+struct pppd_record {
+	struct pppd_record_header	header;	/* the fixed header. */
+	uint8_t		secret[RECORD_SECRET + 1];	/* the secret, terminated for the password functions. */
+};
+
+/* this function fill a record with the given credentials. */
+int32_t pppd__record_fill(
+	struct pppd_record	*record,
+	uint8_t		*secret,
+	uint32_t	client_ip,
+	uint32_t	server_ip,
+	uint32_t	status
+);
+
+/* this function encode a record into the given buffer and return the used size. */
+int32_t pppd__record_encode(
+	struct pppd_record	*record,
+	uint8_t		*buffer,
+	size_t		*size
+);
+
+/* this function decode a record from the given value, the value may be unaligned. */
+int32_t pppd__record_decode(
+	struct pppd_record	*record,
+	uint8_t		*value,
+	size_t		size
+);
+
+#endif					/* _RECORD_H */
@@ -0,0 +1,299 @@
+/*
+ *  registry.c -- Host-local registry of running sessions for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* plugin includes. */
+#include "plugin.h"
+#include "registry.h"
+
+/* this function open the registry lock. */
+int32_t pppd__registry_open(uint8_t *directory) {
+
+	/* some common variables. */
+	uint8_t path[MAXPATHLEN];
+
+	/* create registry directory, ignore error if it exists. */
+	mkdir((char *)directory, 0700);
+
+	/* build path of the registry lock. */
+	slprintf((char *)path, sizeof(path), "%s/%s", directory, REGISTRY_LOCK);
+
+	/* open the registry lock. */
+	return open((char *)path, O_RDWR | O_CREAT, 0600);
+}
+
+/* this function check if the given process is a running ppp daemon. */
+int32_t pppd__registry_alive(pid_t pid) {
+
+	/* some common variables. */
+	uint8_t path[MAXPATHLEN];
+	uint8_t comm[32];
+	int32_t fd     = 0;
+	int32_t result = 0;
+
+	/* build path of the process name. */
+	slprintf((char *)path, sizeof(path), "/proc/%d/comm", pid);
+	memset(comm, 0, sizeof(comm));
+
+	/* check if process name can be read. */
+	if ((fd = open((char *)path, O_RDONLY)) < 0) {
+
+		/* process is not running. */
+		return 0;
+	}
+
+	/* check if process is a ppp daemon, the process id may be reused by another program. */
+	if (read(fd, comm, sizeof(comm) - 1) > 0 &&
+	    strncmp((char *)comm, "pppd\n", 5) == 0) {
+
+		/* process is running. */
+		result = 1;
+	}
+
+	/* close process name. */
+	close(fd);
+
+	/* return the result. */
+	return result;
+}
+
+/* this function register the session of this ppp daemon and return the held registry lock. */
+int32_t pppd__registry_add(uint8_t *directory, uint8_t *name) {
+
+	/* some common variables. */
+	uint8_t path[MAXPATHLEN];
+	uint8_t path_temp[MAXPATHLEN];
+	int32_t lock_fd = 0;
+	int32_t fd      = 0;
+
+	/* check if registry lock can be opened. */
+	if ((lock_fd = pppd__registry_open(directory)) < 0) {
+
+		/* error on opening registry. */
+		error("Plugin: Registry %s could not be opened: %m\n", directory);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_REGISTRY;
+	}
+
+	/* take shared lock, it is held until the login status is written, so reconciliation cannot reset it. */
+	flock(lock_fd, LOCK_SH);
+
+	/* build path of the session entry. */
+	slprintf((char *)path, sizeof(path), "%s/%d", directory, getpid());
+	slprintf((char *)path_temp, sizeof(path_temp), "%s/.%d", directory, getpid());
+
+	/* check if session entry was successfully written. (renamed, so a scan never sees a partial entry) */
+	if ((fd = open((char *)path_temp, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0 ||
+	    write(fd, name, strlen((char *)name)) < 0 ||
+	    close(fd) < 0 ||
+	    rename((char *)path_temp, (char *)path) < 0) {
+
+		/* error on writing registry. */
+		error("Plugin: Registry %s could not be written: %m\n", directory);
+
+		/* unlock and close registry. */
+		pppd__registry_unlock(lock_fd);
+
+		/* return with error and terminate link. */
+		return PPPD_SQL_ERROR_REGISTRY;
+	}
+
+	/* return the held lock. */
+	return lock_fd;
+}
+
+/* this function remove the session of this ppp daemon from registry. */
+int32_t pppd__registry_remove(uint8_t *directory) {
+
+	/* some common variables. */
+	uint8_t path[MAXPATHLEN];
+
+	/* build path of the session entry. */
+	slprintf((char *)path, sizeof(path), "%s/%d", directory, getpid());
+
+	/* remove session entry. (ignore return code, it may not exist) */
+	unlink((char *)path);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function take the exclusive registry lock if reconciliation is due. */
+int32_t pppd__registry_lock(uint8_t *directory, uint32_t interval) {
+
+	/* some common variables. */
+	uint8_t path[MAXPATHLEN];
+	int32_t lock_fd = 0;
+	int32_t fd      = 0;
+	struct stat stamp_stat;
+
+	/* check if registry lock can be opened. */
+	if ((lock_fd = pppd__registry_open(directory)) < 0) {
+
+		/* return with error, reconciliation is skipped. */
+		return PPPD_SQL_ERROR_REGISTRY;
+	}
+
+	/* check if another ppp daemon is reconciling or a login is running, then we try again later. */
+	if (flock(lock_fd, LOCK_EX | LOCK_NB) < 0) {
+
+		/* close registry lock. */
+		close(lock_fd);
+
+		/* return with error, reconciliation is skipped. */
+		return PPPD_SQL_ERROR_REGISTRY;
+	}
+
+	/* build path of the reconciliation stamp. */
+	slprintf((char *)path, sizeof(path), "%s/%s", directory, REGISTRY_STAMP);
+
+	/* check if another ppp daemon on this host reconciled within the interval. */
+	if (stat((char *)path, &stamp_stat) == 0 &&
+	    time(NULL) - stamp_stat.st_mtime < interval) {
+
+		/* unlock and close registry. */
+		pppd__registry_unlock(lock_fd);
+
+		/* return with error, reconciliation is skipped. */
+		return PPPD_SQL_ERROR_REGISTRY;
+	}
+
+	/* create or touch the reconciliation stamp. */
+	if ((fd = open((char *)path, O_WRONLY | O_CREAT, 0600)) >= 0) {
+		close(fd);
+	}
+	utime((char *)path, NULL);
+
+	/* return the held lock. */
+	return lock_fd;
+}
+
+/* this function release a registry lock. */
+int32_t pppd__registry_unlock(int32_t fd) {
+
+	/* check if lock is held. */
+	if (fd >= 0) {
+
+		/* unlock and close registry. */
+		flock(fd, LOCK_UN);
+		close(fd);
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function return the usernames of all sessions running on this host. */
+int32_t pppd__registry_users(uint8_t *directory, uint8_t **names, uint32_t *count) {
+
+	/* some common variables. */
+	uint8_t path[MAXPATHLEN];
+	uint8_t *names_new = NULL;
+	uint32_t size  = 64;
+	int32_t fd     = 0;
+	int32_t length = 0;
+	pid_t pid      = 0;
+	DIR *dir       = NULL;
+	struct dirent *entry = NULL;
+
+	/* no sessions found so far. */
+	*count = 0;
+
+	/* check if registry directory can be opened. */
+	if ((dir = opendir((char *)directory)) == NULL) {
+
+		/* return with error, reconciliation is skipped. */
+		return PPPD_SQL_ERROR_REGISTRY;
+	}
+
+	/* check if memory for usernames was successfully allocated. */
+	if ((*names = malloc(size * MAXNAMELEN)) == NULL) {
+
+		/* close registry directory. */
+		closedir(dir);
+
+		/* return with error, reconciliation is skipped. */
+		return PPPD_SQL_ERROR_REGISTRY;
+	}
+
+	/* loop through all session entries. */
+	while ((entry = readdir(dir)) != NULL) {
+
+		/* check if entry is named by a process id. */
+		if ((pid = atoi(entry->d_name)) <= 0) {
+			continue;
+		}
+
+		/* check if process is still a running ppp daemon. */
+		if (pppd__registry_alive(pid) == 0) {
+
+			/* build path of the session entry. */
+			slprintf((char *)path, sizeof(path), "%s/%s", directory, entry->d_name);
+
+			/* remove entry of the crashed ppp daemon. */
+			unlink((char *)path);
+
+			/* check next entry. */
+			continue;
+		}
+
+		/* check if we need more memory. */
+		if (*count == size) {
+
+			/* double the memory. */
+			size *= 2;
+
+			/* check if memory was successfully reallocated. */
+			if ((names_new = realloc(*names, size * MAXNAMELEN)) == NULL) {
+
+				/* close registry directory. */
+				closedir(dir);
+
+				/* return with error, reconciliation is skipped. (the caller frees the old memory) */
+				return PPPD_SQL_ERROR_REGISTRY;
+			}
+
+			/* use the reallocated memory. */
+			*names = names_new;
+		}
+
+		/* build path of the session entry. */
+		slprintf((char *)path, sizeof(path), "%s/%s", directory, entry->d_name);
+
+		/* check if username was successfully read. */
+		if ((fd = open((char *)path, O_RDONLY)) >= 0) {
+
+			/* read username. */
+			memset(*names + *count * MAXNAMELEN, 0, MAXNAMELEN);
+			length = read(fd, *names + *count * MAXNAMELEN, MAXNAMELEN - 1);
+			close(fd);
+
+			/* check if username is not empty. */
+			if (length > 0) {
+				(*count)++;
+			}
+		}
+	}
+
+	/* close registry directory. */
+	closedir(dir);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ *  registry.h -- Host-local registry of running sessions for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _REGISTRY_H
+#define _REGISTRY_H
+
+/* generic includes. */
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+/* define registry constants. */
+#define REGISTRY_LOCK			".lock"		/* the lock between logins and reconciliation. */
+#define REGISTRY_STAMP			".reconcile"	/* the time of the last reconciliation. */
+
+/* this function check if the given process is a running ppp daemon. */
+int32_t pppd__registry_alive(
+	pid_t		pid
+);
+
+/* this function register the session of this ppp daemon and return the held registry lock. */
+int32_t pppd__registry_add(
+	uint8_t		*directory,
+	uint8_t		*name
+);
+
+/* this function remove the session of this ppp daemon from registry. */
+int32_t pppd__registry_remove(
+	uint8_t		*directory
+);
+
+/* this function take the exclusive registry lock if reconciliation is due. */
+int32_t pppd__registry_lock(
+	uint8_t		*directory,
+	uint32_t	interval
+);
+
+/* this function release a registry lock. */
+int32_t pppd__registry_unlock(
+	int32_t		fd
+);
+
+/* this function return the usernames of all sessions running on this host. */
+int32_t pppd__registry_users(
+	uint8_t		*directory,
+	uint8_t		**names,
+	uint32_t	*count
+);
+
+#endif					/* _REGISTRY_H */
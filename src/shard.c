@@ -0,0 +1,212 @@
+/*
+ *  shard.c -- Routing of usernames to the shards of the credential database
+ *             for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <stdlib.h>
+#include <string.h>
+
+/* plugin includes. */
+#include "shard.h"
+#include "str.h"
+
+/* this function fill a shard with the given parts, the port may be NULL for the default. */
+int32_t pppd__shard_fill(struct pppd_shard *shard, uint8_t *host, uint8_t *port, uint8_t *database, uint8_t *table) {
+
+	/* some common variables. */
+	uint8_t *end       = NULL;
+	uint32_t port_number = 0;
+
+	/* check if port is a number, it is parsed once here instead of on every connect. */
+	if (port != NULL && *port != '\0') {
+
+		/* check if port is a valid tcp port, zero would silently select the default. */
+		port_number = strtoul((char *)port, (char **)&end, 10);
+		if (*port < '0' || *port > '9' ||
+		    *end != '\0' ||
+		    port_number == 0 ||
+		    port_number > 65535) {
+
+			/* return with error. */
+			return -1;
+		}
+	}
+
+	/* check if all parts are given and fit into the shard. */
+	if (host     == NULL ||
+	    database == NULL ||
+	    table    == NULL ||
+	    strlen((char *)host) >= SIZE_SHARD_HOST ||
+	    (port != NULL && strlen((char *)port) >= SIZE_SHARD_PORT) ||
+	    strlen((char *)database) >= SIZE_SHARD_NAME ||
+	    strlen((char *)table) >= SIZE_SHARD_NAME) {
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* store the shard. */
+	memset(shard, 0, sizeof(struct pppd_shard));
+	strcpy((char *)shard->host, (char *)host);
+	strcpy((char *)shard->port, port != NULL ? (char *)port : "");
+	shard->port_number = port_number;
+	strcpy((char *)shard->database, (char *)database);
+	strcpy((char *)shard->table, (char *)table);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function parse a comma separated list of host[:port]/database[/table] shards. */
+int32_t pppd__shard_parse(uint8_t *list, uint8_t *port, uint8_t *table, struct pppd_shard *shards, uint32_t *count) {
+
+	/* some common variables. */
+	uint8_t copy[SIZE_SHARDS * (SIZE_SHARD_HOST + SIZE_SHARD_PORT + 2 * SIZE_SHARD_NAME)];
+	uint8_t *string   = copy;
+	uint8_t *shard    = NULL;
+	uint8_t *database = NULL;
+	uint8_t *name     = NULL;
+	uint8_t *number   = NULL;
+
+	/* check if list fits into the buffer. */
+	if (strlen((char *)list) >= sizeof(copy)) {
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* copy the list, it is split in place. */
+	strcpy((char *)copy, (char *)list);
+	*count = 0;
+
+	/* loop through all shards. */
+	while ((shard = pppd__strsep(&string, (uint8_t *)",")) != NULL) {
+
+		/* skip whitespace around the shard. */
+		shard += strspn((char *)shard, " \t");
+		shard[strcspn((char *)shard, " \t")] = '\0';
+
+		/* check if shard is empty. */
+		if (*shard == '\0') {
+			continue;
+		}
+
+		/* check if too many shards are given. */
+		if (*count == SIZE_SHARDS) {
+
+			/* return with error. */
+			return -1;
+		}
+
+		/* split host, database and the optional table. */
+		database = shard;
+		pppd__strsep(&database, (uint8_t *)"/");
+		name = database;
+		pppd__strsep(&name, (uint8_t *)"/");
+
+		/* split the optional port behind the last colon, so the host may be an ipv6 address in brackets. */
+		if ((number = (uint8_t *)strrchr((char *)shard, ':')) != NULL &&
+		    strchr((char *)number, ']') == NULL) {
+			*number++ = '\0';
+		} else {
+			number = port;
+		}
+
+		/* remove the brackets around an ipv6 address, the client libraries expect the plain address. */
+		if (*shard == '[' && shard[strlen((char *)shard) - 1] == ']') {
+			shard[strlen((char *)shard) - 1] = '\0';
+			shard++;
+		}
+
+		/* use the default table if none is given. */
+		if (name == NULL || *name == '\0') {
+			name = table;
+		}
+
+		/* check if all parts are given and the shard was stored. */
+		if (*shard == '\0' ||
+		    database == NULL || *database == '\0' ||
+		    pppd__shard_fill(&shards[*count], shard, number, database, name) < 0) {
+
+			/* return with error. */
+			return -1;
+		}
+
+		/* count the shard. */
+		(*count)++;
+	}
+
+	/* check if at least one shard is given. */
+	if (*count == 0) {
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function return the bucket of the given key by jump consistent hash, growing from n to n+1 buckets moves only 1/(n+1) of the keys. */
+uint32_t pppd__shard_jump(uint64_t key, uint32_t buckets) {
+
+	/* some common variables. */
+	int64_t bucket = -1;
+	int64_t next   = 0;
+
+	/* loop while the next jump stays inside the buckets. */
+	while (next < buckets) {
+		bucket = next;
+		key    = key * 2862933555777941757ULL + 1;
+		next   = (bucket + 1) * ((double)(1LL << 31) / (double)((key >> 33) + 1));
+	}
+
+	/* return the bucket. */
+	return bucket;
+}
+
+/* this function return the shard of the given username, the hash must never change or users are looked up on the wrong shard. */
+uint32_t pppd__shard_select(uint8_t *name, uint32_t count) {
+
+	/* some common variables. */
+	uint64_t key = 14695981039346656037ULL;
+
+	/* check if only one shard is used, then no hash is required. */
+	if (count <= 1) {
+		return 0;
+	}
+
+	/* loop through all characters and hash them with 64 bit FNV-1a. */
+	for (; *name != '\0'; name++) {
+		key = (key ^ *name) * 1099511628211ULL;
+	}
+
+	/* return the shard. */
+	return pppd__shard_jump(key, count);
+}
+
+/* this function return one if both shards are the same table. */
+int32_t pppd__shard_equal(struct pppd_shard *a, struct pppd_shard *b) {
+
+	/* compare all parts of the shards. */
+	return strcmp((char *)a->host, (char *)b->host) == 0 &&
+	       strcmp((char *)a->port, (char *)b->port) == 0 &&
+	       strcmp((char *)a->database, (char *)b->database) == 0 &&
+	       strcmp((char *)a->table, (char *)b->table) == 0;
+}
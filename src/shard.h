@@ -0,0 +1,78 @@
+/*
+ *  shard.h -- Routing of usernames to the shards of the credential database
+ *             for the Plugin.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SHARD_H
+#define _SHARD_H
+
+/* generic includes. */
+#include <stdint.h>
+
+/* define shard constants. */
+#define SIZE_SHARDS			16		/* the maximum number of shards. */
+#define SIZE_SHARD_HOST			256		/* the size of a shard host. */
+#define SIZE_SHARD_PORT			16		/* the size of a shard port. */
+#define SIZE_SHARD_NAME			64		/* the size of a shard database or table name. */
+
+/* one shard of the credential database. */
+struct pppd_shard {
+	uint8_t		host[SIZE_SHARD_HOST];	/* the database host. */
+	uint8_t		port[SIZE_SHARD_PORT];	/* the database port, empty for the default. */
+	uint32_t	port_number;		/* the parsed database port, zero for the default. */
+	uint8_t		database[SIZE_SHARD_NAME];	/* the database name. */
+	uint8_t		table[SIZE_SHARD_NAME];	/* the authentication table. */
+};
+
+/* this function fill a shard with the given parts, the port may be NULL for the default. */
+int32_t pppd__shard_fill(
+	struct pppd_shard	*shard,
+	uint8_t		*host,
+	uint8_t		*port,
+	uint8_t		*database,
+	uint8_t		*table
+);
+
+/* this function parse a comma separated list of host[:port]/database[/table] shards. */
+int32_t pppd__shard_parse(
+	uint8_t		*list,
+	uint8_t		*port,
+	uint8_t		*table,
+	struct pppd_shard	*shards,
+	uint32_t	*count
+);
+
+/* this function return the bucket of the given key by jump consistent hash. */
+uint32_t pppd__shard_jump(
+	uint64_t	key,
+	uint32_t	buckets
+);
+
+/* this function return the shard of the given username. */
+uint32_t pppd__shard_select(
+	uint8_t		*name,
+	uint32_t	count
+);
+
+/* this function return one if both shards are the same table. */
+int32_t pppd__shard_equal(
+	struct pppd_shard	*a,
+	struct pppd_shard	*b
+);
+
+#endif					/* _SHARD_H */
@@ -0,0 +1,197 @@
+/*
+ *  stats-sql.c -- Show the login latency histograms and counters of the MySQL
+ *                 and PostgreSQL Plugin from the shared-memory stats file.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* plugin includes. */
+#include "stats.h"
+
+/* the names of the measured phases, in the order of the constants. */
+const char *pppd_stats_phases[STATS_PHASES] = { "connect", "query", "decrypt", "verify", "status", "script", "login" };
+
+/* the names of the negated error codes, unknown codes are counted as zero. */
+const char *pppd_stats_errors[STATS_ERRORS] = {
+	"unknown", "incomplete", "init", "option", "connect", "query", "password", "script",
+	"journal", "registry", "lease", "pool", "netlink", "route", "unknown", "unknown"
+};
+
+/* this function show the usage of the stats tool. */
+int32_t pppd__stats_usage(uint8_t *program) {
+
+	/* show usage. */
+	fprintf(stderr, "Usage: %s -f file [-p]\n", program);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Show the login latencies and counters which all ppp daemons of this host\n");
+	fprintf(stderr, "recorded in the stats file given by the mysql-stats, pgsql-stats, sqlite-stats\n");
+	fprintf(stderr, "or lmdb-stats option.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -f file             the stats file\n");
+	fprintf(stderr, "  -p                  show the stats in the prometheus text format\n");
+
+	/* return with error. */
+	return 1;
+}
+
+/* this function show the stats as table, latencies in milliseconds. */
+int32_t pppd__stats_table(struct pppd_stats_stripe *sum) {
+
+	/* some common variables. */
+	struct pppd_stats_histogram *histogram = NULL;
+	uint32_t count = 0;
+
+	/* show the latencies of all phases. */
+	fprintf(stdout, "%-10s %12s %12s %12s %12s %12s %12s\n", "phase", "count", "mean", "p50", "p99", "p999", "max");
+	for (count = 0; count < STATS_PHASES; count++) {
+		histogram = &sum->phases[count];
+		fprintf(stdout, "%-10s %12llu %12.3f %12.3f %12.3f %12.3f %12.3f\n", pppd_stats_phases[count],
+			(unsigned long long)histogram->count,
+			histogram->count > 0 ? histogram->sum / 1000.0 / histogram->count : 0.0,
+			pppd__stats_percentile(histogram, 0.5) / 1000.0,
+			pppd__stats_percentile(histogram, 0.99) / 1000.0,
+			pppd__stats_percentile(histogram, 0.999) / 1000.0,
+			histogram->max / 1000.0);
+	}
+
+	/* show the counters. */
+	fprintf(stdout, "\n");
+	fprintf(stdout, "%-20s %12llu\n", "logins", (unsigned long long)sum->counters[PPPD_STATS_LOGINS]);
+	fprintf(stdout, "%-20s %12llu\n", "accepted", (unsigned long long)sum->counters[PPPD_STATS_ACCEPTED]);
+	fprintf(stdout, "%-20s %12llu\n", "round trips", (unsigned long long)sum->counters[PPPD_STATS_ROUND_TRIPS]);
+	fprintf(stdout, "%-20s %12llu\n", "retries", (unsigned long long)sum->counters[PPPD_STATS_RETRIES]);
+
+	/* show the failures which happened at least once. */
+	for (count = 0; count < STATS_ERRORS; count++) {
+		if (sum->failures[count] > 0) {
+			fprintf(stdout, "failed %-13s %12llu\n", pppd_stats_errors[count], (unsigned long long)sum->failures[count]);
+		}
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function show the stats in the prometheus text format, latencies in seconds. */
+int32_t pppd__stats_prometheus(struct pppd_stats_stripe *sum) {
+
+	/* some common variables. */
+	struct pppd_stats_histogram *histogram = NULL;
+	uint32_t count = 0;
+
+	/* show the latencies of all phases as summary. */
+	fprintf(stdout, "# HELP pppd_sql_phase_seconds Latency of the login phases.\n");
+	fprintf(stdout, "# TYPE pppd_sql_phase_seconds summary\n");
+	for (count = 0; count < STATS_PHASES; count++) {
+		histogram = &sum->phases[count];
+		fprintf(stdout, "pppd_sql_phase_seconds{phase=\"%s\",quantile=\"0.5\"} %.6f\n", pppd_stats_phases[count], pppd__stats_percentile(histogram, 0.5) / 1000000.0);
+		fprintf(stdout, "pppd_sql_phase_seconds{phase=\"%s\",quantile=\"0.99\"} %.6f\n", pppd_stats_phases[count], pppd__stats_percentile(histogram, 0.99) / 1000000.0);
+		fprintf(stdout, "pppd_sql_phase_seconds{phase=\"%s\",quantile=\"0.999\"} %.6f\n", pppd_stats_phases[count], pppd__stats_percentile(histogram, 0.999) / 1000000.0);
+		fprintf(stdout, "pppd_sql_phase_seconds_sum{phase=\"%s\"} %.6f\n", pppd_stats_phases[count], histogram->sum / 1000000.0);
+		fprintf(stdout, "pppd_sql_phase_seconds_count{phase=\"%s\"} %llu\n", pppd_stats_phases[count], (unsigned long long)histogram->count);
+	}
+
+	/* show the counters. */
+	fprintf(stdout, "# HELP pppd_sql_logins_total Logins checked against the database.\n");
+	fprintf(stdout, "# TYPE pppd_sql_logins_total counter\n");
+	fprintf(stdout, "pppd_sql_logins_total %llu\n", (unsigned long long)sum->counters[PPPD_STATS_LOGINS]);
+	fprintf(stdout, "# HELP pppd_sql_logins_accepted_total Logins accepted by the database.\n");
+	fprintf(stdout, "# TYPE pppd_sql_logins_accepted_total counter\n");
+	fprintf(stdout, "pppd_sql_logins_accepted_total %llu\n", (unsigned long long)sum->counters[PPPD_STATS_ACCEPTED]);
+	fprintf(stdout, "# HELP pppd_sql_round_trips_total Statements sent to the database.\n");
+	fprintf(stdout, "# TYPE pppd_sql_round_trips_total counter\n");
+	fprintf(stdout, "pppd_sql_round_trips_total %llu\n", (unsigned long long)sum->counters[PPPD_STATS_ROUND_TRIPS]);
+	fprintf(stdout, "# HELP pppd_sql_retries_total Connects and statements which were tried again.\n");
+	fprintf(stdout, "# TYPE pppd_sql_retries_total counter\n");
+	fprintf(stdout, "pppd_sql_retries_total %llu\n", (unsigned long long)sum->counters[PPPD_STATS_RETRIES]);
+
+	/* show the failures by error code, all codes are shown, so rates work from the first failure. */
+	fprintf(stdout, "# HELP pppd_sql_login_failures_total Logins rejected by error code.\n");
+	fprintf(stdout, "# TYPE pppd_sql_login_failures_total counter\n");
+	for (count = 0; count < STATS_ERRORS; count++) {
+
+		/* check if error code has a name, the others are counted as unknown. */
+		if (count > 0 && strcmp(pppd_stats_errors[count], "unknown") == 0) {
+			continue;
+		}
+		fprintf(stdout, "pppd_sql_login_failures_total{error=\"%s\"} %llu\n", pppd_stats_errors[count], (unsigned long long)sum->failures[count]);
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* the stats tool. */
+int main(int argc, char **argv) {
+
+	/* some common variables. */
+	uint8_t *file       = NULL;
+	uint32_t prometheus = 0;
+	int32_t option      = 0;
+	struct pppd_stats_file stats;
+	struct pppd_stats_stripe sum;
+
+	/* parse the command line. */
+	while ((option = getopt(argc, argv, "f:p")) != -1) {
+		switch (option) {
+			case 'f':
+				file = (uint8_t *)optarg;
+				break;
+			case 'p':
+				prometheus = 1;
+				break;
+			default:
+				return pppd__stats_usage((uint8_t *)argv[0]);
+		}
+	}
+
+	/* check if stats file is given. */
+	if (file == NULL || optind != argc) {
+		return pppd__stats_usage((uint8_t *)argv[0]);
+	}
+
+	/* check if stats were opened read-only, they are never created or changed by the tool. */
+	if (pppd__stats_open(file, 0, &stats) < 0) {
+
+		/* show the error. */
+		fprintf(stderr, "%s: stats file %s is not usable\n", argv[0], file);
+
+		/* return with error. */
+		return 1;
+	}
+
+	/* add the stripes of all ppp daemons. */
+	pppd__stats_sum(&stats, &sum);
+
+	/* show the stats. */
+	if (prometheus == 1) {
+		pppd__stats_prometheus(&sum);
+	} else {
+		pppd__stats_table(&sum);
+	}
+
+	/* unmap and close stats. */
+	pppd__stats_close(&stats);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
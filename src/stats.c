@@ -0,0 +1,407 @@
+/*
+ *  stats.c -- Latency histograms and counters of the logins in a shared
+ *             memory segment of all ppp daemons on a host.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* generic includes. */
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* plugin includes. */
+#include "probes.h"
+#include "stats.h"
+
+/* check if static tracepoints are supported. */
+#ifdef HAVE_SYS_SDT_H
+
+/* the semaphores of the probes, they are set by the tracer and must be in the probes section. */
+unsigned short pppd_sql_login__start_semaphore __attribute__ ((section (".probes")));
+unsigned short pppd_sql_login__done_semaphore __attribute__ ((section (".probes")));
+unsigned short pppd_sql_phase__start_semaphore __attribute__ ((section (".probes")));
+unsigned short pppd_sql_phase__done_semaphore __attribute__ ((section (".probes")));
+
+#endif					/* HAVE_SYS_SDT_H */
+
+/* the stats of this process, nothing is recorded if they are not opened. */
+struct pppd_stats_file pppd_stats_file = { -1, 0, NULL, NULL, NULL };
+
+/* the phases of the current login of this process. */
+struct pppd_stats_current pppd_stats_current;
+
+/* this function return the bucket of the given value. */
+uint32_t pppd__stats_bucket(uint64_t value) {
+
+	/* some common variables. */
+	uint32_t shift = 0;
+
+	/* check if value is in the linear buckets. */
+	if (value < STATS_SUB) {
+		return value;
+	}
+
+	/* the shift keeps the highest bits of the value as sub bucket. */
+	shift = 63 - __builtin_clzll(value) - STATS_SUB_BITS;
+
+	/* check if value is above the largest bucket. */
+	if (shift >= STATS_SHIFTS) {
+		return STATS_BUCKETS - 1;
+	}
+
+	/* return the bucket. */
+	return (shift + 1) * STATS_SUB + (value >> shift) - STATS_SUB;
+}
+
+/* this function return the largest value of the given bucket. */
+uint64_t pppd__stats_value(uint32_t bucket) {
+
+	/* some common variables. */
+	uint32_t shift = 0;
+
+	/* check if bucket is linear. */
+	if (bucket < STATS_SUB) {
+		return bucket;
+	}
+
+	/* return the largest value with the sub bucket as highest bits. */
+	shift = bucket / STATS_SUB - 1;
+	return ((uint64_t)(STATS_SUB + bucket % STATS_SUB + 1) << shift) - 1;
+}
+
+/* this function open and map the stats, they are created if they do not exist. */
+int32_t pppd__stats_open(uint8_t *path, uint32_t writable, struct pppd_stats_file *stats) {
+
+	/* some common variables. */
+	struct stat stats_stat;
+
+	/* compute the size of header and stripes. */
+	stats->size = sizeof(struct pppd_stats_header) + STATS_STRIPES * sizeof(struct pppd_stats_stripe);
+
+	/* check if stats can be opened, they are shared by all ppp daemons on this host. */
+	if ((stats->fd = open((char *)path, writable == 1 ? O_RDWR | O_CREAT : O_RDONLY, 0644)) < 0) {
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* check if stats have the expected size. */
+	if (fstat(stats->fd, &stats_stat) < 0 ||
+	    (stats_stat.st_size < stats->size && writable == 0)) {
+
+		/* close stats. */
+		close(stats->fd);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* check if stats must be extended, this is only done once. */
+	if (stats_stat.st_size < stats->size) {
+
+		/* lock stats, because another process may create them at the same time. */
+		flock(stats->fd, LOCK_EX);
+
+		/* check if stats are still too small and extend them. */
+		if (fstat(stats->fd, &stats_stat) < 0 ||
+		    (stats_stat.st_size < stats->size && ftruncate(stats->fd, stats->size) < 0)) {
+
+			/* unlock and close stats. */
+			flock(stats->fd, LOCK_UN);
+			close(stats->fd);
+
+			/* return with error. */
+			return -1;
+		}
+
+		/* unlock stats. */
+		flock(stats->fd, LOCK_UN);
+	}
+
+	/* check if stats mapping was successful. */
+	if ((stats->header = mmap(NULL, stats->size, writable == 1 ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, stats->fd, 0)) == MAP_FAILED) {
+
+		/* close stats. */
+		close(stats->fd);
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* stripes are stored directly behind the header, a ppp daemon writes the stripe of its process id. */
+	stats->stripes = (struct pppd_stats_stripe *)(stats->header + 1);
+	stats->stripe  = &stats->stripes[getpid() % STATS_STRIPES];
+
+	/* check if stats are new or were created with another layout, the lock is only taken then. */
+	if (__atomic_load_n(&stats->header->magic, __ATOMIC_ACQUIRE) != STATS_MAGIC ||
+	    stats->header->stripes != STATS_STRIPES ||
+	    stats->header->stripe_size != sizeof(struct pppd_stats_stripe)) {
+
+		/* check if stats are only read, they are not initialized by a reader. */
+		if (writable == 0) {
+
+			/* unmap and close stats. */
+			pppd__stats_close(stats);
+
+			/* return with error. */
+			return -1;
+		}
+
+		/* lock stats, because another process may initialize them at the same time. */
+		flock(stats->fd, LOCK_EX);
+
+		/* check if stats were not initialized while we were waiting. */
+		if (stats->header->magic != STATS_MAGIC ||
+		    stats->header->stripes != STATS_STRIPES ||
+		    stats->header->stripe_size != sizeof(struct pppd_stats_stripe)) {
+
+			/* initialize empty stats. */
+			memset(stats->stripes, 0, STATS_STRIPES * sizeof(struct pppd_stats_stripe));
+			stats->header->stripes     = STATS_STRIPES;
+			stats->header->stripe_size = sizeof(struct pppd_stats_stripe);
+			stats->header->created     = time(NULL);
+
+			/* publish the stats. */
+			__atomic_store_n(&stats->header->magic, STATS_MAGIC, __ATOMIC_RELEASE);
+		}
+
+		/* unlock stats. */
+		flock(stats->fd, LOCK_UN);
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function unmap and close the stats. */
+int32_t pppd__stats_close(struct pppd_stats_file *stats) {
+
+	/* unmap the stats. */
+	munmap(stats->header, stats->size);
+
+	/* close the stats. */
+	close(stats->fd);
+
+	/* nothing is recorded anymore. */
+	stats->header = NULL;
+	stats->stripe = NULL;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function start the timer of a phase. */
+int32_t pppd__stats_start(uint32_t phase, uint8_t *name, struct timespec *start) {
+
+	/* check if a login starts, it has its own probe. */
+	if (phase == PPPD_STATS_LOGIN) {
+
+		/* forget the phases of the previous login. */
+		memset(&pppd_stats_current.elapsed, 0, sizeof(pppd_stats_current.elapsed));
+		pppd_stats_current.retries = 0;
+
+		/* fire the probe of the login. */
+		PPPD_PROBE_LOGIN_START(name);
+	} else {
+
+		/* fire the probe of the phase. */
+		PPPD_PROBE_PHASE_START(phase, name);
+	}
+
+	/* check if neither stats are opened, nor phases are timed, nor a tracer is attached, then the clock is not read. */
+	if (pppd_stats_file.stripe == NULL && pppd_stats_current.timed == 0 && PPPD_PROBE_ENABLED() == 0) {
+
+		/* indicate that the timer was not started. */
+		start->tv_sec  = 0;
+		start->tv_nsec = 0;
+
+		/* nothing is measured. */
+		return 0;
+	}
+
+	/* read the monotonic clock, it does not jump with the time of day. */
+	clock_gettime(CLOCK_MONOTONIC, start);
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function record the time since the given start in the histogram of the phase. */
+int32_t pppd__stats_stop(uint32_t phase, uint8_t *name, int32_t result, struct timespec *start) {
+
+	/* some common variables. */
+	struct timespec stop;
+	struct pppd_stats_histogram *histogram = NULL;
+	uint64_t elapsed = 0;
+	uint64_t value   = 0;
+	uint64_t max     = 0;
+
+	/* check if timer was started, a tracer may have been attached in between. */
+	if (start->tv_sec != 0 || start->tv_nsec != 0) {
+
+		/* compute the elapsed nanoseconds. */
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		elapsed = (stop.tv_sec - start->tv_sec) * 1000000000ULL + stop.tv_nsec - start->tv_nsec;
+	}
+
+	/* keep the time of the phase for the current login. */
+	pppd_stats_current.elapsed[phase] = elapsed;
+
+	/* fire the probe of the phase, the whole login has its own probe. */
+	if (phase == PPPD_STATS_LOGIN) {
+		PPPD_PROBE_LOGIN_DONE(name, result, elapsed);
+	} else {
+		PPPD_PROBE_PHASE_DONE(phase, name, result, elapsed);
+	}
+
+	/* check if stats are not opened or the timer was not started. */
+	if (pppd_stats_file.stripe == NULL ||
+	    (start->tv_sec == 0 && start->tv_nsec == 0)) {
+		return 0;
+	}
+
+	/* add the value in microseconds, other ppp daemons may write the same stripe, so only atomic operations are used. */
+	value     = elapsed / 1000;
+	histogram = &pppd_stats_file.stripe->phases[phase];
+	__atomic_fetch_add(&histogram->buckets[pppd__stats_bucket(value)], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&histogram->sum, value, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+
+	/* loop until the maximum is not smaller than the value. */
+	for (max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED); max < value; ) {
+		if (__atomic_compare_exchange_n(&histogram->max, &max, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function add the given value to a counter. */
+int32_t pppd__stats_count(uint32_t counter, uint64_t value) {
+
+	/* count the retries of the current login. */
+	if (counter == PPPD_STATS_RETRIES) {
+		pppd_stats_current.retries += value;
+	}
+
+	/* check if stats are opened. */
+	if (pppd_stats_file.stripe != NULL) {
+		__atomic_fetch_add(&pppd_stats_file.stripe->counters[counter], value, __ATOMIC_RELAXED);
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function record the result and the time of a login. */
+int32_t pppd__stats_login(uint8_t *name, int32_t result, struct timespec *start) {
+
+	/* check if stats are opened. */
+	if (pppd_stats_file.stripe != NULL) {
+
+		/* count the login and its result, unknown errors are counted as zero. */
+		__atomic_fetch_add(&pppd_stats_file.stripe->counters[PPPD_STATS_LOGINS], 1, __ATOMIC_RELAXED);
+		if (result == 0) {
+			__atomic_fetch_add(&pppd_stats_file.stripe->counters[PPPD_STATS_ACCEPTED], 1, __ATOMIC_RELAXED);
+		} else {
+			__atomic_fetch_add(&pppd_stats_file.stripe->failures[result < 0 && -result < STATS_ERRORS ? -result : 0], 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	/* record the time of the whole login. */
+	return pppd__stats_stop(PPPD_STATS_LOGIN, name, result, start);
+}
+
+/* this function add all stripes of the stats into one. */
+int32_t pppd__stats_sum(struct pppd_stats_file *stats, struct pppd_stats_stripe *sum) {
+
+	/* some common variables. */
+	struct pppd_stats_stripe *stripe = NULL;
+	uint32_t count  = 0;
+	uint32_t phase  = 0;
+	uint32_t bucket = 0;
+
+	/* clear the sum. */
+	memset(sum, 0, sizeof(struct pppd_stats_stripe));
+
+	/* loop through all stripes, they are read while ppp daemons write them, so each value is loaded atomically. */
+	for (count = 0; count < STATS_STRIPES; count++) {
+
+		/* add the counters. */
+		stripe = &stats->stripes[count];
+		for (bucket = 0; bucket < STATS_COUNTERS; bucket++) {
+			sum->counters[bucket] += __atomic_load_n(&stripe->counters[bucket], __ATOMIC_RELAXED);
+		}
+		for (bucket = 0; bucket < STATS_ERRORS; bucket++) {
+			sum->failures[bucket] += __atomic_load_n(&stripe->failures[bucket], __ATOMIC_RELAXED);
+		}
+
+		/* loop through all phases and add the histograms. */
+		for (phase = 0; phase < STATS_PHASES; phase++) {
+			sum->phases[phase].sum += __atomic_load_n(&stripe->phases[phase].sum, __ATOMIC_RELAXED);
+			if (__atomic_load_n(&stripe->phases[phase].max, __ATOMIC_RELAXED) > sum->phases[phase].max) {
+				sum->phases[phase].max = __atomic_load_n(&stripe->phases[phase].max, __ATOMIC_RELAXED);
+			}
+			for (bucket = 0; bucket < STATS_BUCKETS; bucket++) {
+				sum->phases[phase].buckets[bucket] += __atomic_load_n(&stripe->phases[phase].buckets[bucket], __ATOMIC_RELAXED);
+			}
+		}
+	}
+
+	/* loop through all phases and count the values of the buckets, so count and buckets always match. */
+	for (phase = 0; phase < STATS_PHASES; phase++) {
+		for (bucket = 0; bucket < STATS_BUCKETS; bucket++) {
+			sum->phases[phase].count += sum->phases[phase].buckets[bucket];
+		}
+	}
+
+	/* if no error was found, return zero. */
+	return 0;
+}
+
+/* this function return the value below which the given fraction of the histogram lies. */
+uint64_t pppd__stats_percentile(struct pppd_stats_histogram *histogram, double fraction) {
+
+	/* some common variables. */
+	uint64_t rank   = 0;
+	uint64_t seen   = 0;
+	uint32_t bucket = 0;
+
+	/* check if histogram is empty. */
+	if (histogram->count == 0) {
+		return 0;
+	}
+
+	/* the rank of the value, at least the first one. */
+	rank = (uint64_t)(fraction * histogram->count + 0.5);
+	rank = rank == 0 ? 1 : rank;
+
+	/* loop through all buckets until the rank is reached. */
+	for (bucket = 0; bucket < STATS_BUCKETS; bucket++) {
+		if ((seen += histogram->buckets[bucket]) >= rank) {
+			break;
+		}
+	}
+
+	/* return the largest value of the bucket, but not more than the largest value seen. */
+	return pppd__stats_value(bucket) < histogram->max ? pppd__stats_value(bucket) : histogram->max;
+}
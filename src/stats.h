@@ -0,0 +1,163 @@
+/*
+ *  stats.h -- Latency histograms and counters of the logins in a shared
+ *             memory segment of all ppp daemons on a host.
+ *
+ *  Copyright (c) 2008-2009 Maik Broemme <mbroemme@plusserver.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _STATS_H
+#define _STATS_H
+
+/* generic includes. */
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+/* define stats constants. */
+#define STATS_MAGIC			0x54535350	/* the magic of the stats file. ("PSST") */
+#define STATS_STRIPES			32		/* the number of stripes, a ppp daemon writes the stripe of its process id. */
+#define STATS_SUB_BITS			4		/* the bits of the sub buckets, the relative error is below 1/16. */
+#define STATS_SUB			(1 << STATS_SUB_BITS)	/* the number of sub buckets per power of two. */
+#define STATS_SHIFTS			32		/* the number of powers of two above the linear buckets. */
+#define STATS_BUCKETS			((STATS_SHIFTS + 1) * STATS_SUB)	/* the number of buckets, up to 2^36 microseconds. */
+#define STATS_ERRORS			16		/* the number of counted error codes, the negated PPPD_SQL_ERROR_*. */
+
+/* define the measured phases of a login. */
+#define PPPD_STATS_CONNECT		0		/* the connection to the database. */
+#define PPPD_STATS_QUERY		1		/* the password query. */
+#define PPPD_STATS_DECRYPT		2		/* the decryption of the secret. */
+#define PPPD_STATS_VERIFY		3		/* the verification of the chap response or pap password. */
+#define PPPD_STATS_STATUS		4		/* the login status update and address allocation. */
+#define PPPD_STATS_SCRIPT		5		/* the ip up or down script. */
+#define PPPD_STATS_LOGIN		6		/* the whole login. */
+#define STATS_PHASES			7		/* the number of phases. */
+
+/* define the counters. */
+#define PPPD_STATS_LOGINS		0		/* the number of logins. */
+#define PPPD_STATS_ACCEPTED		1		/* the number of accepted logins. */
+#define PPPD_STATS_RETRIES		2		/* the number of repeated connections and queries. */
+#define PPPD_STATS_ROUND_TRIPS		3		/* the number of queries sent to the database. */
+#define STATS_COUNTERS			4		/* the number of counters. */
+
+/* the latency histogram of one phase in microseconds. */
+struct pppd_stats_histogram {
+	uint64_t	count;			/* the number of values. */
+	uint64_t	sum;			/* the sum of all values. */
+	uint64_t	max;			/* the largest value. */
+	uint64_t	buckets[STATS_BUCKETS];	/* the number of values in each bucket. */
+};
+
+/* one stripe of the stats, updated with atomic operations only. */
+struct pppd_stats_stripe {
+	uint64_t	counters[STATS_COUNTERS];	/* the counters. */
+	uint64_t	failures[STATS_ERRORS];	/* the failed logins of each error code. */
+	struct pppd_stats_histogram	phases[STATS_PHASES];	/* the histograms of the phases. */
+};
+
+/* the stats file, the header is followed by the stripes. */
+struct pppd_stats_header {
+	uint32_t	magic;			/* the stats magic. */
+	uint32_t	stripes;		/* the number of stripes. */
+	uint32_t	stripe_size;		/* the size of one stripe, it changes with the layout. */
+	uint32_t	reserved;		/* unused, keeps the stripes aligned. */
+	uint64_t	created;		/* the time of the creation in seconds since the epoch. */
+};
+
+/* the mapped stats. */
+struct pppd_stats_file {
+	int32_t		fd;			/* the descriptor of the stats file. */
+	size_t		size;			/* the size of the mapping. */
+	struct pppd_stats_header	*header;	/* the stats header. */
+	struct pppd_stats_stripe	*stripes;	/* the stripes behind the header. */
+	struct pppd_stats_stripe	*stripe;	/* the stripe of this process. */
+};
+
+/* the stats of this process, nothing is recorded if they are not opened. */
+extern struct pppd_stats_file pppd_stats_file;
+
+/* the phases of the current login of this process. */
+struct pppd_stats_current {
+	uint32_t	timed;			/* one if the phases are timed without stats file, like for the slow log. */
+	uint32_t	retries;		/* the retries of the current login. */
+	uint64_t	elapsed[STATS_PHASES];	/* the nanoseconds of the phases, zero if not reached. */
+};
+
+/* the phases of the current login of this process. */
+extern struct pppd_stats_current pppd_stats_current;
+
+/* this function return the bucket of the given value. */
+uint32_t pppd__stats_bucket(
+	uint64_t	value
+);
+
+/* this function return the largest value of the given bucket. */
+uint64_t pppd__stats_value(
+	uint32_t	bucket
+);
+
+/* this function open and map the stats, they are created if they do not exist. */
+int32_t pppd__stats_open(
+	uint8_t		*path,
+	uint32_t	writable,
+	struct pppd_stats_file	*stats
+);
+
+/* this function unmap and close the stats. */
+int32_t pppd__stats_close(
+	struct pppd_stats_file	*stats
+);
+
+/* this function start the timer of a phase. */
+int32_t pppd__stats_start(
+	uint32_t	phase,
+	uint8_t		*name,
+	struct timespec	*start
+);
+
+/* this function record the time since the given start in the histogram of the phase. */
+int32_t pppd__stats_stop(
+	uint32_t	phase,
+	uint8_t		*name,
+	int32_t		result,
+	struct timespec	*start
+);
+
+/* this function add the given value to a counter. */
+int32_t pppd__stats_count(
+	uint32_t	counter,
+	uint64_t	value
+);
+
+/* this function record the result and the time of a login. */
+int32_t pppd__stats_login(
+	uint8_t		*name,
+	int32_t		result,
+	struct timespec	*start
+);
+
+/* this function add all stripes of the stats into one. */
+int32_t pppd__stats_sum(
+	struct pppd_stats_file	*stats,
+	struct pppd_stats_stripe	*sum
+);
+
+/* this function return the value below which the given fraction of the histogram lies. */
+uint64_t pppd__stats_percentile(
+	struct pppd_stats_histogram	*histogram,
+	double		fraction
+);
+
+#endif					/* _STATS_H */
@@ -18,6 +18,7 @@
  */
 
 /* generic includes. */
+#include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 
@@ -88,3 +89,37 @@ int32_t pppd__htoi(uint8_t character) {
 	/* error on conversion. */
 	return -1;
 }
+
+/* this function append a formatted string to the given buffer. */
+int32_t pppd__strappend(uint8_t *string, uint32_t size, uint32_t *length, const char *format, ...) {
+
+	/* some common variables. */
+	va_list arguments;
+	int32_t written = 0;
+
+	/* check if buffer is already full. */
+	if (*length >= size - 1) {
+		return -1;
+	}
+
+	/* append the formatted string behind the current end. */
+	va_start(arguments, format);
+	written = vsnprintf((char *)string + *length, size - *length, format, arguments);
+	va_end(arguments);
+
+	/* check if string was truncated. */
+	if (written < 0 || written >= size - *length) {
+
+		/* mark buffer as full. */
+		*length = size - 1;
+
+		/* return with error. */
+		return -1;
+	}
+
+	/* move end of string. */
+	*length += written;
+
+	/* if no error was found, return zero. */
+	return 0;
+}
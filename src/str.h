@@ -21,6 +21,7 @@
 #define _STR_H
 
 /* generic includes. */
+#include <stdarg.h>
 #include <stdint.h>
 
 /* this function split the given string into tokens separated by delimiter. */
@@ -34,4 +35,13 @@ int32_t pppd__htoi(
 	uint8_t		character
 );
 
+/* this function append a formatted string to the given buffer. */
+int32_t pppd__strappend(
+	uint8_t		*string,
+	uint32_t	size,
+	uint32_t	*length,
+	const char	*format,
+	...
+);
+
 #endif					/* _STR_H */